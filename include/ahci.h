@@ -0,0 +1,217 @@
+#ifndef AHCI_H
+#define AHCI_H
+
+#include <stdint.h>
+
+// ============================================================================
+// DRIVER AHCI (SATA) COM NATIVE COMMAND QUEUING
+// ============================================================================
+
+// Classe PCI do controlador AHCI (Mass Storage / SATA / AHCI 1.0)
+#define AHCI_PCI_CLASS          0x01
+#define AHCI_PCI_SUBCLASS       0x06
+#define AHCI_PCI_PROG_IF        0x01
+
+// Limites do driver
+#define AHCI_MAX_PORTS          8     // Portas inicializadas (QEMU ICH9 tem 6)
+#define AHCI_MAX_SLOTS          32    // Slots de comando por porta
+#define AHCI_PRDT_ENTRIES       8     // Entradas PRDT por comando
+#define AHCI_PRD_MAX_BYTES      (4 * 1024 * 1024)
+#define AHCI_MAX_SECTORS        0xFFFF  // Setores por comando (cabe em 8 PRDs de 4 MB)
+#define AHCI_TIMEOUT_TICKS      500   // 5 segundos a 100 Hz
+#define AHCI_SPIN_LIMIT         10000000
+
+// HBA - Generic Host Control
+#define AHCI_CAP_SNCQ           (1u << 30)  // Suporta NCQ
+#define AHCI_CAP_NCS_SHIFT      8           // Número de slots - 1 (bits 12:8)
+#define AHCI_GHC_HR             (1u << 0)   // HBA reset
+#define AHCI_GHC_IE             (1u << 1)   // Interrupt enable
+#define AHCI_GHC_AE             (1u << 31)  // AHCI enable
+
+// Porta - PxCMD
+#define AHCI_PxCMD_ST           (1u << 0)   // Start (processa a command list)
+#define AHCI_PxCMD_FRE          (1u << 4)   // FIS receive enable
+#define AHCI_PxCMD_FR           (1u << 14)  // FIS receive running
+#define AHCI_PxCMD_CR           (1u << 15)  // Command list running
+
+// Porta - PxIS / PxIE
+#define AHCI_PxIS_DHRS          (1u << 0)   // D2H Register FIS
+#define AHCI_PxIS_PSS           (1u << 1)   // PIO Setup FIS
+#define AHCI_PxIS_DSS           (1u << 2)   // DMA Setup FIS
+#define AHCI_PxIS_SDBS          (1u << 3)   // Set Device Bits FIS (NCQ)
+#define AHCI_PxIS_TFES          (1u << 30)  // Task file error
+#define AHCI_PxIS_ERRORS        0x7DC00050u // Bits de erro/fatais
+
+// Porta - PxTFD / PxSSTS / PxSIG
+#define AHCI_TFD_BSY            0x80
+#define AHCI_TFD_DRQ            0x08
+#define AHCI_TFD_ERR            0x01
+#define AHCI_SSTS_DET_PRESENT   0x3         // Dispositivo presente e comunicando
+#define AHCI_SSTS_IPM_ACTIVE    0x1         // Interface em estado ativo
+#define AHCI_SCTL_DET_INIT      0x1         // PxSCTL.DET: COMRESET
+#define AHCI_SIG_ATA            0x00000101  // Disco SATA
+
+// Tipos de FIS e comandos ATA
+#define FIS_TYPE_REG_H2D        0x27
+#define ATA_CMD_READ_DMA_EXT    0x25
+#define ATA_CMD_WRITE_DMA_EXT   0x35
+#define ATA_CMD_READ_FPDMA      0x60        // READ FPDMA QUEUED (NCQ)
+#define ATA_CMD_WRITE_FPDMA     0x61        // WRITE FPDMA QUEUED (NCQ)
+#define ATA_CMD_FLUSH_CACHE_EXT 0xEA
+#define AHCI_ATA_CMD_IDENTIFY   0xEC
+
+// Benchmark de IOPS
+#define AHCI_BENCH_TICKS        100         // 1 segundo por profundidade de fila
+#define AHCI_BENCH_IO_SECTORS   8           // Leituras aleatórias de 4 KB
+
+// ============================================================================
+// ESTRUTURAS DE HARDWARE
+// ============================================================================
+
+// Registradores de uma porta (0x80 bytes)
+typedef volatile struct {
+    uint32_t clb;           // Command list base (1 KB alinhado)
+    uint32_t clbu;          // Command list base (32 bits superiores)
+    uint32_t fb;            // FIS base (256 bytes alinhado)
+    uint32_t fbu;           // FIS base (32 bits superiores)
+    uint32_t is;            // Interrupt status
+    uint32_t ie;            // Interrupt enable
+    uint32_t cmd;           // Command and status
+    uint32_t reserved0;
+    uint32_t tfd;           // Task file data
+    uint32_t sig;           // Assinatura do dispositivo
+    uint32_t ssts;          // SATA status
+    uint32_t sctl;          // SATA control
+    uint32_t serr;          // SATA error
+    uint32_t sact;          // SATA active (tags NCQ pendentes)
+    uint32_t ci;            // Command issue
+    uint32_t sntf;          // SATA notification
+    uint32_t fbs;           // FIS-based switching
+    uint32_t reserved1[11];
+    uint32_t vendor[4];
+} ahci_port_regs_t;
+
+// Memória do HBA (ABAR)
+typedef volatile struct {
+    uint32_t cap;           // Host capabilities
+    uint32_t ghc;           // Global host control
+    uint32_t is;            // Interrupt status (um bit por porta)
+    uint32_t pi;            // Ports implemented
+    uint32_t vs;            // Versão
+    uint32_t ccc_ctl;
+    uint32_t ccc_ports;
+    uint32_t em_loc;
+    uint32_t em_ctl;
+    uint32_t cap2;
+    uint32_t bohc;
+    uint8_t  reserved[0x74];
+    uint8_t  vendor[0x60];
+    ahci_port_regs_t ports[32];
+} ahci_hba_regs_t;
+
+// Cabeçalho de comando (32 bytes, 32 por command list)
+typedef struct {
+    uint16_t flags;         // CFL (4:0), A (5), W (6), P (7), C (10)
+    uint16_t prdtl;         // Número de entradas PRDT
+    volatile uint32_t prdbc;// Bytes transferidos
+    uint32_t ctba;          // Command table base (128 bytes alinhado)
+    uint32_t ctbau;
+    uint32_t reserved[4];
+} __attribute__((packed)) ahci_cmd_header_t;
+
+#define AHCI_CMD_FLAG_WRITE     (1u << 6)
+
+// Entrada da Physical Region Descriptor Table
+typedef struct {
+    uint32_t dba;           // Endereço dos dados
+    uint32_t dbau;
+    uint32_t reserved;
+    uint32_t dbc;           // Bytes - 1 (bits 21:0), bit 31 = interrupção
+} __attribute__((packed)) ahci_prdt_entry_t;
+
+// Command table (cabeçalho de 128 bytes + PRDT)
+typedef struct {
+    uint8_t cfis[64];       // Command FIS
+    uint8_t acmd[16];       // Comando ATAPI
+    uint8_t reserved[48];
+    ahci_prdt_entry_t prdt[AHCI_PRDT_ENTRIES];
+} __attribute__((packed)) ahci_cmd_table_t;
+
+// FIS Register Host to Device (20 bytes)
+typedef struct {
+    uint8_t fis_type;       // FIS_TYPE_REG_H2D
+    uint8_t pmport_c;       // Bit 7 = comando (1) / controle (0)
+    uint8_t command;
+    uint8_t feature_low;
+    uint8_t lba0;
+    uint8_t lba1;
+    uint8_t lba2;
+    uint8_t device;
+    uint8_t lba3;
+    uint8_t lba4;
+    uint8_t lba5;
+    uint8_t feature_high;
+    uint8_t count_low;
+    uint8_t count_high;
+    uint8_t icc;
+    uint8_t control;
+    uint8_t reserved[4];
+} __attribute__((packed)) fis_reg_h2d_t;
+
+// ============================================================================
+// ESTADO DO DRIVER
+// ============================================================================
+
+struct ahci_port;
+
+// Callback de conclusão (status 0 = sucesso, -1 = erro)
+typedef void (*ahci_callback_t)(struct ahci_port* port, int tag, int status, void* ctx);
+
+// Requisição em andamento em um slot
+typedef struct {
+    ahci_callback_t callback;
+    void* ctx;
+} ahci_request_t;
+
+// Porta SATA com disco presente
+typedef struct ahci_port {
+    int index;                      // Número da porta no HBA
+    ahci_port_regs_t* regs;
+    ahci_cmd_header_t* cmd_list;
+    ahci_cmd_table_t* cmd_tables;
+    uint32_t sectors;               // Capacidade (setores de 512 bytes)
+    uint8_t ncq;                    // 1 = NCQ habilitado
+    uint8_t queue_depth;            // Comandos simultâneos aceitos
+    uint32_t slot_mask;             // Slots utilizáveis
+    volatile uint32_t busy;         // Slots alocados
+    volatile uint32_t issued;       // Slots entregues ao HBA
+    ahci_request_t requests[AHCI_MAX_SLOTS];
+    volatile uint32_t completed;    // Comandos concluídos
+    volatile uint32_t errors;       // Comandos com erro
+} ahci_port_t;
+
+// ============================================================================
+// FUNÇÕES DO DRIVER AHCI
+// ============================================================================
+
+// Inicialização
+int ahci_init(void);
+int ahci_port_count(void);
+ahci_port_t* ahci_get_port(int n);
+
+// Interface assíncrona (retorna a tag, AHCI_AGAIN se não há slot livre
+// ou -1 se o pedido é inválido)
+#define AHCI_AGAIN              (-2)
+int ahci_submit(ahci_port_t* port, uint32_t lba, uint32_t count,
+                void* buffer, int write, ahci_callback_t callback, void* ctx);
+int ahci_poll(ahci_port_t* port);
+
+// Interface síncrona
+int ahci_read(ahci_port_t* port, uint32_t lba, uint32_t count, void* buffer);
+int ahci_write(ahci_port_t* port, uint32_t lba, uint32_t count, const void* buffer);
+int ahci_flush(ahci_port_t* port);
+
+// Comandos
+void cmd_ahcibench(void);
+
+#endif // AHCI_H
@@ -0,0 +1,116 @@
+#ifndef ATA_H
+#define ATA_H
+
+#include <stdint.h>
+
+// ============================================================================
+// DRIVER ATA/IDE (PIO) - DOIS CANAIS, MESTRE E ESCRAVO
+// ============================================================================
+
+// Canais legados (modo de compatibilidade ISA)
+#define ATA_PRIMARY_IO          0x1F0
+#define ATA_PRIMARY_CTRL        0x3F6
+#define ATA_PRIMARY_IRQ         14
+#define ATA_SECONDARY_IO        0x170
+#define ATA_SECONDARY_CTRL      0x376
+#define ATA_SECONDARY_IRQ       15
+
+// Registradores (deslocamento a partir da base de I/O do canal)
+#define ATA_REG_DATA            0
+#define ATA_REG_ERROR           1
+#define ATA_REG_SECCOUNT        2
+#define ATA_REG_LBA_LOW         3
+#define ATA_REG_LBA_MID         4
+#define ATA_REG_LBA_HIGH        5
+#define ATA_REG_DRVHEAD         6
+#define ATA_REG_STATUS          7   // Leitura (limpa a IRQ pendente)
+#define ATA_REG_COMMAND         7   // Escrita
+
+// Registrador de controle (base de controle): status alternativo na leitura
+#define ATA_CTRL_NIEN           0x02  // Desabilita a IRQ do dispositivo
+#define ATA_CTRL_SRST           0x04  // Reset por software
+
+// Comandos ATA
+#define ATA_CMD_READ_SECTORS    0x20
+#define ATA_CMD_WRITE_SECTORS   0x30
+#define ATA_CMD_CACHE_FLUSH     0xE7
+#define ATA_CMD_IDENTIFY        0xEC
+
+// Status bits
+#define ATA_STATUS_BSY          0x80  // Busy
+#define ATA_STATUS_DRDY         0x40  // Drive ready
+#define ATA_STATUS_DF           0x20  // Drive fault
+#define ATA_STATUS_DRQ          0x08  // Data request
+#define ATA_STATUS_ERR          0x01  // Error
+
+// Limites
+#define ATA_CHANNELS            2
+#define ATA_DRIVES              4     // hda, hdb (primário), hdc, hdd (secundário)
+#define ATA_MAX_SECTORS         256   // Por comando READ/WRITE SECTORS (contagem 0)
+#define ATA_SPIN_TIMEOUT        100000
+#define ATA_TIMEOUT_TICKS       500   // 5 segundos a 100 Hz
+
+// Conclusão de uma requisição assíncrona (status 0 = sucesso, -1 = erro)
+typedef void (*ata_callback_t)(int status, void* ctx);
+
+// Requisição em andamento em um canal (máquina de estados dirigida por IRQ)
+typedef struct {
+    struct ata_drive* drive;
+    uint32_t lba;                   // Próximo setor do dispositivo
+    uint32_t count;                 // Setores ainda não comandados
+    uint32_t chunk_left;            // Setores restantes do comando atual
+    uint16_t* buffer;
+    uint8_t write;
+    ata_callback_t callback;
+    void* ctx;
+} ata_request_t;
+
+// Canal IDE: o campo 'busy' é a trava do canal. Cada canal executa um
+// comando por vez, mas os dois canais operam de forma independente
+typedef struct {
+    uint16_t io_base;
+    uint16_t ctrl_base;
+    uint8_t irq;
+    uint8_t selected;               // Último valor escrito em DRVHEAD
+    volatile uint8_t busy;          // Trava: requisição em andamento
+    ata_request_t req;
+    uint32_t completed;
+    uint32_t errors;
+    uint32_t irqs;
+} ata_channel_t;
+
+// Disco em um canal
+typedef struct ata_drive {
+    ata_channel_t* channel;
+    uint8_t index;                  // 0 = hda ... 3 = hdd
+    uint8_t slave;                  // 0 = mestre, 1 = escravo
+    uint8_t present;
+    uint32_t sectors;               // Capacidade LBA28
+    char model[41];
+} ata_drive_t;
+
+// ============================================================================
+// FUNÇÕES DO DRIVER ATA
+// ============================================================================
+
+// Inicialização e enumeração
+int ata_init(void);
+int ata_drive_count(void);
+ata_drive_t* ata_get_drive(int index);
+const char* ata_drive_name(const ata_drive_t* drive);
+
+// Operações assíncronas: retornam -1 se o canal está ocupado
+int ata_submit(ata_drive_t* drive, uint32_t lba, uint32_t count, void* buffer,
+               int write, ata_callback_t callback, void* ctx);
+int ata_busy(const ata_drive_t* drive);
+void ata_poll(ata_drive_t* drive);
+
+// Operações síncronas (esperam a trava do canal)
+int ata_read(ata_drive_t* drive, uint32_t lba, uint32_t count, void* buffer);
+int ata_write(ata_drive_t* drive, uint32_t lba, uint32_t count, const void* buffer);
+int ata_flush(ata_drive_t* drive);
+
+// Diagnóstico
+void ata_print_info(void);
+
+#endif // ATA_H
@@ -0,0 +1,91 @@
+#ifndef BCACHE_H
+#define BCACHE_H
+
+#include <stdint.h>
+
+// ============================================================================
+// CACHE DE BLOCOS (BUFFER CACHE)
+// ============================================================================
+
+// Configurações
+#define BCACHE_BLOCK_SIZE       512
+#define BCACHE_BLOCKS           256     // 128 KB de cache
+#define BCACHE_HASH_SIZE        128     // Potência de 2
+#define BCACHE_WRITEBACK_TICKS  500     // Idade máxima de um bloco sujo (5 s)
+#define BCACHE_FLUSH_INTERVAL   100     // Intervalo do flusher (1 s)
+#define BCACHE_RA_MAX           64      // Blocos por chamada de read-ahead
+#define BCACHE_IO_TIMEOUT       500     // Espera máxima por uma leitura em voo
+
+// Dispositivo: índice na tabela de blockdev.h
+#define BCACHE_DEV_NONE         0xFF    // Bloco livre
+
+// Flags de um bloco
+#define BCACHE_VALID            0x01    // Dados carregados do disco
+#define BCACHE_DIRTY            0x02    // Modificado, aguardando write-back
+#define BCACHE_LOADING          0x04    // Leitura antecipada em voo
+#define BCACHE_PREFETCHED       0x08    // Trazido por read-ahead, ainda não lido
+
+// Estado da leitura assíncrona de um bloco
+#define BCACHE_IO_OK            0
+#define BCACHE_IO_ERROR         (-1)
+#define BCACHE_IO_PENDING       1
+
+// Bloco em cache, chaveado por (dispositivo, LBA)
+typedef struct bcache_buf {
+    uint8_t dev;
+    uint8_t flags;
+    uint16_t refcount;                  // Usuários ativos (não pode ser despejado)
+    uint32_t lba;
+    uint32_t dirty_since;               // Tick da primeira modificação
+    volatile int32_t io_status;         // BCACHE_IO_* (escrito pelo callback)
+    struct bcache_buf* hash_next;       // Encadeamento no bucket
+    struct bcache_buf* lru_prev;        // Lista LRU (cabeça = mais recente)
+    struct bcache_buf* lru_next;
+    uint8_t data[BCACHE_BLOCK_SIZE] __attribute__((aligned(16)));
+} bcache_buf_t;
+
+// Estatísticas
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t disk_reads;
+    uint32_t disk_writes;
+    uint32_t evictions;
+    uint32_t writebacks;                // Escritas feitas pelo flusher
+    uint32_t prefetched;                // Blocos trazidos por read-ahead
+    uint32_t prefetch_hits;             // ... que foram lidos depois
+} bcache_stats_t;
+
+// ============================================================================
+// FUNÇÕES DO CACHE
+// ============================================================================
+
+// Inicialização
+void bcache_init(void);
+
+// Acesso a blocos (bcache_read/bcache_get devem ser pareados com bcache_release)
+bcache_buf_t* bcache_read(uint8_t dev, uint32_t lba);
+bcache_buf_t* bcache_get(uint8_t dev, uint32_t lba);
+void bcache_release(bcache_buf_t* buf);
+void bcache_mark_dirty(bcache_buf_t* buf);
+
+// Atalhos com cópia
+int bcache_read_copy(uint8_t dev, uint32_t lba, void* buffer);
+int bcache_write(uint8_t dev, uint32_t lba, const void* buffer);
+
+// Leitura antecipada
+int bcache_prefetch(uint8_t dev, uint32_t lba, uint32_t count);
+
+// Write-back
+int bcache_sync(void);
+int bcache_writeback_range(uint8_t dev, uint32_t lba, uint32_t count);
+void bcache_update_range(uint8_t dev, uint32_t lba, uint32_t count, const void* data);
+void bcache_flush_expired(void);
+void bcache_invalidate(uint8_t dev);
+
+// Estatísticas
+void bcache_get_stats(bcache_stats_t* stats);
+void cmd_cachestat(void);
+void cmd_sync(void);
+
+#endif // BCACHE_H
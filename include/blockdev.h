@@ -0,0 +1,73 @@
+#ifndef BLOCKDEV_H
+#define BLOCKDEV_H
+
+#include <stdint.h>
+
+// ============================================================================
+// CAMADA DE DISPOSITIVOS DE BLOCO
+// ============================================================================
+
+// Limites
+#define BLOCKDEV_MAX            16
+#define BLOCKDEV_NAME_LEN       8
+#define BLOCKDEV_SECTOR_SIZE    512
+#define BLOCKDEV_NONE           0xFF    // Índice inválido
+
+// Conclusão de uma requisição enfileirada (status 0 = sucesso, -1 = erro)
+typedef void (*blockdev_callback_t)(int status, void* ctx);
+
+typedef struct blockdev blockdev_t;
+
+// Operações de um driver. read/write são obrigatórias; flush e queue são
+// opcionais. 'queue' deixa a leitura em voo (várias por dispositivo) e
+// exige 'kick' para notificar e 'poll' para colher conclusões
+typedef struct {
+    int (*read)(blockdev_t* dev, uint32_t lba, uint32_t count, void* buffer);
+    int (*write)(blockdev_t* dev, uint32_t lba, uint32_t count, const void* buffer);
+    int (*flush)(blockdev_t* dev);
+    int (*queue)(blockdev_t* dev, uint32_t lba, uint32_t count, void* buffer,
+                 blockdev_callback_t callback, void* ctx);
+    void (*kick)(blockdev_t* dev);
+    int (*poll)(blockdev_t* dev);
+} blockdev_ops_t;
+
+// Dispositivo registrado
+struct blockdev {
+    char name[BLOCKDEV_NAME_LEN];       // hda, sda, vda, ram0...
+    uint8_t index;                      // Posição na tabela (chave do cache)
+    uint32_t sectors;                   // Capacidade em setores de 512 bytes
+    const blockdev_ops_t* ops;
+    void* priv;                         // Estado do driver
+    uint32_t sectors_read;
+    uint32_t sectors_written;
+};
+
+// ============================================================================
+// FUNÇÕES DA CAMADA DE BLOCO
+// ============================================================================
+
+// Registro e busca
+blockdev_t* blockdev_register(const char* name, uint32_t sectors,
+                              const blockdev_ops_t* ops, void* priv);
+blockdev_t* blockdev_get(uint8_t index);
+blockdev_t* blockdev_find(const char* name);
+int blockdev_count(void);
+
+// Operações (validam o intervalo de setores)
+int blockdev_read(blockdev_t* dev, uint32_t lba, uint32_t count, void* buffer);
+int blockdev_write(blockdev_t* dev, uint32_t lba, uint32_t count, const void* buffer);
+int blockdev_flush(blockdev_t* dev);
+
+// Leitura enfileirada: sem 'queue' no driver a leitura é feita na hora e o
+// callback roda antes do retorno
+int blockdev_can_queue(const blockdev_t* dev);
+int blockdev_queue(blockdev_t* dev, uint32_t lba, uint32_t count, void* buffer,
+                   blockdev_callback_t callback, void* ctx);
+void blockdev_kick(blockdev_t* dev);
+int blockdev_poll(blockdev_t* dev);
+
+// Diagnóstico
+void blockdev_print_list(void);
+void cmd_lsblk(void);
+
+#endif // BLOCKDEV_H
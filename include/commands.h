@@ -21,11 +21,27 @@ void cmd_echo(const char* text);
 void cmd_shutdown(void);
 
 // Comandos do sistema de arquivos
-void cmd_ls(void);
+void cmd_ls(const char* path);
 void cmd_cat(const char* filename);
 void cmd_fsinfo(void);
+void cmd_vfsstat(void);
+void cmd_fsbench(const char* filename);
+void cmd_fatbench(const char* filename);
+void cmd_fswbench(void);
+void cmd_pathbench(const char* path);
+void cmd_tmpbench(void);
 void cmd_diskinfo(void);
 
+// Comandos de hardware
+void cmd_lspci(int verbose);
+
+// Comandos de armazenamento
+void cmd_ahcibench(void);
+void cmd_diskbench(void);
+void cmd_lsblk(void);
+void cmd_cachestat(void);
+void cmd_sync(void);
+
 // Comandos de rede
 void cmd_ifconfig(void);
 void cmd_ping(const char* target);
@@ -44,6 +60,7 @@ void uint_to_str(uint32_t num, char* buffer, size_t buffer_size);
 // Funções auxiliares de string (implementadas no kernel.c)
 size_t strlen(const char* str);
 int strcmp(const char* s1, const char* s2);
+int memory_compare(const void* s1, const void* s2, size_t n);
 
 // Variável externa para o timer
 extern volatile uint32_t timer_ticks;
@@ -0,0 +1,149 @@
+#ifndef E1000_H
+#define E1000_H
+
+#include <stdint.h>
+#include "netdev.h"
+
+// ============================================================================
+// DRIVER ETHERNET (INTEL 8254x / E1000)
+// ============================================================================
+
+// Identificação PCI
+#define E1000_PCI_VENDOR        0x8086
+#define E1000_PCI_DEVICE_82540EM 0x100E     // Padrão do QEMU
+#define E1000_PCI_DEVICE_82545EM 0x100F
+
+// Registradores (BAR0, MMIO)
+#define E1000_CTRL              0x0000
+#define E1000_STATUS            0x0008
+#define E1000_EERD              0x0014      // Leitura da EEPROM
+#define E1000_ICR               0x00C0      // Causa de interrupção (ler limpa)
+#define E1000_ITR               0x00C4      // Throttling de interrupções
+#define E1000_IMS               0x00D0      // Habilita interrupções
+#define E1000_IMC               0x00D8      // Desabilita interrupções
+#define E1000_RCTL              0x0100
+#define E1000_TCTL              0x0400
+#define E1000_TIPG              0x0410
+#define E1000_RDBAL             0x2800
+#define E1000_RDBAH             0x2804
+#define E1000_RDLEN             0x2808
+#define E1000_RDH               0x2810
+#define E1000_RDT               0x2818
+#define E1000_RDTR              0x2820      // Atraso de interrupção RX
+#define E1000_RADV              0x282C
+#define E1000_TDBAL             0x3800
+#define E1000_TDBAH             0x3804
+#define E1000_TDLEN             0x3808
+#define E1000_TDH               0x3810
+#define E1000_TDT               0x3818
+#define E1000_RXCSUM            0x5000
+#define E1000_MTA               0x5200      // 128 palavras de multicast
+#define E1000_RAL0              0x5400
+#define E1000_RAH0              0x5404
+
+// CTRL
+#define E1000_CTRL_ASDE         (1u << 5)   // Detecção automática de velocidade
+#define E1000_CTRL_SLU          (1u << 6)   // Set Link Up
+#define E1000_CTRL_RST          (1u << 26)
+
+// STATUS
+#define E1000_STATUS_LU         (1u << 1)   // Link ativo
+
+// EERD
+#define E1000_EERD_START        (1u << 0)
+#define E1000_EERD_DONE         (1u << 4)
+
+// Interrupções (ICR/IMS/IMC)
+#define E1000_INT_TXDW          (1u << 0)   // Descritor TX escrito de volta
+#define E1000_INT_LSC           (1u << 2)   // Mudança de link
+#define E1000_INT_RXDMT0        (1u << 4)   // Anel RX abaixo do mínimo
+#define E1000_INT_RXO           (1u << 6)   // Overrun de recepção
+#define E1000_INT_RXT0          (1u << 7)   // Timer de recepção
+#define E1000_INT_RX            (E1000_INT_RXT0 | E1000_INT_RXDMT0 | E1000_INT_RXO)
+
+// RCTL
+#define E1000_RCTL_EN           (1u << 1)
+#define E1000_RCTL_BAM          (1u << 15)  // Aceita broadcast
+#define E1000_RCTL_BSIZE_2048   (0u << 16)
+#define E1000_RCTL_SECRC        (1u << 26)  // Remove o CRC
+
+// TCTL
+#define E1000_TCTL_EN           (1u << 1)
+#define E1000_TCTL_PSP          (1u << 3)   // Completa frames curtos
+#define E1000_TCTL_CT           (0x10u << 4)
+#define E1000_TCTL_COLD         (0x40u << 12)
+#define E1000_TIPG_DEFAULT      0x0060200A
+
+// RXCSUM
+#define E1000_RXCSUM_TUOFL      (1u << 9)   // Confere checksum TCP/UDP
+
+// Descritor de recepção (legado)
+#define E1000_RXD_STAT_DD       0x01        // Descritor concluído
+#define E1000_RXD_STAT_EOP      0x02        // Fim do pacote
+#define E1000_RXD_STAT_IXSM     0x04        // Ignorar indicação de checksum
+#define E1000_RXD_STAT_TCPCS    0x20        // Checksum TCP/UDP conferido
+#define E1000_RXD_ERR_TCPE      0x20        // Checksum TCP/UDP errado
+#define E1000_RXD_ERR_FRAME     0x97        // CE, SE, SEQ, CXE, RXE
+
+typedef struct {
+    uint32_t addr;
+    uint32_t addr_high;
+    uint16_t length;
+    uint16_t checksum;
+    volatile uint8_t status;
+    uint8_t errors;
+    uint16_t special;
+} __attribute__((packed)) e1000_rx_desc_t;
+
+// Descritor de transmissão (legado)
+#define E1000_TXD_CMD_EOP       0x01
+#define E1000_TXD_CMD_IFCS      0x02        // Placa acrescenta o CRC
+#define E1000_TXD_CMD_RS        0x08        // Reportar status (DD)
+#define E1000_TXD_STAT_DD       0x01
+
+typedef struct {
+    uint32_t addr;
+    uint32_t addr_high;
+    uint16_t length;
+    uint8_t cso;
+    uint8_t cmd;
+    volatile uint8_t status;
+    uint8_t css;
+    uint16_t special;
+} __attribute__((packed)) e1000_tx_desc_t;
+
+// Anéis (RDLEN/TDLEN precisam ser múltiplos de 128 bytes)
+#define E1000_RX_DESCS          128
+#define E1000_TX_DESCS          64
+#define E1000_RX_BUFFER         NETBUF_SIZE // RCTL.BSIZE (2048)
+#define E1000_TX_BUFFER         1536
+
+// Teto de interrupções por segundo (ITR conta em unidades de 256 ns)
+#define E1000_MAX_IRQ_RATE      8000
+#define E1000_ITR_INTERVAL      (1000000000 / (E1000_MAX_IRQ_RATE * 256))
+
+#define E1000_RESET_TIMEOUT     10          // Ticks
+
+// Estado do driver
+typedef struct {
+    volatile uint8_t* mmio;     // BAR0
+    uint16_t rx_cur;            // Próximo descritor RX a colher
+    uint16_t tx_tail;           // Próximo descritor TX livre (cópia de TDT)
+    uint16_t tx_clean;          // Descritor TX mais antigo não colhido
+    uint16_t tx_peak;           // Maior ocupação do anel TX
+    uint32_t tail_writes;       // Escritas em RDT/TDT (MMIO)
+    uint32_t rx_overruns;
+    uint32_t irqs;
+    uint32_t irq_window_start;  // Janela da taxa de interrupções
+    uint32_t irq_window_count;
+    uint32_t irq_rate;          // Interrupções/s na última janela
+    netdev_t* netdev;
+} e1000_device_t;
+
+// ============================================================================
+// FUNÇÕES DO DRIVER
+// ============================================================================
+
+int e1000_init(void);
+
+#endif // E1000_H
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "blockdev.h"
 
 // ============================================================================
 // ESTRUTURAS DO SISTEMA DE ARQUIVOS FAT12
@@ -32,6 +33,23 @@ typedef struct fat12_boot_sector {
     uint8_t  filesystem_type[8];     // Filesystem type
 } __attribute__((packed)) fat12_boot_sector_t;
 
+// BPB estendido do FAT32 (a partir do offset 36 do boot sector)
+typedef struct fat32_ext_bpb {
+    uint32_t sectors_per_fat_32;     // Setores por FAT
+    uint16_t ext_flags;              // Espelhamento das FATs
+    uint16_t fs_version;             // Versão (0.0)
+    uint32_t root_cluster;           // Primeiro cluster do diretório raiz
+    uint16_t fsinfo_sector;          // Setor do FSInfo
+    uint16_t backup_boot_sector;     // Cópia do boot sector
+} __attribute__((packed)) fat32_ext_bpb_t;
+
+// FSInfo (FAT32): dica de clusters livres mantida pelo sistema que formatou
+#define FAT32_FSINFO_LEAD_SIG    0x41615252
+#define FAT32_FSINFO_STRUC_SIG   0x61417272
+#define FAT32_FSINFO_FREE_COUNT  488      // Offset do contador no setor
+#define FAT32_FSINFO_NEXT_FREE   492      // Offset da dica de próximo livre
+#define FAT32_FSINFO_STRUC_OFF   484
+
 // Directory Entry (FAT12) - 32 bytes
 typedef struct fat12_dir_entry {
     uint8_t  filename[8];            // Filename (8 chars)
@@ -56,32 +74,162 @@ typedef struct fat12_dir_entry {
 #define FAT_ATTR_VOLUME_LABEL 0x08
 #define FAT_ATTR_DIRECTORY    0x10
 #define FAT_ATTR_ARCHIVE      0x20
+#define FAT_ATTR_LFN          0x0F    // Entrada de nome longo (VFAT)
+
+// Entrada de nome longo (VFAT) - 32 bytes. Precede a entrada 8.3 em ordem
+// inversa, 13 caracteres UCS-2 por entrada
+typedef struct fat_lfn_entry {
+    uint8_t  sequence;               // Ordem da parte (FAT_LFN_LAST = última)
+    uint8_t  name1[10];              // Caracteres 1-5
+    uint8_t  attributes;             // Sempre FAT_ATTR_LFN
+    uint8_t  type;                   // Sempre 0
+    uint8_t  checksum;               // Checksum do nome 8.3 associado
+    uint8_t  name2[12];              // Caracteres 6-11
+    uint16_t first_cluster;          // Sempre 0
+    uint8_t  name3[4];               // Caracteres 12-13
+} __attribute__((packed)) fat_lfn_entry_t;
+
+#define FAT_LFN_LAST          0x40
+#define FAT_LFN_SEQ_MASK      0x1F
+#define FAT_LFN_CHARS         13      // Caracteres por entrada
+#define FAT_LFN_MAX_ENTRIES   20      // 255 caracteres
+#define FS_LFN_MAX            255     // Tamanho máximo de um componente
 
 // FAT12 constants
 #define FAT12_SECTOR_SIZE     512
 #define FAT12_ROOT_ENTRIES    224
 #define FAT12_CLUSTER_FREE    0x000
 #define FAT12_CLUSTER_EOF     0xFF8
+#define FAT12_MAX_FAT_SECTORS 12      // 4084 clusters * 1,5 bytes
+#define FAT12_MAX_ENTRIES     (FAT12_MAX_FAT_SECTORS * FAT12_SECTOR_SIZE * 2 / 3)
+
+// Tipo de FAT, decidido pelo número de clusters (regra da especificação)
+#define FAT12_MAX_CLUSTERS    4085
+#define FAT16_MAX_CLUSTERS    65525
+#define FAT16_CLUSTER_EOF     0xFFF8
+#define FAT32_CLUSTER_MASK    0x0FFFFFFF
+#define FAT32_CLUSTER_EOF     0x0FFFFFF8
+
+// Cluster defeituoso: nunca é seguido, a cadeia termina nele como no EOC
+#define FAT12_CLUSTER_BAD     0xFF7
+#define FAT16_CLUSTER_BAD     0xFFF7
+#define FAT32_CLUSTER_BAD     0x0FFFFFF7
+
+// Fim de cadeia devolvido por fs_get_next_cluster para qualquer tipo de FAT
+#define FS_CLUSTER_EOF        FAT32_CLUSTER_EOF
+
+// Marcas de fim de cadeia gravadas na FAT
+#define FAT12_CLUSTER_EOC     0xFFF
+#define FAT16_CLUSTER_EOC     0xFFFF
+#define FAT32_CLUSTER_EOC     0x0FFFFFFF
+#define FS_FREE_UNKNOWN       0xFFFFFFFF
+
+// Setores da FAT (FAT16/32) mantidos presos no cache de blocos
+#define FS_FAT_CACHE_SLOTS    8       // Potência de 2
+
+// Setores da FAT alterados desde o último espelhamento nas cópias
+#define FS_FAT_DIRTY_MAX      64
+
+// Read-ahead adaptativo (janela em setores, dobra a cada disparo sequencial)
+#define FS_RA_MIN_SECTORS     8       // 4 KB
+#define FS_RA_MAX_SECTORS     64      // 32 KB
+
+// Mapa de extents por arquivo (trechos de clusters consecutivos)
+#define FS_MAX_EXTENTS        32
+
+// Cache de entradas do diretório raiz
+#define FS_DCACHE_ENTRIES     512     // Entradas positivas (cobre FAT12/FAT16)
+#define FS_DCACHE_NEGATIVE    32      // Nomes inexistentes lembrados
+#define FS_DCACHE_HASH_SIZE   128     // Potência de 2
+
+// Nomes longos guardados nos caches (componentes maiores não são cacheados)
+#define FS_NAME_MAX           64      // Com o terminador
+
+// Cache de componentes de caminho: (diretório pai, nome) -> entrada
+#define FS_PCACHE_ENTRIES     128
+#define FS_PCACHE_HASH_SIZE   64      // Potência de 2
+
+// Leitura direta no buffer do chamador (offset alinhado em setor)
+#define FS_DIRECT_MAX_SECTORS 128     // 64 KB por requisição
+#define FS_DIRECT_ALIGN       4       // Alinhamento mínimo do buffer (DMA/PIO)
+
+// Benchmark de leitura de arquivo
+#define FS_BENCH_TICKS        100     // 1 segundo por modo
+#define FS_BENCH_SMALL_READ   256     // Leituras pequenas (via cache)
+#define FS_BENCH_LARGE_READ   65536   // Leituras grandes alinhadas (diretas)
+#define FS_BENCH_PREAD_SIZE   512     // Leituras aleatórias com fs_pread
+#define FS_BENCH_SMALL_FILES  64      // Arquivos pequenos do fswbench
+#define FS_BENCH_SMALL_SIZE   1024    // Bytes por arquivo pequeno
+#define FS_BENCH_LARGE_FILE   (512 * 1024) // Arquivo grande do fswbench
 
 // ============================================================================
 // ESTRUTURA DO SISTEMA DE ARQUIVOS
 // ============================================================================
 
 typedef struct filesystem {
+    blockdev_t* dev;                 // Dispositivo montado
     fat12_boot_sector_t boot_sector;
-    uint8_t *fat_table;              // FAT table in memory
+    uint8_t fat_type;                // 12, 16 ou 32
+    uint32_t fat_start;              // Primeiro setor da FAT
+    uint32_t fat_sectors;            // Setores por FAT
+    uint8_t *fat_table;              // FAT table in memory (só FAT12)
+    uint16_t* fat_entries;           // FAT12 desempacotada (uma entrada por cluster)
+    uint32_t cluster_count;          // Clusters do volume + 2 reservados
+    uint32_t free_clusters;          // FS_FREE_UNKNOWN até ser contado
+    uint32_t next_free;              // Onde começar a procurar cluster livre
+    uint32_t root_cluster;           // Diretório raiz (só FAT32)
+    uint32_t fsinfo_sector;          // Setor do FSInfo (só FAT32)
+    uint32_t root_dir_sectors;       // Tamanho da raiz fixa (FAT12/16)
     uint32_t root_dir_sector;        // First sector of root directory
     uint32_t data_sector;            // First sector of data area
     uint32_t sectors_per_cluster;    // Sectors per cluster
     uint32_t bytes_per_cluster;      // Bytes per cluster
 } filesystem_t;
 
+// Extent: 'length' clusters consecutivos no disco a partir de 'disk_cluster',
+// cobrindo os clusters do arquivo a partir de 'file_cluster'
+typedef struct {
+    uint32_t file_cluster;
+    uint32_t disk_cluster;
+    uint32_t length;
+} fs_extent_t;
+
+// Entrada do cache de diretório, chaveada pelo nome 8.3 empacotado
+typedef struct fs_dentry {
+    fat12_dir_entry_t entry;         // Cópia da entrada do disco
+    char long_name[FS_NAME_MAX];     // Nome VFAT ("" se não houver)
+    uint32_t dir_lba;                // Setor da entrada no diretório
+    uint16_t dir_index;              // Posição da entrada no setor
+    uint8_t negative;                // 1 = nome sabidamente inexistente
+    struct fs_dentry* hash_next;     // Encadeamento no bucket
+} fs_dentry_t;
+
+// Componente de caminho em cache, chaveado por (diretório pai, nome pedido)
+typedef struct fs_pcache_entry {
+    uint32_t parent;                 // Primeiro cluster do pai (0 = raiz)
+    uint32_t hash;
+    char name[FS_NAME_MAX];          // Componente como foi pedido
+    fs_dentry_t dentry;              // Resultado (negative = não existe)
+    uint8_t used;
+    struct fs_pcache_entry* hash_next;
+} fs_pcache_entry_t;
+
 // File handle structure
 typedef struct file_handle {
-    char filename[12];               // 8.3 format filename
+    char filename[12];               // Nome 8.3 empacotado da entrada
     uint32_t size;                   // File size
     uint32_t current_cluster;        // Current cluster
+    uint32_t first_cluster;          // Início da cadeia (0 = arquivo vazio)
+    uint32_t dir_lba;                // Entrada no diretório (para gravar tamanho)
+    uint16_t dir_index;
     uint32_t position;               // Current position in file
+    uint32_t ra_expected;            // Posição da próxima leitura sequencial
+    uint32_t ra_window;              // Janela de read-ahead (setores)
+    uint32_t ra_end;                 // Fim do trecho já antecipado (bytes)
+    fs_extent_t extents[FS_MAX_EXTENTS]; // Mapa da cadeia de clusters
+    uint32_t extent_count;
+    uint8_t extents_complete;        // 0 = cadeia maior que o mapa
+    uint8_t dirty;                   // Tamanho/cluster inicial a gravar no fechamento
     uint8_t is_open;                 // File open flag
 } file_handle_t;
 
@@ -91,6 +239,7 @@ typedef struct file_handle {
 
 // Inicialização
 int fs_init(void);
+int fs_mount(blockdev_t* dev);
 int fs_read_boot_sector(void);
 int fs_load_fat_table(void);
 
@@ -98,15 +247,22 @@ int fs_load_fat_table(void);
 int fs_open(const char* filename, file_handle_t* handle);
 int fs_read(file_handle_t* handle, void* buffer, uint32_t size);
 int fs_close(file_handle_t* handle);
-int fs_list_directory(void);
+int fs_flush(file_handle_t* handle);
+int fs_write(file_handle_t* handle, const void* buffer, uint32_t size);
+int fs_create(const char* filename, file_handle_t* handle);
+int fs_delete(const char* filename);
+int fs_seek(file_handle_t* handle, uint32_t offset);
+int fs_pread(file_handle_t* handle, void* buffer, uint32_t size, uint32_t offset);
+int fs_list_directory(const char* path);
 
 // Utilitários
 void fs_print_boot_info(void);
 uint32_t fs_get_next_cluster(uint32_t cluster);
 int fs_find_file(const char* filename, fat12_dir_entry_t* entry);
-
-// Funções de disco (implementadas em disk.c)
-int disk_read_sector(uint32_t sector, void* buffer);
-int disk_write_sector(uint32_t sector, const void* buffer);
+void fs_dcache_invalidate(void);
+void cmd_fsbench(const char* filename);
+void cmd_fatbench(const char* filename);
+void cmd_fswbench(void);
+void cmd_pathbench(const char* path);
 
 #endif // FILESYSTEM_H
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "multiboot.h"
 
 // ============================================================================
 // CONFIGURAÇÕES DE HARDWARE
@@ -73,6 +74,9 @@ typedef struct {
     uint32_t base;
 } __attribute__((packed)) idt_ptr;
 
+// Handler de IRQ registrado por um driver
+typedef void (*irq_handler_t)(void);
+
 // ============================================================================
 // DECLARAÇÕES DE FUNÇÕES
 // ============================================================================
@@ -99,6 +103,24 @@ void handle_keypress(uint8_t scancode);
 void timer_handler(void);
 void keyboard_handler(void);
 
+// IRQs de dispositivos (2-15)
+int irq_register_handler(uint8_t irq, irq_handler_t handler);
+void irq_dispatch(uint32_t irq);
+
+// Desabilita interrupções salvando o estado anterior de EFLAGS
+static inline uint32_t irq_save(void) {
+    uint32_t flags;
+    __asm__ volatile ("pushfd\n\tpop %0\n\tcli" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+// Restaura o estado de interrupções salvo por irq_save()
+static inline void irq_restore(uint32_t flags) {
+    if (flags & 0x200) {
+        __asm__ volatile ("sti" : : : "memory");
+    }
+}
+
 // Funções auxiliares
 size_t strlen(const char* str);
 int strcmp(const char* s1, const char* s2);
@@ -106,13 +128,23 @@ void uint_to_str(uint32_t num, char* buffer, size_t buffer_size);
 size_t string_length(const char* str);
 void string_copy(const char* src, char* dst);
 void memory_copy(void* dst, const void* src, size_t n);
+void memory_set(void* dst, uint8_t value, size_t n);
 int memory_compare(const void* s1, const void* s2, size_t n);
 void terminal_print_dec(uint32_t num);
+void terminal_print_hex(uint32_t num, int digits);
+
+// Relógio de alta resolução (TSC calibrado contra o PIT no boot)
+uint64_t tsc_read(void);
+void tsc_calibrate(void);
+uint64_t div64_32(uint64_t dividend, uint32_t divisor);
+uint32_t tsc_to_us(uint64_t cycles);
+uint32_t tsc_to_ns(uint64_t cycles);
 
-// Função principal do kernel
-void kernel_main(void);
+// Função principal do kernel (argumentos vindos do bootloader Multiboot)
+void kernel_main(uint32_t magic, multiboot_info_t* mbi);
 
 // Variáveis globais externas
 extern volatile uint32_t timer_ticks;
+extern uint32_t tsc_khz;
 
 #endif // KERNEL_H
\ No newline at end of file
@@ -0,0 +1,54 @@
+#ifndef MULTIBOOT_H
+#define MULTIBOOT_H
+
+#include <stdint.h>
+
+// ============================================================================
+// ESTRUTURAS DO MULTIBOOT (ESPECIFICAÇÃO 0.6.96)
+// ============================================================================
+
+// Valor de EAX na entrada quando carregado por um bootloader Multiboot
+#define MULTIBOOT_BOOTLOADER_MAGIC  0x2BADB002
+
+// Campos válidos de multiboot_info_t
+#define MULTIBOOT_INFO_MEMORY       0x001   // mem_lower / mem_upper
+#define MULTIBOOT_INFO_CMDLINE      0x004
+#define MULTIBOOT_INFO_MODS         0x008   // mods_count / mods_addr
+#define MULTIBOOT_INFO_MEM_MAP      0x040   // mmap_length / mmap_addr
+
+// Tipos de região do mapa de memória
+#define MULTIBOOT_MEMORY_AVAILABLE  1
+
+// Informações passadas pelo bootloader (ponteiro em EBX)
+typedef struct {
+    uint32_t flags;
+    uint32_t mem_lower;             // KB abaixo de 1 MB
+    uint32_t mem_upper;             // KB acima de 1 MB
+    uint32_t boot_device;
+    uint32_t cmdline;
+    uint32_t mods_count;
+    uint32_t mods_addr;
+    uint32_t syms[4];
+    uint32_t mmap_length;
+    uint32_t mmap_addr;
+} __attribute__((packed)) multiboot_info_t;
+
+// Módulo carregado junto com o kernel (ex.: imagem do RAM disk)
+typedef struct {
+    uint32_t mod_start;
+    uint32_t mod_end;               // Primeiro byte após o módulo
+    uint32_t string;                // Linha de comando do módulo
+    uint32_t reserved;
+} __attribute__((packed)) multiboot_module_t;
+
+// Entrada do mapa de memória ('size' não inclui o próprio campo)
+typedef struct {
+    uint32_t size;
+    uint32_t addr_low;
+    uint32_t addr_high;
+    uint32_t len_low;
+    uint32_t len_high;
+    uint32_t type;
+} __attribute__((packed)) multiboot_mmap_entry_t;
+
+#endif // MULTIBOOT_H
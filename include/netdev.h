@@ -0,0 +1,167 @@
+#ifndef NETDEV_H
+#define NETDEV_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "network.h"
+
+// ============================================================================
+// CAMADA DE DISPOSITIVOS DE REDE
+// ============================================================================
+
+// Limites
+#define NETDEV_MAX              4
+#define NETDEV_NAME_LEN         8
+#define NETDEV_MAX_QUEUES       4       // Filas de RX/TX por dispositivo
+#define NETDEV_POLL_BUDGET      64      // Frames por passada de polling
+
+// Buffers de pacote compartilhados entre drivers e pilha
+#define NETBUF_SIZE             2048    // Cabeçalho do driver + frame inteiro
+#define NETBUF_COUNT            384     // Anéis RX (e1000 + virtio-net) e sockets
+
+// Capacidades de offload do dispositivo (netdev_t.features)
+#define NETDEV_F_TX_CSUM        0x01    // Completa o checksum L4 no envio
+#define NETDEV_F_RX_CSUM        0x02    // Valida o checksum L4 na recepção
+
+// Flags de um frame recebido (netdev_receive)
+#define NETDEV_RX_CSUM_VALID    0x01    // Checksum L4 já conferido pela placa
+
+// Contadores de uma fila
+typedef struct {
+    uint32_t packets;
+    uint32_t bytes;
+    uint32_t errors;
+    uint32_t drops;                     // Sem espaço no anel ou no destino
+} netdev_queue_stats_t;
+
+// Pedido de offload que acompanha um frame. Offsets contados a partir do
+// início do frame; só é usado se o dispositivo anuncia a capacidade
+typedef struct {
+    uint16_t csum_start;                // Início da soma L4
+    uint16_t csum_offset;               // Campo do checksum, relativo a csum_start
+} netdev_offload_t;
+
+// Buffer de pacote. Drivers com um buffer por descritor (e1000,
+// virtio-net) o emprestam à pilha junto com o frame; quem fica com ele
+// (a fila de um socket) devolve com netbuf_free. Um datagrama remontado
+// maior que o buffer deixa nele só os cabeçalhos: os dados ficam na
+// remontagem IP (ext_data) até ip_reasm_release
+typedef struct netbuf {
+    struct netbuf* next;                // Pool livre ou fila do dono
+    uint16_t offset;                    // Início dos dados úteis em data
+    uint16_t len;                       // Bytes úteis
+    uint16_t net_offset;                // Cabeçalho IP (preenchido pela pilha)
+    const uint8_t* ext_data;            // Dados fora do buffer (0 = em data)
+    uint8_t data[NETBUF_SIZE] __attribute__((aligned(16)));
+} netbuf_t;
+
+// Buffer dono de um endereço data (cookie dos anéis)
+static inline netbuf_t* netbuf_from_data(void* data) {
+    return (netbuf_t*)((uint8_t*)data - offsetof(netbuf_t, data));
+}
+
+// Contadores do pool
+typedef struct {
+    uint32_t free;
+    uint32_t min_free;                  // Menor folga já vista
+    uint32_t alloc_failures;
+    uint32_t loaned;                    // Frames que ficaram no buffer do driver
+    uint32_t copied;                    // Frames copiados para um buffer do pool
+} netbuf_stats_t;
+
+typedef struct netdev netdev_t;
+
+// Operações de um driver. transmit copia o frame (já com cabeçalho
+// Ethernet) para o anel de envio e retorna 0, ou -1 se não há espaço.
+// offload é 0 quando o checksum já foi calculado pela pilha. Dentro de
+// um lote (dev->tx_batch) o driver não avisa a placa a cada frame: flush
+// publica tudo de uma vez. print_stats (opcional) acrescenta contadores
+// do driver ao netstat.
+//
+// Recepção: a interrupção de RX só agenda o dispositivo
+// (netdev_rx_schedule), que fica mascarado enquanto poll colhe até
+// 'budget' frames por passada. rx_irq_enable retorna 1 se chegaram
+// frames antes de a interrupção voltar (o polling continua). Drivers com
+// um netbuf por descritor entregam com netdev_receive_buf e põem no anel
+// o buffer retornado
+typedef struct {
+    int (*transmit)(netdev_t* dev, const void* frame, uint32_t len,
+                    const netdev_offload_t* offload);
+    void (*flush)(netdev_t* dev);
+    int (*poll)(netdev_t* dev, int budget);
+    void (*rx_irq_disable)(netdev_t* dev);
+    int (*rx_irq_enable)(netdev_t* dev);
+    void (*print_stats)(const netdev_t* dev);
+} netdev_ops_t;
+
+// Contadores do polling de recepção
+typedef struct {
+    uint32_t schedules;                 // Interrupções de RX que agendaram
+    uint32_t polls;                     // Passadas
+    uint32_t packets;                   // Frames colhidos nas passadas
+    uint32_t budget_exhausted;          // Passadas que esgotaram o orçamento
+    uint32_t max_packets;               // Maior passada
+    uint64_t cycles;                    // Tempo (TSC) dentro das passadas
+} netdev_poll_stats_t;
+
+// Dispositivo registrado
+struct netdev {
+    char name[NETDEV_NAME_LEN];         // eth0, eth1...
+    const char* driver;                 // "rtl8139"...
+    uint8_t index;
+    uint8_t irq;
+    uint8_t link_up;
+    uint8_t rx_queues;
+    uint8_t tx_queues;
+    uint8_t features;                   // NETDEV_F_*
+    uint8_t tx_batch;                   // Lotes de envio abertos
+    volatile uint8_t rx_scheduled;      // Polling pendente (RX mascarado)
+    mac_addr_t mac;
+    const netdev_ops_t* ops;
+    void* priv;                         // Estado do driver
+    netdev_queue_stats_t rx[NETDEV_MAX_QUEUES];
+    netdev_queue_stats_t tx[NETDEV_MAX_QUEUES];
+    netdev_poll_stats_t poll;
+};
+
+// ============================================================================
+// FUNÇÕES DA CAMADA DE REDE
+// ============================================================================
+
+// Registro e busca (o nome ethN segue a ordem de registro)
+netdev_t* netdev_register(const char* driver, const mac_addr_t* mac, uint8_t irq,
+                          uint8_t rx_queues, uint8_t tx_queues,
+                          const netdev_ops_t* ops, void* priv);
+netdev_t* netdev_get(int index);
+int netdev_count(void);
+
+// Envio e entrega de frames recebidos (chamada pelo driver)
+int netdev_transmit(netdev_t* dev, const void* frame, uint32_t len);
+int netdev_transmit_offload(netdev_t* dev, const void* frame, uint32_t len,
+                            const netdev_offload_t* offload);
+void netdev_receive(netdev_t* dev, uint8_t queue, const uint8_t* frame, uint32_t len,
+                    uint8_t flags);
+netbuf_t* netdev_receive_buf(netdev_t* dev, uint8_t queue, netbuf_t* buf, uint16_t offset,
+                             uint32_t len, uint8_t flags);
+uint8_t netdev_select_queue(const netdev_t* dev, const uint8_t* frame, uint32_t len);
+
+// Buffers de pacote
+void netbuf_init(void);
+netbuf_t* netbuf_alloc(void);
+void netbuf_free(netbuf_t* buf);
+netbuf_t* netbuf_take(const uint8_t* data, uint32_t len);
+const netbuf_stats_t* netbuf_get_stats(void);
+
+// Recepção por polling: a interrupção agenda, o laço principal colhe
+void netdev_rx_schedule(netdev_t* dev);
+int netdev_poll(void);
+int netdev_poll_pending(void);
+
+// Lote de envio: uma única notificação à placa para vários frames
+void netdev_tx_batch_begin(netdev_t* dev);
+void netdev_tx_batch_end(netdev_t* dev);
+
+// Diagnóstico
+void netdev_print_stats(const netdev_t* dev);
+
+#endif // NETDEV_H
@@ -9,11 +9,25 @@
 // ============================================================================
 
 // Tamanhos padrão
-#define ETH_FRAME_SIZE      1518
+#define ETH_FRAME_SIZE      1514    // Sem o CRC
 #define ETH_HEADER_SIZE     14
+#define ETH_MTU             1500
 #define ETH_ADDR_LEN        6
 #define IP_ADDR_LEN         4
+#define IP_HEADER_SIZE      20
+#define IP_DEFAULT_TTL      64
+#define IP_MAX_PAYLOAD      65515   // 65535 menos o cabeçalho (com fragmentação)
+
+// Cache de vizinhos (ARP)
 #define ARP_TABLE_SIZE      32
+#define ARP_HASH_SIZE       64      // Potência de 2
+#define ARP_REACHABLE_TICKS 3000    // Confirmação vale 30 s; depois STALE
+#define ARP_STALE_TICKS     6000    // STALE sem uso por 60 s é removida
+#define ARP_RETRY_TICKS     100     // Intervalo entre requisições (1 s)
+#define ARP_MAX_RETRIES     3       // Requisições antes de desistir
+#define ARP_SCAN_TICKS      10      // Intervalo da varredura de idade
+#define ARP_QUEUE_SIZE      16      // Pacotes aguardando resolução (total)
+#define ARP_QUEUE_PER_ENTRY 4       // ... por vizinho
 
 // Tipos Ethernet
 #define ETH_TYPE_IP         0x0800
@@ -24,6 +38,56 @@
 #define IP_PROTO_TCP        6
 #define IP_PROTO_UDP        17
 
+// Fragmentação (flags_offset)
+#define IP_FLAG_MF          0x2000
+#define IP_OFFSET_MASK      0x1FFF
+
+// Remontagem de fragmentos (RFC 815)
+#define IP_REASM_MAX        8       // Datagramas em remontagem ou retidos por sockets
+#define IP_REASM_BUF_SIZE   65536   // Dados de um datagrama (mais o último buraco)
+#define IP_REASM_TIMEOUT    3000    // Ticks para chegarem todos os fragmentos (30 s)
+#define IP_REASM_SCAN_TICKS 50      // Intervalo da varredura de prazos
+
+// ARP
+#define ARP_HTYPE_ETHERNET  1
+#define ARP_OP_REQUEST      1
+#define ARP_OP_REPLY        2
+
+// ICMP
+#define ICMP_ECHO_REPLY     0
+#define ICMP_ECHO_REQUEST   8
+#define ICMP_TIME_EXCEEDED  11
+#define ICMP_FRAG_TIMEOUT   1       // Código: prazo de remontagem esgotado
+
+// Ping (eco ICMP)
+#define PING_DEFAULT_COUNT  4
+#define PING_FLOOD_COUNT    100     // -f sem -c (não há como interromper)
+#define PING_DEFAULT_SIZE   56      // Bytes de dados, como no ping do Unix
+#define PING_MIN_SIZE       8       // Carimbo do TSC no início dos dados
+#define PING_MAX_SIZE       65507   // Máximo IP - ICMP (acima de 1472, fragmentado)
+#define PING_DEFAULT_INTERVAL 1000  // ms
+#define PING_FLOOD_INTERVAL 10      // ms, ou assim que todas as respostas chegarem
+#define PING_TIMEOUT        1000    // ms de espera pelas últimas respostas
+#define PING_HIST_BUCKETS   16      // Histograma log2 do RTT em microssegundos
+#define PING_SEQ_WINDOW     1024    // Sequências rastreadas contra duplicatas
+
+// Ordem de bytes da rede (big-endian)
+static inline uint16_t htons(uint16_t value) {
+    return (uint16_t)((value << 8) | (value >> 8));
+}
+
+static inline uint16_t ntohs(uint16_t value) {
+    return htons(value);
+}
+
+static inline uint32_t htonl(uint32_t value) {
+    return (value << 24) | ((value & 0xFF00) << 8) | ((value >> 8) & 0xFF00) | (value >> 24);
+}
+
+static inline uint32_t ntohl(uint32_t value) {
+    return htonl(value);
+}
+
 // ============================================================================
 // ESTRUTURAS DE DADOS
 // ============================================================================
@@ -59,114 +123,203 @@ typedef struct {
     ip_addr_t dst_ip;        // IP destino
 } __attribute__((packed)) ip_header_t;
 
-// Entrada da tabela ARP
+// Pacote ARP (Ethernet/IPv4)
+typedef struct {
+    uint16_t htype;          // Tipo de hardware
+    uint16_t ptype;          // Tipo de protocolo
+    uint8_t hlen;
+    uint8_t plen;
+    uint16_t oper;           // Requisição ou resposta
+    mac_addr_t sha;          // MAC de quem envia
+    ip_addr_t spa;           // IP de quem envia
+    mac_addr_t tha;          // MAC alvo
+    ip_addr_t tpa;           // IP alvo
+} __attribute__((packed)) arp_packet_t;
+
+// Cabeçalho ICMP (eco)
+typedef struct {
+    uint8_t type;
+    uint8_t code;
+    uint16_t checksum;
+    uint16_t id;
+    uint16_t seq;
+} __attribute__((packed)) icmp_header_t;
+
+// Sessão do comando ping: respostas são contabilizadas em icmp_receive
 typedef struct {
+    ip_addr_t dst;
+    uint16_t id;
+    uint8_t active;
+    uint8_t flood;                  // Sem linha por resposta
+    uint32_t sent;
+    uint32_t received;
+    uint32_t duplicates;
+    uint32_t rtt_min;               // ns
+    uint32_t rtt_max;               // ns
+    uint64_t rtt_sum;               // ns
+    uint64_t rtt_sum_sq;            // us² (desvio padrão)
+    uint32_t hist[PING_HIST_BUCKETS];
+    uint32_t seen[PING_SEQ_WINDOW / 32];
+} ping_session_t;
+
+// Estado de um vizinho
+#define ARP_STATE_FREE          0
+#define ARP_STATE_INCOMPLETE    1   // Requisição em andamento
+#define ARP_STATE_REACHABLE     2   // Confirmado há menos de ARP_REACHABLE_TICKS
+#define ARP_STATE_STALE         3   // Usável, revalidado no próximo uso
+
+// Pacote IP pronto aguardando a resolução do próximo salto
+typedef struct arp_pending {
+    struct arp_pending* next;
+    uint16_t len;
+    uint8_t data[ETH_MTU];
+} arp_pending_t;
+
+// Entrada do cache ARP, chaveada pelo IP
+typedef struct arp_entry {
     ip_addr_t ip;
     mac_addr_t mac;
-    uint8_t valid;
+    uint8_t state;
+    uint8_t retries;                // Requisições sem resposta
+    uint8_t queued;                 // Pacotes na fila pendente
+    uint32_t confirmed;             // Tick da última confirmação
+    uint32_t requested;             // Tick da última requisição
+    uint32_t used;                  // Tick do último uso
+    uint32_t hits;
+    arp_pending_t* queue_head;
+    arp_pending_t* queue_tail;
+    struct arp_entry* hash_next;    // Encadeamento no bucket
+    struct arp_entry* lru_prev;     // Lista LRU (cabeça = mais recente)
+    struct arp_entry* lru_next;
 } arp_entry_t;
 
+// Estatísticas do cache ARP
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t requests;              // Requisições enviadas
+    uint32_t evictions;
+    uint32_t failures;              // Resoluções abandonadas
+    uint32_t queued;
+    uint32_t flushed;               // Pacotes enviados ao resolver
+    uint32_t dropped;               // Pacotes descartados da fila
+} arp_stats_t;
+
+// Estado de um datagrama em remontagem
+#define IP_REASM_FREE       0
+#define IP_REASM_ACTIVE     1   // Esperando fragmentos
+#define IP_REASM_DONE       2   // Completo, sendo entregue
+#define IP_REASM_HELD       3   // Completo, retido por um socket até liberar
+
+// Datagrama em remontagem, chaveado por origem, id e protocolo. Os
+// buracos (descritores da RFC 815) ficam no próprio buffer, no início de
+// cada trecho que falta; os dados vêm logo depois do cabeçalho para o
+// datagrama completo ser entregue contíguo
+typedef struct {
+    uint8_t state;
+    uint8_t protocol;
+    uint8_t has_first;              // Fragmento de offset 0 recebido
+    uint16_t id;
+    uint16_t holes;                 // Offset do primeiro buraco
+    ip_addr_t src_ip;
+    uint32_t total;                 // Bytes de dados (0 = falta o último fragmento)
+    uint32_t received_end;          // Maior fim de fragmento já visto
+    uint32_t started;               // Tick do primeiro fragmento
+    uint32_t fragments;
+    uint8_t packet[IP_HEADER_SIZE + IP_REASM_BUF_SIZE] __attribute__((aligned(16)));
+} ip_reasm_t;
+
+// Estatísticas de fragmentação (nomes do MIB IP)
+typedef struct {
+    uint32_t reasm_reqds;           // Fragmentos recebidos
+    uint32_t reasm_oks;             // Datagramas remontados
+    uint32_t reasm_fails;           // Fragmentos inválidos ou inconsistentes
+    uint32_t reasm_timeouts;        // Datagramas expirados incompletos
+    uint32_t reasm_evictions;       // Despejados para dar lugar a outro
+    uint32_t frag_oks;              // Datagramas fragmentados no envio
+    uint32_t frag_creates;          // Fragmentos gerados
+    uint32_t frag_fails;            // Sem MAC do próximo salto ou interrompidos
+} ip_frag_stats_t;
+
+struct netdev;
+
 // Interface de rede
 typedef struct {
+    struct netdev* dev;      // 0 = modo simulado
     mac_addr_t mac_address;
     ip_addr_t ip_address;
     ip_addr_t subnet_mask;
     ip_addr_t gateway;
+    uint16_t mtu;            // Maior pacote IP sem fragmentar
     uint8_t enabled;
     char name[16];
 } network_interface_t;
 
-// ============================================================================
-// DRIVER ETHERNET (RTL8139)
-// ============================================================================
-
-// Registradores RTL8139
-#define RTL8139_IDR0        0x00    // ID Registers
-#define RTL8139_IDR4        0x04
-#define RTL8139_MAR0        0x08    // Multicast Registers
-#define RTL8139_MAR4        0x0C
-#define RTL8139_TSAD0       0x20    // Transmit Start Address
-#define RTL8139_TSAD1       0x24
-#define RTL8139_TSAD2       0x28
-#define RTL8139_TSAD3       0x2C
-#define RTL8139_TSD0        0x10    // Transmit Status
-#define RTL8139_TSD1        0x14
-#define RTL8139_TSD2        0x18
-#define RTL8139_TSD3        0x1C
-#define RTL8139_RBSTART     0x30    // Receive Buffer Start
-#define RTL8139_ERBCR       0x34    // Early RX Byte Count
-#define RTL8139_ERSR        0x36    // Early RX Status
-#define RTL8139_CMD         0x37    // Command Register
-#define RTL8139_CAPR        0x38    // Current Address of Packet Read
-#define RTL8139_CBR         0x3A    // Current Buffer Address
-#define RTL8139_IMR         0x3C    // Interrupt Mask
-#define RTL8139_ISR         0x3E    // Interrupt Status
-#define RTL8139_TCR         0x40    // Transmit Configuration
-#define RTL8139_RCR         0x44    // Receive Configuration
-#define RTL8139_TCTR        0x48    // Timer Count
-#define RTL8139_MPC         0x4C    // Missed Packet Counter
-#define RTL8139_9346CR      0x50    // EEPROM Command
-#define RTL8139_CONFIG0     0x51    // Configuration Register 0
-#define RTL8139_CONFIG1     0x52    // Configuration Register 1
-#define RTL8139_MSR         0x58    // Media Status Register
-#define RTL8139_CONFIG4     0x5A    // Configuration Register 4
-#define RTL8139_MULINT      0x5C    // Multiple Interrupt Select
-#define RTL8139_BMCR        0x62    // Basic Mode Control Register
-#define RTL8139_BMSR        0x64    // Basic Mode Status Register
-
-// Comandos
-#define RTL8139_CMD_RST     0x10    // Reset
-#define RTL8139_CMD_RE      0x08    // Receiver Enable
-#define RTL8139_CMD_TE      0x04    // Transmitter Enable
-#define RTL8139_CMD_BUFE    0x01    // Buffer Empty
-
-// Estado do driver
-typedef struct {
-    uint16_t io_base;           // Endereço base I/O
-    uint32_t tx_buffer[4];      // Buffers de transmissão
-    uint32_t rx_buffer;         // Buffer de recepção
-    uint8_t tx_cur;             // Índice atual TX
-    uint16_t rx_cur;            // Índice atual RX
-    network_interface_t interface;
-} rtl8139_device_t;
-
 // ============================================================================
 // FUNÇÕES PÚBLICAS
 // ============================================================================
 
 // Inicialização
 void network_init(void);
-int rtl8139_init(void);
-void network_interface_init(void);
+void network_interface_init(struct netdev* dev);
+const network_interface_t* network_get_interface(void);
 
 // Transmissão/Recepção
 int eth_send_frame(const uint8_t* data, size_t len, const mac_addr_t* dst_mac, uint16_t type);
-void eth_receive_frame(void);
-void network_process_packets(void);
+void eth_receive_frame(struct netdev* dev, const uint8_t* frame, size_t len, uint8_t flags);
+int network_process_packets(void);
 
 // Utilidades
 void mac_to_string(const mac_addr_t* mac, char* str);
 void ip_to_string(const ip_addr_t* ip, char* str);
 int string_to_ip(const char* str, ip_addr_t* ip);
 uint16_t calculate_checksum(const void* data, size_t len);
+uint32_t checksum_accumulate(uint32_t sum, const void* data, size_t len);
+uint16_t checksum_finish(uint32_t sum);
+const char* net_next_token(const char* args, char* token, size_t size);
+int net_parse_uint(const char* str, uint32_t* value);
+uint32_t l4_pseudo_sum(const ip_addr_t* src, const ip_addr_t* dst, uint8_t protocol,
+                       size_t len);
+uint16_t l4_checksum(const ip_addr_t* src, const ip_addr_t* dst, uint8_t protocol,
+                     const void* data, size_t len);
 
 // ARP
 void arp_init(void);
 int arp_lookup(const ip_addr_t* ip, mac_addr_t* mac);
 void arp_add_entry(const ip_addr_t* ip, const mac_addr_t* mac);
 void arp_request(const ip_addr_t* ip);
+void arp_receive(const uint8_t* packet, size_t len);
+void arp_timer(void);
 
 // IP
 int ip_send(const uint8_t* data, size_t len, const ip_addr_t* dst_ip, uint8_t protocol);
+int ip_send_l4(uint8_t* segment, size_t len, const ip_addr_t* dst_ip, uint8_t protocol,
+               uint16_t csum_offset);
 void ip_receive(const uint8_t* packet, size_t len);
+int ip_resolve(const ip_addr_t* dst_ip, uint32_t timeout_ms);
+int ip_next_hop_mac(const ip_addr_t* dst_ip, mac_addr_t* mac);
+
+// Fragmentação e remontagem. ip_reasm_input retorna o datagrama completo
+// (entregue e depois devolvido com ip_reasm_done); quem precisa dos dados
+// além da entrega os retém com ip_reasm_hold até ip_reasm_release
+void ip_frag_init(void);
+int ip_fragment(const ip_header_t* ip, const uint8_t* data, size_t len, uint32_t mtu);
+const ip_header_t* ip_reasm_input(const ip_header_t* ip, uint32_t header_len);
+void ip_reasm_done(const ip_header_t* ip);
+int ip_reasm_hold(const uint8_t* data);
+void ip_reasm_release(const uint8_t* data);
+void ip_reasm_timer(void);
+const ip_frag_stats_t* ip_frag_get_stats(void);
+void ip_frag_print_stats(void);
 
 // ICMP (Ping)
+void icmp_receive(const ip_addr_t* src_ip, uint8_t ttl, const uint8_t* data, size_t len);
 void icmp_reply(const ip_addr_t* src_ip, const uint8_t* data, size_t len);
-int ping_send(const ip_addr_t* dst_ip, uint16_t id, uint16_t seq);
+int ping_send(const ip_addr_t* dst_ip, uint16_t id, uint16_t seq, size_t size);
 
 // Comandos de rede
 void cmd_ifconfig(void);
-void cmd_ping(const char* target);
+void cmd_ping(const char* args);
 void cmd_arp(void);
 void cmd_netstat(void);
 
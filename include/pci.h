@@ -0,0 +1,186 @@
+#ifndef PCI_H
+#define PCI_H
+
+#include <stdint.h>
+
+// ============================================================================
+// BARRAMENTO PCI (CONFIG MECHANISM #1)
+// ============================================================================
+
+// Portas de configuração
+#define PCI_CONFIG_ADDRESS      0xCF8
+#define PCI_CONFIG_DATA         0xCFC
+
+// Offsets do espaço de configuração (header tipo 0)
+#define PCI_VENDOR_ID           0x00
+#define PCI_DEVICE_ID           0x02
+#define PCI_COMMAND             0x04
+#define PCI_STATUS              0x06
+#define PCI_REVISION_ID         0x08
+#define PCI_PROG_IF             0x09
+#define PCI_SUBCLASS            0x0A
+#define PCI_CLASS               0x0B
+#define PCI_HEADER_TYPE         0x0E
+#define PCI_BAR0                0x10
+#define PCI_BAR5                0x24
+#define PCI_SUBSYS_VENDOR_ID    0x2C
+#define PCI_SUBSYS_ID           0x2E
+#define PCI_CAP_POINTER         0x34
+#define PCI_INTERRUPT_LINE      0x3C
+#define PCI_INTERRUPT_PIN       0x3D
+
+// Header tipo 1 (ponte PCI-PCI)
+#define PCI_SECONDARY_BUS       0x19
+
+// Tipo de header
+#define PCI_HEADER_TYPE_MASK    0x7F
+#define PCI_HEADER_MULTI_FUNC   0x80
+#define PCI_HEADER_NORMAL       0x00
+#define PCI_HEADER_BRIDGE       0x01
+
+// Bits do registrador de comando
+#define PCI_CMD_IO_SPACE        0x0001
+#define PCI_CMD_MEM_SPACE       0x0002
+#define PCI_CMD_BUS_MASTER      0x0004
+#define PCI_CMD_INTX_DISABLE    0x0400
+
+// Bits do registrador de status
+#define PCI_STATUS_CAP_LIST     0x0010
+
+#define PCI_VENDOR_NONE         0xFFFF
+
+// Capabilities (lista encadeada a partir de PCI_CAP_POINTER)
+#define PCI_CAP_ID_PM           0x01
+#define PCI_CAP_ID_MSI          0x05
+#define PCI_CAP_ID_VENDOR       0x09
+#define PCI_CAP_ID_PCIE         0x10
+#define PCI_CAP_ID_MSIX         0x11
+
+// Power management: PMCSR e estados
+#define PCI_PM_CTRL             0x04
+#define PCI_PM_STATE_MASK       0x0003
+#define PCI_PM_STATE_D0         0x0000
+
+// MSI: registrador de controle
+#define PCI_MSI_CTRL            0x02
+#define PCI_MSI_CTRL_ENABLE     0x0001
+#define PCI_MSI_CTRL_MMC_SHIFT  1       // Vetores suportados: 2^MMC
+#define PCI_MSI_CTRL_64BIT      0x0080
+#define PCI_MSI_CTRL_MASKABLE   0x0100
+
+// MSI-X: controle, tabela e PBA (offset | BIR)
+#define PCI_MSIX_CTRL           0x02
+#define PCI_MSIX_CTRL_SIZE      0x07FF  // Vetores - 1
+#define PCI_MSIX_CTRL_MASK_ALL  0x4000
+#define PCI_MSIX_CTRL_ENABLE    0x8000
+#define PCI_MSIX_TABLE          0x04
+#define PCI_MSIX_PBA            0x08
+#define PCI_MSIX_BIR_MASK       0x7
+
+// Classes usadas pelos drivers e pelo lspci
+#define PCI_CLASS_BRIDGE        0x06
+#define PCI_SUBCLASS_PCI_BRIDGE 0x04
+
+// Tabela de dispositivos enumerados
+#define PCI_MAX_DEVICES         32
+#define PCI_MAX_BARS            6
+#define PCI_MAX_CAPS            8
+
+// Tipo de um BAR
+#define PCI_BAR_IO              0x01
+#define PCI_BAR_MEM64           0x02
+#define PCI_BAR_PREFETCH        0x04
+
+// Curinga nas tabelas de IDs dos drivers
+#define PCI_ANY_ID              0xFFFF
+
+// Endereço de uma função PCI
+typedef struct {
+    uint8_t bus;
+    uint8_t device;
+    uint8_t function;
+} pci_address_t;
+
+// Capability encontrada na lista
+typedef struct {
+    uint8_t id;
+    uint8_t offset;
+} pci_cap_t;
+
+struct pci_driver;
+
+// Função enumerada, com o espaço de configuração relevante em cache
+typedef struct {
+    pci_address_t addr;
+    uint16_t vendor_id;
+    uint16_t device_id;
+    uint16_t subsys_vendor;
+    uint16_t subsys_id;
+    uint8_t class_code;
+    uint8_t subclass;
+    uint8_t prog_if;
+    uint8_t revision;
+    uint8_t header_type;
+    uint8_t irq_line;
+    uint8_t irq_pin;                    // 0 = sem INTx
+    uint32_t bar[PCI_MAX_BARS];         // Base sem os bits de tipo
+    uint32_t bar_size[PCI_MAX_BARS];    // 0 = BAR não implementado
+    uint8_t bar_flags[PCI_MAX_BARS];    // PCI_BAR_*
+    pci_cap_t caps[PCI_MAX_CAPS];
+    uint8_t cap_count;
+    uint8_t pm_cap;                     // Offsets das capabilities (0 = ausente)
+    uint8_t msi_cap;
+    uint8_t msix_cap;
+    uint16_t msi_vectors;               // Vetores suportados
+    uint16_t msix_vectors;
+    const struct pci_driver* driver;    // 0 = sem driver
+    void* driver_data;
+} pci_device_t;
+
+// Entrada da tabela de IDs de um driver (PCI_ANY_ID casa com qualquer
+// valor). A tabela termina numa entrada com vendor 0
+typedef struct {
+    uint16_t vendor;
+    uint16_t device;
+    uint16_t class_code;
+    uint16_t subclass;
+} pci_device_id_t;
+
+// Driver: probe retorna 0 quando assume o dispositivo
+typedef struct pci_driver {
+    const char* name;
+    const pci_device_id_t* ids;
+    int (*probe)(pci_device_t* dev, const pci_device_id_t* id);
+} pci_driver_t;
+
+// ============================================================================
+// FUNÇÕES PCI
+// ============================================================================
+
+// Enumeração (varre os barramentos uma vez; as buscas usam o cache)
+void pci_init(void);
+uint32_t pci_device_count(void);
+pci_device_t* pci_get_device(uint32_t index);
+
+// Acesso ao espaço de configuração
+uint32_t pci_config_read32(const pci_address_t* addr, uint8_t offset);
+uint16_t pci_config_read16(const pci_address_t* addr, uint8_t offset);
+uint8_t pci_config_read8(const pci_address_t* addr, uint8_t offset);
+void pci_config_write32(const pci_address_t* addr, uint8_t offset, uint32_t value);
+void pci_config_write16(const pci_address_t* addr, uint8_t offset, uint16_t value);
+
+// Busca e configuração de dispositivos
+int pci_find_class(uint8_t class_code, uint8_t subclass, uint8_t prog_if, pci_address_t* out);
+int pci_find_device(uint16_t vendor, uint16_t device, pci_address_t* out);
+void pci_enable_device(const pci_address_t* addr, uint16_t flags);
+uint32_t pci_read_bar(const pci_address_t* addr, int bar);
+
+// Drivers e capabilities
+int pci_register_driver(const pci_driver_t* driver);
+int pci_device_enable(pci_device_t* dev, uint16_t flags);
+uint8_t pci_find_capability(const pci_device_t* dev, uint8_t id);
+
+// Comando
+void cmd_lspci(int verbose);
+
+#endif // PCI_H
@@ -0,0 +1,14 @@
+#ifndef RAMDISK_H
+#define RAMDISK_H
+
+#include <stdint.h>
+#include "multiboot.h"
+
+// ============================================================================
+// RAM DISK (IMAGEM CARREGADA COMO MÓDULO MULTIBOOT)
+// ============================================================================
+
+// Registra ram0 sobre o primeiro módulo Multiboot, se houver
+int ramdisk_init(uint32_t magic, const multiboot_info_t* mbi);
+
+#endif // RAMDISK_H
@@ -0,0 +1,123 @@
+#ifndef RTL8139_H
+#define RTL8139_H
+
+#include <stdint.h>
+#include "netdev.h"
+
+// ============================================================================
+// DRIVER ETHERNET (RTL8139)
+// ============================================================================
+
+// Identificação PCI
+#define RTL8139_PCI_VENDOR  0x10EC
+#define RTL8139_PCI_DEVICE  0x8139
+
+// Registradores RTL8139
+#define RTL8139_IDR0        0x00    // ID Registers
+#define RTL8139_IDR4        0x04
+#define RTL8139_MAR0        0x08    // Multicast Registers
+#define RTL8139_MAR4        0x0C
+#define RTL8139_TSAD0       0x20    // Transmit Start Address
+#define RTL8139_TSAD1       0x24
+#define RTL8139_TSAD2       0x28
+#define RTL8139_TSAD3       0x2C
+#define RTL8139_TSD0        0x10    // Transmit Status
+#define RTL8139_TSD1        0x14
+#define RTL8139_TSD2        0x18
+#define RTL8139_TSD3        0x1C
+#define RTL8139_RBSTART     0x30    // Receive Buffer Start
+#define RTL8139_ERBCR       0x34    // Early RX Byte Count
+#define RTL8139_ERSR        0x36    // Early RX Status
+#define RTL8139_CMD         0x37    // Command Register
+#define RTL8139_CAPR        0x38    // Current Address of Packet Read
+#define RTL8139_CBR         0x3A    // Current Buffer Address
+#define RTL8139_IMR         0x3C    // Interrupt Mask
+#define RTL8139_ISR         0x3E    // Interrupt Status
+#define RTL8139_TCR         0x40    // Transmit Configuration
+#define RTL8139_RCR         0x44    // Receive Configuration
+#define RTL8139_TCTR        0x48    // Timer Count
+#define RTL8139_MPC         0x4C    // Missed Packet Counter
+#define RTL8139_9346CR      0x50    // EEPROM Command
+#define RTL8139_CONFIG0     0x51    // Configuration Register 0
+#define RTL8139_CONFIG1     0x52    // Configuration Register 1
+#define RTL8139_MSR         0x58    // Media Status Register
+#define RTL8139_CONFIG4     0x5A    // Configuration Register 4
+#define RTL8139_MULINT      0x5C    // Multiple Interrupt Select
+#define RTL8139_BMCR        0x62    // Basic Mode Control Register
+#define RTL8139_BMSR        0x64    // Basic Mode Status Register
+
+// Comandos
+#define RTL8139_CMD_RST     0x10    // Reset
+#define RTL8139_CMD_RE      0x08    // Receiver Enable
+#define RTL8139_CMD_TE      0x04    // Transmitter Enable
+#define RTL8139_CMD_BUFE    0x01    // Buffer Empty
+
+// Interrupções (IMR/ISR; ISR limpa escrevendo 1)
+#define RTL8139_INT_ROK     0x0001  // Pacote recebido
+#define RTL8139_INT_RER     0x0002  // Erro de recepção
+#define RTL8139_INT_TOK     0x0004  // Pacote transmitido
+#define RTL8139_INT_TER     0x0008  // Erro de transmissão
+#define RTL8139_INT_RXOVW   0x0010  // Anel de recepção cheio
+#define RTL8139_INT_LINK    0x0020  // Mudança de link
+#define RTL8139_INT_FOVW    0x0040  // FIFO de recepção cheia
+#define RTL8139_INT_SERR    0x8000  // Erro de sistema (PCI)
+#define RTL8139_INT_RX      (RTL8139_INT_ROK | RTL8139_INT_RER | RTL8139_INT_RXOVW | \
+                             RTL8139_INT_FOVW)
+#define RTL8139_INT_ALL     (RTL8139_INT_RX | RTL8139_INT_TOK | RTL8139_INT_TER | \
+                             RTL8139_INT_LINK | RTL8139_INT_SERR)
+
+// Status de transmissão (TSD0-3)
+#define RTL8139_TSD_SIZE    0x00001FFF
+#define RTL8139_TSD_OWN     0x00002000  // DMA para a FIFO concluído
+#define RTL8139_TSD_TUN     0x00004000  // Underrun
+#define RTL8139_TSD_TOK     0x00008000  // Transmitido
+#define RTL8139_TSD_TABT    0x40000000  // Abortado
+
+// Configuração de recepção (RCR)
+#define RTL8139_RCR_AAP     0x00000001  // Todos os pacotes (promíscuo)
+#define RTL8139_RCR_APM     0x00000002  // Endereço físico da placa
+#define RTL8139_RCR_AM      0x00000004  // Multicast
+#define RTL8139_RCR_AB      0x00000008  // Broadcast
+#define RTL8139_RCR_WRAP    0x00000080  // Pacote não é partido no fim do anel
+#define RTL8139_RCR_MXDMA   0x00000700  // DMA sem limite de rajada
+#define RTL8139_RCR_RBLEN_8K 0x00000000 // Anel de 8 KB + 16
+#define RTL8139_RCR_RXFTH   0x0000E000  // Sem limiar de FIFO (pacote inteiro)
+
+// Configuração de transmissão (TCR)
+#define RTL8139_TCR_MXDMA   0x00000600  // Rajada de 1 KB
+#define RTL8139_TCR_IFG     0x03000000  // Intervalo entre frames padrão
+
+// Cabeçalho que a placa grava antes de cada pacote no anel
+#define RTL8139_RX_ROK      0x0001
+#define RTL8139_RX_HEADER   4
+
+// Media Status
+#define RTL8139_MSR_LINKB   0x04    // 1 = sem link
+
+// Anéis
+#define RTL8139_RX_RING     8192    // Tamanho lógico do anel (RBLEN 8K)
+#define RTL8139_RX_BUFFER   (RTL8139_RX_RING + 16 + 1536)  // Folga para WRAP
+#define RTL8139_TX_SLOTS    4       // TSD0-3 usados em rodízio
+#define RTL8139_TX_BUFFER   1536
+#define RTL8139_MIN_FRAME   60      // Sem o CRC
+
+// Estado do driver
+typedef struct {
+    uint16_t io_base;           // Endereço base I/O
+    uint8_t tx_cur;             // Próximo descritor livre
+    uint8_t tx_dirty;           // Descritor mais antigo em voo
+    uint8_t tx_count;           // Descritores em voo
+    uint16_t tx_len[RTL8139_TX_SLOTS];
+    uint16_t rx_offset;         // Próximo pacote no anel (CAPR + 16)
+    uint32_t rx_overflows;
+    uint32_t irqs;
+    netdev_t* netdev;
+} rtl8139_device_t;
+
+// ============================================================================
+// FUNÇÕES DO DRIVER
+// ============================================================================
+
+int rtl8139_init(void);
+
+#endif // RTL8139_H
@@ -0,0 +1,292 @@
+#ifndef TCP_H
+#define TCP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "network.h"
+
+// ============================================================================
+// TCP - SOCKETS DO KERNEL
+// ============================================================================
+
+// Cabeçalho e flags
+#define TCP_HEADER_SIZE         20
+#define TCP_OPTIONS_MAX         40
+#define TCP_FIN                 0x01
+#define TCP_SYN                 0x02
+#define TCP_RST                 0x04
+#define TCP_PSH                 0x08
+#define TCP_ACK                 0x10
+#define TCP_URG                 0x20
+
+// Opções
+#define TCP_OPT_END             0
+#define TCP_OPT_NOP             1
+#define TCP_OPT_MSS             2
+#define TCP_OPT_WSCALE          3
+#define TCP_OPT_SACK_PERM       4
+#define TCP_OPT_SACK            5
+
+// Limites
+#define TCP_MAX_CONNS           8       // Sockets, escutas e conexões filhas
+#define TCP_HASH_SIZE           64      // Potência de 2
+#define TCP_SND_BUF             65536   // Anel de envio por conexão (potência de 2)
+#define TCP_RCV_BUF             131072  // Anel de recepção por conexão (potência de 2)
+#define TCP_MSS                 (ETH_MTU - IP_HEADER_SIZE - TCP_HEADER_SIZE)
+#define TCP_DEFAULT_MSS         536     // Sem a opção MSS (RFC 1122)
+#define TCP_RCV_WSCALE          2       // Janela anunciada até 256 KB
+#define TCP_MAX_WSCALE          14
+#define TCP_BACKLOG_MAX         4
+#define TCP_OOO_MAX             4       // Trechos fora de ordem (= blocos SACK enviados)
+#define TCP_SACK_MAX            8       // Trechos confirmados por SACK (placar do envio)
+#define TCP_EPHEMERAL_MIN       49152
+#define TCP_EPHEMERAL_MAX       65535
+
+// Controle de congestionamento
+#define TCP_INIT_CWND           10      // Segmentos (RFC 6928)
+#define TCP_DUPACK_THRESHOLD    3
+
+// Temporizadores (ms)
+#define TCP_RTO_INIT            1000    // RFC 6298
+#define TCP_RTO_MIN             200
+#define TCP_RTO_MAX             60000
+#define TCP_DELACK_TIME         40      // ACK atrasado
+#define TCP_TIME_WAIT_TIME      60000   // 2 MSL
+#define TCP_FIN_WAIT2_TIME      60000   // Órfã esperando o FIN do outro lado
+#define TCP_SYN_RETRIES         5
+#define TCP_MAX_RETRIES         8       // Retransmissões por RTO antes de desistir
+
+// Roda de temporizadores: um slot por tick, horizonte de 2,56 s. Prazos
+// mais longos dão voltas na roda
+#define TCP_WHEEL_SIZE          256     // Potência de 2
+
+// Benchmark (tcpbench)
+#define TCP_BENCH_MB            16      // Megabytes enviados por padrão
+#define TCP_BENCH_CHUNK         16384   // Bytes por tcp_send
+#define TCP_BENCH_TIMEOUT       10000   // ms sem progresso antes de desistir
+
+// Retornos de tcp_recv/tcp_accept além de -1 (erro)
+#define TCP_AGAIN               (-2)    // Nada ainda; tente depois
+
+// Aritmética de números de sequência (módulo 2^32)
+#define TCP_SEQ_LT(a, b)        ((int32_t)((a) - (b)) < 0)
+#define TCP_SEQ_LEQ(a, b)       ((int32_t)((a) - (b)) <= 0)
+#define TCP_SEQ_GT(a, b)        ((int32_t)((a) - (b)) > 0)
+#define TCP_SEQ_GEQ(a, b)       ((int32_t)((a) - (b)) >= 0)
+
+// Estados (RFC 793)
+typedef enum {
+    TCP_CLOSED = 0,
+    TCP_LISTEN,
+    TCP_SYN_SENT,
+    TCP_SYN_RECEIVED,
+    TCP_ESTABLISHED,
+    TCP_FIN_WAIT_1,
+    TCP_FIN_WAIT_2,
+    TCP_CLOSE_WAIT,
+    TCP_CLOSING,
+    TCP_LAST_ACK,
+    TCP_TIME_WAIT
+} tcp_state_t;
+
+// Flags de uma conexão
+#define TCP_CF_ORPHAN           0x01    // Fechada pelo dono; liberada ao terminar
+#define TCP_CF_FIN_QUEUED       0x02    // FIN depois dos dados do anel
+#define TCP_CF_FIN_SENT         0x04
+#define TCP_CF_SACK             0x08    // SACK negociado
+#define TCP_CF_WSCALE           0x10    // Escala de janela negociada
+#define TCP_CF_OUTPUT           0x20    // Envio interrompido (anel TX da placa cheio)
+#define TCP_CF_RECOVERY         0x40    // Recuperação rápida em andamento
+
+typedef struct __attribute__((packed)) {
+    uint16_t src_port;
+    uint16_t dst_port;
+    uint32_t seq;
+    uint32_t ack;
+    uint8_t data_offset;                // Tamanho do cabeçalho em palavras (<< 4)
+    uint8_t flags;
+    uint16_t window;
+    uint16_t checksum;
+    uint16_t urgent;
+} tcp_header_t;
+
+// Trecho [start, end) do espaço de sequência
+typedef struct {
+    uint32_t start;
+    uint32_t end;
+} tcp_range_t;
+
+// Estado do CUBIC (RFC 8312), em segmentos e milissegundos
+typedef struct {
+    uint32_t last_max;                  // W_max
+    uint32_t epoch_start;               // Início da época (0 = nova época)
+    uint32_t origin;                    // Janela no platô da curva
+    uint32_t k;                         // Tempo até o platô
+    uint32_t cnt;                       // ACKs por segmento de aumento
+    uint32_t ack_cnt;                   // Segmentos confirmados na época
+    uint32_t tcp_cwnd;                  // Janela estimada do Reno (região amigável)
+} tcp_cubic_t;
+
+// Segmento recebido, com as opções já decodificadas
+typedef struct {
+    uint32_t seq;
+    uint32_t ack;
+    uint32_t len;                       // Bytes de dados
+    const uint8_t* data;
+    uint16_t wnd;                       // Campo do cabeçalho, sem escala
+    uint8_t flags;
+    uint8_t wscale;                     // 0xFF = sem a opção
+    uint16_t mss;                       // 0 = sem a opção
+    uint8_t sack_perm;
+    uint8_t sack_count;
+    tcp_range_t sack[TCP_OOO_MAX];
+} tcp_segment_t;
+
+struct tcp_conn;
+
+// Algoritmo de controle de congestionamento. cong_avoid cresce a janela a
+// cada ACK novo (partida lenta incluída); ssthresh dá o novo limiar numa
+// perda (recuperação rápida ou RTO)
+typedef struct {
+    const char* name;
+    void (*init)(struct tcp_conn* conn);
+    void (*cong_avoid)(struct tcp_conn* conn, uint32_t acked);
+    uint32_t (*ssthresh)(struct tcp_conn* conn);
+} tcp_cc_ops_t;
+
+// Conexão (ou socket em escuta)
+typedef struct tcp_conn {
+    uint8_t used;
+    uint8_t state;                      // tcp_state_t
+    uint8_t flags;                      // TCP_CF_*
+    int8_t error;                       // -1 depois de RST ou timeout
+    uint16_t local_port;
+    uint16_t remote_port;
+    ip_addr_t remote_ip;
+    struct tcp_conn* hash_next;         // Encadeamento no bucket
+    struct tcp_conn* listener;          // Escuta que criou a conexão
+    struct tcp_conn* accept_next;       // Fila de accept da escuta
+    struct tcp_conn* accept_head;
+    uint8_t backlog;
+    uint8_t pending;                    // Filhas ainda não aceitas
+    
+    // Envio: o anel guarda de snd_una até o fim dos dados da aplicação
+    uint32_t iss;
+    uint32_t snd_una;                   // Mais antigo não confirmado
+    uint32_t snd_nxt;                   // Próximo a enviar
+    uint32_t snd_max;                   // Maior já enviado
+    uint32_t snd_wnd;                   // Janela do outro lado (já escalada)
+    uint32_t snd_wl1;                   // seq/ack da última atualização de janela
+    uint32_t snd_wl2;
+    uint32_t snd_head;                  // Índice de snd_una no anel
+    uint32_t snd_len;                   // Bytes no anel
+    uint16_t mss;                       // MSS efetivo
+    uint8_t snd_wscale;
+    uint8_t rcv_wscale;
+    
+    // Recepção: o anel guarda os dados ainda não lidos e, adiante, os
+    // trechos fora de ordem no lugar definitivo
+    uint32_t irs;
+    uint32_t rcv_nxt;
+    uint32_t rcv_adv;                   // Borda direita anunciada
+    uint32_t rcv_head;                  // Índice do próximo byte a ler
+    uint32_t rcv_len;                   // Bytes prontos para leitura
+    uint16_t segs_unacked;              // Segmentos desde o último ACK
+    uint8_t ooo_count;
+    tcp_range_t ooo[TCP_OOO_MAX];       // Mais recente primeiro (ordem dos blocos SACK)
+    
+    // Placar do SACK recebido (ordenado, sem sobreposição)
+    uint8_t sacked_count;
+    tcp_range_t sacked[TCP_SACK_MAX];
+    
+    // Congestionamento
+    const tcp_cc_ops_t* cc;
+    uint32_t cwnd;                      // Bytes
+    uint32_t ssthresh;
+    uint32_t cwnd_cnt;                  // Acúmulo em prevenção (unidade do algoritmo)
+    uint32_t recover;                   // snd_max ao entrar em recuperação
+    uint32_t retx_next;                 // Próximo buraco a retransmitir
+    uint8_t dupacks;
+    tcp_cubic_t cubic;
+    
+    // RTT (RFC 6298), medido pelo TSC em um segmento por vez (Karn)
+    uint32_t srtt_us;
+    uint32_t rttvar_us;
+    uint32_t rtt_min_us;
+    uint32_t rto_ms;
+    uint32_t rtt_seq;
+    uint64_t rtt_start;
+    uint8_t rtt_timing;
+    uint8_t backoff;                    // Retransmissões seguidas por RTO
+    
+    // Temporizadores (tick absoluto; 0 = desarmado) e lugar na roda
+    uint32_t rto_at;                    // Retransmissão, persistência ou SYN
+    uint32_t delack_at;
+    uint32_t linger_at;                 // TIME_WAIT ou FIN_WAIT_2 órfã
+    uint32_t timer_expires;             // Prazo do slot atual (0 = fora da roda)
+    struct tcp_conn* timer_prev;
+    struct tcp_conn* timer_next;
+    
+    // Contadores
+    uint32_t segs_in;
+    uint32_t segs_out;
+    uint32_t bytes_in;                  // Dados entregues em ordem
+    uint32_t bytes_out;                 // Dados confirmados
+    uint32_t retransmits;
+    uint32_t fast_retransmits;
+    uint32_t timeouts;
+    uint32_t ooo_segs;
+    uint32_t sack_recovered;            // Retransmissões guiadas por SACK
+} tcp_conn_t;
+
+// Estatísticas (nomes do MIB TCP)
+typedef struct {
+    uint32_t active_opens;
+    uint32_t passive_opens;
+    uint32_t attempt_fails;
+    uint32_t estab_resets;
+    uint32_t in_segs;
+    uint32_t out_segs;
+    uint32_t retrans_segs;
+    uint32_t in_errs;
+    uint32_t out_rsts;
+    uint32_t csum_offloaded;
+    uint32_t timer_fires;               // Conexões retiradas da roda no prazo
+    uint32_t timer_relinks;             // Conexões movidas na roda
+} tcp_stats_t;
+
+// ============================================================================
+// FUNÇÕES DO TCP
+// ============================================================================
+
+void tcp_init(void);
+
+// Sockets (descritor = índice na tabela; retornam -1 em erro). Nada
+// bloqueia: quem espera chama network_process_packets
+int tcp_socket(void);
+int tcp_bind(int sock, uint16_t port);
+int tcp_listen(int sock, int backlog);
+int tcp_accept(int sock);
+int tcp_connect(int sock, const ip_addr_t* ip, uint16_t port);
+int tcp_send(int sock, const void* data, size_t len);
+int tcp_recv(int sock, void* data, size_t len);
+int tcp_shutdown(int sock);
+void tcp_close(int sock);
+int tcp_get_state(int sock);
+const tcp_conn_t* tcp_get_conn(int sock);
+int tcp_set_congestion(int sock, const char* name);
+
+// Recepção e temporizadores (chamados pela pilha)
+void tcp_receive(const ip_header_t* ip, const uint8_t* data, size_t len, uint8_t csum_valid);
+void tcp_timer(void);
+
+// Controle de congestionamento (tcp_cong.c)
+const tcp_cc_ops_t* tcp_cc_find(const char* name);
+const tcp_cc_ops_t* tcp_cc_default(void);
+
+// Diagnóstico e benchmark
+int tcp_active_connections(void);
+void tcp_print_stats(void);
+void cmd_tcpbench(const char* args);
+
+#endif // TCP_H
@@ -0,0 +1,55 @@
+#ifndef TMPFS_H
+#define TMPFS_H
+
+#include <stdint.h>
+#include "vfs.h"
+
+// ============================================================================
+// TMPFS - ARQUIVOS EM MEMÓRIA
+// ============================================================================
+
+// Limites
+#define TMPFS_PAGES             256     // 1 MB de dados (páginas de VFS_PAGE_SIZE)
+#define TMPFS_MAX_FILES         64
+#define TMPFS_NAME_MAX          32      // Com o terminador
+#define TMPFS_HASH_SIZE         32      // Potência de 2
+
+// Árvore radix de páginas por arquivo: 16 filhos por nó, altura h cobre
+// os índices abaixo de 16^h
+#define TMPFS_RADIX_SHIFT       4
+#define TMPFS_RADIX_SLOTS       (1 << TMPFS_RADIX_SHIFT)
+#define TMPFS_RADIX_NODES       128
+#define TMPFS_MAX_HEIGHT        4       // 65536 páginas
+
+// Benchmark: tmpfs contra o FAT pelo VFS
+#define TMPFS_BENCH_TICKS       100     // 1 s por fase
+#define TMPFS_BENCH_FILE_SIZE   1024
+#define TMPFS_BENCH_APPEND      256     // Bytes por escrita no append
+#define TMPFS_BENCH_LOG_SIZE    (512 * 1024)
+
+// Nó da árvore: no último nível os slots apontam para páginas
+typedef struct tmpfs_node {
+    void* slots[TMPFS_RADIX_SLOTS];
+} tmpfs_node_t;
+
+// Arquivo (o namespace é plano: /tmp/NOME)
+typedef struct tmpfs_file {
+    char name[TMPFS_NAME_MAX];
+    uint32_t size;
+    uint32_t generation;                // Muda a cada criação no slot
+    tmpfs_node_t* root;
+    uint8_t height;                     // 0 = sem páginas
+    uint8_t used;
+    uint8_t* tail_page;                 // Última página (append sem descer a árvore)
+    uint32_t tail_index;
+    struct tmpfs_file* hash_next;
+} tmpfs_file_t;
+
+// ============================================================================
+// FUNÇÕES DO TMPFS
+// ============================================================================
+
+int tmpfs_init(void);
+void cmd_tmpbench(void);
+
+#endif // TMPFS_H
@@ -0,0 +1,93 @@
+#ifndef UDP_H
+#define UDP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "network.h"
+#include "netdev.h"
+
+// ============================================================================
+// UDP - SOCKETS DO KERNEL
+// ============================================================================
+
+#define UDP_HEADER_SIZE         8
+#define UDP_MAX_PAYLOAD         (ETH_MTU - IP_HEADER_SIZE - UDP_HEADER_SIZE)
+#define UDP_MAX_DATAGRAM        (IP_MAX_PAYLOAD - UDP_HEADER_SIZE)  // Fragmentado
+#define UDP_MAX_SOCKETS         16
+#define UDP_HASH_SIZE           32      // Potência de 2
+#define UDP_RX_QUEUE_MAX        64      // Datagramas aguardando recvfrom
+#define UDP_EPHEMERAL_MIN       49152   // Portas automáticas (IANA)
+#define UDP_EPHEMERAL_MAX       65535
+
+// Benchmark (udpbench)
+#define UDP_BENCH_COUNT         10000   // Datagramas enviados por padrão
+#define UDP_BENCH_SIZE          64      // Bytes de dados por padrão
+#define UDP_BENCH_SECONDS       10      // Janela de recepção por padrão
+#define UDP_BENCH_BATCH         32      // Envios por lote (uma notificação à placa)
+#define UDP_BENCH_RETRY_MS      100     // Espera por espaço no anel TX
+#define UDP_BENCH_FRAG_COUNT    100     // Datagramas máximos no modo frag
+
+typedef struct {
+    uint16_t src_port;
+    uint16_t dst_port;
+    uint16_t length;                    // Cabeçalho + dados
+    uint16_t checksum;                  // 0 = não calculado
+} __attribute__((packed)) udp_header_t;
+
+// Socket: porta local no hash e fila de buffers recebidos
+typedef struct udp_socket {
+    uint8_t used;
+    uint16_t port;                      // Porta local (0 = sem bind)
+    uint16_t queued;
+    netbuf_t* rx_head;                  // Datagramas, do mais antigo
+    netbuf_t* rx_tail;
+    struct udp_socket* hash_next;       // Encadeamento no bucket
+    uint32_t rx_datagrams;
+    uint32_t rx_drops;                  // Fila cheia ou pool vazio
+    uint32_t tx_datagrams;
+} udp_socket_t;
+
+// Datagrama entregue por udp_recvfrom: os dados continuam no buffer do
+// pacote, ou no da remontagem IP se era fragmentado (sem cópia), até
+// udp_release
+typedef struct {
+    netbuf_t* buf;
+    const uint8_t* data;
+    uint16_t len;
+    ip_addr_t src_ip;
+    uint16_t src_port;
+} udp_datagram_t;
+
+// Estatísticas (nomes do MIB UDP)
+typedef struct {
+    uint32_t in_datagrams;
+    uint32_t no_ports;                  // Sem socket na porta
+    uint32_t in_errors;                 // Tamanho ou checksum inválido
+    uint32_t rcvbuf_errors;             // Fila do socket cheia ou pool vazio
+    uint32_t out_datagrams;
+    uint32_t csum_offloaded;            // Checksums conferidos pela placa
+} udp_stats_t;
+
+// ============================================================================
+// FUNÇÕES DO UDP
+// ============================================================================
+
+void udp_init(void);
+
+// Sockets (descritor = índice na tabela; retornam -1 em erro)
+int udp_socket(void);
+int udp_bind(int sock, uint16_t port);
+int udp_sendto(int sock, const void* data, size_t len, const ip_addr_t* dst_ip,
+               uint16_t dst_port);
+int udp_recvfrom(int sock, udp_datagram_t* dgram);
+void udp_release(udp_datagram_t* dgram);
+void udp_close(int sock);
+
+// Recepção (chamada por ip_receive)
+void udp_receive(const ip_header_t* ip, const uint8_t* data, size_t len, uint8_t csum_valid);
+
+// Diagnóstico e benchmark
+void udp_print_stats(void);
+void cmd_udpbench(const char* args);
+
+#endif // UDP_H
@@ -0,0 +1,158 @@
+#ifndef VFS_H
+#define VFS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// SISTEMA DE ARQUIVOS VIRTUAL (VFS)
+// ============================================================================
+
+// Limites
+#define VFS_MAX_MOUNTS          4
+#define VFS_MOUNT_LEN           16      // Prefixo do ponto de montagem
+#define VFS_PATH_MAX            128     // Caminho absoluto normalizado
+#define VFS_MAX_INODES          32      // Inodes em memória (abertos ou em cache)
+#define VFS_MAX_DENTRIES        64      // Caminhos resolvidos lembrados
+#define VFS_DENTRY_HASH_SIZE    32      // Potência de 2
+#define VFS_MAX_FDS             16      // Descritores por contexto
+
+// Page cache compartilhado por todos os sistemas de arquivos
+#define VFS_PAGE_SIZE           4096
+#define VFS_PAGES               64      // 256 KB
+#define VFS_PAGE_HASH_SIZE      64      // Potência de 2
+
+// Flags de abertura
+#define VFS_O_READ              0x01
+#define VFS_O_WRITE             0x02
+#define VFS_O_RDWR              (VFS_O_READ | VFS_O_WRITE)
+#define VFS_O_CREATE            0x04    // Cria o arquivo se não existir
+#define VFS_O_APPEND            0x08    // Escritas vão sempre para o fim
+
+typedef struct vfs_mount vfs_mount_t;
+typedef struct vfs_inode vfs_inode_t;
+
+// Identidade de um arquivo devolvida pelo lookup do sistema de arquivos
+typedef struct {
+    uint32_t key;                       // Única dentro da montagem
+    uint32_t generation;                // Muda quando a entrada é reaproveitada
+    uint32_t size;
+} vfs_stat_t;
+
+// Operações de um sistema de arquivos. Os caminhos são relativos ao ponto
+// de montagem ("/DIR/ARQ"). lookup, open e read_page (ou read) são
+// obrigatórias. Sistemas que já guardam os dados em memória fornecem read
+// e não passam pelo page cache. revalidate (opcional) confirma em O(1)
+// que path ainda leva a (key, generation); sem ela o VFS repete o lookup
+typedef struct {
+    const char* name;                   // "fat", "tmpfs"...
+    int (*lookup)(vfs_mount_t* mnt, const char* path, vfs_stat_t* stat);
+    int (*revalidate)(vfs_mount_t* mnt, const char* path, uint32_t key, uint32_t generation);
+    int (*open)(vfs_inode_t* inode, const char* path);
+    void (*release)(vfs_inode_t* inode);                // Inode despejado
+    int (*read_page)(vfs_inode_t* inode, uint32_t index, void* page);
+    int (*read)(vfs_inode_t* inode, uint32_t offset, void* data, uint32_t size);
+    int (*write)(vfs_inode_t* inode, uint32_t offset, const void* data, uint32_t size);
+    int (*flush)(vfs_inode_t* inode);                   // Último descritor fechado
+    int (*create)(vfs_mount_t* mnt, const char* path);
+    int (*unlink)(vfs_mount_t* mnt, const char* path);
+    int (*list)(vfs_mount_t* mnt, const char* path);
+} vfs_ops_t;
+
+// Ponto de montagem
+struct vfs_mount {
+    char prefix[VFS_MOUNT_LEN];         // "/" ou "/tmp"
+    uint32_t prefix_len;
+    const vfs_ops_t* ops;
+    void* priv;                         // Estado do sistema de arquivos
+};
+
+// Inode em memória, chaveado por (montagem, key). Fica em cache com as suas
+// páginas depois do último close até ser reaproveitado
+struct vfs_inode {
+    vfs_mount_t* mount;                 // 0 = livre
+    uint32_t key;
+    uint32_t generation;
+    uint32_t size;
+    uint16_t refcount;                  // Descritores abertos
+    uint16_t pages;                     // Páginas no page cache
+    uint32_t last_used;                 // Tick do último uso (despejo)
+    uint8_t index;                      // Posição na tabela (estado do backend)
+    void* priv;
+};
+
+// Caminho resolvido -> inode, com a identidade que o sistema de arquivos
+// deu no lookup (conferida a cada acerto)
+typedef struct vfs_dentry {
+    char path[VFS_PATH_MAX];
+    uint32_t hash;
+    uint32_t key;
+    uint32_t generation;
+    vfs_inode_t* inode;                 // 0 = livre
+    struct vfs_dentry* hash_next;
+} vfs_dentry_t;
+
+// Página do page cache, chaveada por (inode, índice da página)
+typedef struct vfs_page {
+    vfs_inode_t* inode;                 // 0 = livre
+    uint32_t index;
+    uint32_t valid;                     // Bytes válidos (página final do arquivo)
+    struct vfs_page* hash_next;
+    struct vfs_page* lru_prev;          // Lista LRU (cabeça = mais recente)
+    struct vfs_page* lru_next;
+    uint8_t data[VFS_PAGE_SIZE] __attribute__((aligned(16)));
+} vfs_page_t;
+
+// Arquivo aberto
+typedef struct {
+    vfs_inode_t* inode;                 // 0 = descritor livre
+    uint32_t position;
+    uint8_t flags;
+} vfs_file_t;
+
+// Contexto de execução: tabela de descritores própria
+typedef struct {
+    vfs_file_t files[VFS_MAX_FDS];
+} vfs_context_t;
+
+// Estatísticas
+typedef struct {
+    uint32_t page_hits;
+    uint32_t page_misses;
+    uint32_t page_evictions;
+    uint32_t dentry_hits;
+    uint32_t dentry_misses;
+    uint32_t dentry_stale;              // Acertos que o sistema de arquivos desmentiu
+    uint32_t inode_evictions;
+} vfs_stats_t;
+
+// ============================================================================
+// FUNÇÕES DO VFS
+// ============================================================================
+
+// Inicialização e montagem
+void vfs_init(void);
+int vfs_mount(const char* prefix, const vfs_ops_t* ops, void* priv);
+
+// Contextos (o shell usa o contexto do kernel)
+void vfs_context_init(vfs_context_t* ctx);
+vfs_context_t* vfs_set_context(vfs_context_t* ctx);
+
+// Descritores de arquivo
+int vfs_open(const char* path, uint8_t flags);
+int vfs_read(int fd, void* buffer, uint32_t size);
+int vfs_pread(int fd, void* buffer, uint32_t size, uint32_t offset);
+int vfs_write(int fd, const void* buffer, uint32_t size);
+int vfs_seek(int fd, uint32_t offset);
+int vfs_size(int fd);
+int vfs_close(int fd);
+
+// Operações por caminho
+int vfs_unlink(const char* path);
+int vfs_list(const char* path);
+
+// Estatísticas
+void vfs_get_stats(vfs_stats_t* stats);
+void cmd_vfsstat(void);
+
+#endif // VFS_H
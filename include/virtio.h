@@ -0,0 +1,134 @@
+#ifndef VIRTIO_H
+#define VIRTIO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "pci.h"
+
+// ============================================================================
+// VIRTIO - TRANSPORTE PCI LEGADO E VIRTQUEUES SPLIT
+// ============================================================================
+
+// Identificação PCI (dispositivos transicionais)
+#define VIRTIO_PCI_VENDOR           0x1AF4
+#define VIRTIO_PCI_DEVICE_NET       0x1000
+#define VIRTIO_PCI_DEVICE_BLK       0x1001
+
+// Registradores do transporte legado (BAR0, espaço de I/O)
+#define VIRTIO_REG_DEVICE_FEATURES  0x00
+#define VIRTIO_REG_GUEST_FEATURES   0x04
+#define VIRTIO_REG_QUEUE_ADDRESS    0x08    // PFN (endereço >> 12)
+#define VIRTIO_REG_QUEUE_SIZE       0x0C
+#define VIRTIO_REG_QUEUE_SELECT     0x0E
+#define VIRTIO_REG_QUEUE_NOTIFY     0x10
+#define VIRTIO_REG_DEVICE_STATUS    0x12
+#define VIRTIO_REG_ISR_STATUS       0x13
+#define VIRTIO_REG_DEVICE_CONFIG    0x14    // Configuração específica (sem MSI-X)
+
+// Bits de status do dispositivo
+#define VIRTIO_STATUS_ACKNOWLEDGE   0x01
+#define VIRTIO_STATUS_DRIVER        0x02
+#define VIRTIO_STATUS_DRIVER_OK     0x04
+#define VIRTIO_STATUS_FAILED        0x80
+
+// Features comuns a todos os dispositivos
+#define VIRTIO_RING_F_INDIRECT_DESC (1u << 28)
+#define VIRTIO_RING_F_EVENT_IDX     (1u << 29)
+
+// Flags dos descritores
+#define VIRTQ_DESC_F_NEXT           1
+#define VIRTQ_DESC_F_WRITE          2       // Buffer escrito pelo dispositivo
+#define VIRTQ_DESC_F_INDIRECT       4       // Aponta para uma tabela de descritores
+
+// Flags dos anéis (usadas quando EVENT_IDX não foi negociado)
+#define VIRTQ_AVAIL_F_NO_INTERRUPT  1
+#define VIRTQ_USED_F_NO_NOTIFY      1
+
+// Tamanho máximo de fila suportado pelo driver
+#define VIRTQ_MAX_SIZE              256
+#define VIRTQ_ALIGN                 4096
+
+// Memória necessária para uma fila de 'n' entradas (layout legado)
+#define VIRTQ_ALIGN_UP(x)           (((x) + VIRTQ_ALIGN - 1) & ~(VIRTQ_ALIGN - 1))
+#define VIRTQ_RING_BYTES(n)         (VIRTQ_ALIGN_UP(16 * (n) + 6 + 2 * (n)) + \
+                                     VIRTQ_ALIGN_UP(6 + 8 * (n)))
+
+// ============================================================================
+// ESTRUTURAS DO ANEL
+// ============================================================================
+
+// Descritor de buffer
+typedef struct {
+    uint32_t addr;          // Endereço físico (32 bits inferiores)
+    uint32_t addr_high;
+    uint32_t len;
+    uint16_t flags;
+    uint16_t next;
+} __attribute__((packed)) virtq_desc_t;
+
+// Anel de buffers disponíveis (driver -> dispositivo)
+typedef struct {
+    uint16_t flags;
+    volatile uint16_t idx;
+    uint16_t ring[];        // Seguido de used_event (EVENT_IDX)
+} __attribute__((packed)) virtq_avail_t;
+
+// Elemento do anel de buffers usados
+typedef struct {
+    uint32_t id;            // Cabeça da cadeia de descritores
+    uint32_t len;           // Bytes escritos pelo dispositivo
+} __attribute__((packed)) virtq_used_elem_t;
+
+// Anel de buffers usados (dispositivo -> driver)
+typedef struct {
+    volatile uint16_t flags;
+    volatile uint16_t idx;
+    virtq_used_elem_t ring[]; // Seguido de avail_event (EVENT_IDX)
+} __attribute__((packed)) virtq_used_t;
+
+// Segmento de buffer para montar uma cadeia
+typedef struct {
+    void* addr;
+    uint32_t len;
+    uint8_t device_writes;  // 1 = dispositivo escreve (entrada)
+} virtq_buf_t;
+
+// Virtqueue split
+typedef struct {
+    uint16_t io_base;               // BAR0 do dispositivo
+    uint16_t index;                 // Número da fila
+    uint16_t size;                  // Entradas (potência de 2)
+    uint8_t event_idx;              // 1 = EVENT_IDX negociado
+    virtq_desc_t* desc;
+    virtq_avail_t* avail;
+    virtq_used_t* used;
+    uint16_t free_head;             // Lista de descritores livres
+    uint16_t num_free;
+    uint16_t last_used_idx;         // Próximo elemento do anel usado a colher
+    uint16_t last_kick_idx;         // avail->idx na última notificação
+    void* cookies[VIRTQ_MAX_SIZE];  // Contexto por cabeça de cadeia
+    uint32_t kicks;                 // Notificações enviadas (saídas de VM)
+    uint32_t kicks_suppressed;      // Notificações evitadas pelo avail_event
+} virtqueue_t;
+
+// ============================================================================
+// FUNÇÕES DO TRANSPORTE
+// ============================================================================
+
+// Dispositivo
+int virtio_pci_setup(const pci_address_t* addr, uint16_t* io_base);
+uint32_t virtio_negotiate(uint16_t io_base, uint32_t supported);
+void virtio_set_status(uint16_t io_base, uint8_t status);
+uint8_t virtio_read_isr(uint16_t io_base);
+
+// Virtqueue
+int virtq_init(virtqueue_t* vq, uint16_t io_base, uint16_t index,
+               void* memory, size_t memory_size, uint8_t event_idx);
+int virtq_add_chain(virtqueue_t* vq, const virtq_buf_t* bufs, uint16_t count, void* cookie);
+int virtq_add_indirect(virtqueue_t* vq, virtq_desc_t* table, uint16_t count, void* cookie);
+void virtq_kick(virtqueue_t* vq);
+void* virtq_get_used(virtqueue_t* vq, uint32_t* len);
+void virtq_disable_interrupts(virtqueue_t* vq);
+int virtq_enable_interrupts(virtqueue_t* vq);
+
+#endif // VIRTIO_H
@@ -0,0 +1,65 @@
+#ifndef VIRTIO_BLK_H
+#define VIRTIO_BLK_H
+
+#include <stdint.h>
+
+// ============================================================================
+// DRIVER VIRTIO-BLK
+// ============================================================================
+
+// Tipos de requisição
+#define VIRTIO_BLK_T_IN             0       // Leitura
+#define VIRTIO_BLK_T_OUT            1       // Escrita
+#define VIRTIO_BLK_T_FLUSH          4
+
+// Status devolvido pelo dispositivo
+#define VIRTIO_BLK_S_OK             0
+#define VIRTIO_BLK_S_IOERR          1
+#define VIRTIO_BLK_S_UNSUPP         2
+
+// Features específicas
+#define VIRTIO_BLK_F_FLUSH          (1u << 9)
+
+// Configuração do dispositivo (offsets a partir de VIRTIO_REG_DEVICE_CONFIG)
+#define VIRTIO_BLK_CFG_CAPACITY     0x00    // uint64: setores de 512 bytes
+
+// Limites do driver
+#define VIRTIO_BLK_MAX_INFLIGHT     32      // Requisições simultâneas
+#define VIRTIO_BLK_MAX_SECTORS      256     // Setores por requisição
+#define VIRTIO_BLK_TIMEOUT_TICKS    500
+
+// Cabeçalho de requisição (lido pelo dispositivo)
+typedef struct {
+    uint32_t type;
+    uint32_t reserved;
+    uint32_t sector_low;
+    uint32_t sector_high;
+} __attribute__((packed)) virtio_blk_req_header_t;
+
+// Callback de conclusão (status 0 = sucesso, -1 = erro)
+typedef void (*virtio_blk_callback_t)(int status, void* ctx);
+
+// ============================================================================
+// FUNÇÕES DO DRIVER VIRTIO-BLK
+// ============================================================================
+
+// Inicialização
+int virtio_blk_init(void);
+int virtio_blk_available(void);
+uint32_t virtio_blk_sectors(void);
+
+// Interface assíncrona: várias submissões e um único virtio_blk_kick()
+int virtio_blk_submit(uint32_t lba, uint32_t count, void* buffer, int write,
+                      virtio_blk_callback_t callback, void* ctx);
+void virtio_blk_kick(void);
+int virtio_blk_poll(void);
+
+// Interface síncrona
+int virtio_blk_read(uint32_t lba, uint32_t count, void* buffer);
+int virtio_blk_write(uint32_t lba, uint32_t count, const void* buffer);
+int virtio_blk_flush(void);
+
+// Utilitários
+void virtio_blk_print_info(void);
+
+#endif // VIRTIO_BLK_H
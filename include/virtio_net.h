@@ -0,0 +1,98 @@
+#ifndef VIRTIO_NET_H
+#define VIRTIO_NET_H
+
+#include <stdint.h>
+#include "virtio.h"
+#include "netdev.h"
+
+// ============================================================================
+// DRIVER VIRTIO-NET
+// ============================================================================
+
+// Features específicas (palavra de 32 bits do transporte legado)
+#define VIRTIO_NET_F_CSUM           (1u << 0)   // Host completa checksum no envio
+#define VIRTIO_NET_F_GUEST_CSUM     (1u << 1)   // Host entrega checksum parcial/validado
+#define VIRTIO_NET_F_MAC            (1u << 5)   // MAC na configuração
+#define VIRTIO_NET_F_HOST_TSO4      (1u << 11)  // Host segmenta TCP/IPv4
+#define VIRTIO_NET_F_MRG_RXBUF      (1u << 15)  // Pacote pode ocupar vários buffers
+#define VIRTIO_NET_F_STATUS         (1u << 16)  // Estado do link na configuração
+#define VIRTIO_NET_F_CTRL_VQ        (1u << 17)  // Fila de controle
+#define VIRTIO_NET_F_MQ             (1u << 22)  // Vários pares de filas
+
+// Configuração do dispositivo (offsets a partir de VIRTIO_REG_DEVICE_CONFIG)
+#define VIRTIO_NET_CFG_MAC          0x00    // 6 bytes
+#define VIRTIO_NET_CFG_STATUS       0x06    // uint16 (F_STATUS)
+#define VIRTIO_NET_CFG_MAX_PAIRS    0x08    // uint16 (F_MQ)
+
+#define VIRTIO_NET_S_LINK_UP        1
+
+// Cabeçalho que precede cada pacote nas filas
+#define VIRTIO_NET_HDR_F_NEEDS_CSUM 1       // Checksum parcial a completar
+#define VIRTIO_NET_HDR_F_DATA_VALID 2       // Checksum já conferido (RX)
+#define VIRTIO_NET_HDR_GSO_NONE     0
+#define VIRTIO_NET_HDR_GSO_TCPV4    1
+
+typedef struct {
+    uint8_t flags;
+    uint8_t gso_type;
+    uint16_t hdr_len;           // Cabeçalhos até o payload (GSO)
+    uint16_t gso_size;          // MSS (GSO)
+    uint16_t csum_start;
+    uint16_t csum_offset;
+    uint16_t num_buffers;       // Só com MRG_RXBUF
+} __attribute__((packed)) virtio_net_hdr_t;
+
+#define VIRTIO_NET_HDR_SIZE         10      // Sem num_buffers
+#define VIRTIO_NET_HDR_MRG_SIZE     12
+
+// Fila de controle
+#define VIRTIO_NET_CTRL_MQ          4
+#define VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET 0
+#define VIRTIO_NET_OK               0
+
+typedef struct {
+    uint8_t class_id;
+    uint8_t command;
+} __attribute__((packed)) virtio_net_ctrl_hdr_t;
+
+// Limites do driver
+#define VIRTIO_NET_MAX_PAIRS        2       // Pares RX/TX usados
+#define VIRTIO_NET_RX_BUFFERS       64      // Buffers postados por fila RX
+#define VIRTIO_NET_RX_BUFFER_SIZE   NETBUF_SIZE // Cabeçalho + frame inteiro
+#define VIRTIO_NET_TX_SLOTS         32      // Frames em voo por fila TX
+#define VIRTIO_NET_TX_BUFFER_SIZE   (VIRTIO_NET_HDR_MRG_SIZE + ETH_FRAME_SIZE)
+#define VIRTIO_NET_MAX_PACKET       4096    // Remontagem de buffers mesclados
+#define VIRTIO_NET_CTRL_TIMEOUT     100     // Ticks
+#define VIRTIO_NET_TX_WAIT_MS       2       // Espera por slot com o anel TX cheio
+
+// Fila de envio: slots de frames com o cabeçalho virtio-net à frente
+typedef struct {
+    virtqueue_t vq;
+    uint8_t free[VIRTIO_NET_TX_SLOTS];  // Pilha de slots livres
+    uint8_t free_count;
+} virtio_net_txq_t;
+
+// Estado do driver
+typedef struct {
+    uint16_t io_base;
+    uint32_t features;          // Features negociadas
+    uint8_t pairs;              // Pares de filas em uso
+    uint8_t hdr_len;            // 10 ou 12 (MRG_RXBUF)
+    virtqueue_t rxq[VIRTIO_NET_MAX_PAIRS];
+    virtio_net_txq_t txq[VIRTIO_NET_MAX_PAIRS];
+    virtqueue_t ctrlq;
+    uint32_t irqs;
+    uint32_t rx_merged;         // Pacotes que ocuparam mais de um buffer
+    uint32_t rx_csum_fixed;     // Checksums parciais completados aqui
+    uint32_t tx_offloaded;      // Frames com checksum feito pelo host
+    uint32_t tx_ring_waits;     // Envios que esperaram o host liberar slots
+    netdev_t* netdev;
+} virtio_net_device_t;
+
+// ============================================================================
+// FUNÇÕES DO DRIVER
+// ============================================================================
+
+int virtio_net_init(void);
+
+#endif // VIRTIO_NET_H
@@ -25,6 +25,8 @@ stack_top:                      # Topo da stack (cresce para baixo)
 .type _start, @function         # Define _start como uma função
 _start:
     mov esp, offset stack_top   # Configura o ponteiro da stack (ESP)
+    push ebx                    # 2º argumento: informações do Multiboot
+    push eax                    # 1º argumento: magic do bootloader
     call kernel_main            # Chama a função principal do kernel em C
     cli                         # Desabilita interrupções (Clear Interrupt)
 1:  hlt                         # Para o processador (Halt)
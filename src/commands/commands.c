@@ -5,6 +5,15 @@
 
 #include "../../include/commands.h"
 #include "../../include/network.h"
+#include "../../include/udp.h"
+#include "../../include/tcp.h"
+#include "../../include/ahci.h"
+#include "../../include/disk.h"
+#include "../../include/filesystem.h"
+#include "../../include/bcache.h"
+#include "../../include/vfs.h"
+#include "../../include/tmpfs.h"
+#include "../../include/pci.h"
 #include <stdint.h>
 #include <stddef.h>
 
@@ -28,10 +37,31 @@ void cmd_help(void) {
     terminal_print("  shutdown - Encerra o sistema\n");
     terminal_print("\nRede:\n");
     terminal_print("  ifconfig - Mostra configuracoes de rede\n");
-    terminal_print("  ping IP  - Envia ping para endereco IP\n");
+    terminal_print("  ping IP  - Eco ICMP com RTT (-c N, -i seg, -s bytes, -f)\n");
     terminal_print("  arp      - Mostra tabela ARP\n");
     terminal_print("  netstat  - Estatisticas de rede\n");
-    terminal_print("\nSistema de arquivos: (em desenvolvimento)\n");
+    terminal_print("  udpbench tx IP PORTA [N] [BYTES] | rx PORTA [SEG] - Vazao UDP\n");
+    terminal_print("  udpbench frag IP PORTA [N] - UDP de 64 KB fragmentado\n");
+    terminal_print("  tcpbench send IP PORTA [MB] [cubic|newreno] | recv PORTA [SEG] - Vazao TCP\n");
+    terminal_print("\nHardware:\n");
+    terminal_print("  lspci [-v] - Dispositivos PCI (com -v, BARs e capabilities)\n");
+    terminal_print("\nArmazenamento:\n");
+    terminal_print("  diskinfo  - Informacoes do disco\n");
+    terminal_print("  lsblk     - Lista dispositivos de bloco\n");
+    terminal_print("  diskbench - Compara ATA PIO e virtio-blk\n");
+    terminal_print("  ahcibench - IOPS de leitura aleatoria AHCI (QD 1-32)\n");
+    terminal_print("  cachestat - Estatisticas do cache de blocos\n");
+    terminal_print("  sync      - Grava blocos modificados no disco\n");
+    terminal_print("\nSistema de arquivos:\n");
+    terminal_print("  ls [DIR] - Lista arquivos (raiz por padrao)\n");
+    terminal_print("  cat ARQ  - Mostra conteudo de um arquivo (/DIR/ARQ)\n");
+    terminal_print("  fsinfo   - Informacoes do volume FAT\n");
+    terminal_print("  vfsstat  - Montagens e page cache do VFS\n");
+    terminal_print("  fsbench ARQ - Vazao de leitura de um arquivo\n");
+    terminal_print("  fatbench ARQ - Percorre a cadeia de clusters\n");
+    terminal_print("  fswbench - Vazao de escrita (arquivos pequenos e grande)\n");
+    terminal_print("  pathbench CAMINHO - Latencia de resolucao de caminhos\n");
+    terminal_print("  tmpbench - Criacao e append no FAT e no tmpfs (/tmp)\n");
     terminal_print("\nAtalhos para encerrar:\n");
     terminal_print("- Comando: shutdown\n");
     terminal_print("- Tecla: ESC ou F12\n");
@@ -51,7 +81,7 @@ void cmd_about(void) {
     terminal_print("- Timer/PIT integrado\n");
     terminal_print("- IDT completa\n");
     terminal_print("- Tratamento de interrupcoes\n");
-    terminal_print("- Sistema de arquivos FAT12\n");
+    terminal_print("- Sistema de arquivos FAT12/16/32\n");
 }
 
 // Comando: uptime - Mostra tempo de execução
@@ -94,36 +124,59 @@ void cmd_shutdown(void) {
 }
 
 // ============================================================================
-// COMANDOS DO SISTEMA DE ARQUIVOS (EM DESENVOLVIMENTO)
+// COMANDOS DO SISTEMA DE ARQUIVOS
 // ============================================================================
 
-// Comando: ls - Lista arquivos do diretório (placeholder)
-void cmd_ls(void) {
-    terminal_print("\nSistema de arquivos em desenvolvimento.\n");
-    terminal_print("Comando 'ls' sera implementado em breve.\n");
+// Comando: ls [DIR] - Lista arquivos de um diretório (raiz por padrão)
+void cmd_ls(const char* path) {
+    terminal_print("\n");
+    if (vfs_list(path) < 0) {
+        if (path[0]) {
+            terminal_print("Diretorio nao encontrado: ");
+            terminal_print(path);
+            terminal_print("\n");
+        } else {
+            terminal_print("Sistema de arquivos nao montado.\n");
+        }
+    }
 }
 
-// Comando: cat - Mostra conteúdo de um arquivo (placeholder)
+// Comando: cat - Mostra conteúdo de um arquivo (pelo VFS e page cache)
 void cmd_cat(const char* filename) {
-    terminal_print("\nSistema de arquivos em desenvolvimento.\n");
-    terminal_print("Comando 'cat' sera implementado em breve.\n");
-    if (filename) {
-        terminal_print("Arquivo solicitado: ");
+    char chunk[257];
+    int bytes;
+    int fd = vfs_open(filename, VFS_O_READ);
+    
+    if (fd < 0) {
+        terminal_print("\nArquivo nao encontrado: ");
         terminal_print(filename);
         terminal_print("\n");
+        return;
+    }
+    
+    terminal_print("\n");
+    while ((bytes = vfs_read(fd, chunk, sizeof(chunk) - 1)) > 0) {
+        chunk[bytes] = '\0';
+        terminal_print(chunk);
+    }
+    if (bytes < 0) {
+        terminal_print("\nErro de leitura.");
     }
+    terminal_print("\n");
+    
+    vfs_close(fd);
 }
 
-// Comando: fsinfo - Mostra informações do sistema de arquivos (placeholder)
+// Comando: fsinfo - Mostra informações do sistema de arquivos
 void cmd_fsinfo(void) {
-    terminal_print("\nSistema de arquivos em desenvolvimento.\n");
-    terminal_print("Informacoes do FS serao implementadas em breve.\n");
+    terminal_print("\n");
+    fs_print_boot_info();
 }
 
-// Comando: diskinfo - Mostra informações do disco (placeholder)
+// Comando: diskinfo - Mostra informações do disco
 void cmd_diskinfo(void) {
-    terminal_print("\nSistema de arquivos em desenvolvimento.\n");
-    terminal_print("Informacoes do disco serao implementadas em breve.\n");
+    terminal_print("\n");
+    disk_print_info();
 }
 
 // ============================================================================
@@ -153,14 +206,44 @@ void process_command(const char* cmd) {
         cmd_shutdown();
         
     } else if (strcmp(cmd, "ls") == 0) {
-        cmd_ls();
+        cmd_ls("");
         
     } else if (strcmp(cmd, "fsinfo") == 0) {
         cmd_fsinfo();
         
+    } else if (strcmp(cmd, "vfsstat") == 0) {
+        cmd_vfsstat();
+        
     } else if (strcmp(cmd, "diskinfo") == 0) {
         cmd_diskinfo();
         
+    } else if (strcmp(cmd, "diskbench") == 0) {
+        cmd_diskbench();
+        
+    } else if (strcmp(cmd, "ahcibench") == 0) {
+        cmd_ahcibench();
+        
+    } else if (strcmp(cmd, "lsblk") == 0) {
+        cmd_lsblk();
+        
+    } else if (strcmp(cmd, "lspci") == 0) {
+        cmd_lspci(0);
+        
+    } else if (strcmp(cmd, "lspci -v") == 0) {
+        cmd_lspci(1);
+        
+    } else if (strcmp(cmd, "cachestat") == 0) {
+        cmd_cachestat();
+        
+    } else if (strcmp(cmd, "sync") == 0) {
+        cmd_sync();
+        
+    } else if (strcmp(cmd, "fswbench") == 0) {
+        cmd_fswbench();
+        
+    } else if (strcmp(cmd, "tmpbench") == 0) {
+        cmd_tmpbench();
+    
     // Comandos de rede
     } else if (strcmp(cmd, "ifconfig") == 0) {
         cmd_ifconfig();
@@ -176,6 +259,30 @@ void process_command(const char* cmd) {
         // Comando ping - ping para IP específico
         cmd_ping(cmd + 5);
         
+    } else if (strlen(cmd) > 9 && memory_compare(cmd, "udpbench ", 9) == 0) {
+        // Comando udpbench - pacotes/s de UDP em cada sentido
+        cmd_udpbench(cmd + 9);
+        
+    } else if (strlen(cmd) > 9 && memory_compare(cmd, "tcpbench ", 9) == 0) {
+        // Comando tcpbench - vazão de uma transferência TCP em massa
+        cmd_tcpbench(cmd + 9);
+        
+    } else if (strlen(cmd) > 8 && memory_compare(cmd, "fsbench ", 8) == 0) {
+        // Comando fsbench - vazão de leitura de um arquivo
+        cmd_fsbench(cmd + 8);
+        
+    } else if (strlen(cmd) > 9 && memory_compare(cmd, "fatbench ", 9) == 0) {
+        // Comando fatbench - FAT empacotada vs. desempacotada
+        cmd_fatbench(cmd + 9);
+        
+    } else if (strlen(cmd) > 3 && memory_compare(cmd, "ls ", 3) == 0) {
+        // Comando ls DIR - lista um subdiretório
+        cmd_ls(cmd + 3);
+        
+    } else if (strlen(cmd) > 10 && memory_compare(cmd, "pathbench ", 10) == 0) {
+        // Comando pathbench - latência de resolução de caminhos
+        cmd_pathbench(cmd + 10);
+        
     } else if (strlen(cmd) > 4 && cmd[0] == 'c' && cmd[1] == 'a' && 
                cmd[2] == 't' && cmd[3] == ' ') {
         // Comando cat - mostra conteúdo do arquivo
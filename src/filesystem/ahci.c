@@ -0,0 +1,753 @@
+// ============================================================================
+// NanoOS - Driver AHCI (SATA)
+// Command lists, FIS receive e Native Command Queuing (até 32 comandos
+// simultâneos por porta), com conclusão por IRQ legada ou polling
+// ============================================================================
+
+#include "../../include/ahci.h"
+#include "../../include/pci.h"
+#include "../../include/kernel.h"
+#include "../../include/blockdev.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// VARIÁVEIS GLOBAIS
+// ============================================================================
+
+static ahci_hba_regs_t* hba = 0;
+static ahci_port_t ahci_ports[AHCI_MAX_PORTS];
+static int ahci_ports_found = 0;
+
+// Estruturas de DMA (memória identidade: endereço virtual = físico)
+static ahci_cmd_header_t cmd_lists[AHCI_MAX_PORTS][AHCI_MAX_SLOTS] __attribute__((aligned(1024)));
+static uint8_t fis_areas[AHCI_MAX_PORTS][256] __attribute__((aligned(256)));
+static ahci_cmd_table_t cmd_tables[AHCI_MAX_PORTS][AHCI_MAX_SLOTS] __attribute__((aligned(128)));
+
+// Buffer para IDENTIFY DEVICE
+static uint16_t identify_buffer[256] __attribute__((aligned(4)));
+
+// Buffers do benchmark (um por comando em voo)
+static uint8_t bench_buffers[AHCI_MAX_SLOTS][AHCI_BENCH_IO_SECTORS * 512] __attribute__((aligned(4096)));
+
+// ============================================================================
+// FUNÇÕES AUXILIARES
+// ============================================================================
+
+// Zera uma região de memória
+static void ahci_memzero(void* ptr, size_t n) {
+    uint8_t* p = (uint8_t*)ptr;
+    for (size_t i = 0; i < n; i++) {
+        p[i] = 0;
+    }
+}
+
+// Aguarda os bits de 'mask' ficarem em zero (retorna -1 em timeout).
+// O limite de voltas cobre chamadas feitas com interrupções desabilitadas,
+// quando timer_ticks não avança
+static int ahci_wait_clear(volatile uint32_t* reg, uint32_t mask) {
+    uint32_t start = timer_ticks;
+    
+    for (uint32_t spins = 0; *reg & mask; spins++) {
+        if (timer_ticks - start > AHCI_TIMEOUT_TICKS || spins > AHCI_SPIN_LIMIT) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Para o processamento da command list e a recepção de FIS
+static int ahci_port_stop(ahci_port_regs_t* regs) {
+    regs->cmd &= ~AHCI_PxCMD_ST;
+    if (ahci_wait_clear(&regs->cmd, AHCI_PxCMD_CR) != 0) return -1;
+    
+    regs->cmd &= ~AHCI_PxCMD_FRE;
+    return ahci_wait_clear(&regs->cmd, AHCI_PxCMD_FR);
+}
+
+// COMRESET: reinicia o link quando a command list não para sozinha.
+// Retorna 0 se PxCMD.CR e PxCMD.FR zeraram
+static int ahci_port_comreset(ahci_port_regs_t* regs) {
+    uint64_t deadline;
+    
+    regs->sctl = (regs->sctl & ~0x0Fu) | AHCI_SCTL_DET_INIT;
+    deadline = tsc_read() + tsc_khz;    // Ao menos 1 ms em DET = 1
+    while (tsc_read() < deadline) {
+    }
+    regs->sctl &= ~0x0Fu;
+    
+    for (uint32_t spins = 0; (regs->ssts & 0x0F) != AHCI_SSTS_DET_PRESENT; spins++) {
+        if (spins > AHCI_SPIN_LIMIT) break;
+    }
+    regs->cmd &= ~(AHCI_PxCMD_ST | AHCI_PxCMD_FRE);
+    return ahci_wait_clear(&regs->cmd, AHCI_PxCMD_CR | AHCI_PxCMD_FR);
+}
+
+// Inicia a recepção de FIS e o processamento de comandos
+static int ahci_port_start(ahci_port_regs_t* regs) {
+    if (ahci_wait_clear(&regs->cmd, AHCI_PxCMD_CR) != 0) return -1;
+    
+    regs->cmd |= AHCI_PxCMD_FRE;
+    regs->cmd |= AHCI_PxCMD_ST;
+    return 0;
+}
+
+// ============================================================================
+// CONCLUSÃO DE COMANDOS
+// ============================================================================
+
+// Finaliza os slots em 'done' chamando os callbacks (interrupções desabilitadas)
+static void ahci_complete_slots(ahci_port_t* port, uint32_t done, int status) {
+    while (done) {
+        int tag = __builtin_ctz(done);
+        uint32_t bit = 1u << tag;
+        ahci_request_t* req = &port->requests[tag];
+        ahci_callback_t callback = req->callback;
+        void* ctx = req->ctx;
+        
+        done &= ~bit;
+        port->issued &= ~bit;
+        port->busy &= ~bit;
+        req->callback = 0;
+        
+        if (status == 0) {
+            port->completed++;
+        } else {
+            port->errors++;
+        }
+        
+        if (callback) {
+            callback(port, tag, status, ctx);
+        }
+    }
+}
+
+// Conta os slots em uma máscara (sem __builtin_popcount: não há libgcc)
+static int ahci_count_slots(uint32_t mask) {
+    int count = 0;
+    
+    while (mask) {
+        mask &= mask - 1;
+        count++;
+    }
+    return count;
+}
+
+// Recupera a porta após um erro de task file ou um comando sem resposta:
+// zerar PxCMD.ST faz o HBA descartar PxCI e PxSACT (com COMRESET se a
+// command list não para). Todos os comandos em voo falham. Retorna -1 se
+// nem o COMRESET parou o HBA (DMA ainda pode acontecer)
+static int ahci_port_recover(ahci_port_t* port) {
+    uint32_t failed = port->issued;
+    int result = 0;
+    
+    if (ahci_port_stop(port->regs) != 0) {
+        result = ahci_port_comreset(port->regs);
+    }
+    port->regs->serr = 0xFFFFFFFF;
+    port->regs->is = 0xFFFFFFFF;
+    ahci_port_start(port->regs);
+    
+    ahci_complete_slots(port, failed, -1);
+    return result;
+}
+
+// Colhe os comandos concluídos: um slot terminou quando não está mais em
+// PxCI (comandos comuns) nem em PxSACT (comandos NCQ)
+static int ahci_port_reap(ahci_port_t* port) {
+    uint32_t pis = port->regs->is;
+    
+    if (pis) {
+        port->regs->is = pis;  // Limpa (write-1-to-clear)
+    }
+    
+    if ((pis & AHCI_PxIS_TFES) || (port->regs->tfd & AHCI_TFD_ERR)) {
+        int failed = ahci_count_slots(port->issued);
+        ahci_port_recover(port);
+        return failed;
+    }
+    
+    uint32_t active = port->regs->sact | port->regs->ci;
+    uint32_t done = port->issued & ~active;
+    
+    ahci_complete_slots(port, done, 0);
+    return ahci_count_slots(done);
+}
+
+// Handler da IRQ legada (INTx) do controlador
+static void ahci_irq_handler(void) {
+    uint32_t is = hba->is;
+    
+    for (int i = 0; i < ahci_ports_found; i++) {
+        if (is & (1u << ahci_ports[i].index)) {
+            ahci_port_reap(&ahci_ports[i]);
+        }
+    }
+    
+    hba->is = is;
+}
+
+// Colhe conclusões por polling (funciona com ou sem IRQ)
+int ahci_poll(ahci_port_t* port) {
+    uint32_t flags = irq_save();
+    int done = ahci_port_reap(port);
+    irq_restore(flags);
+    return done;
+}
+
+// ============================================================================
+// SUBMISSÃO DE COMANDOS
+// ============================================================================
+
+// Monta a PRDT para um buffer contíguo; retorna o número de entradas
+static int ahci_build_prdt(ahci_cmd_table_t* table, void* buffer, uint32_t bytes) {
+    uint32_t addr = (uint32_t)buffer;
+    int n = 0;
+    
+    while (bytes > 0 && n < AHCI_PRDT_ENTRIES) {
+        uint32_t chunk = bytes > AHCI_PRD_MAX_BYTES ? AHCI_PRD_MAX_BYTES : bytes;
+        
+        table->prdt[n].dba = addr;
+        table->prdt[n].dbau = 0;
+        table->prdt[n].reserved = 0;
+        table->prdt[n].dbc = (chunk - 1) | (1u << 31);  // Interrompe ao concluir
+        
+        addr += chunk;
+        bytes -= chunk;
+        n++;
+    }
+    
+    return bytes == 0 ? n : -1;
+}
+
+// Prepara um comando no slot 'tag' (slot já reservado em port->busy)
+static int ahci_prepare(ahci_port_t* port, int tag, uint8_t command, uint32_t lba,
+                        uint32_t count, void* buffer, uint32_t bytes, int write) {
+    ahci_cmd_header_t* header = &port->cmd_list[tag];
+    ahci_cmd_table_t* table = &port->cmd_tables[tag];
+    fis_reg_h2d_t* fis = (fis_reg_h2d_t*)table->cfis;
+    
+    ahci_memzero(fis, sizeof(fis_reg_h2d_t));
+    
+    int prdtl = ahci_build_prdt(table, buffer, bytes);
+    if (prdtl < 0) return -1;
+    
+    header->flags = (sizeof(fis_reg_h2d_t) / 4) | (write ? AHCI_CMD_FLAG_WRITE : 0);
+    header->prdtl = prdtl;
+    header->prdbc = 0;
+    
+    fis->fis_type = FIS_TYPE_REG_H2D;
+    fis->pmport_c = 0x80;
+    fis->command = command;
+    fis->device = 0x40;  // Modo LBA
+    fis->lba0 = lba & 0xFF;
+    fis->lba1 = (lba >> 8) & 0xFF;
+    fis->lba2 = (lba >> 16) & 0xFF;
+    fis->lba3 = (lba >> 24) & 0xFF;
+    
+    if (command == ATA_CMD_READ_FPDMA || command == ATA_CMD_WRITE_FPDMA) {
+        // NCQ: contagem de setores vai em FEATURES, a tag em COUNT[7:3]
+        fis->feature_low = count & 0xFF;
+        fis->feature_high = (count >> 8) & 0xFF;
+        fis->count_low = tag << 3;
+    } else {
+        fis->count_low = count & 0xFF;
+        fis->count_high = (count >> 8) & 0xFF;
+    }
+    
+    return 0;
+}
+
+// Reserva o slot livre de menor número (retorna -1 se a fila está cheia)
+static int ahci_alloc_slot(ahci_port_t* port) {
+    uint32_t flags = irq_save();
+    uint32_t free = port->slot_mask & ~port->busy;
+    int tag = -1;
+    
+    if (free) {
+        tag = __builtin_ctz(free);
+        port->busy |= 1u << tag;
+    }
+    
+    irq_restore(flags);
+    return tag;
+}
+
+// Devolve um slot reservado que não chegou a ser emitido
+static void ahci_free_slot(ahci_port_t* port, int tag) {
+    uint32_t flags = irq_save();
+    port->busy &= ~(1u << tag);
+    irq_restore(flags);
+}
+
+// Entrega o slot ao HBA
+static void ahci_issue(ahci_port_t* port, int tag, int queued,
+                       ahci_callback_t callback, void* ctx) {
+    uint32_t bit = 1u << tag;
+    uint32_t flags = irq_save();
+    
+    port->requests[tag].callback = callback;
+    port->requests[tag].ctx = ctx;
+    port->issued |= bit;
+    
+    if (queued) {
+        port->regs->sact = bit;  // Tag NCQ ativa antes de emitir
+    }
+    port->regs->ci = bit;
+    
+    irq_restore(flags);
+}
+
+// Submete uma leitura/escrita sem aguardar a conclusão. Retorna a tag,
+// AHCI_AGAIN se a fila está cheia ou -1 se o pedido é inválido
+int ahci_submit(ahci_port_t* port, uint32_t lba, uint32_t count,
+                void* buffer, int write, ahci_callback_t callback, void* ctx) {
+    if (!port || count == 0 || count > AHCI_MAX_SECTORS) return -1;
+    
+    int tag = ahci_alloc_slot(port);
+    if (tag < 0) return AHCI_AGAIN;
+    
+    uint8_t command;
+    if (port->ncq) {
+        command = write ? ATA_CMD_WRITE_FPDMA : ATA_CMD_READ_FPDMA;
+    } else {
+        command = write ? ATA_CMD_WRITE_DMA_EXT : ATA_CMD_READ_DMA_EXT;
+    }
+    
+    if (ahci_prepare(port, tag, command, lba, count, buffer, count * 512, write) != 0) {
+        ahci_free_slot(port, tag);
+        return -1;
+    }
+    
+    ahci_issue(port, tag, port->ncq, callback, ctx);
+    return tag;
+}
+
+// ============================================================================
+// INTERFACE SÍNCRONA
+// ============================================================================
+
+// Callback usado pelas operações síncronas: 1 = sucesso, -1 = erro
+static void ahci_sync_done(ahci_port_t* port, int tag, int status, void* ctx) {
+    (void)port;
+    (void)tag;
+    *(volatile int*)ctx = (status == 0) ? 1 : -1;
+}
+
+// Aguarda o resultado gravado por ahci_sync_done. Sem resposta no prazo,
+// a porta é recuperada: o comando sai do HBA e falha antes de 'result'
+// (na pilha de quem chamou) deixar de existir
+static int ahci_wait_sync(ahci_port_t* port, volatile int* result) {
+    uint32_t start = timer_ticks;
+    
+    while (*result == 0) {
+        ahci_poll(port);
+        
+        if (timer_ticks - start > AHCI_TIMEOUT_TICKS) {
+            uint32_t flags = irq_save();
+            if (*result == 0) {
+                ahci_port_recover(port);
+            }
+            irq_restore(flags);
+        }
+    }
+    return *result == 1 ? 0 : -1;
+}
+
+// Leitura/escrita síncrona em comandos de até AHCI_MAX_SECTORS setores.
+// Só a fila cheia é repetida; se nenhum slot libera no prazo, a porta é
+// recuperada como em ahci_wait_sync
+static int ahci_sync_io(ahci_port_t* port, uint32_t lba, uint32_t count,
+                        uint8_t* buffer, int write) {
+    if (!port || count == 0) return -1;
+    
+    while (count > 0) {
+        uint32_t chunk = count > AHCI_MAX_SECTORS ? AHCI_MAX_SECTORS : count;
+        uint32_t start = timer_ticks;
+        volatile int result = 0;
+        int tag;
+        
+        while ((tag = ahci_submit(port, lba, chunk, buffer, write,
+                                  ahci_sync_done, (void*)&result)) == AHCI_AGAIN) {
+            ahci_poll(port);  // Fila cheia: espera algum slot liberar
+            
+            if (timer_ticks - start > AHCI_TIMEOUT_TICKS) {
+                uint32_t flags = irq_save();
+                ahci_port_recover(port);
+                irq_restore(flags);
+                start = timer_ticks;
+            }
+        }
+        if (tag < 0 || ahci_wait_sync(port, &result) != 0) return -1;
+        
+        lba += chunk;
+        count -= chunk;
+        buffer += chunk * 512;
+    }
+    return 0;
+}
+
+int ahci_read(ahci_port_t* port, uint32_t lba, uint32_t count, void* buffer) {
+    return ahci_sync_io(port, lba, count, (uint8_t*)buffer, 0);
+}
+
+int ahci_write(ahci_port_t* port, uint32_t lba, uint32_t count, const void* buffer) {
+    return ahci_sync_io(port, lba, count, (uint8_t*)buffer, 1);
+}
+
+// Esvazia o cache de escrita do disco (FLUSH CACHE EXT, sem dados). Não é
+// um comando NCQ: só é emitido com a fila vazia
+int ahci_flush(ahci_port_t* port) {
+    volatile int result = 0;
+    uint32_t start = timer_ticks;
+    int tag = -1;
+    
+    if (!port) return -1;
+    
+    while (port->issued || (tag = ahci_alloc_slot(port)) < 0) {
+        ahci_poll(port);
+        if (timer_ticks - start > AHCI_TIMEOUT_TICKS) return -1;
+    }
+    
+    if (ahci_prepare(port, tag, ATA_CMD_FLUSH_CACHE_EXT, 0, 0, 0, 0, 0) != 0) {
+        ahci_free_slot(port, tag);
+        return -1;
+    }
+    
+    ahci_issue(port, tag, 0, ahci_sync_done, (void*)&result);
+    return ahci_wait_sync(port, &result);
+}
+
+// Envia IDENTIFY DEVICE (comando comum, slot 0, fila vazia)
+static int ahci_identify(ahci_port_t* port) {
+    volatile int result = 0;
+    int tag = ahci_alloc_slot(port);
+    
+    if (tag < 0) return -1;
+    if (ahci_prepare(port, tag, AHCI_ATA_CMD_IDENTIFY, 0, 0,
+                     identify_buffer, sizeof(identify_buffer), 0) != 0) {
+        ahci_free_slot(port, tag);
+        return -1;
+    }
+    
+    ahci_issue(port, tag, 0, ahci_sync_done, (void*)&result);
+    if (ahci_wait_sync(port, &result) != 0) return -1;
+    
+    // Capacidade: palavras 100-103 (LBA48) ou 60-61 (LBA28)
+    uint32_t lba48 = identify_buffer[100] | ((uint32_t)identify_buffer[101] << 16);
+    uint32_t lba28 = identify_buffer[60] | ((uint32_t)identify_buffer[61] << 16);
+    port->sectors = lba48 ? lba48 : lba28;
+    
+    // NCQ: palavra 76 bit 8; profundidade na palavra 75 (bits 4:0) + 1
+    if (identify_buffer[76] & (1 << 8)) {
+        port->ncq = 1;
+        port->queue_depth = (identify_buffer[75] & 0x1F) + 1;
+    }
+    
+    return 0;
+}
+
+// ============================================================================
+// DISPOSITIVO DE BLOCO
+// ============================================================================
+
+static int ahci_blk_read(blockdev_t* dev, uint32_t lba, uint32_t count, void* buffer) {
+    return ahci_read((ahci_port_t*)dev->priv, lba, count, buffer);
+}
+
+static int ahci_blk_write(blockdev_t* dev, uint32_t lba, uint32_t count, const void* buffer) {
+    return ahci_write((ahci_port_t*)dev->priv, lba, count, buffer);
+}
+
+static int ahci_blk_flush(blockdev_t* dev) {
+    return ahci_flush((ahci_port_t*)dev->priv);
+}
+
+static const blockdev_ops_t ahci_blk_ops = {
+    .read = ahci_blk_read,
+    .write = ahci_blk_write,
+    .flush = ahci_blk_flush,
+};
+
+// ============================================================================
+// INICIALIZAÇÃO
+// ============================================================================
+
+// Configura uma porta: command list, FIS receive area e interrupções
+static int ahci_port_init(ahci_port_t* port, int index, uint32_t hba_slots, int hba_ncq) {
+    int n = ahci_ports_found;
+    ahci_port_regs_t* regs = &hba->ports[index];
+    
+    port->index = index;
+    port->regs = regs;
+    port->cmd_list = cmd_lists[n];
+    port->cmd_tables = cmd_tables[n];
+    port->ncq = 0;
+    port->queue_depth = 1;
+    port->busy = 0;
+    port->issued = 0;
+    port->completed = 0;
+    port->errors = 0;
+    port->slot_mask = hba_slots >= 32 ? 0xFFFFFFFF : ((1u << hba_slots) - 1);
+    
+    if (ahci_port_stop(regs) != 0) return -1;
+    
+    ahci_memzero(cmd_lists[n], sizeof(cmd_lists[n]));
+    ahci_memzero(fis_areas[n], sizeof(fis_areas[n]));
+    
+    regs->clb = (uint32_t)cmd_lists[n];
+    regs->clbu = 0;
+    regs->fb = (uint32_t)fis_areas[n];
+    regs->fbu = 0;
+    
+    for (int slot = 0; slot < AHCI_MAX_SLOTS; slot++) {
+        cmd_lists[n][slot].ctba = (uint32_t)&cmd_tables[n][slot];
+        cmd_lists[n][slot].ctbau = 0;
+    }
+    
+    regs->serr = 0xFFFFFFFF;
+    regs->is = 0xFFFFFFFF;
+    regs->ie = AHCI_PxIS_DHRS | AHCI_PxIS_PSS | AHCI_PxIS_DSS |
+               AHCI_PxIS_SDBS | AHCI_PxIS_TFES;
+    
+    if (ahci_port_start(regs) != 0) return -1;
+    if (ahci_identify(port) != 0) return -1;
+    
+    // NCQ só se HBA e disco suportarem; a fila fica limitada pelos slots
+    if (!hba_ncq) {
+        port->ncq = 0;
+        port->queue_depth = 1;
+    }
+    if (port->queue_depth > hba_slots) {
+        port->queue_depth = hba_slots;
+    }
+    if (port->ncq && port->queue_depth < 32) {
+        port->slot_mask = (1u << port->queue_depth) - 1;  // Tags aceitas pelo disco
+    }
+    
+    return 0;
+}
+
+// Probe do controlador AHCI: inicializa as portas com disco SATA. Só um
+// HBA é suportado
+static int ahci_probe(pci_device_t* dev, const pci_device_id_t* id) {
+    (void)id;
+    
+    if (hba || dev->prog_if != AHCI_PCI_PROG_IF || !dev->bar_size[5]) return -1;
+    
+    terminal_print("Controlador AHCI encontrado\n");
+    
+    pci_device_enable(dev, PCI_CMD_MEM_SPACE | PCI_CMD_BUS_MASTER);
+    hba = (ahci_hba_regs_t*)dev->bar[5];
+    
+    // Reset do HBA e modo AHCI
+    hba->ghc |= AHCI_GHC_AE;
+    hba->ghc |= AHCI_GHC_HR;
+    if (ahci_wait_clear(&hba->ghc, AHCI_GHC_HR) != 0) {
+        terminal_print("AHCI: timeout no reset do HBA\n");
+        hba = 0;
+        return -1;
+    }
+    hba->ghc |= AHCI_GHC_AE;
+    
+    uint32_t cap = hba->cap;
+    uint32_t hba_slots = ((cap >> AHCI_CAP_NCS_SHIFT) & 0x1F) + 1;
+    int hba_ncq = (cap & AHCI_CAP_SNCQ) ? 1 : 0;
+    uint32_t pi = hba->pi;
+    
+    for (int i = 0; i < 32 && ahci_ports_found < AHCI_MAX_PORTS; i++) {
+        if (!(pi & (1u << i))) continue;
+        
+        ahci_port_regs_t* regs = &hba->ports[i];
+        uint32_t ssts = regs->ssts;
+        
+        if ((ssts & 0x0F) != AHCI_SSTS_DET_PRESENT ||
+            ((ssts >> 8) & 0x0F) != AHCI_SSTS_IPM_ACTIVE) {
+            continue;  // Porta sem dispositivo
+        }
+        if (regs->sig != AHCI_SIG_ATA) continue;  // ATAPI, port multiplier...
+        
+        ahci_port_t* port = &ahci_ports[ahci_ports_found];
+        if (ahci_port_init(port, i, hba_slots, hba_ncq) != 0) {
+            terminal_print("AHCI: falha ao inicializar porta ");
+            terminal_print_dec(i);
+            terminal_print("\n");
+            continue;
+        }
+        ahci_ports_found++;
+        
+        // sda, sdb, ... na ordem das portas
+        char name[4] = { 's', 'd', 'a' + ahci_ports_found - 1, '\0' };
+        blockdev_register(name, port->sectors, &ahci_blk_ops, port);
+        
+        terminal_print("  Porta ");
+        terminal_print_dec(i);
+        terminal_print(": disco SATA, ");
+        terminal_print_dec(port->sectors / 2048);
+        terminal_print(" MB, NCQ ");
+        if (port->ncq) {
+            terminal_print("profundidade ");
+            terminal_print_dec(port->queue_depth);
+        } else {
+            terminal_print("indisponivel");
+        }
+        terminal_print("\n");
+    }
+    
+    // IRQ legada (MSI exigiria APIC local, que o kernel ainda não configura)
+    if (ahci_ports_found > 0 && irq_register_handler(dev->irq_line, ahci_irq_handler) == 0) {
+        hba->is = 0xFFFFFFFF;
+        hba->ghc |= AHCI_GHC_IE;
+    }
+    
+    return 0;
+}
+
+static const pci_device_id_t ahci_pci_ids[] = {
+    { PCI_ANY_ID, PCI_ANY_ID, AHCI_PCI_CLASS, AHCI_PCI_SUBCLASS },
+    { 0, 0, 0, 0 }
+};
+
+static const pci_driver_t ahci_pci_driver = {
+    .name = "ahci",
+    .ids = ahci_pci_ids,
+    .probe = ahci_probe,
+};
+
+// Registra o driver no PCI; falha se não houver disco SATA
+int ahci_init(void) {
+    pci_register_driver(&ahci_pci_driver);
+    return ahci_ports_found > 0 ? 0 : -1;
+}
+
+int ahci_port_count(void) {
+    return ahci_ports_found;
+}
+
+ahci_port_t* ahci_get_port(int n) {
+    if (n < 0 || n >= ahci_ports_found) return 0;
+    return &ahci_ports[n];
+}
+
+// ============================================================================
+// BENCHMARK DE IOPS (LEITURA ALEATÓRIA)
+// ============================================================================
+
+static volatile uint32_t bench_inflight = 0;
+static volatile uint32_t bench_done = 0;
+static volatile uint32_t bench_errors = 0;
+static volatile uint32_t bench_buffer_busy = 0;
+
+// Gerador xorshift32 para LBAs aleatórios
+static uint32_t bench_random(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Conclusão de uma leitura do benchmark: libera o buffer usado. Leituras
+// com erro não entram na vazão
+static void ahci_bench_done(ahci_port_t* port, int tag, int status, void* ctx) {
+    (void)port;
+    (void)tag;
+    bench_buffer_busy &= ~(1u << (uint32_t)ctx);
+    bench_inflight--;
+    if (status == 0) {
+        bench_done++;
+    } else {
+        bench_errors++;
+    }
+}
+
+// Mede IOPS de leituras aleatórias de 4 KB com profundidade de fila 1..32
+void cmd_ahcibench(void) {
+    ahci_port_t* port = ahci_get_port(0);
+    
+    if (!port) {
+        terminal_print("\nNenhum disco AHCI disponivel.\n");
+        return;
+    }
+    if (port->sectors < AHCI_BENCH_IO_SECTORS) {
+        terminal_print("\nDisco AHCI pequeno demais para o benchmark.\n");
+        return;
+    }
+    
+    uint32_t blocks = port->sectors / AHCI_BENCH_IO_SECTORS;
+    uint32_t seed = timer_ticks | 1;
+    
+    terminal_print("\nAHCI: leitura aleatoria de 4 KB (porta ");
+    terminal_print_dec(port->index);
+    terminal_print(port->ncq ? ", NCQ)\n" : ", sem NCQ)\n");
+    terminal_print("QD   IOPS     KB/s     Erros\n");
+    
+    for (uint32_t qd = 1; qd <= AHCI_MAX_SLOTS; qd *= 2) {
+        bench_inflight = 0;
+        bench_done = 0;
+        bench_errors = 0;
+        bench_buffer_busy = 0;
+        
+        uint32_t start = timer_ticks;
+        while (timer_ticks - start < AHCI_BENCH_TICKS) {
+            // Mantém 'qd' leituras em voo
+            while (bench_inflight < qd) {
+                uint32_t lba = (bench_random(&seed) % blocks) * AHCI_BENCH_IO_SECTORS;
+                
+                // Reserva o buffer antes de submeter: a conclusão pode chegar
+                // pela IRQ antes de ahci_submit retornar
+                uint32_t flags = irq_save();
+                uint32_t buf = __builtin_ctz(~bench_buffer_busy);
+                bench_buffer_busy |= 1u << buf;
+                bench_inflight++;
+                irq_restore(flags);
+                
+                if (ahci_submit(port, lba, AHCI_BENCH_IO_SECTORS, bench_buffers[buf], 0,
+                                ahci_bench_done, (void*)buf) < 0) {
+                    flags = irq_save();
+                    bench_buffer_busy &= ~(1u << buf);
+                    bench_inflight--;
+                    irq_restore(flags);
+                    break;  // Fila do HBA cheia
+                }
+            }
+            ahci_poll(port);
+        }
+        uint32_t elapsed = timer_ticks - start;
+        
+        // Drena as leituras restantes antes da próxima profundidade
+        uint32_t drain = timer_ticks;
+        while (bench_inflight > 0 && timer_ticks - drain < AHCI_TIMEOUT_TICKS) {
+            ahci_poll(port);
+        }
+        
+        // Leituras presas: a porta para (PxCMD.ST/CR) antes de os buffers
+        // voltarem a ser usados; elas falham pelo caminho de recuperação
+        if (bench_inflight > 0) {
+            uint32_t flags = irq_save();
+            int result = ahci_port_recover(port);
+            irq_restore(flags);
+            
+            if (result != 0) {
+                terminal_print("HBA nao parou; benchmark interrompido\n");
+                return;
+            }
+        }
+        
+        uint32_t iops = elapsed ? (bench_done * TIMER_FREQUENCY) / elapsed : 0;
+        
+        terminal_print_dec(qd);
+        terminal_print(qd < 10 ? "    " : "   ");
+        terminal_print_dec(iops);
+        terminal_print("    ");
+        terminal_print_dec(iops * (AHCI_BENCH_IO_SECTORS / 2));
+        terminal_print("     ");
+        terminal_print_dec(bench_errors);
+        terminal_print("\n");
+    }
+    
+    terminal_print("Erros: ");
+    terminal_print_dec(port->errors);
+    terminal_print("\n");
+}
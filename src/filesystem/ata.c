@@ -0,0 +1,547 @@
+// ============================================================================
+// NanoOS - Driver ATA/IDE
+// Canais primário e secundário, discos mestre e escravo. Cada canal tem
+// sua própria trava e uma máquina de estados PIO dirigida pela IRQ do
+// canal (14 ou 15), então os dois canais trabalham ao mesmo tempo
+// ============================================================================
+
+#include "../../include/ata.h"
+#include "../../include/kernel.h"
+#include "../../include/blockdev.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// VARIÁVEIS GLOBAIS
+// ============================================================================
+
+static ata_channel_t channels[ATA_CHANNELS];
+static ata_drive_t drives[ATA_DRIVES];
+static int drive_count = 0;
+
+static const char* drive_names[ATA_DRIVES] = { "hda", "hdb", "hdc", "hdd" };
+
+// ============================================================================
+// ACESSO AOS REGISTRADORES
+// ============================================================================
+
+// Status alternativo: não confirma a IRQ pendente
+static inline uint8_t ata_alt_status(ata_channel_t* ch) {
+    return inb(ch->ctrl_base);
+}
+
+// Pausa de ~400 ns antes de confiar no status (quatro leituras da porta)
+static inline void ata_delay_400ns(ata_channel_t* ch) {
+    for (int i = 0; i < 4; i++) {
+        ata_alt_status(ch);
+    }
+}
+
+// Transfere um setor (256 words) com rep insw/outsw
+static inline void ata_read_data(ata_channel_t* ch, uint16_t* buffer) {
+    uint32_t count = 256;
+    __asm__ volatile ("rep insw" : "+D"(buffer), "+c"(count)
+                      : "d"(ch->io_base + ATA_REG_DATA) : "memory");
+}
+
+static inline void ata_write_data(ata_channel_t* ch, const uint16_t* buffer) {
+    uint32_t count = 256;
+    __asm__ volatile ("rep outsw" : "+S"(buffer), "+c"(count)
+                      : "d"(ch->io_base + ATA_REG_DATA) : "memory");
+}
+
+// Aguarda BSY limpar (com timeout: barramento flutuante lê 0xFF)
+static int ata_wait_not_busy(ata_channel_t* ch) {
+    for (uint32_t i = 0; i < ATA_SPIN_TIMEOUT; i++) {
+        if (!(ata_alt_status(ch) & ATA_STATUS_BSY)) return 0;
+    }
+    return -1;
+}
+
+// Aguarda dados prontos para leitura/escrita
+static int ata_wait_drq(ata_channel_t* ch) {
+    for (uint32_t i = 0; i < ATA_SPIN_TIMEOUT; i++) {
+        uint8_t status = ata_alt_status(ch);
+        
+        if (status & ATA_STATUS_BSY) continue;
+        if (status & (ATA_STATUS_ERR | ATA_STATUS_DF)) return -1;
+        if (status & ATA_STATUS_DRQ) return 0;
+    }
+    return -1;
+}
+
+// Seleciona o disco (modo LBA); só espera quando o disco muda
+static void ata_select(ata_drive_t* drive, uint32_t lba) {
+    ata_channel_t* ch = drive->channel;
+    uint8_t value = 0xE0 | (drive->slave << 4) | ((lba >> 24) & 0x0F);
+    
+    outb(ch->io_base + ATA_REG_DRVHEAD, value);
+    if ((value ^ ch->selected) & 0x10) {
+        ata_delay_400ns(ch);
+    }
+    ch->selected = value;
+}
+
+// ============================================================================
+// TRAVA DO CANAL
+// ============================================================================
+
+static int ata_try_lock(ata_channel_t* ch) {
+    uint32_t flags = irq_save();
+    
+    if (ch->busy) {
+        irq_restore(flags);
+        return -1;
+    }
+    ch->busy = 1;
+    irq_restore(flags);
+    return 0;
+}
+
+static void ata_unlock(ata_channel_t* ch) {
+    ch->req.drive = 0;
+    ch->busy = 0;
+}
+
+// Espera a trava do canal, avançando a requisição de quem a detém
+static int ata_lock(ata_drive_t* drive) {
+    uint32_t start = timer_ticks;
+    
+    while (ata_try_lock(drive->channel) != 0) {
+        ata_poll(drive);
+        if (timer_ticks - start > ATA_TIMEOUT_TICKS) return -1;
+    }
+    return 0;
+}
+
+// ============================================================================
+// MÁQUINA DE ESTADOS
+// ============================================================================
+
+// Encerra a requisição do canal e libera a trava antes do callback (que
+// pode submeter a próxima requisição)
+static void ata_complete(ata_channel_t* ch, int status) {
+    ata_callback_t callback = ch->req.callback;
+    void* ctx = ch->req.ctx;
+    
+    if (status == 0) {
+        ch->completed++;
+    } else {
+        ch->errors++;
+    }
+    
+    ata_unlock(ch);
+    if (callback) {
+        callback(status, ctx);
+    }
+}
+
+// Envia o próximo comando (até 256 setores) da requisição do canal
+static int ata_issue(ata_channel_t* ch) {
+    ata_request_t* req = &ch->req;
+    uint32_t chunk = req->count > ATA_MAX_SECTORS ? ATA_MAX_SECTORS : req->count;
+    uint32_t lba = req->lba;
+    
+    if (ata_wait_not_busy(ch) != 0) return -1;
+    
+    ata_select(req->drive, lba);
+    outb(ch->io_base + ATA_REG_SECCOUNT, chunk & 0xFF);         // 0 = 256 setores
+    outb(ch->io_base + ATA_REG_LBA_LOW, lba & 0xFF);            // LBA[7:0]
+    outb(ch->io_base + ATA_REG_LBA_MID, (lba >> 8) & 0xFF);     // LBA[15:8]
+    outb(ch->io_base + ATA_REG_LBA_HIGH, (lba >> 16) & 0xFF);   // LBA[23:16]
+    outb(ch->io_base + ATA_REG_COMMAND,
+         req->write ? ATA_CMD_WRITE_SECTORS : ATA_CMD_READ_SECTORS);
+    
+    req->lba += chunk;
+    req->count -= chunk;
+    req->chunk_left = chunk;
+    
+    // O primeiro setor de uma escrita é enviado sem esperar IRQ
+    if (req->write) {
+        if (ata_wait_drq(ch) != 0) return -1;
+        ata_write_data(ch, req->buffer);
+        req->buffer += 256;
+        req->chunk_left--;
+    }
+    return 0;
+}
+
+// Avança a requisição do canal. Chamada pela IRQ ou por polling, sempre
+// com interrupções desabilitadas. Ler o status confirma a IRQ
+static void ata_service(ata_channel_t* ch) {
+    uint8_t status = inb(ch->io_base + ATA_REG_STATUS);
+    ata_request_t* req = &ch->req;
+    
+    if (!req->drive) return;                 // Nenhuma requisição dirigida por IRQ
+    if (status & ATA_STATUS_BSY) return;
+    
+    if (status & (ATA_STATUS_ERR | ATA_STATUS_DF)) {
+        ata_complete(ch, -1);
+        return;
+    }
+    
+    if (req->write) {
+        if (status & ATA_STATUS_DRQ) {
+            if (req->chunk_left == 0) {
+                ata_complete(ch, -1);        // Dispositivo pede mais do que enviamos
+                return;
+            }
+            ata_write_data(ch, req->buffer);
+            req->buffer += 256;
+            req->chunk_left--;
+            return;
+        }
+        if (req->chunk_left > 0) return;     // Ainda gravando
+    } else {
+        if (!(status & ATA_STATUS_DRQ)) return;
+        
+        ata_read_data(ch, req->buffer);
+        req->buffer += 256;
+        if (--req->chunk_left > 0) return;
+    }
+    
+    // Comando atual concluído: próximo bloco ou fim da requisição
+    if (req->count > 0) {
+        if (ata_issue(ch) != 0) {
+            ata_complete(ch, -1);
+        }
+        return;
+    }
+    ata_complete(ch, 0);
+}
+
+static void ata_primary_irq(void) {
+    channels[0].irqs++;
+    ata_service(&channels[0]);
+}
+
+static void ata_secondary_irq(void) {
+    channels[1].irqs++;
+    ata_service(&channels[1]);
+}
+
+// Reset por software do canal (após timeout)
+static void ata_reset_channel(ata_channel_t* ch) {
+    outb(ch->ctrl_base, ATA_CTRL_SRST);
+    ata_delay_400ns(ch);
+    outb(ch->ctrl_base, 0);
+    ata_wait_not_busy(ch);
+    ch->selected = 0xFF;
+}
+
+// ============================================================================
+// OPERAÇÕES
+// ============================================================================
+
+static int ata_valid(const ata_drive_t* drive, uint32_t lba, uint32_t count) {
+    return drive && drive->present && count > 0 &&
+           lba < drive->sectors && count <= drive->sectors - lba;
+}
+
+// Inicia a requisição com a trava já obtida (libera a trava se falhar)
+static int ata_start(ata_drive_t* drive, uint32_t lba, uint32_t count, void* buffer,
+                     int write, ata_callback_t callback, void* ctx) {
+    ata_channel_t* ch = drive->channel;
+    ata_request_t* req = &ch->req;
+    
+    uint32_t flags = irq_save();
+    req->lba = lba;
+    req->count = count;
+    req->buffer = (uint16_t*)buffer;
+    req->write = write ? 1 : 0;
+    req->callback = callback;
+    req->ctx = ctx;
+    req->drive = drive;
+    
+    if (ata_issue(ch) != 0) {
+        ch->errors++;
+        ata_unlock(ch);
+        irq_restore(flags);
+        return -1;
+    }
+    irq_restore(flags);
+    return 0;
+}
+
+// Submete uma requisição; a conclusão chega pela IRQ do canal
+int ata_submit(ata_drive_t* drive, uint32_t lba, uint32_t count, void* buffer,
+               int write, ata_callback_t callback, void* ctx) {
+    if (!ata_valid(drive, lba, count)) return -1;
+    if (ata_try_lock(drive->channel) != 0) return -1;
+    
+    return ata_start(drive, lba, count, buffer, write, callback, ctx);
+}
+
+// 1 se o canal do disco está com uma requisição em andamento
+int ata_busy(const ata_drive_t* drive) {
+    return drive->channel->busy;
+}
+
+// Avança a requisição do canal por polling (caso a IRQ atrase)
+void ata_poll(ata_drive_t* drive) {
+    ata_channel_t* ch = drive->channel;
+    uint32_t flags = irq_save();
+    
+    ata_delay_400ns(ch);
+    ata_service(ch);
+    irq_restore(flags);
+}
+
+// Callback das operações síncronas: 1 = sucesso, -1 = erro
+static void ata_sync_done(int status, void* ctx) {
+    *(volatile int*)ctx = (status == 0) ? 1 : -1;
+}
+
+// Executa uma requisição e espera a conclusão
+static int ata_sync(ata_drive_t* drive, uint32_t lba, uint32_t count, void* buffer, int write) {
+    volatile int result = 0;
+    
+    if (!ata_valid(drive, lba, count)) return -1;
+    if (ata_lock(drive) != 0) return -1;
+    if (ata_start(drive, lba, count, buffer, write, ata_sync_done, (void*)&result) != 0) {
+        return -1;
+    }
+    
+    uint32_t start = timer_ticks;
+    while (result == 0) {
+        ata_poll(drive);
+        
+        if (timer_ticks - start > ATA_TIMEOUT_TICKS) {
+            uint32_t flags = irq_save();
+            if (result == 0) {
+                drive->channel->errors++;
+                ata_unlock(drive->channel);
+                ata_reset_channel(drive->channel);
+                result = -1;
+            }
+            irq_restore(flags);
+        }
+    }
+    return result == 1 ? 0 : -1;
+}
+
+int ata_read(ata_drive_t* drive, uint32_t lba, uint32_t count, void* buffer) {
+    return ata_sync(drive, lba, count, buffer, 0);
+}
+
+int ata_write(ata_drive_t* drive, uint32_t lba, uint32_t count, const void* buffer) {
+    return ata_sync(drive, lba, count, (void*)buffer, 1);
+}
+
+// Esvazia o cache de escrita do disco (CACHE FLUSH, por polling)
+int ata_flush(ata_drive_t* drive) {
+    if (!drive || !drive->present) return -1;
+    if (ata_lock(drive) != 0) return -1;
+    
+    ata_channel_t* ch = drive->channel;
+    int result = 0;
+    
+    ata_select(drive, 0);
+    outb(ch->io_base + ATA_REG_COMMAND, ATA_CMD_CACHE_FLUSH);
+    ata_delay_400ns(ch);
+    
+    uint32_t start = timer_ticks;
+    while (ata_alt_status(ch) & ATA_STATUS_BSY) {
+        if (timer_ticks - start > ATA_TIMEOUT_TICKS) {
+            result = -1;
+            break;
+        }
+    }
+    if (inb(ch->io_base + ATA_REG_STATUS) & (ATA_STATUS_ERR | ATA_STATUS_DF)) {
+        result = -1;
+    }
+    
+    ata_unlock(ch);
+    return result;
+}
+
+// ============================================================================
+// DISPOSITIVO DE BLOCO
+// ============================================================================
+
+static int ata_blk_read(blockdev_t* dev, uint32_t lba, uint32_t count, void* buffer) {
+    return ata_read((ata_drive_t*)dev->priv, lba, count, buffer);
+}
+
+static int ata_blk_write(blockdev_t* dev, uint32_t lba, uint32_t count, const void* buffer) {
+    return ata_write((ata_drive_t*)dev->priv, lba, count, buffer);
+}
+
+static int ata_blk_flush(blockdev_t* dev) {
+    return ata_flush((ata_drive_t*)dev->priv);
+}
+
+// Sem 'queue': o canal executa um comando por vez, então o read-ahead do
+// cache rende mais com leituras síncronas multi-setor
+static const blockdev_ops_t ata_blk_ops = {
+    .read = ata_blk_read,
+    .write = ata_blk_write,
+    .flush = ata_blk_flush,
+};
+
+// ============================================================================
+// INICIALIZAÇÃO
+// ============================================================================
+
+// Identifica um disco (por polling, com a IRQ do canal desabilitada)
+static int ata_identify(ata_drive_t* drive) {
+    ata_channel_t* ch = drive->channel;
+    uint16_t identify_data[256];
+    
+    ata_select(drive, 0);
+    
+    // Zera contadores
+    outb(ch->io_base + ATA_REG_SECCOUNT, 0);
+    outb(ch->io_base + ATA_REG_LBA_LOW, 0);
+    outb(ch->io_base + ATA_REG_LBA_MID, 0);
+    outb(ch->io_base + ATA_REG_LBA_HIGH, 0);
+    
+    // Envia comando IDENTIFY
+    outb(ch->io_base + ATA_REG_COMMAND, ATA_CMD_IDENTIFY);
+    ata_delay_400ns(ch);
+    
+    // Verifica se há drive
+    if (inb(ch->io_base + ATA_REG_STATUS) == 0) return -1;
+    if (ata_wait_not_busy(ch) != 0) return -1;
+    
+    // Verifica se é ATA (não ATAPI)
+    if (inb(ch->io_base + ATA_REG_LBA_MID) != 0 || inb(ch->io_base + ATA_REG_LBA_HIGH) != 0) {
+        return -1;
+    }
+    
+    // Aguarda DRQ ou erro
+    if (ata_wait_drq(ch) != 0) return -1;
+    ata_read_data(ch, identify_data);
+    
+    // Capacidade em setores endereçáveis por LBA28 (palavras 60-61)
+    drive->sectors = identify_data[60] | ((uint32_t)identify_data[61] << 16);
+    
+    // Modelo (palavras 27-46, bytes trocados em cada palavra)
+    for (int i = 0; i < 20; i++) {
+        drive->model[i * 2] = identify_data[27 + i] >> 8;
+        drive->model[i * 2 + 1] = identify_data[27 + i] & 0xFF;
+    }
+    drive->model[40] = '\0';
+    for (int i = 39; i >= 0 && drive->model[i] == ' '; i--) {
+        drive->model[i] = '\0';
+    }
+    
+    return drive->sectors > 0 ? 0 : -1;
+}
+
+// Detecta os dois canais e os quatro discos possíveis
+int ata_init(void) {
+    static const uint16_t io_bases[ATA_CHANNELS] = { ATA_PRIMARY_IO, ATA_SECONDARY_IO };
+    static const uint16_t ctrl_bases[ATA_CHANNELS] = { ATA_PRIMARY_CTRL, ATA_SECONDARY_CTRL };
+    static const uint8_t irqs[ATA_CHANNELS] = { ATA_PRIMARY_IRQ, ATA_SECONDARY_IRQ };
+    static const irq_handler_t handlers[ATA_CHANNELS] = { ata_primary_irq, ata_secondary_irq };
+    
+    drive_count = 0;
+    
+    for (int c = 0; c < ATA_CHANNELS; c++) {
+        ata_channel_t* ch = &channels[c];
+        
+        ch->io_base = io_bases[c];
+        ch->ctrl_base = ctrl_bases[c];
+        ch->irq = irqs[c];
+        ch->selected = 0xFF;
+        ch->busy = 0;
+        ch->req.drive = 0;
+        ch->completed = 0;
+        ch->errors = 0;
+        ch->irqs = 0;
+        
+        for (int d = 0; d < 2; d++) {
+            ata_drive_t* drive = &drives[c * 2 + d];
+            
+            drive->channel = ch;
+            drive->index = c * 2 + d;
+            drive->slave = d;
+            drive->present = 0;
+            drive->sectors = 0;
+            drive->model[0] = '\0';
+        }
+        
+        // Barramento flutuante: canal ausente
+        if (inb(ch->io_base + ATA_REG_STATUS) == 0xFF) continue;
+        
+        outb(ch->ctrl_base, ATA_CTRL_NIEN);
+        
+        int found = 0;
+        for (int d = 0; d < 2; d++) {
+            ata_drive_t* drive = &drives[c * 2 + d];
+            
+            if (ata_identify(drive) == 0) {
+                drive->present = 1;
+                drive_count++;
+                found++;
+                blockdev_register(drive_names[drive->index], drive->sectors, &ata_blk_ops, drive);
+                
+                terminal_print("Disco ATA ");
+                terminal_print(drive_names[drive->index]);
+                terminal_print(": ");
+                terminal_print_dec(drive->sectors / 2048);
+                terminal_print(" MB\n");
+            }
+        }
+        
+        // Canal em uso: conclusões passam a chegar pela IRQ
+        if (found) {
+            irq_register_handler(ch->irq, handlers[c]);
+            outb(ch->ctrl_base, 0);
+        }
+    }
+    
+    return drive_count > 0 ? 0 : -1;
+}
+
+int ata_drive_count(void) {
+    return drive_count;
+}
+
+// Disco por índice (0 = hda ... 3 = hdd); 0 se ausente
+ata_drive_t* ata_get_drive(int index) {
+    if (index < 0 || index >= ATA_DRIVES || !drives[index].present) return 0;
+    return &drives[index];
+}
+
+const char* ata_drive_name(const ata_drive_t* drive) {
+    return drive_names[drive->index];
+}
+
+// Lista discos e contadores dos canais
+void ata_print_info(void) {
+    if (drive_count == 0) {
+        terminal_print("ATA: nenhum disco\n");
+        return;
+    }
+    
+    for (int i = 0; i < ATA_DRIVES; i++) {
+        ata_drive_t* drive = &drives[i];
+        if (!drive->present) continue;
+        
+        terminal_print(drive_names[i]);
+        terminal_print(i < 2 ? ": canal primario, " : ": canal secundario, ");
+        terminal_print(drive->slave ? "escravo, " : "mestre, ");
+        terminal_print_dec(drive->sectors / 2048);
+        terminal_print(" MB");
+        if (drive->model[0]) {
+            terminal_print(" (");
+            terminal_print(drive->model);
+            terminal_print(")");
+        }
+        terminal_print("\n");
+    }
+    
+    for (int c = 0; c < ATA_CHANNELS; c++) {
+        if (!drives[c * 2].present && !drives[c * 2 + 1].present) continue;
+        
+        terminal_print(c == 0 ? "  Canal primario: " : "  Canal secundario: ");
+        terminal_print_dec(channels[c].completed);
+        terminal_print(" requisicoes, ");
+        terminal_print_dec(channels[c].errors);
+        terminal_print(" erros, ");
+        terminal_print_dec(channels[c].irqs);
+        terminal_print(" IRQs\n");
+    }
+}
@@ -0,0 +1,542 @@
+// ============================================================================
+// NanoOS - Cache de Blocos
+// Tabela hash por (dispositivo, LBA), despejo LRU, rastreamento de blocos
+// sujos, write-back periódico e leitura antecipada. Usado apenas fora de
+// contexto de IRQ (comandos e loop principal), então não precisa de travas;
+// o callback de leitura assíncrona só escreve io_status
+// ============================================================================
+
+#include "../../include/bcache.h"
+#include "../../include/blockdev.h"
+#include "../../include/kernel.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// VARIÁVEIS GLOBAIS
+// ============================================================================
+
+static bcache_buf_t buffers[BCACHE_BLOCKS];
+static bcache_buf_t* hash_table[BCACHE_HASH_SIZE];
+static bcache_buf_t* lru_head = 0;      // Mais recente
+static bcache_buf_t* lru_tail = 0;      // Candidato a despejo
+static bcache_stats_t stats;
+static uint32_t dirty_count = 0;
+static uint32_t last_flush = 0;
+
+// Destino das leituras antecipadas síncronas (ATA PIO)
+static uint8_t ra_staging[BCACHE_RA_MAX * BCACHE_BLOCK_SIZE] __attribute__((aligned(16)));
+
+// ============================================================================
+// ACESSO AO DISPOSITIVO
+// ============================================================================
+
+// Lê um bloco do dispositivo
+static int bcache_dev_read(uint8_t dev, uint32_t lba, void* buffer) {
+    stats.disk_reads++;
+    return blockdev_read(blockdev_get(dev), lba, 1, buffer);
+}
+
+// Escreve um bloco no dispositivo
+static int bcache_dev_write(uint8_t dev, uint32_t lba, const void* buffer) {
+    stats.disk_writes++;
+    return blockdev_write(blockdev_get(dev), lba, 1, buffer);
+}
+
+// Conclusão de uma leitura antecipada (pode rodar em contexto de IRQ):
+// apenas registra o resultado; o bloco é finalizado por bcache_io_finish
+static void bcache_io_done(int status, void* ctx) {
+    bcache_buf_t* buf = (bcache_buf_t*)ctx;
+    buf->io_status = (status == 0) ? BCACHE_IO_OK : BCACHE_IO_ERROR;
+}
+
+// Finaliza a leitura em voo de um bloco. Retorna 1 se ainda não terminou
+static int bcache_io_finish(bcache_buf_t* buf) {
+    if (!(buf->flags & BCACHE_LOADING)) return 0;
+    if (buf->io_status == BCACHE_IO_PENDING) return 1;
+    
+    buf->flags &= ~BCACHE_LOADING;
+    if (buf->io_status == BCACHE_IO_OK) {
+        buf->flags |= BCACHE_VALID;
+    } else {
+        buf->flags &= ~BCACHE_PREFETCHED;
+    }
+    return 0;
+}
+
+// Aguarda a leitura em voo de um bloco. Em caso de timeout o bloco continua
+// marcado como em voo (o DMA ainda pode escrever nele) e nunca é reusado
+static int bcache_io_wait(bcache_buf_t* buf) {
+    blockdev_t* dev = blockdev_get(buf->dev);
+    uint32_t start = timer_ticks;
+    
+    while (bcache_io_finish(buf)) {
+        blockdev_poll(dev);
+        if (timer_ticks - start > BCACHE_IO_TIMEOUT) return -1;
+    }
+    return 0;
+}
+
+// ============================================================================
+// TABELA HASH E LISTA LRU
+// ============================================================================
+
+// Bucket de (dev, lba) - hash multiplicativo de Knuth
+static inline uint32_t bcache_hash(uint8_t dev, uint32_t lba) {
+    return ((lba ^ ((uint32_t)dev << 24)) * 2654435761u >> 16) & (BCACHE_HASH_SIZE - 1);
+}
+
+static bcache_buf_t* bcache_lookup(uint8_t dev, uint32_t lba) {
+    bcache_buf_t* buf = hash_table[bcache_hash(dev, lba)];
+    
+    while (buf) {
+        if (buf->lba == lba && buf->dev == dev) return buf;
+        buf = buf->hash_next;
+    }
+    return 0;
+}
+
+static void bcache_hash_insert(bcache_buf_t* buf) {
+    uint32_t h = bcache_hash(buf->dev, buf->lba);
+    buf->hash_next = hash_table[h];
+    hash_table[h] = buf;
+}
+
+static void bcache_hash_remove(bcache_buf_t* buf) {
+    bcache_buf_t** link = &hash_table[bcache_hash(buf->dev, buf->lba)];
+    
+    while (*link) {
+        if (*link == buf) {
+            *link = buf->hash_next;
+            buf->hash_next = 0;
+            return;
+        }
+        link = &(*link)->hash_next;
+    }
+}
+
+// Remove o bloco da lista LRU
+static void bcache_lru_unlink(bcache_buf_t* buf) {
+    if (buf->lru_prev) buf->lru_prev->lru_next = buf->lru_next;
+    else lru_head = buf->lru_next;
+    
+    if (buf->lru_next) buf->lru_next->lru_prev = buf->lru_prev;
+    else lru_tail = buf->lru_prev;
+    
+    buf->lru_prev = 0;
+    buf->lru_next = 0;
+}
+
+// Move o bloco para a cabeça (mais recente)
+static void bcache_lru_touch(bcache_buf_t* buf) {
+    if (lru_head == buf) return;
+    
+    bcache_lru_unlink(buf);
+    buf->lru_next = lru_head;
+    if (lru_head) lru_head->lru_prev = buf;
+    lru_head = buf;
+    if (!lru_tail) lru_tail = buf;
+}
+
+// ============================================================================
+// WRITE-BACK E DESPEJO
+// ============================================================================
+
+// Grava um bloco sujo no dispositivo
+static int bcache_writeback(bcache_buf_t* buf) {
+    if (!(buf->flags & BCACHE_DIRTY)) return 0;
+    
+    if (bcache_dev_write(buf->dev, buf->lba, buf->data) != 0) {
+        return -1;
+    }
+    
+    buf->flags &= ~BCACHE_DIRTY;
+    dirty_count--;
+    return 0;
+}
+
+// Libera o bloco menos recente sem usuários (grava antes se estiver sujo)
+static bcache_buf_t* bcache_evict(void) {
+    for (bcache_buf_t* buf = lru_tail; buf; buf = buf->lru_prev) {
+        if (buf->refcount > 0) continue;
+        if (bcache_io_finish(buf)) continue;       // Leitura ainda em voo
+        if (bcache_writeback(buf) != 0) continue;  // Mantém dados não gravados
+        
+        if (buf->flags & BCACHE_VALID) {
+            stats.evictions++;
+        }
+        if (buf->dev != BCACHE_DEV_NONE) {
+            bcache_hash_remove(buf);
+        }
+        buf->flags = 0;
+        return buf;
+    }
+    return 0;
+}
+
+// ============================================================================
+// INTERFACE PÚBLICA
+// ============================================================================
+
+// Inicializa o cache: todos os blocos livres na lista LRU
+void bcache_init(void) {
+    for (int i = 0; i < BCACHE_HASH_SIZE; i++) {
+        hash_table[i] = 0;
+    }
+    
+    lru_head = 0;
+    lru_tail = 0;
+    for (int i = 0; i < BCACHE_BLOCKS; i++) {
+        bcache_buf_t* buf = &buffers[i];
+        
+        buf->dev = BCACHE_DEV_NONE;
+        buf->flags = 0;
+        buf->refcount = 0;
+        buf->io_status = BCACHE_IO_OK;
+        buf->hash_next = 0;
+        buf->lru_prev = lru_tail;
+        buf->lru_next = 0;
+        if (lru_tail) lru_tail->lru_next = buf;
+        else lru_head = buf;
+        lru_tail = buf;
+    }
+    
+    dirty_count = 0;
+    last_flush = timer_ticks;
+    stats.hits = 0;
+    stats.misses = 0;
+    stats.disk_reads = 0;
+    stats.disk_writes = 0;
+    stats.evictions = 0;
+    stats.writebacks = 0;
+    stats.prefetched = 0;
+    stats.prefetch_hits = 0;
+}
+
+// Obtém o bloco sem ler do disco (para quem vai sobrescrevê-lo inteiro)
+bcache_buf_t* bcache_get(uint8_t dev, uint32_t lba) {
+    bcache_buf_t* buf = bcache_lookup(dev, lba);
+    
+    if (!buf) {
+        buf = bcache_evict();
+        if (!buf) return 0;  // Todos os blocos em uso
+        
+        buf->dev = dev;
+        buf->lba = lba;
+        bcache_hash_insert(buf);
+    } else if (bcache_io_wait(buf) != 0) {
+        return 0;  // Leitura antecipada travada
+    }
+    
+    buf->refcount++;
+    bcache_lru_touch(buf);
+    return buf;
+}
+
+// Obtém o bloco com dados válidos (lê do disco apenas em caso de miss)
+bcache_buf_t* bcache_read(uint8_t dev, uint32_t lba) {
+    bcache_buf_t* buf = bcache_get(dev, lba);
+    if (!buf) return 0;
+    
+    if (buf->flags & BCACHE_VALID) {
+        stats.hits++;
+        if (buf->flags & BCACHE_PREFETCHED) {
+            buf->flags &= ~BCACHE_PREFETCHED;
+            stats.prefetch_hits++;
+        }
+        return buf;
+    }
+    
+    stats.misses++;
+    if (bcache_dev_read(dev, lba, buf->data) != 0) {
+        buf->refcount--;
+        bcache_hash_remove(buf);
+        buf->dev = BCACHE_DEV_NONE;
+        return 0;
+    }
+    
+    buf->flags |= BCACHE_VALID;
+    return buf;
+}
+
+// Devolve um bloco obtido por bcache_read/bcache_get
+void bcache_release(bcache_buf_t* buf) {
+    if (buf && buf->refcount > 0) {
+        buf->refcount--;
+    }
+}
+
+// Marca o bloco como modificado; o flusher o grava depois
+void bcache_mark_dirty(bcache_buf_t* buf) {
+    buf->flags |= BCACHE_VALID;
+    if (!(buf->flags & BCACHE_DIRTY)) {
+        buf->flags |= BCACHE_DIRTY;
+        buf->dirty_since = timer_ticks;
+        dirty_count++;
+    }
+}
+
+// Copia um bloco para 'buffer'
+int bcache_read_copy(uint8_t dev, uint32_t lba, void* buffer) {
+    bcache_buf_t* buf = bcache_read(dev, lba);
+    if (!buf) return -1;
+    
+    memory_copy(buffer, buf->data, BCACHE_BLOCK_SIZE);
+    bcache_release(buf);
+    return 0;
+}
+
+// Substitui o conteúdo de um bloco (write-back: grava só no flush)
+int bcache_write(uint8_t dev, uint32_t lba, const void* buffer) {
+    bcache_buf_t* buf = bcache_get(dev, lba);
+    if (!buf) return -1;
+    
+    memory_copy(buf->data, buffer, BCACHE_BLOCK_SIZE);
+    bcache_mark_dirty(buf);
+    bcache_release(buf);
+    return 0;
+}
+
+// Prepara um bloco livre para (dev, lba) vindo do read-ahead
+static bcache_buf_t* bcache_prefetch_slot(uint8_t dev, uint32_t lba) {
+    bcache_buf_t* buf = bcache_evict();
+    if (!buf) return 0;
+    
+    buf->dev = dev;
+    buf->lba = lba;
+    bcache_hash_insert(buf);
+    bcache_lru_touch(buf);
+    return buf;
+}
+
+// Leitura antecipada de até BCACHE_RA_MAX blocos a partir de 'lba'. Em
+// dispositivos com fila (virtio-blk) as leituras ficam em voo e só quem
+// precisar de um bloco espera por ele; nos demais cada trecho contíguo
+// ausente é lido com uma única requisição multi-setor. Retorna o número
+// de blocos iniciados
+int bcache_prefetch(uint8_t dev, uint32_t lba, uint32_t count) {
+    blockdev_t* bdev = blockdev_get(dev);
+    
+    if (!bdev) return 0;
+    if (count > BCACHE_RA_MAX) count = BCACHE_RA_MAX;
+    if (lba >= bdev->sectors) return 0;
+    if (count > bdev->sectors - lba) count = bdev->sectors - lba;
+    
+    int issued = 0;
+    
+    if (blockdev_can_queue(bdev)) {
+        for (uint32_t i = 0; i < count; i++) {
+            if (bcache_lookup(dev, lba + i)) continue;
+            
+            bcache_buf_t* buf = bcache_prefetch_slot(dev, lba + i);
+            if (!buf) break;
+            
+            buf->flags = BCACHE_LOADING | BCACHE_PREFETCHED;
+            buf->io_status = BCACHE_IO_PENDING;
+            if (blockdev_queue(bdev, lba + i, 1, buf->data, bcache_io_done, buf) != 0) {
+                // Fila do dispositivo cheia: o restante fica para a próxima vez
+                bcache_hash_remove(buf);
+                buf->dev = BCACHE_DEV_NONE;
+                buf->flags = 0;
+                break;
+            }
+            stats.disk_reads++;
+            stats.prefetched++;
+            issued++;
+        }
+        
+        if (issued > 0) {
+            blockdev_kick(bdev);  // Uma notificação para o lote inteiro
+        }
+        return issued;
+    }
+    
+    uint32_t i = 0;
+    while (i < count) {
+        if (bcache_lookup(dev, lba + i)) {
+            i++;
+            continue;
+        }
+        
+        // Trecho contíguo de blocos ausentes
+        uint32_t run = 1;
+        while (i + run < count && !bcache_lookup(dev, lba + i + run)) {
+            run++;
+        }
+        
+        stats.disk_reads += run;
+        if (blockdev_read(bdev, lba + i, run, ra_staging) != 0) {
+            return issued;
+        }
+        
+        for (uint32_t j = 0; j < run; j++) {
+            bcache_buf_t* buf = bcache_prefetch_slot(dev, lba + i + j);
+            if (!buf) return issued;
+            
+            memory_copy(buf->data, ra_staging + j * BCACHE_BLOCK_SIZE, BCACHE_BLOCK_SIZE);
+            buf->flags = BCACHE_VALID | BCACHE_PREFETCHED;
+            stats.prefetched++;
+            issued++;
+        }
+        i += run;
+    }
+    
+    return issued;
+}
+
+// Grava todos os blocos sujos (sync explícito)
+int bcache_sync(void) {
+    int result = 0;
+    
+    for (int i = 0; i < BCACHE_BLOCKS && dirty_count > 0; i++) {
+        if (bcache_writeback(&buffers[i]) != 0) {
+            result = -1;
+        }
+    }
+    
+    // Esvazia também o cache de escrita dos dispositivos
+    for (int i = 0; i < blockdev_count(); i++) {
+        if (blockdev_flush(blockdev_get(i)) != 0) {
+            result = -1;
+        }
+    }
+    return result;
+}
+
+// Grava os blocos sujos de um intervalo. Usado antes de leituras diretas
+// do dispositivo, que não passam pelo cache
+int bcache_writeback_range(uint8_t dev, uint32_t lba, uint32_t count) {
+    if (dirty_count == 0) return 0;
+    
+    for (uint32_t i = 0; i < count; i++) {
+        bcache_buf_t* buf = bcache_lookup(dev, lba + i);
+        
+        if (buf && bcache_writeback(buf) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Atualiza as cópias em cache de um trecho que acabou de ser gravado
+// direto no dispositivo: recebem os dados novos e deixam de estar sujas
+void bcache_update_range(uint8_t dev, uint32_t lba, uint32_t count, const void* data) {
+    const uint8_t* src = (const uint8_t*)data;
+    
+    for (uint32_t i = 0; i < count; i++) {
+        bcache_buf_t* buf = bcache_lookup(dev, lba + i);
+        
+        if (!buf || bcache_io_wait(buf) != 0) continue;
+        
+        memory_copy(buf->data, src + i * BCACHE_BLOCK_SIZE, BCACHE_BLOCK_SIZE);
+        buf->flags |= BCACHE_VALID;
+        if (buf->flags & BCACHE_DIRTY) {
+            buf->flags &= ~BCACHE_DIRTY;
+            dirty_count--;
+        }
+    }
+}
+
+// Flusher chamado pelo loop principal: grava blocos sujos há mais de
+// BCACHE_WRITEBACK_TICKS, verificando no máximo uma vez por intervalo
+void bcache_flush_expired(void) {
+    uint32_t now = timer_ticks;
+    
+    if (now - last_flush < BCACHE_FLUSH_INTERVAL) return;
+    last_flush = now;
+    
+    if (dirty_count == 0) return;
+    
+    for (int i = 0; i < BCACHE_BLOCKS; i++) {
+        bcache_buf_t* buf = &buffers[i];
+        
+        if ((buf->flags & BCACHE_DIRTY) && buf->refcount == 0 &&
+            now - buf->dirty_since >= BCACHE_WRITEBACK_TICKS) {
+            if (bcache_writeback(buf) == 0) {
+                stats.writebacks++;
+            }
+        }
+    }
+}
+
+// Descarta os blocos de um dispositivo (gravando os sujos antes)
+void bcache_invalidate(uint8_t dev) {
+    for (int i = 0; i < BCACHE_BLOCKS; i++) {
+        bcache_buf_t* buf = &buffers[i];
+        
+        if (buf->dev != dev || buf->refcount > 0) continue;
+        if (bcache_io_finish(buf)) continue;
+        if (bcache_writeback(buf) != 0) continue;
+        
+        bcache_hash_remove(buf);
+        buf->dev = BCACHE_DEV_NONE;
+        buf->flags = 0;
+    }
+}
+
+void bcache_get_stats(bcache_stats_t* out) {
+    *out = stats;
+}
+
+// ============================================================================
+// COMANDOS
+// ============================================================================
+
+// Comando: cachestat - estatísticas do cache de blocos
+void cmd_cachestat(void) {
+    uint32_t lookups = stats.hits + stats.misses;
+    uint32_t used = 0;
+    
+    for (int i = 0; i < BCACHE_BLOCKS; i++) {
+        if (buffers[i].flags & BCACHE_VALID) used++;
+    }
+    
+    terminal_print("\nCache de blocos:\n");
+    terminal_print("  Blocos: ");
+    terminal_print_dec(used);
+    terminal_print("/");
+    terminal_print_dec(BCACHE_BLOCKS);
+    terminal_print(" em uso, ");
+    terminal_print_dec(dirty_count);
+    terminal_print(" sujos\n");
+    
+    terminal_print("  Acertos: ");
+    terminal_print_dec(stats.hits);
+    terminal_print("  Faltas: ");
+    terminal_print_dec(stats.misses);
+    terminal_print("  Taxa de acerto: ");
+    terminal_print_dec(lookups ? (stats.hits * 100) / lookups : 0);
+    terminal_print("%\n");
+    
+    terminal_print("  Leituras do disco: ");
+    terminal_print_dec(stats.disk_reads);
+    terminal_print("  Escritas no disco: ");
+    terminal_print_dec(stats.disk_writes);
+    terminal_print("\n");
+    
+    terminal_print("  Read-ahead: ");
+    terminal_print_dec(stats.prefetched);
+    terminal_print(" blocos, ");
+    terminal_print_dec(stats.prefetch_hits);
+    terminal_print(" aproveitados\n");
+    
+    terminal_print("  Despejos: ");
+    terminal_print_dec(stats.evictions);
+    terminal_print("  Write-backs do flusher: ");
+    terminal_print_dec(stats.writebacks);
+    terminal_print("\n");
+}
+
+// Comando: sync - grava todos os blocos sujos
+void cmd_sync(void) {
+    uint32_t pending = dirty_count;
+    
+    if (bcache_sync() != 0) {
+        terminal_print("\nErro ao gravar blocos sujos.\n");
+        return;
+    }
+    
+    terminal_print("\n");
+    terminal_print_dec(pending);
+    terminal_print(" bloco(s) gravado(s).\n");
+}
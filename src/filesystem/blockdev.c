@@ -0,0 +1,165 @@
+// ============================================================================
+// NanoOS - Camada de Dispositivos de Bloco
+// Tabela de dispositivos nomeados com operações por driver (ATA, AHCI,
+// virtio-blk, RAM disk). O cache de blocos e o sistema de arquivos só
+// falam com esta camada
+// ============================================================================
+
+#include "../../include/blockdev.h"
+#include "../../include/kernel.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// VARIÁVEIS GLOBAIS
+// ============================================================================
+
+static blockdev_t devices[BLOCKDEV_MAX];
+static int device_count = 0;
+
+// ============================================================================
+// REGISTRO
+// ============================================================================
+
+// Registra um dispositivo; retorna 0 se a tabela está cheia
+blockdev_t* blockdev_register(const char* name, uint32_t sectors,
+                              const blockdev_ops_t* ops, void* priv) {
+    if (device_count >= BLOCKDEV_MAX || !ops || !ops->read || !ops->write) {
+        return 0;
+    }
+    
+    blockdev_t* dev = &devices[device_count];
+    int i = 0;
+    
+    for (; name[i] && i < BLOCKDEV_NAME_LEN - 1; i++) {
+        dev->name[i] = name[i];
+    }
+    dev->name[i] = '\0';
+    
+    dev->index = device_count;
+    dev->sectors = sectors;
+    dev->ops = ops;
+    dev->priv = priv;
+    dev->sectors_read = 0;
+    dev->sectors_written = 0;
+    
+    device_count++;
+    return dev;
+}
+
+blockdev_t* blockdev_get(uint8_t index) {
+    if (index >= device_count) return 0;
+    return &devices[index];
+}
+
+blockdev_t* blockdev_find(const char* name) {
+    for (int i = 0; i < device_count; i++) {
+        if (strcmp(devices[i].name, name) == 0) {
+            return &devices[i];
+        }
+    }
+    return 0;
+}
+
+int blockdev_count(void) {
+    return device_count;
+}
+
+// ============================================================================
+// OPERAÇÕES
+// ============================================================================
+
+static int blockdev_in_range(const blockdev_t* dev, uint32_t lba, uint32_t count) {
+    return dev && count > 0 && lba < dev->sectors && count <= dev->sectors - lba;
+}
+
+int blockdev_read(blockdev_t* dev, uint32_t lba, uint32_t count, void* buffer) {
+    if (!blockdev_in_range(dev, lba, count)) return -1;
+    
+    dev->sectors_read += count;
+    return dev->ops->read(dev, lba, count, buffer);
+}
+
+int blockdev_write(blockdev_t* dev, uint32_t lba, uint32_t count, const void* buffer) {
+    if (!blockdev_in_range(dev, lba, count)) return -1;
+    
+    dev->sectors_written += count;
+    return dev->ops->write(dev, lba, count, buffer);
+}
+
+int blockdev_flush(blockdev_t* dev) {
+    if (!dev) return -1;
+    if (!dev->ops->flush) return 0;  // Sem cache de escrita
+    
+    return dev->ops->flush(dev);
+}
+
+int blockdev_can_queue(const blockdev_t* dev) {
+    return dev && dev->ops->queue != 0;
+}
+
+// Enfileira uma leitura. Retorna -1 se o dispositivo não tem slot livre
+int blockdev_queue(blockdev_t* dev, uint32_t lba, uint32_t count, void* buffer,
+                   blockdev_callback_t callback, void* ctx) {
+    if (!blockdev_in_range(dev, lba, count)) return -1;
+    
+    if (dev->ops->queue) {
+        if (dev->ops->queue(dev, lba, count, buffer, callback, ctx) != 0) return -1;
+        dev->sectors_read += count;
+        return 0;
+    }
+    
+    dev->sectors_read += count;
+    int status = dev->ops->read(dev, lba, count, buffer);
+    if (callback) {
+        callback(status, ctx);
+    }
+    return 0;
+}
+
+void blockdev_kick(blockdev_t* dev) {
+    if (dev && dev->ops->kick) {
+        dev->ops->kick(dev);
+    }
+}
+
+int blockdev_poll(blockdev_t* dev) {
+    if (dev && dev->ops->poll) {
+        return dev->ops->poll(dev);
+    }
+    return 0;
+}
+
+// ============================================================================
+// DIAGNÓSTICO
+// ============================================================================
+
+// Lista os dispositivos registrados
+void blockdev_print_list(void) {
+    if (device_count == 0) {
+        terminal_print("Nenhum dispositivo de bloco.\n");
+        return;
+    }
+    
+    terminal_print("Nome   Tamanho     Lidos (KB)  Gravados (KB)\n");
+    for (int i = 0; i < device_count; i++) {
+        blockdev_t* dev = &devices[i];
+        
+        terminal_print(dev->name);
+        for (size_t pad = strlen(dev->name); pad < 7; pad++) {
+            terminal_print(" ");
+        }
+        terminal_print_dec(dev->sectors / 2);
+        terminal_print(" KB    ");
+        terminal_print_dec(dev->sectors_read / 2);
+        terminal_print("    ");
+        terminal_print_dec(dev->sectors_written / 2);
+        terminal_print(dev->ops->queue ? "    (fila)\n" : "\n");
+    }
+}
+
+// Comando: lsblk - lista os dispositivos de bloco
+void cmd_lsblk(void) {
+    terminal_print("\n");
+    blockdev_print_list();
+}
@@ -1,232 +1,246 @@
 // ============================================================================
-// NanoOS - Driver de Disco ATA/IDE
-// Implementação básica para leitura/escrita de setores
+// NanoOS - Diagnóstico de Disco
+// Informações dos dispositivos e benchmark comparando ATA PIO e virtio-blk
 // ============================================================================
 
 #include "../../include/disk.h"
 #include "../../include/kernel.h"
+#include "../../include/virtio_blk.h"
+#include "../../include/ata.h"
+#include "../../include/blockdev.h"
 #include <stdint.h>
 
 // ============================================================================
 // VARIÁVEIS GLOBAIS
 // ============================================================================
 
-static int disk_available = 0;
+static ata_drive_t* disk_ata = 0;            // Disco ATA do benchmark
+
+// Buffers do benchmark (maior transferência sequencial; um por canal ATA)
+static uint8_t bench_buffer[DISK_BENCH_SEQ_SECTORS * DISK_SECTOR_SIZE] __attribute__((aligned(4096)));
+static uint8_t bench_buffer_b[DISK_BENCH_SEQ_SECTORS * DISK_SECTOR_SIZE] __attribute__((aligned(4096)));
 
 // ============================================================================
-// FUNÇÕES DE E/S
+// UTILITÁRIOS
 // ============================================================================
 
-// Lê um byte de uma porta
-static inline uint8_t inb(uint16_t port) {
-    uint8_t result;
-    __asm__ volatile ("inb %1, %0" : "=a"(result) : "Nd"(port));
-    return result;
-}
-
-// Escreve um byte em uma porta
-static inline void outb(uint16_t port, uint8_t value) {
-    __asm__ volatile ("outb %0, %1" : : "a"(value), "Nd"(port));
-}
-
-// Lê uma word (16 bits) de uma porta
-static inline uint16_t inw(uint16_t port) {
-    uint16_t result;
-    __asm__ volatile ("inw %1, %0" : "=a"(result) : "Nd"(port));
-    return result;
+// Primeiro disco ATA presente (usado pelo benchmark)
+static ata_drive_t* disk_first_ata(void) {
+    for (int i = 0; i < ATA_DRIVES; i++) {
+        ata_drive_t* drive = ata_get_drive(i);
+        if (drive) return drive;
+    }
+    return 0;
 }
 
-// Escreve uma word (16 bits) em uma porta
-static inline void outw(uint16_t port, uint16_t value) {
-    __asm__ volatile ("outw %0, %1" : : "a"(value), "Nd"(port));
+// Mostra os dispositivos de bloco e os detalhes de cada driver
+void disk_print_info(void) {
+    blockdev_print_list();
+    ata_print_info();
+    virtio_blk_print_info();
 }
 
 // ============================================================================
-// FUNÇÕES DE ESPERA
+// BENCHMARK: ATA PIO x VIRTIO-BLK
 // ============================================================================
 
-// Aguarda o disco ficar pronto
-void disk_wait_ready(void) {
-    while (inb(ATA_PRIMARY_STATUS) & ATA_STATUS_BSY);
+static volatile uint32_t bench_inflight = 0;
+static volatile uint32_t bench_done = 0;
+static volatile uint32_t bench_channel_ops[2];
+
+// Gerador xorshift32 para LBAs aleatórios
+static uint32_t bench_random(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
 }
 
-// Aguarda dados estarem prontos para leitura/escrita
-int disk_wait_drq(void) {
-    uint32_t timeout = DISK_TIMEOUT;
-    
-    while (timeout--) {
-        uint8_t status = inb(ATA_PRIMARY_STATUS);
-        if (status & ATA_STATUS_DRQ) return 0;  // Sucesso
-        if (status & ATA_STATUS_ERR) return -1; // Erro
-    }
-    
-    return -1; // Timeout
+// Conclusão de uma leitura assíncrona virtio do benchmark
+static void bench_virtio_done(int status, void* ctx) {
+    (void)status;
+    (void)ctx;
+    bench_inflight--;
+    bench_done++;
 }
 
-// ============================================================================
-// INICIALIZAÇÃO DO DISCO
-// ============================================================================
-
-// Inicializa o driver de disco
-int disk_init(void) {
-    terminal_print("Inicializando driver de disco...\n");
+// Imprime uma linha de resultado: operações em 'elapsed' ticks
+static void bench_report(const char* label, uint32_t ops, uint32_t sectors_per_op, uint32_t elapsed) {
+    uint32_t per_sec = elapsed ? (ops * TIMER_FREQUENCY) / elapsed : 0;
     
-    // Seleciona drive 0 (master)
-    outb(ATA_PRIMARY_DRVHEAD, 0xA0);
-    disk_wait_ready();
-    
-    // Tenta identificar o disco
-    if (disk_identify() == 0) {
-        disk_available = 1;
-        terminal_print("Disco detectado com sucesso!\n");
-        return 0;
-    } else {
-        terminal_print("Nenhum disco detectado.\n");
-        return -1;
+    terminal_print(label);
+    terminal_print_dec(per_sec);
+    terminal_print(" IOPS, ");
+    terminal_print_dec(per_sec * sectors_per_op / 2);
+    terminal_print(" KB/s\n");
+}
+
+// Leitura síncrona pelo caminho do benchmark
+static int bench_read(int backend, uint32_t lba, uint32_t count) {
+    if (backend == DISK_BACKEND_VIRTIO) {
+        return virtio_blk_read(lba, count, bench_buffer);
     }
+    return ata_read(disk_ata, lba, count, bench_buffer);
 }
 
-// Identifica o disco
-int disk_identify(void) {
-    // Seleciona drive 0
-    outb(ATA_PRIMARY_DRVHEAD, 0xA0);
-    
-    // Zera contadores
-    outb(ATA_PRIMARY_SECCOUNT, 0);
-    outb(ATA_PRIMARY_SECNUM, 0);
-    outb(ATA_PRIMARY_CYLLOW, 0);
-    outb(ATA_PRIMARY_CYLHIGH, 0);
-    
-    // Envia comando IDENTIFY
-    outb(ATA_PRIMARY_COMMAND, ATA_CMD_IDENTIFY);
-    
-    // Verifica se há drive
-    uint8_t status = inb(ATA_PRIMARY_STATUS);
-    if (status == 0) return -1; // Não há drive
-    
-    // Aguarda até não estar busy
-    disk_wait_ready();
-    
-    // Verifica se é ATA (não ATAPI)
-    if (inb(ATA_PRIMARY_CYLLOW) != 0 || inb(ATA_PRIMARY_CYLHIGH) != 0) {
-        return -1; // Não é ATA
+// Leitura sequencial e aleatória síncrona (QD 1) por um caminho
+static void bench_sync(int backend, uint32_t sectors) {
+    uint32_t seed = timer_ticks | 1;
+    uint32_t lba = 0;
+    uint32_t ops = 0;
+    uint32_t start = timer_ticks;
+    
+    // Sequencial em blocos de 32 KB
+    while (timer_ticks - start < DISK_BENCH_TICKS) {
+        if (lba + DISK_BENCH_SEQ_SECTORS > sectors) lba = 0;
+        
+        if (bench_read(backend, lba, DISK_BENCH_SEQ_SECTORS) != 0) break;
+        
+        lba += DISK_BENCH_SEQ_SECTORS;
+        ops++;
     }
-    
-    // Aguarda DRQ ou erro
-    if (disk_wait_drq() != 0) return -1;
-    
-    // Lê os dados de identificação (256 words = 512 bytes)
-    uint16_t identify_data[256];
-    for (int i = 0; i < 256; i++) {
-        identify_data[i] = inw(ATA_PRIMARY_DATA);
+    bench_report("  Sequencial 32 KB:     ", ops, DISK_BENCH_SEQ_SECTORS, timer_ticks - start);
+    
+    // Aleatória em blocos de 4 KB
+    uint32_t blocks = sectors / DISK_BENCH_RAND_SECTORS;
+    ops = 0;
+    start = timer_ticks;
+    while (timer_ticks - start < DISK_BENCH_TICKS) {
+        lba = (bench_random(&seed) % blocks) * DISK_BENCH_RAND_SECTORS;
+        
+        if (bench_read(backend, lba, DISK_BENCH_RAND_SECTORS) != 0) break;
+        ops++;
     }
-    
-    return 0; // Sucesso
+    bench_report("  Aleatoria 4 KB QD1:   ", ops, DISK_BENCH_RAND_SECTORS, timer_ticks - start);
 }
 
-// ============================================================================
-// OPERAÇÕES DE LEITURA/ESCRITA
-// ============================================================================
-
-// Lê um setor do disco
-int disk_read_sector(uint32_t lba, void* buffer) {
-    if (!disk_available) return -1;
-    
-    uint16_t* buf = (uint16_t*)buffer;
-    
-    // Aguarda disco pronto
-    disk_wait_ready();
-    
-    // Configura LBA
-    outb(ATA_PRIMARY_DRVHEAD, 0xE0 | ((lba >> 24) & 0x0F)); // LBA mode, drive 0
-    outb(ATA_PRIMARY_SECCOUNT, 1);                           // 1 setor
-    outb(ATA_PRIMARY_SECNUM, lba & 0xFF);                   // LBA[7:0]
-    outb(ATA_PRIMARY_CYLLOW, (lba >> 8) & 0xFF);            // LBA[15:8]
-    outb(ATA_PRIMARY_CYLHIGH, (lba >> 16) & 0xFF);          // LBA[23:16]
-    
-    // Envia comando de leitura
-    outb(ATA_PRIMARY_COMMAND, ATA_CMD_READ_SECTORS);
-    
-    // Aguarda dados estarem prontos
-    if (disk_wait_drq() != 0) return -1;
+// Leitura aleatória virtio com várias requisições em voo e kick em lote
+static void bench_virtio_queued(uint32_t sectors, uint32_t qd) {
+    uint32_t seed = timer_ticks | 1;
+    uint32_t blocks = sectors / DISK_BENCH_RAND_SECTORS;
+    
+    bench_inflight = 0;
+    bench_done = 0;
+    
+    uint32_t start = timer_ticks;
+    while (timer_ticks - start < DISK_BENCH_TICKS) {
+        int queued = 0;
+        
+        while (bench_inflight < qd) {
+            uint32_t lba = (bench_random(&seed) % blocks) * DISK_BENCH_RAND_SECTORS;
+            
+            uint32_t flags = irq_save();
+            bench_inflight++;
+            irq_restore(flags);
+            
+            // Dados descartados: todas as leituras podem usar o mesmo buffer
+            if (virtio_blk_submit(lba, DISK_BENCH_RAND_SECTORS, bench_buffer, 0,
+                                  bench_virtio_done, 0) < 0) {
+                flags = irq_save();
+                bench_inflight--;
+                irq_restore(flags);
+                break;
+            }
+            queued++;
+        }
+        
+        if (queued) virtio_blk_kick();
+        virtio_blk_poll();
+    }
+    uint32_t elapsed = timer_ticks - start;
     
-    // Lê os dados (256 words = 512 bytes)
-    for (int i = 0; i < 256; i++) {
-        buf[i] = inw(ATA_PRIMARY_DATA);
+    uint32_t drain = timer_ticks;
+    while (bench_inflight > 0 && timer_ticks - drain < VIRTIO_BLK_TIMEOUT_TICKS) {
+        virtio_blk_poll();
     }
     
-    return 0; // Sucesso
+    bench_report("  Aleatoria 4 KB QD32:  ", bench_done, DISK_BENCH_RAND_SECTORS, elapsed);
 }
 
-// Escreve um setor no disco
-int disk_write_sector(uint32_t lba, const void* buffer) {
-    if (!disk_available) return -1;
-    
-    const uint16_t* buf = (const uint16_t*)buffer;
-    
-    // Aguarda disco pronto
-    disk_wait_ready();
-    
-    // Configura LBA
-    outb(ATA_PRIMARY_DRVHEAD, 0xE0 | ((lba >> 24) & 0x0F)); // LBA mode, drive 0
-    outb(ATA_PRIMARY_SECCOUNT, 1);                           // 1 setor
-    outb(ATA_PRIMARY_SECNUM, lba & 0xFF);                   // LBA[7:0]
-    outb(ATA_PRIMARY_CYLLOW, (lba >> 8) & 0xFF);            // LBA[15:8]
-    outb(ATA_PRIMARY_CYLHIGH, (lba >> 16) & 0xFF);          // LBA[23:16]
-    
-    // Envia comando de escrita
-    outb(ATA_PRIMARY_COMMAND, ATA_CMD_WRITE_SECTORS);
-    
-    // Aguarda estar pronto para receber dados
-    if (disk_wait_drq() != 0) return -1;
-    
-    // Escreve os dados (256 words = 512 bytes)
-    for (int i = 0; i < 256; i++) {
-        outw(ATA_PRIMARY_DATA, buf[i]);
-    }
-    
-    // Aguarda conclusão da escrita
-    disk_wait_ready();
-    
-    return 0; // Sucesso
+// Conclusão de uma leitura ATA do benchmark de canais (ctx = canal)
+static void bench_ata_done(int status, void* ctx) {
+    (void)status;
+    bench_done++;
+    bench_channel_ops[(uint32_t)ctx]++;
 }
 
-// Lê múltiplos setores
-int disk_read_sectors(uint32_t lba, uint32_t count, void* buffer) {
-    uint8_t* buf = (uint8_t*)buffer;
-    
-    for (uint32_t i = 0; i < count; i++) {
-        if (disk_read_sector(lba + i, buf + (i * DISK_SECTOR_SIZE)) != 0) {
-            return -1;
+// Leitura sequencial simultânea em um disco de cada canal: cada canal
+// recebe o próximo comando assim que termina o anterior
+static void bench_ata_channels(ata_drive_t* a, ata_drive_t* b) {
+    ata_drive_t* pair[2] = { a, b };
+    uint8_t* buffers[2] = { bench_buffer, bench_buffer_b };
+    uint32_t lba[2] = { 0, 0 };
+    
+    bench_done = 0;
+    bench_channel_ops[0] = 0;
+    bench_channel_ops[1] = 0;
+    
+    uint32_t start = timer_ticks;
+    while (timer_ticks - start < DISK_BENCH_TICKS) {
+        for (uint32_t i = 0; i < 2; i++) {
+            if (ata_busy(pair[i])) {
+                ata_poll(pair[i]);
+                continue;
+            }
+            if (lba[i] + DISK_BENCH_SEQ_SECTORS > pair[i]->sectors) lba[i] = 0;
+            if (ata_submit(pair[i], lba[i], DISK_BENCH_SEQ_SECTORS, buffers[i], 0,
+                           bench_ata_done, (void*)i) == 0) {
+                lba[i] += DISK_BENCH_SEQ_SECTORS;
+            }
         }
     }
+    uint32_t elapsed = timer_ticks - start;
     
-    return 0;
+    uint32_t drain = timer_ticks;
+    while ((ata_busy(a) || ata_busy(b)) && timer_ticks - drain < ATA_TIMEOUT_TICKS) {
+        ata_poll(a);
+        ata_poll(b);
+    }
+    
+    terminal_print("  Dois canais (");
+    terminal_print(ata_drive_name(a));
+    terminal_print(" + ");
+    terminal_print(ata_drive_name(b));
+    terminal_print("): ");
+    terminal_print_dec(bench_channel_ops[0]);
+    terminal_print(" + ");
+    terminal_print_dec(bench_channel_ops[1]);
+    terminal_print(" leituras\n");
+    bench_report("  Sequencial 32 KB x2:  ", bench_done, DISK_BENCH_SEQ_SECTORS, elapsed);
 }
 
-// Escreve múltiplos setores
-int disk_write_sectors(uint32_t lba, uint32_t count, const void* buffer) {
-    const uint8_t* buf = (const uint8_t*)buffer;
-    
-    for (uint32_t i = 0; i < count; i++) {
-        if (disk_write_sector(lba + i, buf + (i * DISK_SECTOR_SIZE)) != 0) {
-            return -1;
+// Comando: diskbench - compara vazão e IOPS dos caminhos ATA e virtio-blk
+void cmd_diskbench(void) {
+    terminal_print("\nBenchmark de leitura (1 segundo por teste)\n");
+    
+    disk_ata = disk_first_ata();
+    
+    if (disk_ata && disk_ata->sectors >= DISK_BENCH_SEQ_SECTORS) {
+        terminal_print("ATA PIO (");
+        terminal_print(ata_drive_name(disk_ata));
+        terminal_print("):\n");
+        bench_sync(DISK_BACKEND_ATA, disk_ata->sectors);
+        
+        // Um disco em cada canal: mede a operação simultânea
+        ata_drive_t* primary = ata_get_drive(0) ? ata_get_drive(0) : ata_get_drive(1);
+        ata_drive_t* secondary = ata_get_drive(2) ? ata_get_drive(2) : ata_get_drive(3);
+        if (primary && secondary &&
+            primary->sectors >= DISK_BENCH_SEQ_SECTORS &&
+            secondary->sectors >= DISK_BENCH_SEQ_SECTORS) {
+            bench_ata_channels(primary, secondary);
         }
+    } else {
+        terminal_print("ATA PIO: nao disponivel\n");
     }
     
-    return 0;
-}
-
-// ============================================================================
-// UTILITÁRIOS
-// ============================================================================
-
-// Mostra informações do disco
-void disk_print_info(void) {
-    if (disk_available) {
-        terminal_print("Status do disco: Disponivel\n");
-        terminal_print("Tamanho do setor: 512 bytes\n");
+    uint32_t vsectors = virtio_blk_sectors();
+    if (virtio_blk_available() && vsectors >= DISK_BENCH_SEQ_SECTORS) {
+        terminal_print("virtio-blk:\n");
+        bench_sync(DISK_BACKEND_VIRTIO, vsectors);
+        bench_virtio_queued(vsectors, DISK_BENCH_QUEUE_DEPTH);
     } else {
-        terminal_print("Status do disco: Nao disponivel\n");
+        terminal_print("virtio-blk: nao disponivel\n");
     }
 }
\ No newline at end of file
@@ -1,21 +1,55 @@
 // ============================================================================
-// NanoOS - Sistema de Arquivos FAT12
-// Implementação básica para leitura de arquivos em disquetes FAT12
+// NanoOS - Sistema de Arquivos FAT
+// Leitura de arquivos em volumes FAT12, FAT16 e FAT32
 // ============================================================================
 
 #include "../../include/filesystem.h"
-#include "../../include/disk.h"
+#include "../../include/blockdev.h"
 #include "../../include/commands.h"
+#include "../../include/kernel.h"
+#include "../../include/bcache.h"
+#include "../../include/vfs.h"
 #include <stdint.h>
 
 // ============================================================================
 // VARIÁVEIS GLOBAIS DO SISTEMA DE ARQUIVOS
 // ============================================================================
 
-static filesystem_t fs;
-static uint8_t fat_buffer[FAT12_SECTOR_SIZE * 9]; // Buffer para FAT (máx 9 setores)
+static filesystem_t fs_state;
+static uint8_t fat_buffer[FAT12_SECTOR_SIZE * FAT12_MAX_FAT_SECTORS] __attribute__((aligned(4)));
+static uint16_t fat_entries[FAT12_MAX_ENTRIES];
+
+// Setores da FAT (FAT16/32) presos no cache de blocos, mapeados por LBA
+static bcache_buf_t* fat_cache[FS_FAT_CACHE_SLOTS];
 static int fs_initialized = 0;
 
+// Setores da FAT (relativos ao início) alterados e ainda não espelhados
+static uint32_t fat_dirty[FS_FAT_DIRTY_MAX];
+static uint32_t fat_dirty_count = 0;
+
+static void fs_fat_cache_release(void);
+static int fs_fat_flush(void);
+static const vfs_ops_t fs_vfs_ops;
+
+// Cache de diretório: entradas positivas em ordem de diretório, mais um
+// anel de entradas negativas reaproveitadas em ordem circular
+static fs_dentry_t dcache_entries[FS_DCACHE_ENTRIES];
+static fs_dentry_t dcache_negative[FS_DCACHE_NEGATIVE];
+static fs_dentry_t* dcache_hash[FS_DCACHE_HASH_SIZE];
+static uint32_t dcache_count = 0;
+static uint32_t dcache_negative_next = 0;
+static int dcache_state = 0;         // 0 = inválido, 1 = carregado, -1 = não coube
+
+// Cache de componentes de caminho, reaproveitado em ordem circular
+static fs_pcache_entry_t pcache_entries[FS_PCACHE_ENTRIES];
+static fs_pcache_entry_t* pcache_hash[FS_PCACHE_HASH_SIZE];
+static uint32_t pcache_next = 0;
+static uint32_t pcache_hits = 0;
+static uint32_t pcache_misses = 0;
+
+// Buffer do benchmark de leitura (alinhado para o caminho direto)
+static uint8_t fs_bench_buffer[FS_BENCH_LARGE_READ + FS_DIRECT_ALIGN] __attribute__((aligned(512)));
+
 // ============================================================================
 // FUNÇÕES AUXILIARES DE STRING
 // ============================================================================
@@ -54,367 +88,2373 @@ static void str_to_fat_format(const char* input, char* output) {
     }
 }
 
-// Compara nomes de arquivo no formato FAT
-static int fat_name_compare(const char* fat_name, const char* search_name) {
-    char formatted_search[12];
-    str_to_fat_format(search_name, formatted_search);
+static inline char fs_upper(char c) {
+    return (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+}
+
+// Compara nomes sem distinguir maiúsculas (nomes FAT são case-insensitive)
+static int fs_name_equal(const char* a, const char* b) {
+    while (*a && fs_upper(*a) == fs_upper(*b)) {
+        a++;
+        b++;
+    }
+    return fs_upper(*a) == fs_upper(*b);
+}
+
+// O nome cabe no formato 8.3 sem perdas (até 8 caracteres, ponto, até 3)?
+static int fs_is_short_name(const char* name) {
+    int base = 0;
+    int ext = -1;
     
-    for (int i = 0; i < 11; i++) {
-        if (fat_name[i] != formatted_search[i]) {
-            return 0; // Diferentes
+    for (; *name; name++) {
+        char c = *name;
+        
+        if (c == '.') {
+            if (ext >= 0 || base == 0) return 0;
+            ext = 0;
+            continue;
+        }
+        if ((uint8_t)c <= ' ' || (uint8_t)c >= 0x80 || c == '+' || c == ',' ||
+            c == ';' || c == '=' || c == '[' || c == ']') {
+            return 0;
+        }
+        if (ext >= 0) {
+            if (++ext > 3) return 0;
+        } else if (++base > 8) {
+            return 0;
+        }
+    }
+    return base > 0 && ext != 0;
+}
+
+// Nome 8.3 de uma entrada na forma "NOME.EXT"
+static void fs_short_name(const fat12_dir_entry_t* entry, char* name) {
+    int len = 0;
+    
+    for (int j = 0; j < 8 && entry->filename[j] != ' '; j++) {
+        name[len++] = entry->filename[j];
+    }
+    
+    // Adiciona extensão se houver
+    if (entry->extension[0] != ' ') {
+        name[len++] = '.';
+        for (int j = 0; j < 3 && entry->extension[j] != ' '; j++) {
+            name[len++] = entry->extension[j];
         }
     }
-    return 1; // Iguais
+    name[len] = '\0';
 }
 
 // ============================================================================
 // INICIALIZAÇÃO DO SISTEMA DE ARQUIVOS
 // ============================================================================
 
-// Inicializa o sistema de arquivos
-int fs_init(void) {
-    terminal_print("Inicializando sistema de arquivos FAT12...\n");
+// Volumes tentados na montagem, em ordem de preferência: o RAM disk vem
+// primeiro para que o boot não dependa da detecção de discos
+static const char* fs_root_candidates[] = {
+    "ram0", "vda", "hda", "hdb", "hdc", "hdd", "sda", "sdb", 0
+};
+
+// Monta o volume FAT de um dispositivo de bloco
+int fs_mount(blockdev_t* dev) {
+    if (!dev) return -1;
     
-    // Inicializa o driver de disco
-    if (disk_init() != 0) {
-        terminal_print("Erro: Nao foi possivel inicializar o disco.\n");
-        return -1;
-    }
+    // Alterações pendentes do volume anterior vão para o cache antes
+    if (fs_initialized) fs_fat_flush();
     
-    // Lê o boot sector
-    if (fs_read_boot_sector() != 0) {
-        terminal_print("Erro: Nao foi possivel ler o boot sector.\n");
-        return -1;
-    }
+    fs_initialized = 0;
+    fat_dirty_count = 0;
+    fs_fat_cache_release();
+    fs_state.dev = dev;
+    fs_dcache_invalidate();
     
-    // Carrega a tabela FAT
-    if (fs_load_fat_table() != 0) {
-        terminal_print("Erro: Nao foi possivel carregar a tabela FAT.\n");
+    // Lê o boot sector e carrega a tabela FAT
+    if (fs_read_boot_sector() != 0 || fs_load_fat_table() != 0) {
+        fs_state.dev = 0;
         return -1;
     }
     
     fs_initialized = 1;
-    terminal_print("Sistema de arquivos inicializado com sucesso!\n");
     return 0;
 }
 
-// Lê o boot sector do disco
+// Inicializa o sistema de arquivos no primeiro volume FAT encontrado
+int fs_init(void) {
+    terminal_print("Inicializando sistema de arquivos FAT...\n");
+    
+    for (int i = 0; fs_root_candidates[i]; i++) {
+        blockdev_t* dev = blockdev_find(fs_root_candidates[i]);
+        
+        if (dev && fs_mount(dev) == 0) {
+            terminal_print("Sistema de arquivos montado em ");
+            terminal_print(dev->name);
+            terminal_print("\n");
+            return vfs_mount("/", &fs_vfs_ops, 0);
+        }
+    }
+    
+    terminal_print("Erro: nenhum volume FAT encontrado.\n");
+    return -1;
+}
+
+// Lê o boot sector do disco e determina o tipo de FAT
 int fs_read_boot_sector(void) {
-    // Lê o setor 0 (boot sector)
-    if (disk_read_sector(0, &fs.boot_sector) != 0) {
+    uint8_t sector_buffer[FAT12_SECTOR_SIZE];
+    
+    // Lê o setor 0 (boot sector) inteiro; a estrutura cobre só o BPB
+    if (blockdev_read(fs_state.dev, 0, 1, sector_buffer) != 0) {
+        return -1;
+    }
+    memory_copy(&fs_state.boot_sector, sector_buffer, sizeof(fs_state.boot_sector));
+    
+    fat12_boot_sector_t* bpb = &fs_state.boot_sector;
+    fat32_ext_bpb_t* ext = (fat32_ext_bpb_t*)(sector_buffer + 36);
+    
+    // Só setores de 512 bytes são suportados
+    if (bpb->bytes_per_sector != FAT12_SECTOR_SIZE ||
+        bpb->sectors_per_cluster == 0 || bpb->fat_count == 0) {
         return -1;
     }
     
     // Calcula informações do sistema de arquivos
-    fs.sectors_per_cluster = fs.boot_sector.sectors_per_cluster;
-    fs.bytes_per_cluster = fs.boot_sector.bytes_per_sector * fs.sectors_per_cluster;
+    fs_state.sectors_per_cluster = bpb->sectors_per_cluster;
+    fs_state.bytes_per_cluster = bpb->bytes_per_sector * fs_state.sectors_per_cluster;
+    
+    // FAT32 tem o campo de 16 bits zerado e usa o BPB estendido
+    fs_state.fat_start = bpb->reserved_sectors;
+    fs_state.fat_sectors = bpb->sectors_per_fat ? bpb->sectors_per_fat : ext->sectors_per_fat_32;
+    if (fs_state.fat_sectors == 0) return -1;
     
     // Calcula setor inicial do diretório raiz
-    fs.root_dir_sector = fs.boot_sector.reserved_sectors + 
-                        (fs.boot_sector.fat_count * fs.boot_sector.sectors_per_fat);
+    fs_state.root_dir_sector = fs_state.fat_start + bpb->fat_count * fs_state.fat_sectors;
     
     // Calcula setor inicial da área de dados
-    uint32_t root_dir_sectors = (fs.boot_sector.root_entries * 32 + 
-                                fs.boot_sector.bytes_per_sector - 1) / 
-                               fs.boot_sector.bytes_per_sector;
-    fs.data_sector = fs.root_dir_sector + root_dir_sectors;
+    fs_state.root_dir_sectors = (bpb->root_entries * 32 + 
+                                 bpb->bytes_per_sector - 1) / 
+                                bpb->bytes_per_sector;
+    fs_state.data_sector = fs_state.root_dir_sector + fs_state.root_dir_sectors;
+    
+    // O tipo de FAT vem apenas do número de clusters de dados
+    uint32_t total_sectors = bpb->total_sectors_16 ? bpb->total_sectors_16 : 
+                                                     bpb->total_sectors_32;
+    if (total_sectors <= fs_state.data_sector) return -1;
+    
+    uint32_t clusters = (total_sectors - fs_state.data_sector) / fs_state.sectors_per_cluster;
+    
+    if (clusters < FAT12_MAX_CLUSTERS) {
+        fs_state.fat_type = 12;
+    } else if (clusters < FAT16_MAX_CLUSTERS) {
+        fs_state.fat_type = 16;
+    } else {
+        fs_state.fat_type = 32;
+    }
+    
+    // A FAT precisa ter uma entrada por cluster
+    uint32_t fat_bytes = fs_state.fat_sectors * FAT12_SECTOR_SIZE;
+    uint32_t fat_capacity = fs_state.fat_type == 12 ? fat_bytes * 2 / 3 : 
+                            fat_bytes / (fs_state.fat_type / 8);
+    
+    fs_state.cluster_count = clusters + 2;
+    if (fs_state.cluster_count > fat_capacity) fs_state.cluster_count = fat_capacity;
+    
+    fs_state.root_cluster = 0;
+    fs_state.fsinfo_sector = 0;
+    if (fs_state.fat_type == 32) {
+        fs_state.root_cluster = ext->root_cluster;
+        fs_state.fsinfo_sector = ext->fsinfo_sector;
+        if (fs_state.root_cluster < 2) return -1;
+    }
     
     return 0;
 }
 
-// Carrega a tabela FAT na memória
-int fs_load_fat_table(void) {
-    uint32_t fat_start_sector = fs.boot_sector.reserved_sectors;
-    uint32_t fat_sectors = fs.boot_sector.sectors_per_fat;
-    
-    // Lê todos os setores da primeira FAT
-    for (uint32_t i = 0; i < fat_sectors && i < 9; i++) {
-        if (disk_read_sector(fat_start_sector + i, 
-                           fat_buffer + (i * FAT12_SECTOR_SIZE)) != 0) {
-            return -1;
-        }
+// Solta os setores da FAT presos no cache de blocos
+static void fs_fat_cache_release(void) {
+    for (int i = 0; i < FS_FAT_CACHE_SLOTS; i++) {
+        bcache_release(fat_cache[i]);
+        fat_cache[i] = 0;
     }
+}
+
+// Setor 'lba' da FAT, mantido preso no cache de blocos. Um cluster a mais
+// na cadeia quase sempre cai no mesmo setor, que aqui dispensa a busca no hash
+static bcache_buf_t* fs_fat_sector(uint32_t lba) {
+    bcache_buf_t** slot = &fat_cache[lba & (FS_FAT_CACHE_SLOTS - 1)];
     
-    fs.fat_table = fat_buffer;
-    return 0;
+    if (*slot && (*slot)->lba == lba) return *slot;
+    
+    bcache_release(*slot);
+    *slot = bcache_read(fs_state.dev->index, lba);
+    return *slot;
 }
 
-// ============================================================================
-// OPERAÇÕES DE ARQUIVO
-// ============================================================================
+// Lê a entrada de 'cluster' numa FAT16/32 (setor carregado sob demanda).
+// A marca de cluster defeituoso encerra a cadeia
+static uint32_t fs_fat_read_entry(uint32_t cluster) {
+    uint32_t offset = cluster * (fs_state.fat_type / 8);
+    bcache_buf_t* buf = fs_fat_sector(fs_state.fat_start + offset / FAT12_SECTOR_SIZE);
+    
+    if (!buf) return FS_CLUSTER_EOF;
+    
+    uint32_t in_sector = offset % FAT12_SECTOR_SIZE;
+    
+    if (fs_state.fat_type == 16) {
+        uint32_t value = *(uint16_t*)(buf->data + in_sector);
+        return value >= FAT16_CLUSTER_BAD ? FS_CLUSTER_EOF : value;
+    }
+    
+    uint32_t value = *(uint32_t*)(buf->data + in_sector) & FAT32_CLUSTER_MASK;
+    return value >= FAT32_CLUSTER_BAD ? FS_CLUSTER_EOF : value;
+}
 
-// Procura um arquivo no diretório raiz
-int fs_find_file(const char* filename, fat12_dir_entry_t* entry) {
-    if (!fs_initialized) return -1;
+// Conta os clusters livres percorrendo a FAT inteira (só quando pedido)
+static uint32_t fs_count_free_clusters(void) {
+    uint32_t free_count = 0;
     
+    for (uint32_t cluster = 2; cluster < fs_state.cluster_count; cluster++) {
+        free_count += fs_fat_read_entry(cluster) == 0;
+    }
+    return free_count;
+}
+
+// Dicas do FSInfo: clusters livres e próximo cluster livre. Valores
+// ausentes ou inválidos ficam como FS_FREE_UNKNOWN e 2, respectivamente
+static void fs_read_fsinfo(void) {
     uint8_t sector_buffer[FAT12_SECTOR_SIZE];
-    uint32_t root_sectors = (fs.boot_sector.root_entries * 32 + 
-                            FAT12_SECTOR_SIZE - 1) / FAT12_SECTOR_SIZE;
     
-    // Percorre todos os setores do diretório raiz
-    for (uint32_t sector = 0; sector < root_sectors; sector++) {
-        if (disk_read_sector(fs.root_dir_sector + sector, sector_buffer) != 0) {
-            return -1;
-        }
-        
-        // Percorre todas as entradas do setor
-        fat12_dir_entry_t* entries = (fat12_dir_entry_t*)sector_buffer;
-        uint32_t entries_per_sector = FAT12_SECTOR_SIZE / sizeof(fat12_dir_entry_t);
-        
-        for (uint32_t i = 0; i < entries_per_sector; i++) {
-            // Verifica se a entrada é válida
-            if (entries[i].filename[0] == 0x00) {
-                return -1; // Fim das entradas
-            }
-            
-            if (entries[i].filename[0] == 0xE5) {
-                continue; // Entrada deletada
-            }
-            
-            // Ignora entradas de volume label e diretórios
-            if (entries[i].attributes & (FAT_ATTR_VOLUME_LABEL | FAT_ATTR_DIRECTORY)) {
-                continue;
-            }
-            
-            // Compara nomes
-            if (fat_name_compare((char*)entries[i].filename, filename)) {
-                *entry = entries[i];
-                return 0; // Arquivo encontrado
-            }
-        }
+    if (fs_state.fsinfo_sector == 0 || fs_state.fsinfo_sector >= fs_state.fat_start) {
+        return;
+    }
+    if (blockdev_read(fs_state.dev, fs_state.fsinfo_sector, 1, sector_buffer) != 0) {
+        return;
+    }
+    
+    if (*(uint32_t*)sector_buffer != FAT32_FSINFO_LEAD_SIG ||
+        *(uint32_t*)(sector_buffer + FAT32_FSINFO_STRUC_OFF) != FAT32_FSINFO_STRUC_SIG) {
+        return;
     }
     
-    return -1; // Arquivo não encontrado
+    uint32_t free_count = *(uint32_t*)(sector_buffer + FAT32_FSINFO_FREE_COUNT);
+    uint32_t next_free = *(uint32_t*)(sector_buffer + FAT32_FSINFO_NEXT_FREE);
+    
+    if (free_count <= fs_state.cluster_count - 2) fs_state.free_clusters = free_count;
+    if (next_free >= 2 && next_free < fs_state.cluster_count) fs_state.next_free = next_free;
 }
 
-// Obtém o próximo cluster de um arquivo
-uint32_t fs_get_next_cluster(uint32_t cluster) {
-    if (!fs_initialized || cluster < 2) return FAT12_CLUSTER_EOF;
-    
-    // Calcula posição na FAT (FAT12 = 1.5 bytes per entry)
-    uint32_t fat_offset = cluster + (cluster / 2); // cluster * 1.5
-    uint16_t fat_value = *(uint16_t*)(fs.fat_table + fat_offset);
+// Desempacota entradas de 12 bits para 16 bits. É um laço escalar
+// desenrolado, não vetorial (o kernel não habilita SSE): cada volta lê
+// 12 bytes em três palavras de 32 bits, extrai 8 entradas com
+// deslocamentos e máscaras e conta os clusters livres sem desvios.
+// Retorna o número de clusters livres
+static uint32_t fs_unpack_fat12(const uint8_t* packed, uint16_t* out, uint32_t count) {
+    uint32_t free_count = 0;
+    uint32_t i = 0;
     
-    if (cluster & 1) {
-        fat_value = fat_value >> 4; // Cluster ímpar - usa bits superiores
-    } else {
-        fat_value = fat_value & 0x0FFF; // Cluster par - usa bits inferiores
+    for (; i + 8 <= count; i += 8, packed += 12) {
+        uint32_t w0 = *(const uint32_t*)(packed + 0);
+        uint32_t w1 = *(const uint32_t*)(packed + 4);
+        uint32_t w2 = *(const uint32_t*)(packed + 8);
+        uint16_t e0 = w0 & 0xFFF;
+        uint16_t e1 = (w0 >> 12) & 0xFFF;
+        uint16_t e2 = ((w0 >> 24) | (w1 << 8)) & 0xFFF;
+        uint16_t e3 = (w1 >> 4) & 0xFFF;
+        uint16_t e4 = (w1 >> 16) & 0xFFF;
+        uint16_t e5 = ((w1 >> 28) | (w2 << 4)) & 0xFFF;
+        uint16_t e6 = (w2 >> 8) & 0xFFF;
+        uint16_t e7 = w2 >> 20;
+        
+        out[i + 0] = e0; out[i + 1] = e1; out[i + 2] = e2; out[i + 3] = e3;
+        out[i + 4] = e4; out[i + 5] = e5; out[i + 6] = e6; out[i + 7] = e7;
+        
+        free_count += (e0 == 0) + (e1 == 0) + (e2 == 0) + (e3 == 0) +
+                      (e4 == 0) + (e5 == 0) + (e6 == 0) + (e7 == 0);
     }
     
-    if (fat_value >= 0xFF8) {
-        return FAT12_CLUSTER_EOF; // Fim do arquivo
+    // Entradas restantes, duas a cada três bytes
+    for (; i < count; i++) {
+        const uint8_t* p = packed + ((i & 7) >> 1) * 3;
+        uint16_t e = (i & 1) ? ((p[1] >> 4) | (p[2] << 4)) : (p[0] | ((p[1] & 0x0F) << 8));
+        
+        out[i] = e;
+        free_count += (e == 0);
     }
     
-    return fat_value;
+    return free_count;
 }
 
-// Abre um arquivo para leitura
-int fs_open(const char* filename, file_handle_t* handle) {
-    if (!fs_initialized || !filename || !handle) return -1;
+// Prepara o acesso à FAT. FAT12 (no máximo 12 setores) é lida e
+// desempacotada por inteiro; FAT16/32 é lida setor a setor sob demanda
+int fs_load_fat_table(void) {
+    fs_state.fat_table = 0;
+    fs_state.fat_entries = 0;
+    fs_state.free_clusters = FS_FREE_UNKNOWN;
+    fs_state.next_free = 2;
     
-    fat12_dir_entry_t entry;
-    if (fs_find_file(filename, &entry) != 0) {
-        return -1; // Arquivo não encontrado
+    if (fs_state.fat_type != 12) {
+        // Sem varrer a FAT: FAT32 confia no FSInfo, FAT16 conta quando pedido
+        if (fs_state.fat_type == 32) fs_read_fsinfo();
+        return 0;
     }
     
-    // Inicializa o handle
-    str_to_fat_format(filename, handle->filename);
-    handle->size = entry.file_size;
-    handle->current_cluster = entry.first_cluster_low;
-    handle->position = 0;
-    handle->is_open = 1;
+    uint32_t fat_sectors = fs_state.fat_sectors;
+    
+    // Lê a primeira FAT em uma única requisição
+    if (fat_sectors > FAT12_MAX_FAT_SECTORS) fat_sectors = FAT12_MAX_FAT_SECTORS;
+    if (blockdev_read(fs_state.dev, fs_state.fat_start, fat_sectors, fat_buffer) != 0) {
+        return -1;
+    }
+    
+    // Clusters do volume, limitados à parte da FAT que foi lida
+    uint32_t count = fs_state.cluster_count;
+    if (count > fat_sectors * FAT12_SECTOR_SIZE * 2 / 3) {
+        count = fat_sectors * FAT12_SECTOR_SIZE * 2 / 3;
+    }
     
+    uint32_t free_count = fs_unpack_fat12(fat_buffer, fat_entries, count);
+    
+    // As duas primeiras entradas são reservadas (mídia e EOC), não livres
+    fs_state.fat_table = fat_buffer;
+    fs_state.fat_entries = fat_entries;
+    fs_state.cluster_count = count;
+    fs_state.free_clusters = free_count - (fat_entries[0] == 0) - (fat_entries[1] == 0);
+    
+    // Clusters 0 e 1 nunca fazem parte de uma cadeia
+    fat_entries[0] = FAT12_CLUSTER_EOF;
+    fat_entries[1] = FAT12_CLUSTER_EOF;
     return 0;
 }
 
-// Lê dados de um arquivo
-int fs_read(file_handle_t* handle, void* buffer, uint32_t size) {
-    if (!fs_initialized || !handle || !handle->is_open || !buffer) return -1;
+// ============================================================================
+// CACHE DE DIRETÓRIO
+// ============================================================================
+
+// Entrada livre ou fim do diretório?
+static inline int fs_dir_entry_unused(const fat12_dir_entry_t* entry) {
+    return entry->filename[0] == 0x00 || entry->filename[0] == 0xE5;
+}
+
+// Primeiro setor de um cluster de dados
+static inline uint32_t fs_cluster_to_lba(uint32_t cluster) {
+    return fs_state.data_sector + (cluster - 2) * fs_state.sectors_per_cluster;
+}
+
+// Primeiro cluster de uma entrada (a metade alta só existe no FAT32)
+static inline uint32_t fs_entry_cluster(const fat12_dir_entry_t* entry) {
+    uint32_t cluster = entry->first_cluster_low;
     
-    uint32_t bytes_read = 0;
-    uint8_t* buf = (uint8_t*)buffer;
-    uint8_t cluster_buffer[FAT12_SECTOR_SIZE];
+    if (fs_state.fat_type == 32) cluster |= (uint32_t)entry->first_cluster_high << 16;
+    return cluster;
+}
+
+// Percorre os setores de um diretório: a raiz é a região fixa no FAT12/16
+// ou a cadeia de root_cluster no FAT32; subdiretórios são cadeias de clusters
+typedef struct {
+    uint32_t cluster;
+    uint32_t sector;
+    uint8_t fixed;                   // Raiz fixa do FAT12/16
+} fs_dir_cursor_t;
+
+// 'dir_cluster' é o primeiro cluster do diretório (0 = raiz)
+static void fs_dir_begin(fs_dir_cursor_t* cursor, uint32_t dir_cluster) {
+    cursor->fixed = dir_cluster == 0 && fs_state.fat_type != 32;
+    cursor->cluster = dir_cluster != 0 ? dir_cluster : fs_state.root_cluster;
+    cursor->sector = 0;
+}
+
+// LBA do próximo setor do diretório, ou 0 no fim
+static uint32_t fs_dir_next(fs_dir_cursor_t* cursor) {
+    if (cursor->fixed) {
+        if (cursor->sector >= fs_state.root_dir_sectors) return 0;
+        return fs_state.root_dir_sector + cursor->sector++;
+    }
     
-    while (bytes_read < size && handle->position < handle->size && 
-           handle->current_cluster < FAT12_CLUSTER_EOF) {
-        
-        // Calcula setor do cluster atual
-        uint32_t cluster_sector = fs.data_sector + 
-                                 (handle->current_cluster - 2) * fs.sectors_per_cluster;
-        
-        // Lê o cluster
-        if (disk_read_sector(cluster_sector, cluster_buffer) != 0) {
-            return -1;
-        }
-        
-        // Calcula quantos bytes copiar
-        uint32_t cluster_offset = handle->position % fs.boot_sector.bytes_per_sector;
-        uint32_t bytes_in_cluster = fs.boot_sector.bytes_per_sector - cluster_offset;
-        uint32_t bytes_to_copy = size - bytes_read;
-        
-        if (bytes_to_copy > bytes_in_cluster) {
-            bytes_to_copy = bytes_in_cluster;
-        }
-        
-        if (handle->position + bytes_to_copy > handle->size) {
-            bytes_to_copy = handle->size - handle->position;
-        }
-        
-        // Copia dados
-        for (uint32_t i = 0; i < bytes_to_copy; i++) {
-            buf[bytes_read + i] = cluster_buffer[cluster_offset + i];
-        }
-        
-        bytes_read += bytes_to_copy;
-        handle->position += bytes_to_copy;
-        
-        // Se chegou ao fim do cluster, vai para o próximo
-        if ((handle->position % fs.boot_sector.bytes_per_sector) == 0) {
-            handle->current_cluster = fs_get_next_cluster(handle->current_cluster);
-        }
+    if (cursor->sector == fs_state.sectors_per_cluster) {
+        cursor->cluster = fs_get_next_cluster(cursor->cluster);
+        cursor->sector = 0;
     }
+    if (cursor->cluster < 2 || cursor->cluster >= FS_CLUSTER_EOF) return 0;
     
-    return bytes_read;
+    return fs_cluster_to_lba(cursor->cluster) + cursor->sector++;
 }
 
-// Fecha um arquivo
-int fs_close(file_handle_t* handle) {
-    if (!handle) return -1;
+// Nome longo sendo montado a partir das entradas VFAT, que chegam da
+// última parte para a primeira
+typedef struct {
+    char name[FS_LFN_MAX + 1];
+    uint8_t checksum;
+    uint8_t next_seq;                // Próxima parte esperada (0 = completo)
+    uint8_t valid;
+} fs_lfn_t;
+
+static inline void fs_lfn_reset(fs_lfn_t* lfn) {
+    lfn->valid = 0;
+    lfn->next_seq = 0;
+}
+
+// Checksum do nome 8.3 gravado em cada parte do nome longo
+static uint8_t fs_lfn_checksum(const uint8_t* short_name) {
+    uint8_t sum = 0;
     
-    handle->is_open = 0;
-    return 0;
+    for (int i = 0; i < 11; i++) {
+        sum = ((sum & 1) << 7) + (sum >> 1) + short_name[i];
+    }
+    return sum;
 }
 
-// Lista arquivos do diretório raiz
-int fs_list_directory(void) {
-    if (!fs_initialized) return -1;
+// Acrescenta uma parte ao nome. Caracteres fora do ASCII viram '?'
+static void fs_lfn_feed(fs_lfn_t* lfn, const fat_lfn_entry_t* part) {
+    static const uint8_t counts[3] = {5, 6, 2};
+    const uint8_t* chars[3] = {part->name1, part->name2, part->name3};
+    uint8_t seq = part->sequence & FAT_LFN_SEQ_MASK;
     
-    uint8_t sector_buffer[FAT12_SECTOR_SIZE];
-    uint32_t root_sectors = (fs.boot_sector.root_entries * 32 + 
-                            FAT12_SECTOR_SIZE - 1) / FAT12_SECTOR_SIZE;
-    int file_count = 0;
+    if (part->sequence & FAT_LFN_LAST) {
+        memory_set(lfn->name, 0, sizeof(lfn->name));
+        lfn->checksum = part->checksum;
+        lfn->next_seq = seq;
+        lfn->valid = seq != 0 && seq <= FAT_LFN_MAX_ENTRIES;
+    }
+    if (!lfn->valid || seq != lfn->next_seq || part->checksum != lfn->checksum) {
+        lfn->valid = 0;
+        return;
+    }
+    lfn->next_seq--;
     
-    terminal_print("\nArquivos no diretorio raiz:\n");
-    terminal_print("Nome           Tamanho\n");
-    terminal_print("------------------------\n");
+    uint32_t pos = (seq - 1) * FAT_LFN_CHARS;
     
-    // Percorre todos os setores do diretório raiz
-    for (uint32_t sector = 0; sector < root_sectors; sector++) {
-        if (disk_read_sector(fs.root_dir_sector + sector, sector_buffer) != 0) {
-            return -1;
+    for (int p = 0; p < 3; p++) {
+        for (int k = 0; k < counts[p]; k++, pos++) {
+            uint16_t c = chars[p][2 * k] | (chars[p][2 * k + 1] << 8);
+            
+            if (c == 0) return; // Terminador (o resto é preenchido com 0xFFFF)
+            if (pos < FS_LFN_MAX) lfn->name[pos] = c < 0x80 ? (char)c : '?';
         }
+    }
+}
+
+// Nome longo que precede 'entry', ou "" se a sequência não é dela
+static const char* fs_lfn_finish(const fs_lfn_t* lfn, const fat12_dir_entry_t* entry) {
+    if (!lfn->valid || lfn->next_seq != 0 ||
+        lfn->checksum != fs_lfn_checksum(entry->filename)) {
+        return "";
+    }
+    return lfn->name;
+}
+
+// Visita cada entrada em uso de um diretório (menos o volume label), com o
+// nome longo já decodificado. O visitante retorna 1 para parar
+typedef int (*fs_dir_visit_t)(const fat12_dir_entry_t* entry, const char* long_name,
+                              uint32_t lba, uint16_t index, void* ctx);
+
+// Retorna 1 se o visitante parou, 0 no fim do diretório, -1 em erro
+static int fs_dir_iterate(uint32_t dir_cluster, fs_dir_visit_t visit, void* ctx) {
+    uint32_t entries_per_sector = FAT12_SECTOR_SIZE / sizeof(fat12_dir_entry_t);
+    fs_dir_cursor_t cursor;
+    fs_lfn_t lfn;
+    uint32_t lba;
+    
+    fs_lfn_reset(&lfn);
+    fs_dir_begin(&cursor, dir_cluster);
+    while ((lba = fs_dir_next(&cursor)) != 0) {
+        bcache_buf_t* buf = bcache_read(fs_state.dev->index, lba);
+        if (!buf) return -1;
         
-        fat12_dir_entry_t* entries = (fat12_dir_entry_t*)sector_buffer;
-        uint32_t entries_per_sector = FAT12_SECTOR_SIZE / sizeof(fat12_dir_entry_t);
+        fat12_dir_entry_t* entries = (fat12_dir_entry_t*)buf->data;
         
         for (uint32_t i = 0; i < entries_per_sector; i++) {
-            if (entries[i].filename[0] == 0x00) {
-                goto end_listing; // Fim das entradas
-            }
+            const fat12_dir_entry_t* entry = &entries[i];
             
-            if (entries[i].filename[0] == 0xE5) {
-                continue; // Entrada deletada
+            if (entry->filename[0] == 0x00) {
+                bcache_release(buf);
+                return 0; // Fim das entradas
             }
-            
-            // Ignora volume labels
-            if (entries[i].attributes & FAT_ATTR_VOLUME_LABEL) {
+            if (entry->filename[0] == 0xE5) {
+                fs_lfn_reset(&lfn);
                 continue;
             }
-            
-            // Mostra nome do arquivo
-            char name[12] = {0};
-            for (int j = 0; j < 8; j++) {
-                if (entries[i].filename[j] != ' ') {
-                    name[j] = entries[i].filename[j];
-                } else {
-                    break;
-                }
-            }
-            
-            // Adiciona extensão se houver
-            if (entries[i].extension[0] != ' ') {
-                int len = strlen(name);
-                name[len] = '.';
-                for (int j = 0; j < 3; j++) {
-                    if (entries[i].extension[j] != ' ') {
-                        name[len + 1 + j] = entries[i].extension[j];
-                    } else {
-                        break;
-                    }
-                }
+            if (entry->attributes == FAT_ATTR_LFN) {
+                fs_lfn_feed(&lfn, (const fat_lfn_entry_t*)entry);
+                continue;
             }
             
-            // Mostra informações
-            terminal_print(name);
+            int stop = 0;
             
-            // Preenche com espaços
-            int name_len = strlen(name);
-            for (int j = name_len; j < 14; j++) {
-                terminal_print(" ");
+            if (!(entry->attributes & FAT_ATTR_VOLUME_LABEL)) {
+                stop = visit(entry, fs_lfn_finish(&lfn, entry), lba, i, ctx);
             }
+            fs_lfn_reset(&lfn);
             
-            // Mostra tamanho
-            char size_str[16];
-            uint_to_str(entries[i].file_size, size_str, sizeof(size_str));
-            terminal_print(size_str);
-            terminal_print(" bytes");
-            
-            if (entries[i].attributes & FAT_ATTR_DIRECTORY) {
-                terminal_print(" <DIR>");
+            if (stop) {
+                bcache_release(buf);
+                return 1;
             }
-            
-            terminal_print("\n");
-            file_count++;
         }
+        
+        bcache_release(buf);
     }
     
-end_listing:
-    char count_str[16];
-    uint_to_str(file_count, count_str, sizeof(count_str));
-    terminal_print("\nTotal: ");
-    terminal_print(count_str);
-    terminal_print(" arquivo(s)\n");
-    
-    return file_count;
+    return 0;
 }
 
-// ============================================================================
-// UTILITÁRIOS
-// ============================================================================
+// Preenche uma entrada de cache a partir da entrada do disco
+static void fs_dentry_fill(fs_dentry_t* dentry, const fat12_dir_entry_t* entry,
+                           const char* long_name, uint32_t lba, uint16_t index) {
+    uint32_t len = 0;
+    
+    while (long_name[len] && len < FS_NAME_MAX - 1) {
+        dentry->long_name[len] = long_name[len];
+        len++;
+    }
+    dentry->long_name[len] = '\0';
+    dentry->entry = *entry;
+    dentry->dir_lba = lba;
+    dentry->dir_index = index;
+    dentry->negative = 0;
+}
 
-// Mostra informações do boot sector
-void fs_print_boot_info(void) {
-    if (!fs_initialized) {
-        terminal_print("Sistema de arquivos nao inicializado.\n");
-        return;
+// Hash FNV-1a do nome 8.3 empacotado (11 bytes)
+static inline uint32_t fs_dcache_hash(const uint8_t* name) {
+    uint32_t hash = 2166136261u;
+    
+    for (int i = 0; i < 11; i++) {
+        hash = (hash ^ name[i]) * 16777619u;
     }
+    return hash & (FS_DCACHE_HASH_SIZE - 1);
+}
+
+static void fs_dcache_insert(fs_dentry_t* dentry) {
+    uint32_t bucket = fs_dcache_hash(dentry->entry.filename);
     
-    terminal_print("\nInformacoes do sistema de arquivos:\n");
+    dentry->hash_next = dcache_hash[bucket];
+    dcache_hash[bucket] = dentry;
+}
+
+static void fs_dcache_unlink(fs_dentry_t* dentry) {
+    fs_dentry_t** link = &dcache_hash[fs_dcache_hash(dentry->entry.filename)];
     
-    char buffer[32];
+    while (*link && *link != dentry) {
+        link = &(*link)->hash_next;
+    }
+    if (*link) *link = dentry->hash_next;
+}
+
+// Descarta o cache; a próxima consulta relê o diretório. Deve ser chamado
+// por qualquer caminho que escreva no diretório raiz
+void fs_dcache_invalidate(void) {
+    dcache_state = 0;
+}
+
+static int fs_dcache_load_entry(const fat12_dir_entry_t* entry, const char* long_name,
+                                uint32_t lba, uint16_t index, void* ctx) {
+    (void)ctx;
     
-    terminal_print("Bytes por setor: ");
-    uint_to_str(fs.boot_sector.bytes_per_sector, buffer, sizeof(buffer));
-    terminal_print(buffer);
-    terminal_print("\n");
+    // Diretório maior que o cache: as consultas voltam ao disco
+    if (dcache_count == FS_DCACHE_ENTRIES) return 1;
     
-    terminal_print("Setores por cluster: ");
-    uint_to_str(fs.boot_sector.sectors_per_cluster, buffer, sizeof(buffer));
-    terminal_print(buffer);
-    terminal_print("\n");
+    fs_dentry_t* dentry = &dcache_entries[dcache_count++];
+    fs_dentry_fill(dentry, entry, long_name, lba, index);
+    fs_dcache_insert(dentry);
+    return 0;
+}
+
+// Lê o diretório raiz inteiro para o cache (uma vez por montagem)
+static void fs_dcache_load(void) {
+    for (int i = 0; i < FS_DCACHE_HASH_SIZE; i++) {
+        dcache_hash[i] = 0;
+    }
+    for (int i = 0; i < FS_DCACHE_NEGATIVE; i++) {
+        dcache_negative[i].negative = 0;
+    }
+    dcache_count = 0;
+    dcache_negative_next = 0;
+    dcache_state = -1;
     
-    terminal_print("Numero de FATs: ");
-    uint_to_str(fs.boot_sector.fat_count, buffer, sizeof(buffer));
-    terminal_print(buffer);
-    terminal_print("\n");
+    if (fs_dir_iterate(0, fs_dcache_load_entry, 0) == 0) dcache_state = 1;
+}
+
+// Consulta por nome empacotado: um único bucket
+static fs_dentry_t* fs_dcache_lookup(const char* packed) {
+    fs_dentry_t* dentry = dcache_hash[fs_dcache_hash((const uint8_t*)packed)];
     
-    terminal_print("Entradas do diretorio raiz: ");
-    uint_to_str(fs.boot_sector.root_entries, buffer, sizeof(buffer));
-    terminal_print(buffer);
-    terminal_print("\n");
+    while (dentry && memory_compare(dentry->entry.filename, packed, 11) != 0) {
+        dentry = dentry->hash_next;
+    }
+    return dentry;
+}
+
+// Lembra que um nome não existe (reaproveita a entrada negativa mais antiga)
+static void fs_dcache_add_negative(const char* packed) {
+    fs_dentry_t* dentry = &dcache_negative[dcache_negative_next];
     
-    terminal_print("Setores por FAT: ");
-    uint_to_str(fs.boot_sector.sectors_per_fat, buffer, sizeof(buffer));
+    dcache_negative_next = (dcache_negative_next + 1) % FS_DCACHE_NEGATIVE;
+    if (dentry->negative) fs_dcache_unlink(dentry);
+    
+    memory_copy(dentry->entry.filename, packed, 11);
+    dentry->negative = 1;
+    fs_dcache_insert(dentry);
+}
+
+// Mantém o cache coerente com uma entrada recém-criada no diretório
+static void fs_dcache_add(const fs_dentry_t* created) {
+    if (dcache_state <= 0) return;
+    
+    fs_dentry_t* dentry = fs_dcache_lookup((const char*)created->entry.filename);
+    
+    if (dentry && dentry->negative) {
+        fs_dcache_unlink(dentry);
+        dentry->negative = 0;
+    }
+    
+    if (dcache_count == FS_DCACHE_ENTRIES) {
+        fs_dcache_invalidate();
+        return;
+    }
+    
+    dentry = &dcache_entries[dcache_count++];
+    *dentry = *created;
+    dentry->negative = 0;
+    fs_dcache_insert(dentry);
+}
+
+// Remove do cache uma entrada apagada (a última ocupa o lugar dela) e
+// lembra o nome como inexistente
+static void fs_dcache_remove(const char* packed) {
+    if (dcache_state <= 0) return;
+    
+    fs_dentry_t* dentry = fs_dcache_lookup(packed);
+    if (!dentry || dentry->negative) return;
+    
+    fs_dentry_t* last = &dcache_entries[dcache_count - 1];
+    
+    fs_dcache_unlink(dentry);
+    if (dentry != last) {
+        fs_dcache_unlink(last);
+        *dentry = *last;
+        fs_dcache_insert(dentry);
+    }
+    dcache_count--;
+    fs_dcache_add_negative(packed);
+}
+
+// Atualiza a cópia em cache de uma entrada regravada em (lba, index). A
+// posição distingue a raiz de um subdiretório com um arquivo de mesmo nome
+static void fs_dcache_update(const fat12_dir_entry_t* entry, uint32_t lba, uint16_t index) {
+    if (dcache_state <= 0) return;
+    
+    fs_dentry_t* dentry = fs_dcache_lookup((const char*)entry->filename);
+    if (dentry && !dentry->negative && dentry->dir_lba == lba && dentry->dir_index == index) {
+        dentry->entry = *entry;
+    }
+}
+
+// Varredura do diretório no disco (diretório maior que o cache)
+static int fs_scan_root(const char* packed, fs_dentry_t* found) {
+    uint32_t entries_per_sector = FAT12_SECTOR_SIZE / sizeof(fat12_dir_entry_t);
+    fs_dir_cursor_t cursor;
+    uint32_t lba;
+    
+    fs_dir_begin(&cursor, 0);
+    while ((lba = fs_dir_next(&cursor)) != 0) {
+        bcache_buf_t* buf = bcache_read(fs_state.dev->index, lba);
+        if (!buf) return -1;
+        
+        fat12_dir_entry_t* entries = (fat12_dir_entry_t*)buf->data;
+        
+        for (uint32_t i = 0; i < entries_per_sector; i++) {
+            if (entries[i].filename[0] == 0x00) {
+                bcache_release(buf);
+                return -1; // Fim das entradas
+            }
+            
+            if (!fs_dir_entry_unused(&entries[i]) && entries[i].attributes != FAT_ATTR_LFN &&
+                memory_compare(entries[i].filename, packed, 11) == 0) {
+                fs_dentry_fill(found, &entries[i], "", lba, i);
+                bcache_release(buf);
+                return 0;
+            }
+        }
+        
+        bcache_release(buf);
+    }
+    
+    return -1;
+}
+
+// ============================================================================
+// CACHE DE CAMINHOS
+// ============================================================================
+
+// Hash FNV-1a de (diretório pai, componente), sem distinguir maiúsculas
+static uint32_t fs_pcache_hash(uint32_t parent, const char* name) {
+    uint32_t hash = 2166136261u ^ parent;
+    
+    while (*name) {
+        hash = (hash ^ (uint8_t)fs_upper(*name++)) * 16777619u;
+    }
+    return hash;
+}
+
+// Descarta todos os componentes. Chamado quando um diretório ganha ou perde
+// entradas (os resultados negativos deixariam de valer)
+static void fs_pcache_invalidate(void) {
+    for (int i = 0; i < FS_PCACHE_HASH_SIZE; i++) {
+        pcache_hash[i] = 0;
+    }
+    for (int i = 0; i < FS_PCACHE_ENTRIES; i++) {
+        pcache_entries[i].used = 0;
+    }
+    pcache_next = 0;
+}
+
+static fs_pcache_entry_t* fs_pcache_lookup(uint32_t parent, const char* name) {
+    uint32_t hash = fs_pcache_hash(parent, name);
+    fs_pcache_entry_t* entry = pcache_hash[hash & (FS_PCACHE_HASH_SIZE - 1)];
+    
+    while (entry && (entry->hash != hash || entry->parent != parent ||
+                     !fs_name_equal(entry->name, name))) {
+        entry = entry->hash_next;
+    }
+    return entry;
+}
+
+// Guarda o resultado de uma busca (found = 0: o nome não existe),
+// reaproveitando a entrada mais antiga
+static void fs_pcache_insert(uint32_t parent, const char* name, const fs_dentry_t* found) {
+    uint32_t len = strlen(name);
+    
+    if (len >= FS_NAME_MAX) return;
+    
+    fs_pcache_entry_t* entry = &pcache_entries[pcache_next];
+    
+    pcache_next = (pcache_next + 1) % FS_PCACHE_ENTRIES;
+    if (entry->used) {
+        fs_pcache_entry_t** link = &pcache_hash[entry->hash & (FS_PCACHE_HASH_SIZE - 1)];
+        
+        while (*link != entry) {
+            link = &(*link)->hash_next;
+        }
+        *link = entry->hash_next;
+    }
+    
+    entry->parent = parent;
+    entry->hash = fs_pcache_hash(parent, name);
+    memory_copy(entry->name, name, len + 1);
+    if (found) {
+        entry->dentry = *found;
+        entry->dentry.negative = 0;
+    } else {
+        entry->dentry.negative = 1;
+    }
+    entry->used = 1;
+    
+    uint32_t bucket = entry->hash & (FS_PCACHE_HASH_SIZE - 1);
+    entry->hash_next = pcache_hash[bucket];
+    pcache_hash[bucket] = entry;
+}
+
+// Atualiza as cópias em cache de uma entrada regravada em (lba, index)
+static void fs_pcache_update(const fat12_dir_entry_t* dir_entry, uint32_t lba, uint16_t index) {
+    for (int i = 0; i < FS_PCACHE_ENTRIES; i++) {
+        fs_pcache_entry_t* entry = &pcache_entries[i];
+        
+        if (entry->used && !entry->dentry.negative &&
+            entry->dentry.dir_lba == lba && entry->dentry.dir_index == index) {
+            entry->dentry.entry = *dir_entry;
+        }
+    }
+}
+
+// ============================================================================
+// ALOCAÇÃO DE CLUSTERS
+// ============================================================================
+
+// Registra um setor da FAT alterado (espelhado nas cópias por fs_fat_flush)
+static void fs_fat_mark_dirty(uint32_t sector) {
+    for (uint32_t i = fat_dirty_count; i > 0; i--) {
+        if (fat_dirty[i - 1] == sector) return;
+    }
+    
+    if (fat_dirty_count == FS_FAT_DIRTY_MAX) fs_fat_flush();
+    fat_dirty[fat_dirty_count++] = sector;
+}
+
+// Grava 'value' na entrada de 'cluster' (FS_CLUSTER_EOF vira a marca de fim
+// de cadeia do tipo). Só a primeira FAT é alterada aqui
+static int fs_fat_set(uint32_t cluster, uint32_t value) {
+    if (cluster < 2 || cluster >= fs_state.cluster_count) return -1;
+    
+    if (fs_state.fat_type == 12) {
+        if (value == FS_CLUSTER_EOF) value = FAT12_CLUSTER_EOC;
+        
+        uint32_t offset = cluster + (cluster / 2);
+        uint8_t* p = fs_state.fat_table + offset;
+        
+        if (cluster & 1) {
+            p[0] = (p[0] & 0x0F) | (uint8_t)(value << 4);
+            p[1] = (uint8_t)(value >> 4);
+        } else {
+            p[0] = (uint8_t)value;
+            p[1] = (p[1] & 0xF0) | ((value >> 8) & 0x0F);
+        }
+        fs_state.fat_entries[cluster] = value;
+        
+        // Uma entrada de 12 bits pode cruzar a fronteira de setor
+        fs_fat_mark_dirty(offset / FAT12_SECTOR_SIZE);
+        fs_fat_mark_dirty((offset + 1) / FAT12_SECTOR_SIZE);
+        return 0;
+    }
+    
+    uint32_t offset = cluster * (fs_state.fat_type / 8);
+    bcache_buf_t* buf = fs_fat_sector(fs_state.fat_start + offset / FAT12_SECTOR_SIZE);
+    
+    if (!buf) return -1;
+    
+    uint8_t* p = buf->data + offset % FAT12_SECTOR_SIZE;
+    
+    if (fs_state.fat_type == 16) {
+        *(uint16_t*)p = value == FS_CLUSTER_EOF ? FAT16_CLUSTER_EOC : value;
+    } else {
+        // Os 4 bits altos são reservados e preservados
+        if (value == FS_CLUSTER_EOF) value = FAT32_CLUSTER_EOC;
+        *(uint32_t*)p = (*(uint32_t*)p & ~FAT32_CLUSTER_MASK) | (value & FAT32_CLUSTER_MASK);
+    }
+    
+    bcache_mark_dirty(buf);
+    fs_fat_mark_dirty(offset / FAT12_SECTOR_SIZE);
+    return 0;
+}
+
+// Copia os setores alterados da primeira FAT para o cache (FAT12) e para
+// as demais cópias, e atualiza o FSInfo. A gravação no disco fica com o
+// flusher do cache de blocos ou com o sync
+static int fs_fat_flush(void) {
+    uint8_t dev = fs_state.dev->index;
+    int result = 0;
+    
+    for (uint32_t i = 0; i < fat_dirty_count; i++) {
+        uint32_t sector = fat_dirty[i];
+        const uint8_t* src;
+        
+        if (fs_state.fat_type == 12) {
+            src = fs_state.fat_table + sector * FAT12_SECTOR_SIZE;
+            if (bcache_write(dev, fs_state.fat_start + sector, src) != 0) result = -1;
+        } else {
+            bcache_buf_t* primary = fs_fat_sector(fs_state.fat_start + sector);
+            if (!primary) {
+                result = -1;
+                continue;
+            }
+            src = primary->data;
+        }
+        
+        for (uint32_t copy = 1; copy < fs_state.boot_sector.fat_count; copy++) {
+            uint32_t lba = fs_state.fat_start + copy * fs_state.fat_sectors + sector;
+            if (bcache_write(dev, lba, src) != 0) result = -1;
+        }
+    }
+    
+    if (fat_dirty_count > 0 && fs_state.fat_type == 32 && fs_state.fsinfo_sector != 0) {
+        bcache_buf_t* info = bcache_read(dev, fs_state.fsinfo_sector);
+        
+        if (info && *(uint32_t*)info->data == FAT32_FSINFO_LEAD_SIG) {
+            *(uint32_t*)(info->data + FAT32_FSINFO_FREE_COUNT) = fs_state.free_clusters;
+            *(uint32_t*)(info->data + FAT32_FSINFO_NEXT_FREE) = fs_state.next_free;
+            bcache_mark_dirty(info);
+        }
+        bcache_release(info);
+    }
+    
+    fat_dirty_count = 0;
+    return result;
+}
+
+// Procura um cluster livre a partir da dica next_free, dando a volta no
+// volume. Com a dica o caso comum (volume preenchido em ordem) é O(1)
+static uint32_t fs_find_free_cluster(void) {
+    uint32_t span = fs_state.cluster_count - 2;
+    uint32_t cluster = fs_state.next_free;
+    
+    for (uint32_t i = 0; i < span; i++, cluster++) {
+        if (cluster >= fs_state.cluster_count) cluster = 2;
+        if (fs_get_next_cluster(cluster) == FAT12_CLUSTER_FREE) return cluster;
+    }
+    return 0;
+}
+
+// Aloca um cluster e o encadeia depois de 'prev' (0 = início de cadeia).
+// O cluster logo após 'prev' é preferido para manter o arquivo contíguo.
+// Retorna 0 se o volume está cheio
+static uint32_t fs_alloc_cluster(uint32_t prev) {
+    uint32_t cluster = 0;
+    
+    if (prev >= 2 && prev + 1 < fs_state.cluster_count &&
+        fs_get_next_cluster(prev + 1) == FAT12_CLUSTER_FREE) {
+        cluster = prev + 1;
+    } else {
+        cluster = fs_find_free_cluster();
+    }
+    if (cluster == 0) return 0;
+    
+    if (fs_fat_set(cluster, FS_CLUSTER_EOF) != 0) return 0;
+    
+    // Sem o encadeamento o cluster ficaria marcado e fora de qualquer cadeia
+    if (prev >= 2 && fs_fat_set(prev, cluster) != 0) {
+        fs_fat_set(cluster, FAT12_CLUSTER_FREE);
+        return 0;
+    }
+    
+    fs_state.next_free = cluster + 1 < fs_state.cluster_count ? cluster + 1 : 2;
+    if (fs_state.free_clusters != FS_FREE_UNKNOWN) fs_state.free_clusters--;
+    return cluster;
+}
+
+// Libera uma cadeia inteira a partir de 'cluster'
+static void fs_free_chain(uint32_t cluster) {
+    while (cluster >= 2 && cluster < FS_CLUSTER_EOF) {
+        uint32_t next = fs_get_next_cluster(cluster);
+        
+        if (fs_fat_set(cluster, FAT12_CLUSTER_FREE) != 0) return;
+        if (fs_state.free_clusters != FS_FREE_UNKNOWN) fs_state.free_clusters++;
+        if (cluster < fs_state.next_free) fs_state.next_free = cluster;
+        cluster = next;
+    }
+}
+
+// ============================================================================
+// OPERAÇÕES DE ARQUIVO
+// ============================================================================
+
+// Procura um nome 8.3 empacotado no diretório raiz (qualquer tipo de
+// entrada). Preenche a cópia da entrada e sua posição no diretório
+static int fs_lookup(const char* packed, fs_dentry_t* found) {
+    if (dcache_state == 0) fs_dcache_load();
+    
+    if (dcache_state <= 0) return fs_scan_root(packed, found);
+    
+    fs_dentry_t* dentry = fs_dcache_lookup(packed);
+    
+    if (!dentry) {
+        fs_dcache_add_negative(packed);
+        return -1;
+    }
+    if (dentry->negative) return -1;
+    
+    *found = *dentry;
+    return 0;
+}
+
+// Visitante de fs_dir_find: compara com o nome longo e com o nome 8.3
+typedef struct {
+    const char* name;
+    fs_dentry_t* found;
+} fs_find_ctx_t;
+
+static int fs_dir_find_entry(const fat12_dir_entry_t* entry, const char* long_name,
+                             uint32_t lba, uint16_t index, void* ctx) {
+    fs_find_ctx_t* find = (fs_find_ctx_t*)ctx;
+    char short_name[13];
+    
+    fs_short_name(entry, short_name);
+    if (!fs_name_equal(long_name, find->name) && !fs_name_equal(short_name, find->name)) {
+        return 0;
+    }
+    
+    fs_dentry_fill(find->found, entry, long_name, lba, index);
+    return 1;
+}
+
+// Varredura de um diretório no disco (via cache de blocos) por nome longo
+// ou 8.3
+static int fs_dir_find(uint32_t dir_cluster, const char* name, fs_dentry_t* found) {
+    fs_find_ctx_t find = {name, found};
+    
+    return fs_dir_iterate(dir_cluster, fs_dir_find_entry, &find) == 1 ? 0 : -1;
+}
+
+// Procura um componente no diretório 'dir_cluster' (0 = raiz). O cache de
+// caminhos responde primeiro; na raiz, nomes 8.3 usam o cache de diretório
+static int fs_lookup_in(uint32_t dir_cluster, const char* name, fs_dentry_t* found) {
+    fs_pcache_entry_t* cached = fs_pcache_lookup(dir_cluster, name);
+    
+    if (cached) {
+        pcache_hits++;
+        if (cached->dentry.negative) return -1;
+        *found = cached->dentry;
+        return 0;
+    }
+    pcache_misses++;
+    
+    int result;
+    
+    if (dir_cluster == 0 && fs_is_short_name(name)) {
+        char packed[12];
+        str_to_fat_format(name, packed);
+        result = fs_lookup(packed, found);
+    } else {
+        result = fs_dir_find(dir_cluster, name, found);
+    }
+    
+    fs_pcache_insert(dir_cluster, name, result == 0 ? found : 0);
+    return result;
+}
+
+// Resolve todos os componentes de 'path' menos o último, que é copiado para
+// 'last' (FS_LFN_MAX + 1 bytes). Devolve o diretório pai (0 = raiz)
+static int fs_walk(const char* path, uint32_t* parent, char* last) {
+    uint32_t dir = 0;
+    
+    for (;;) {
+        while (*path == '/') path++;
+        
+        uint32_t len = 0;
+        while (path[len] && path[len] != '/') len++;
+        if (len == 0 || len > FS_LFN_MAX) return -1;
+        
+        memory_copy(last, path, len);
+        last[len] = '\0';
+        path += len;
+        while (*path == '/') path++;
+        
+        if (*path == '\0') {
+            *parent = dir;
+            return 0;
+        }
+        if (last[0] == '.' && last[1] == '\0') continue;
+        
+        fs_dentry_t found;
+        if (fs_lookup_in(dir, last, &found) != 0 ||
+            !(found.entry.attributes & FAT_ATTR_DIRECTORY)) {
+            return -1;
+        }
+        
+        // O ".." de um subdiretório de primeiro nível aponta para o cluster 0;
+        // no FAT32 a raiz também é normalizada para 0
+        dir = fs_entry_cluster(&found.entry);
+        if (dir == fs_state.root_cluster) dir = 0;
+    }
+}
+
+// Resolve um caminho até a entrada do último componente
+static int fs_resolve(const char* path, uint32_t* parent, fs_dentry_t* found) {
+    char last[FS_LFN_MAX + 1];
+    
+    if (fs_walk(path, parent, last) != 0) return -1;
+    return fs_lookup_in(*parent, last, found);
+}
+
+// Procura um arquivo por caminho ("/DIR/SUB/ARQUIVO.TXT", nomes longos ou 8.3)
+int fs_find_file(const char* path, fat12_dir_entry_t* entry) {
+    if (!fs_initialized || !path) return -1;
+    
+    uint32_t parent;
+    fs_dentry_t found;
+    if (fs_resolve(path, &parent, &found) != 0) return -1;
+    
+    // Ignora entradas de volume label e diretórios
+    if (found.entry.attributes & (FAT_ATTR_VOLUME_LABEL | FAT_ATTR_DIRECTORY)) {
+        return -1;
+    }
+    
+    *entry = found.entry;
+    return 0; // Arquivo encontrado
+}
+
+// Decodificação direto da FAT empacotada (referência para o fatbench)
+static uint32_t fs_get_next_cluster_packed(uint32_t cluster) {
+    if (!fs_initialized || cluster < 2) return FS_CLUSTER_EOF;
+    
+    // Calcula posição na FAT (FAT12 = 1.5 bytes per entry)
+    uint32_t fat_offset = cluster + (cluster / 2); // cluster * 1.5
+    uint16_t fat_value = *(uint16_t*)(fs_state.fat_table + fat_offset);
+    
+    if (cluster & 1) {
+        fat_value = fat_value >> 4; // Cluster ímpar - usa bits superiores
+    } else {
+        fat_value = fat_value & 0x0FFF; // Cluster par - usa bits inferiores
+    }
+    
+    if (fat_value >= FAT12_CLUSTER_BAD) {
+        return FS_CLUSTER_EOF; // Fim do arquivo (ou cluster defeituoso)
+    }
+    
+    return fat_value;
+}
+
+// Obtém o próximo cluster de um arquivo. FAT12 é uma leitura na tabela
+// desempacotada; FAT16/32 lê o setor da FAT pelo cache. O fim de cadeia
+// (ou um cluster defeituoso) é sempre FS_CLUSTER_EOF
+uint32_t fs_get_next_cluster(uint32_t cluster) {
+    if (cluster >= fs_state.cluster_count) return FS_CLUSTER_EOF;
+    
+    if (fs_state.fat_type == 12) {
+        uint32_t value = fs_state.fat_entries[cluster];
+        return value >= FAT12_CLUSTER_BAD ? FS_CLUSTER_EOF : value;
+    }
+    
+    if (cluster < 2) return FS_CLUSTER_EOF;
+    return fs_fat_read_entry(cluster);
+}
+
+// Monta o mapa de extents do arquivo percorrendo a cadeia uma única vez.
+// Cadeias mais fragmentadas que FS_MAX_EXTENTS ficam com o mapa parcial
+static void fs_build_extents(file_handle_t* handle, uint32_t first_cluster) {
+    uint32_t cluster = first_cluster;
+    uint32_t file_cluster = 0;
+    
+    handle->extent_count = 0;
+    handle->extents_complete = 1;
+    
+    while (cluster >= 2 && cluster < FS_CLUSTER_EOF) {
+        fs_extent_t* last = handle->extent_count ? 
+                            &handle->extents[handle->extent_count - 1] : 0;
+        
+        if (last && last->disk_cluster + last->length == cluster) {
+            last->length++;
+        } else if (handle->extent_count < FS_MAX_EXTENTS) {
+            fs_extent_t* ext = &handle->extents[handle->extent_count++];
+            ext->file_cluster = file_cluster;
+            ext->disk_cluster = cluster;
+            ext->length = 1;
+        } else {
+            handle->extents_complete = 0;
+            return;
+        }
+        
+        file_cluster++;
+        cluster = fs_get_next_cluster(cluster);
+    }
+}
+
+// Cluster de disco do n-ésimo cluster do arquivo (busca binária no mapa).
+// Retorna FS_CLUSTER_EOF se o arquivo termina antes
+static uint32_t fs_extent_lookup(file_handle_t* handle, uint32_t file_cluster) {
+    if (handle->extent_count == 0) return FS_CLUSTER_EOF;
+    
+    uint32_t lo = 0;
+    uint32_t hi = handle->extent_count - 1;
+    
+    // Último extent que começa em ou antes de 'file_cluster'
+    while (lo < hi) {
+        uint32_t mid = (lo + hi + 1) / 2;
+        if (handle->extents[mid].file_cluster <= file_cluster) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    
+    fs_extent_t* ext = &handle->extents[lo];
+    uint32_t delta = file_cluster - ext->file_cluster;
+    
+    if (delta < ext->length) return ext->disk_cluster + delta;
+    if (lo + 1 < handle->extent_count || handle->extents_complete) {
+        return FS_CLUSTER_EOF;
+    }
+    
+    // Além do mapa parcial: continua pela FAT a partir do último extent
+    uint32_t cluster = ext->disk_cluster + ext->length - 1;
+    delta -= ext->length - 1;
+    while (delta-- > 0 && cluster < FS_CLUSTER_EOF) {
+        cluster = fs_get_next_cluster(cluster);
+    }
+    return cluster;
+}
+
+// Acrescenta 'cluster' ao fim do mapa de extents (cadeia estendida por
+// uma escrita). Um mapa já parcial continua sendo completado pela FAT
+static void fs_extent_append(file_handle_t* handle, uint32_t cluster) {
+    if (!handle->extents_complete) return;
+    
+    fs_extent_t* last = handle->extent_count ? 
+                        &handle->extents[handle->extent_count - 1] : 0;
+    
+    if (last && last->disk_cluster + last->length == cluster) {
+        last->length++;
+    } else if (handle->extent_count < FS_MAX_EXTENTS) {
+        fs_extent_t* ext = &handle->extents[handle->extent_count++];
+        ext->file_cluster = last ? last->file_cluster + last->length : 0;
+        ext->disk_cluster = cluster;
+        ext->length = 1;
+    } else {
+        handle->extents_complete = 0;
+    }
+}
+
+// Último cluster da cadeia do arquivo (0 se vazio)
+static uint32_t fs_last_cluster(file_handle_t* handle) {
+    if (handle->extent_count == 0) return 0;
+    
+    fs_extent_t* last = &handle->extents[handle->extent_count - 1];
+    uint32_t cluster = last->disk_cluster + last->length - 1;
+    
+    if (!handle->extents_complete) {
+        uint32_t next;
+        while ((next = fs_get_next_cluster(cluster)) >= 2 && next < FS_CLUSTER_EOF) {
+            cluster = next;
+        }
+    }
+    return cluster;
+}
+
+// Abre um arquivo (por caminho) para leitura e escrita
+int fs_open(const char* path, file_handle_t* handle) {
+    if (!fs_initialized || !path || !handle) return -1;
+    
+    uint32_t parent;
+    fs_dentry_t found;
+    
+    if (fs_resolve(path, &parent, &found) != 0 ||
+        (found.entry.attributes & (FAT_ATTR_VOLUME_LABEL | FAT_ATTR_DIRECTORY))) {
+        return -1; // Arquivo não encontrado
+    }
+    
+    // Inicializa o handle
+    memory_copy(handle->filename, found.entry.filename, 11);
+    handle->filename[11] = '\0';
+    handle->size = found.entry.file_size;
+    handle->first_cluster = fs_entry_cluster(&found.entry);
+    handle->current_cluster = handle->first_cluster;
+    handle->dir_lba = found.dir_lba;
+    handle->dir_index = found.dir_index;
+    handle->dirty = 0;
+    handle->position = 0;
+    handle->ra_expected = 0;
+    handle->ra_window = FS_RA_MIN_SECTORS;
+    handle->ra_end = 0;
+    handle->is_open = 1;
+    
+    fs_build_extents(handle, handle->current_cluster);
+    
+    return 0;
+}
+
+// Read-ahead: quando resta menos de meia janela antecipada à frente da
+// posição atual, antecipa até 'posição + janela' seguindo a cadeia de
+// clusters e agrupando clusters consecutivos em uma única requisição
+static void fs_readahead(file_handle_t* handle) {
+    uint32_t window_bytes = handle->ra_window * FAT12_SECTOR_SIZE;
+    uint32_t target = handle->position + window_bytes;
+    
+    if (target > handle->size) target = handle->size;
+    if (handle->ra_end < handle->position) handle->ra_end = handle->position;
+    if (handle->ra_end >= target || 
+        handle->ra_end - handle->position >= window_bytes / 2) {
+        return;
+    }
+    
+    // Localiza o cluster onde o trecho começa
+    uint32_t offset = handle->ra_end & ~(FAT12_SECTOR_SIZE - 1);
+    uint32_t cluster = handle->current_cluster;
+    uint32_t skip = offset / fs_state.bytes_per_cluster - 
+                    handle->position / fs_state.bytes_per_cluster;
+    
+    while (skip-- > 0 && cluster < FS_CLUSTER_EOF) {
+        cluster = fs_get_next_cluster(cluster);
+    }
+    
+    uint32_t run_lba = 0;
+    uint32_t run_len = 0;
+    
+    while (offset < target && cluster >= 2 && cluster < FS_CLUSTER_EOF) {
+        uint32_t in_cluster = offset % fs_state.bytes_per_cluster;
+        uint32_t lba = fs_cluster_to_lba(cluster) + in_cluster / FAT12_SECTOR_SIZE;
+        uint32_t sectors = (fs_state.bytes_per_cluster - in_cluster) / FAT12_SECTOR_SIZE;
+        uint32_t remaining = (target - offset + FAT12_SECTOR_SIZE - 1) / FAT12_SECTOR_SIZE;
+        
+        if (sectors > remaining) sectors = remaining;
+        
+        if (run_len > 0 && run_lba + run_len == lba) {
+            run_len += sectors;
+        } else {
+            if (run_len > 0) bcache_prefetch(fs_state.dev->index, run_lba, run_len);
+            run_lba = lba;
+            run_len = sectors;
+        }
+        
+        offset += sectors * FAT12_SECTOR_SIZE;
+        cluster = fs_get_next_cluster(cluster);
+    }
+    
+    if (run_len > 0) bcache_prefetch(fs_state.dev->index, run_lba, run_len);
+    
+    handle->ra_end = offset < target ? offset : target;
+    
+    // Acesso sequencial confirmado: a próxima janela é maior
+    if (handle->ra_window < FS_RA_MAX_SECTORS) {
+        handle->ra_window *= 2;
+    }
+}
+
+// Leitura direta: setores inteiros do arquivo vão do dispositivo para o
+// buffer do chamador, uma requisição por trecho de clusters consecutivos,
+// sem passar pelo cache. Retorna os bytes lidos (0 se não há um setor
+// inteiro a ler) ou -1 em erro
+static int fs_read_direct(file_handle_t* handle, uint8_t* dst, uint32_t max_bytes) {
+    uint32_t remaining = handle->size - handle->position;
+    uint32_t sectors = (max_bytes < remaining ? max_bytes : remaining) / FAT12_SECTOR_SIZE;
+    
+    if (sectors > FS_DIRECT_MAX_SECTORS) sectors = FS_DIRECT_MAX_SECTORS;
+    if (sectors == 0) return 0;
+    
+    // Trecho contíguo a partir da posição atual
+    uint32_t cluster = handle->current_cluster;
+    uint32_t cluster_offset = handle->position % fs_state.bytes_per_cluster;
+    uint32_t lba = fs_cluster_to_lba(cluster) + cluster_offset / FAT12_SECTOR_SIZE;
+    uint32_t run = (fs_state.bytes_per_cluster - cluster_offset) / FAT12_SECTOR_SIZE;
+    
+    while (run < sectors) {
+        uint32_t next = fs_get_next_cluster(cluster);
+        if (next != cluster + 1) break;
+        cluster = next;
+        run += fs_state.sectors_per_cluster;
+    }
+    if (run > sectors) run = sectors;
+    
+    // Blocos modificados no cache precisam chegar ao disco antes
+    if (bcache_writeback_range(fs_state.dev->index, lba, run) != 0) return -1;
+    if (blockdev_read(fs_state.dev, lba, run, dst) != 0) return -1;
+    
+    // Avança a posição e o cluster atual pelas fronteiras cruzadas
+    uint32_t bytes = run * FAT12_SECTOR_SIZE;
+    uint32_t crossed = (cluster_offset + bytes) / fs_state.bytes_per_cluster;
+    
+    while (crossed-- > 0) {
+        handle->current_cluster = fs_get_next_cluster(handle->current_cluster);
+    }
+    handle->position += bytes;
+    handle->ra_end = handle->position;
+    
+    return bytes;
+}
+
+// Lê dados de um arquivo
+int fs_read(file_handle_t* handle, void* buffer, uint32_t size) {
+    if (!fs_initialized || !handle || !handle->is_open || !buffer) return -1;
+    
+    uint32_t bytes_read = 0;
+    uint8_t* buf = (uint8_t*)buffer;
+    
+    // Leitura fora de sequência: volta à janela mínima
+    if (handle->position != handle->ra_expected) {
+        handle->ra_window = FS_RA_MIN_SECTORS;
+        handle->ra_end = handle->position;
+    }
+    
+    while (bytes_read < size && handle->position < handle->size && 
+           handle->current_cluster < FS_CLUSTER_EOF) {
+        
+        // Offset em setor inteiro e buffer alinhado: lê direto no buffer do
+        // chamador (zero cópia) em vez de passar pelo cache
+        if ((handle->position % FAT12_SECTOR_SIZE) == 0 &&
+            ((uint32_t)(buf + bytes_read) % FS_DIRECT_ALIGN) == 0 &&
+            size - bytes_read >= FAT12_SECTOR_SIZE) {
+            int direct = fs_read_direct(handle, buf + bytes_read, size - bytes_read);
+            
+            if (direct < 0) return -1;
+            if (direct > 0) {
+                bytes_read += direct;
+                continue;
+            }
+        }
+        
+        fs_readahead(handle);
+        
+        // Calcula o setor da posição atual dentro do cluster
+        uint32_t cluster_offset = handle->position % fs_state.bytes_per_cluster;
+        uint32_t sector = fs_cluster_to_lba(handle->current_cluster) + 
+                          cluster_offset / FAT12_SECTOR_SIZE;
+        
+        // Lê o setor (via cache de blocos)
+        bcache_buf_t* cached = bcache_read(fs_state.dev->index, sector);
+        if (!cached) {
+            return -1;
+        }
+        
+        // Calcula quantos bytes copiar
+        uint32_t sector_offset = handle->position % FAT12_SECTOR_SIZE;
+        uint32_t bytes_to_copy = FAT12_SECTOR_SIZE - sector_offset;
+        
+        if (bytes_to_copy > size - bytes_read) {
+            bytes_to_copy = size - bytes_read;
+        }
+        
+        if (handle->position + bytes_to_copy > handle->size) {
+            bytes_to_copy = handle->size - handle->position;
+        }
+        
+        // Copia dados
+        memory_copy(buf + bytes_read, cached->data + sector_offset, bytes_to_copy);
+        bcache_release(cached);
+        
+        bytes_read += bytes_to_copy;
+        handle->position += bytes_to_copy;
+        
+        // Se chegou ao fim do cluster, vai para o próximo
+        if ((handle->position % fs_state.bytes_per_cluster) == 0) {
+            handle->current_cluster = fs_get_next_cluster(handle->current_cluster);
+        }
+    }
+    
+    handle->ra_expected = handle->position;
+    return bytes_read;
+}
+
+// Posiciona o handle em 'offset' sem percorrer a cadeia de clusters.
+// A próxima leitura reinicia o read-ahead por não ser sequencial
+int fs_seek(file_handle_t* handle, uint32_t offset) {
+    if (!fs_initialized || !handle || !handle->is_open) return -1;
+    if (offset > handle->size) return -1;
+    
+    handle->current_cluster = fs_extent_lookup(handle, offset / fs_state.bytes_per_cluster);
+    handle->position = offset;
+    return 0;
+}
+
+// Lê a partir de 'offset' sem alterar a posição corrente do handle
+int fs_pread(file_handle_t* handle, void* buffer, uint32_t size, uint32_t offset) {
+    if (!fs_initialized || !handle || !handle->is_open) return -1;
+    
+    uint32_t saved_position = handle->position;
+    uint32_t saved_cluster = handle->current_cluster;
+    
+    if (fs_seek(handle, offset) != 0) return -1;
+    
+    int n = fs_read(handle, buffer, size);
+    
+    handle->position = saved_position;
+    handle->current_cluster = saved_cluster;
+    return n;
+}
+
+// ============================================================================
+// ESCRITA
+// ============================================================================
+
+// Escrita direta: setores inteiros vão do buffer do chamador para o
+// dispositivo, uma requisição por trecho de clusters consecutivos,
+// estendendo a cadeia conforme necessário. As cópias do trecho que estiverem
+// no cache recebem os dados novos. Retorna os bytes gravados ou -1 em erro
+static int fs_write_direct(file_handle_t* handle, const uint8_t* src, uint32_t max_bytes) {
+    uint32_t sectors = max_bytes / FAT12_SECTOR_SIZE;
+    
+    if (sectors > FS_DIRECT_MAX_SECTORS) sectors = FS_DIRECT_MAX_SECTORS;
+    if (sectors == 0) return 0;
+    
+    // Trecho contíguo a partir da posição atual
+    uint32_t cluster = handle->current_cluster;
+    uint32_t cluster_offset = handle->position % fs_state.bytes_per_cluster;
+    uint32_t lba = fs_cluster_to_lba(cluster) + cluster_offset / FAT12_SECTOR_SIZE;
+    uint32_t run = (fs_state.bytes_per_cluster - cluster_offset) / FAT12_SECTOR_SIZE;
+    
+    while (run < sectors) {
+        uint32_t next = fs_get_next_cluster(cluster);
+        
+        if (next < 2 || next >= FS_CLUSTER_EOF) {
+            next = fs_alloc_cluster(cluster);
+            if (next == 0) break; // Volume cheio: grava o que couber
+            fs_extent_append(handle, next);
+        }
+        if (next != cluster + 1) break;
+        cluster = next;
+        run += fs_state.sectors_per_cluster;
+    }
+    if (run > sectors) run = sectors;
+    
+    if (blockdev_write(fs_state.dev, lba, run, src) != 0) return -1;
+    bcache_update_range(fs_state.dev->index, lba, run, src);
+    
+    // Avança a posição e o cluster atual pelas fronteiras cruzadas
+    uint32_t bytes = run * FAT12_SECTOR_SIZE;
+    uint32_t crossed = (cluster_offset + bytes) / fs_state.bytes_per_cluster;
+    
+    while (crossed-- > 0) {
+        handle->current_cluster = fs_get_next_cluster(handle->current_cluster);
+    }
+    handle->position += bytes;
+    if (handle->position > handle->size) handle->size = handle->position;
+    
+    return bytes;
+}
+
+// Escreve dados na posição atual, estendendo o arquivo se preciso. Dados e
+// metadados ficam no cache de blocos; a entrada do diretório é gravada no
+// fs_close. Retorna os bytes gravados (menos que 'size' com o volume cheio)
+int fs_write(file_handle_t* handle, const void* buffer, uint32_t size) {
+    if (!fs_initialized || !handle || !handle->is_open || !buffer) return -1;
+    
+    const uint8_t* src = (const uint8_t*)buffer;
+    uint8_t dev = fs_state.dev->index;
+    uint32_t written = 0;
+    
+    while (written < size) {
+        // Posição além do último cluster: estende a cadeia
+        if (handle->current_cluster < 2 || handle->current_cluster >= FS_CLUSTER_EOF) {
+            uint32_t tail = fs_last_cluster(handle);
+            uint32_t cluster = fs_alloc_cluster(tail);
+            
+            if (cluster == 0) break; // Volume cheio
+            if (tail == 0) handle->first_cluster = cluster;
+            fs_extent_append(handle, cluster);
+            handle->current_cluster = cluster;
+        }
+        handle->dirty = 1;
+        
+        // Offset em setor inteiro e buffer alinhado: grava direto do buffer
+        // do chamador em vez de passar pelo cache
+        if ((handle->position % FAT12_SECTOR_SIZE) == 0 &&
+            ((uint32_t)(src + written) % FS_DIRECT_ALIGN) == 0 &&
+            size - written >= FAT12_SECTOR_SIZE) {
+            int direct = fs_write_direct(handle, src + written, size - written);
+            
+            if (direct < 0) return -1;
+            if (direct > 0) {
+                written += direct;
+                continue;
+            }
+        }
+        
+        uint32_t cluster_offset = handle->position % fs_state.bytes_per_cluster;
+        uint32_t sector = fs_cluster_to_lba(handle->current_cluster) + 
+                          cluster_offset / FAT12_SECTOR_SIZE;
+        uint32_t sector_offset = handle->position % FAT12_SECTOR_SIZE;
+        uint32_t bytes_to_copy = FAT12_SECTOR_SIZE - sector_offset;
+        
+        if (bytes_to_copy > size - written) {
+            bytes_to_copy = size - written;
+        }
+        
+        // Setor sobrescrito inteiro ou além do fim do arquivo: não precisa
+        // ser lido do disco
+        int fresh = sector_offset == 0 && 
+                    (bytes_to_copy == FAT12_SECTOR_SIZE || handle->position >= handle->size);
+        bcache_buf_t* cached = fresh ? bcache_get(dev, sector) : bcache_read(dev, sector);
+        
+        if (!cached) return -1;
+        
+        if (fresh && bytes_to_copy < FAT12_SECTOR_SIZE) {
+            memory_set(cached->data + bytes_to_copy, 0, FAT12_SECTOR_SIZE - bytes_to_copy);
+        }
+        memory_copy(cached->data + sector_offset, src + written, bytes_to_copy);
+        bcache_mark_dirty(cached);
+        bcache_release(cached);
+        
+        written += bytes_to_copy;
+        handle->position += bytes_to_copy;
+        if (handle->position > handle->size) handle->size = handle->position;
+        
+        // Se chegou ao fim do cluster, vai para o próximo (ou para EOF)
+        if ((handle->position % fs_state.bytes_per_cluster) == 0) {
+            handle->current_cluster = fs_get_next_cluster(handle->current_cluster);
+        }
+    }
+    
+    return written;
+}
+
+// Grava tamanho e cluster inicial do handle na entrada do diretório
+static int fs_dir_update(file_handle_t* handle) {
+    bcache_buf_t* buf = bcache_read(fs_state.dev->index, handle->dir_lba);
+    if (!buf) return -1;
+    
+    fat12_dir_entry_t* entry = &((fat12_dir_entry_t*)buf->data)[handle->dir_index];
+    
+    entry->file_size = handle->size;
+    entry->first_cluster_low = handle->first_cluster & 0xFFFF;
+    if (fs_state.fat_type == 32) {
+        entry->first_cluster_high = handle->first_cluster >> 16;
+    }
+    
+    bcache_mark_dirty(buf);
+    fs_dcache_update(entry, handle->dir_lba, handle->dir_index);
+    fs_pcache_update(entry, handle->dir_lba, handle->dir_index);
+    bcache_release(buf);
+    return 0;
+}
+
+// Procura uma entrada livre no diretório 'dir_cluster' (0 = raiz). Um
+// diretório em cadeia de clusters cheio ganha um cluster zerado; a raiz
+// do FAT12/16 tem tamanho fixo
+static int fs_dir_alloc_slot(uint32_t dir_cluster, uint32_t* slot_lba, uint16_t* slot_index) {
+    uint32_t entries_per_sector = FAT12_SECTOR_SIZE / sizeof(fat12_dir_entry_t);
+    uint8_t dev = fs_state.dev->index;
+    fs_dir_cursor_t cursor;
+    uint32_t last_cluster = 0;
+    uint32_t lba;
+    
+    fs_dir_begin(&cursor, dir_cluster);
+    while ((lba = fs_dir_next(&cursor)) != 0) {
+        bcache_buf_t* buf = bcache_read(dev, lba);
+        if (!buf) return -1;
+        
+        fat12_dir_entry_t* entries = (fat12_dir_entry_t*)buf->data;
+        
+        last_cluster = cursor.cluster;
+        for (uint32_t i = 0; i < entries_per_sector; i++) {
+            if (fs_dir_entry_unused(&entries[i])) {
+                *slot_lba = lba;
+                *slot_index = i;
+                bcache_release(buf);
+                return 0;
+            }
+        }
+        
+        bcache_release(buf);
+    }
+    
+    if (cursor.fixed) return -1; // Raiz fixa cheia
+    
+    uint32_t cluster = fs_alloc_cluster(last_cluster);
+    if (cluster == 0) return -1;
+    
+    // Entradas zeradas marcam o fim do diretório
+    lba = fs_cluster_to_lba(cluster);
+    for (uint32_t i = 0; i < fs_state.sectors_per_cluster; i++) {
+        bcache_buf_t* buf = bcache_get(dev, lba + i);
+        if (!buf) return -1;
+        
+        memory_set(buf->data, 0, FAT12_SECTOR_SIZE);
+        bcache_mark_dirty(buf);
+        bcache_release(buf);
+    }
+    
+    *slot_lba = lba;
+    *slot_index = 0;
+    return 0;
+}
+
+// Marca como apagada a entrada em (lba, index) e as partes de nome longo
+// logo antes dela, que podem estar em setores ou clusters anteriores
+static int fs_dir_erase(uint32_t dir_cluster, uint32_t lba, uint16_t index) {
+    uint32_t entries_per_sector = FAT12_SECTOR_SIZE / sizeof(fat12_dir_entry_t);
+    uint8_t dev = fs_state.dev->index;
+    uint32_t lfn_lba[FAT_LFN_MAX_ENTRIES];
+    uint16_t lfn_index[FAT_LFN_MAX_ENTRIES];
+    uint32_t lfn_count = 0;
+    fs_dir_cursor_t cursor;
+    uint32_t sector;
+    
+    fs_dir_begin(&cursor, dir_cluster);
+    while ((sector = fs_dir_next(&cursor)) != 0) {
+        bcache_buf_t* buf = bcache_read(dev, sector);
+        if (!buf) return -1;
+        
+        fat12_dir_entry_t* entries = (fat12_dir_entry_t*)buf->data;
+        
+        for (uint32_t i = 0; i < entries_per_sector; i++) {
+            if (sector == lba && i == index) {
+                entries[i].filename[0] = 0xE5;
+                bcache_mark_dirty(buf);
+                bcache_release(buf);
+                
+                for (uint32_t k = 0; k < lfn_count; k++) {
+                    bcache_buf_t* part = bcache_read(dev, lfn_lba[k]);
+                    if (!part) return -1;
+                    
+                    ((fat12_dir_entry_t*)part->data)[lfn_index[k]].filename[0] = 0xE5;
+                    bcache_mark_dirty(part);
+                    bcache_release(part);
+                }
+                return 0;
+            }
+            
+            if (entries[i].filename[0] == 0x00) break;
+            
+            if (entries[i].filename[0] != 0xE5 && entries[i].attributes == FAT_ATTR_LFN) {
+                if (lfn_count == FAT_LFN_MAX_ENTRIES) lfn_count = 0; // Partes órfãs
+                lfn_lba[lfn_count] = sector;
+                lfn_index[lfn_count] = i;
+                lfn_count++;
+            } else {
+                lfn_count = 0;
+            }
+        }
+        
+        bcache_release(buf);
+    }
+    
+    return -1;
+}
+
+// Cria um arquivo vazio (substituindo um existente de mesmo nome) e o abre
+// em 'handle'. Os diretórios do caminho precisam existir e o último
+// componente precisa caber em 8.3: nomes longos não são gerados
+int fs_create(const char* path, file_handle_t* handle) {
+    if (!fs_initialized || !path || !handle) return -1;
+    
+    char last[FS_LFN_MAX + 1];
+    char packed[12];
+    uint32_t parent;
+    fs_dentry_t found;
+    
+    if (fs_walk(path, &parent, last) != 0 || !fs_is_short_name(last)) return -1;
+    str_to_fat_format(last, packed);
+    
+    if (fs_lookup_in(parent, last, &found) == 0) {
+        if (found.entry.attributes & (FAT_ATTR_VOLUME_LABEL | FAT_ATTR_DIRECTORY)) {
+            return -1;
+        }
+        if (fs_delete(path) != 0) return -1;
+    }
+    
+    if (fs_dir_alloc_slot(parent, &found.dir_lba, &found.dir_index) != 0) {
+        fs_fat_flush();
+        return -1;
+    }
+    
+    bcache_buf_t* buf = bcache_read(fs_state.dev->index, found.dir_lba);
+    if (!buf) return -1;
+    
+    fat12_dir_entry_t* entry = &((fat12_dir_entry_t*)buf->data)[found.dir_index];
+    
+    memory_set(entry, 0, sizeof(*entry));
+    memory_copy(entry->filename, packed, 11);
+    entry->attributes = FAT_ATTR_ARCHIVE;
+    found.entry = *entry;
+    found.long_name[0] = '\0';
+    
+    bcache_mark_dirty(buf);
+    bcache_release(buf);
+    
+    if (parent == 0) fs_dcache_add(&found);
+    fs_pcache_invalidate();
+    fs_fat_flush();
+    
+    return fs_open(path, handle);
+}
+
+// Apaga um arquivo (por caminho) e libera seus clusters
+int fs_delete(const char* path) {
+    if (!fs_initialized || !path) return -1;
+    
+    uint32_t parent;
+    fs_dentry_t found;
+    
+    if (fs_resolve(path, &parent, &found) != 0 ||
+        (found.entry.attributes & (FAT_ATTR_VOLUME_LABEL | FAT_ATTR_DIRECTORY))) {
+        return -1;
+    }
+    
+    if (fs_dir_erase(parent, found.dir_lba, found.dir_index) != 0) return -1;
+    
+    if (parent == 0) fs_dcache_remove((const char*)found.entry.filename);
+    fs_pcache_invalidate();
+    fs_free_chain(fs_entry_cluster(&found.entry));
+    return fs_fat_flush();
+}
+
+// Se houve escrita, grava a entrada do diretório e espelha as alterações
+// da FAT nas demais cópias. O handle continua aberto
+int fs_flush(file_handle_t* handle) {
+    if (!handle || !handle->is_open || !handle->dirty) return 0;
+    
+    int result = 0;
+    
+    if (fs_dir_update(handle) != 0) result = -1;
+    if (fs_fat_flush() != 0) result = -1;
+    handle->dirty = 0;
+    return result;
+}
+
+// Fecha um arquivo (gravando metadados pendentes)
+int fs_close(file_handle_t* handle) {
+    if (!handle) return -1;
+    
+    int result = fs_flush(handle);
+    
+    handle->is_open = 0;
+    return result;
+}
+
+// ============================================================================
+// LISTAGEM
+// ============================================================================
+
+// Mostra uma linha da listagem: nome (longo, se houver), tamanho e
+// marcador de diretório
+static void fs_print_dir_entry(const fat12_dir_entry_t* entry, const char* long_name) {
+    char short_name[13];
+    
+    fs_short_name(entry, short_name);
+    
+    const char* name = long_name[0] ? long_name : short_name;
+    terminal_print(name);
+    
+    // Preenche com espaços (nomes longos ganham ao menos um)
+    int name_len = strlen(name);
+    for (int j = name_len; j < 14; j++) {
+        terminal_print(" ");
+    }
+    if (name_len >= 14) terminal_print(" ");
+    
+    // Mostra tamanho
+    char size_str[16];
+    uint_to_str(entry->file_size, size_str, sizeof(size_str));
+    terminal_print(size_str);
+    terminal_print(" bytes");
+    
+    if (entry->attributes & FAT_ATTR_DIRECTORY) {
+        terminal_print(" <DIR>");
+    }
+    
+    terminal_print("\n");
+}
+
+static int fs_list_entry(const fat12_dir_entry_t* entry, const char* long_name,
+                         uint32_t lba, uint16_t index, void* ctx) {
+    (void)lba;
+    (void)index;
+    
+    fs_print_dir_entry(entry, long_name);
+    (*(uint32_t*)ctx)++;
+    return 0;
+}
+
+// Mostra o rodapé da listagem
+static void fs_print_list_total(uint32_t count) {
+    char count_str[16];
+    uint_to_str(count, count_str, sizeof(count_str));
+    terminal_print("\nTotal: ");
+    terminal_print(count_str);
+    terminal_print(" arquivo(s)\n");
+}
+
+// Lista um diretório. A raiz ("" ou "/") vem do cache de diretório; os
+// subdiretórios são lidos pelo cache de blocos
+int fs_list_directory(const char* path) {
+    if (!fs_initialized) return -1;
+    
+    while (path && *path == '/') path++;
+    
+    if (path && *path) {
+        uint32_t parent;
+        uint32_t count = 0;
+        fs_dentry_t found;
+        
+        if (fs_resolve(path, &parent, &found) != 0 ||
+            !(found.entry.attributes & FAT_ATTR_DIRECTORY)) {
+            return -1;
+        }
+        
+        uint32_t dir = fs_entry_cluster(&found.entry);
+        if (dir == fs_state.root_cluster) dir = 0;
+        
+        terminal_print("\nArquivos em /");
+        terminal_print(path);
+        terminal_print(":\n");
+        terminal_print("Nome           Tamanho\n");
+        terminal_print("------------------------\n");
+        
+        if (fs_dir_iterate(dir, fs_list_entry, &count) < 0) {
+            terminal_print("Erro de leitura.\n");
+        }
+        fs_print_list_total(count);
+        return count;
+    }
+    
+    if (dcache_state == 0) fs_dcache_load();
+    
+    terminal_print("\nArquivos no diretorio raiz:\n");
+    terminal_print("Nome           Tamanho\n");
+    terminal_print("------------------------\n");
+    
+    for (uint32_t i = 0; i < dcache_count; i++) {
+        fs_print_dir_entry(&dcache_entries[i].entry, dcache_entries[i].long_name);
+    }
+    
+    fs_print_list_total(dcache_count);
+    
+    // Diretório maior que o cache: só as primeiras entradas foram listadas
+    if (dcache_state < 0) {
+        terminal_print("(listagem parcial)\n");
+    }
+    
+    return dcache_count;
+}
+
+// ============================================================================
+// UTILITÁRIOS
+// ============================================================================
+
+// Mostra informações do boot sector
+void fs_print_boot_info(void) {
+    if (!fs_initialized) {
+        terminal_print("Sistema de arquivos nao inicializado.\n");
+        return;
+    }
+    
+    terminal_print("\nInformacoes do sistema de arquivos:\n");
+    terminal_print("Dispositivo: ");
+    terminal_print(fs_state.dev->name);
+    terminal_print("\n");
+    
+    terminal_print("Tipo: FAT");
+    terminal_print_dec(fs_state.fat_type);
+    terminal_print("\n");
+    
+    char buffer[32];
+    
+    terminal_print("Bytes por setor: ");
+    uint_to_str(fs_state.boot_sector.bytes_per_sector, buffer, sizeof(buffer));
     terminal_print(buffer);
     terminal_print("\n");
-}
\ No newline at end of file
+    
+    terminal_print("Setores por cluster: ");
+    uint_to_str(fs_state.boot_sector.sectors_per_cluster, buffer, sizeof(buffer));
+    terminal_print(buffer);
+    terminal_print("\n");
+    
+    terminal_print("Numero de FATs: ");
+    uint_to_str(fs_state.boot_sector.fat_count, buffer, sizeof(buffer));
+    terminal_print(buffer);
+    terminal_print("\n");
+    
+    if (fs_state.fat_type == 32) {
+        terminal_print("Cluster do diretorio raiz: ");
+        terminal_print_dec(fs_state.root_cluster);
+        terminal_print("\n");
+    } else {
+        terminal_print("Entradas do diretorio raiz: ");
+        uint_to_str(fs_state.boot_sector.root_entries, buffer, sizeof(buffer));
+        terminal_print(buffer);
+        terminal_print("\n");
+    }
+    
+    terminal_print("Setores por FAT: ");
+    uint_to_str(fs_state.fat_sectors, buffer, sizeof(buffer));
+    terminal_print(buffer);
+    terminal_print("\n");
+    
+    // Sem dica válida do FSInfo (ou FAT16), conta agora e guarda o resultado
+    if (fs_state.free_clusters == FS_FREE_UNKNOWN) {
+        fs_state.free_clusters = fs_count_free_clusters();
+    }
+    
+    terminal_print("Clusters livres: ");
+    terminal_print_dec(fs_state.free_clusters);
+    terminal_print(" de ");
+    terminal_print_dec(fs_state.cluster_count - 2);
+    terminal_print("\n");
+}
+
+// ============================================================================
+// BENCHMARK DE LEITURA DE ARQUIVO
+// ============================================================================
+
+// Lê o arquivo inteiro repetidamente por FS_BENCH_TICKS em pedaços de
+// 'chunk' bytes a partir de 'buffer' e mostra a vazão
+static void fs_bench_run(const char* label, const char* filename, uint8_t* buffer, uint32_t chunk) {
+    file_handle_t handle;
+    uint32_t total = 0;
+    uint32_t passes = 0;
+    int n = 0;
+    
+    uint32_t start = timer_ticks;
+    while (timer_ticks - start < FS_BENCH_TICKS) {
+        if (fs_open(filename, &handle) != 0) return;
+        
+        while ((n = fs_read(&handle, buffer, chunk)) > 0) {
+            total += n;
+        }
+        fs_close(&handle);
+        
+        if (n < 0) {
+            terminal_print(label);
+            terminal_print("erro de leitura\n");
+            return;
+        }
+        passes++;
+    }
+    uint32_t elapsed = timer_ticks - start;
+    
+    terminal_print(label);
+    terminal_print_dec(elapsed ? (total / 1024) * TIMER_FREQUENCY / elapsed : 0);
+    terminal_print(" KB/s (");
+    terminal_print_dec(passes);
+    terminal_print(" leituras completas)\n");
+}
+
+// Leituras de FS_BENCH_PREAD_SIZE bytes em offsets pseudoaleatórios por
+// FS_BENCH_TICKS; com o mapa de extents o custo não depende do tamanho
+static void fs_bench_random(const char* label, const char* filename) {
+    file_handle_t handle;
+    uint32_t ops = 0;
+    uint32_t seed = 12345;
+    
+    if (fs_open(filename, &handle) != 0) return;
+    
+    uint32_t span = handle.size > FS_BENCH_PREAD_SIZE ? 
+                    handle.size - FS_BENCH_PREAD_SIZE : 1;
+    
+    uint32_t start = timer_ticks;
+    while (timer_ticks - start < FS_BENCH_TICKS) {
+        seed = seed * 1103515245 + 12345;
+        uint32_t offset = (seed >> 8) % span;
+        
+        if (fs_pread(&handle, fs_bench_buffer, FS_BENCH_PREAD_SIZE, offset) < 0) {
+            terminal_print(label);
+            terminal_print("erro de leitura\n");
+            fs_close(&handle);
+            return;
+        }
+        ops++;
+    }
+    uint32_t elapsed = timer_ticks - start;
+    
+    terminal_print(label);
+    terminal_print_dec(elapsed ? ops * TIMER_FREQUENCY / elapsed : 0);
+    terminal_print(" leituras/s (");
+    terminal_print_dec(handle.extent_count);
+    terminal_print(handle.extents_complete ? " extents)\n" : "+ extents)\n");
+    fs_close(&handle);
+}
+
+// Comando: fsbench ARQ - vazão de leitura de um arquivo grande
+void cmd_fsbench(const char* filename) {
+    fat12_dir_entry_t entry;
+    
+    if (!fs_initialized || fs_find_file(filename, &entry) != 0) {
+        terminal_print("\nArquivo nao encontrado: ");
+        terminal_print(filename);
+        terminal_print("\n");
+        return;
+    }
+    
+    terminal_print("\nLeitura de ");
+    terminal_print(filename);
+    terminal_print(" (");
+    terminal_print_dec(entry.file_size / 1024);
+    terminal_print(" KB) em ");
+    terminal_print(fs_state.dev->name);
+    terminal_print(", 1 segundo por modo\n");
+    
+    fs_bench_run("  256 B via cache:           ", filename,
+                 fs_bench_buffer, FS_BENCH_SMALL_READ);
+    fs_bench_run("  64 KB via cache (copia):   ", filename,
+                 fs_bench_buffer + 1, FS_BENCH_LARGE_READ);
+    fs_bench_run("  64 KB direto (zero copia): ", filename,
+                 fs_bench_buffer, FS_BENCH_LARGE_READ);
+    fs_bench_random("  512 B aleatorio (pread):   ", filename);
+}
+
+// ============================================================================
+// BENCHMARK DE ESCRITA
+// ============================================================================
+
+// Nome do n-ésimo arquivo do benchmark: BNCHnnn.TMP
+static void fs_bench_name(char* name, uint32_t n) {
+    memory_copy(name, "BNCH000.TMP", 12);
+    name[4] = '0' + (n / 100) % 10;
+    name[5] = '0' + (n / 10) % 10;
+    name[6] = '0' + n % 10;
+}
+
+// Mostra a duração de uma fase em ms (resolução de um tick)
+static void fs_bench_print_ms(uint32_t elapsed) {
+    terminal_print(" (");
+    terminal_print_dec(elapsed * (1000 / TIMER_FREQUENCY));
+    terminal_print(" ms)\n");
+}
+
+// Comando: fswbench - cria muitos arquivos pequenos e um grande, incluindo
+// o sync final no tempo medido, e apaga tudo no fim
+void cmd_fswbench(void) {
+    file_handle_t handle;
+    char name[12];
+    
+    if (!fs_initialized) {
+        terminal_print("\nSistema de arquivos nao montado.\n");
+        return;
+    }
+    
+    for (uint32_t i = 0; i < FS_BENCH_LARGE_READ; i++) {
+        fs_bench_buffer[i] = (uint8_t)i;
+    }
+    
+    terminal_print("\nEscrita em ");
+    terminal_print(fs_state.dev->name);
+    terminal_print(" (FAT");
+    terminal_print_dec(fs_state.fat_type);
+    terminal_print(")\n");
+    
+    // Muitos arquivos pequenos: custo dominado por diretório e FAT
+    uint32_t files = 0;
+    uint32_t start = timer_ticks;
+    
+    for (uint32_t i = 0; i < FS_BENCH_SMALL_FILES; i++) {
+        fs_bench_name(name, i);
+        if (fs_create(name, &handle) != 0) break;
+        
+        int n = fs_write(&handle, fs_bench_buffer, FS_BENCH_SMALL_SIZE);
+        fs_close(&handle);
+        if (n != FS_BENCH_SMALL_SIZE) break;
+        files++;
+    }
+    bcache_sync();
+    
+    uint32_t elapsed = timer_ticks - start;
+    if (elapsed == 0) elapsed = 1;
+    
+    terminal_print("  Arquivos de 1 KB: ");
+    terminal_print_dec(files);
+    terminal_print(" criados, ");
+    terminal_print_dec(files * TIMER_FREQUENCY / elapsed);
+    terminal_print(" arquivos/s");
+    fs_bench_print_ms(elapsed);
+    
+    // Um arquivo grande em pedaços de 64 KB (caminho direto)
+    uint32_t total = 0;
+    start = timer_ticks;
+    
+    if (fs_create("BNCHBIG.TMP", &handle) == 0) {
+        while (total < FS_BENCH_LARGE_FILE) {
+            int n = fs_write(&handle, fs_bench_buffer, FS_BENCH_LARGE_READ);
+            if (n <= 0) break;
+            total += n;
+        }
+        fs_close(&handle);
+    }
+    bcache_sync();
+    
+    elapsed = timer_ticks - start;
+    if (elapsed == 0) elapsed = 1;
+    
+    terminal_print("  Arquivo grande:   ");
+    terminal_print_dec(total / 1024);
+    terminal_print(" KB, ");
+    terminal_print_dec((total / 1024) * TIMER_FREQUENCY / elapsed);
+    terminal_print(" KB/s");
+    fs_bench_print_ms(elapsed);
+    
+    // Limpeza
+    for (uint32_t i = 0; i < files; i++) {
+        fs_bench_name(name, i);
+        fs_delete(name);
+    }
+    fs_delete("BNCHBIG.TMP");
+    bcache_sync();
+}
+
+// ============================================================================
+// BENCHMARK DA FAT
+// ============================================================================
+
+// Percorre a cadeia de 'first' repetidamente por FS_BENCH_TICKS e mostra
+// quantos passos por segundo a função 'next' consegue
+static void fs_bench_chain(const char* label, uint32_t first, uint32_t (*next)(uint32_t)) {
+    uint32_t steps = 0;
+    
+    uint32_t start = timer_ticks;
+    while (timer_ticks - start < FS_BENCH_TICKS) {
+        uint32_t cluster = first;
+        
+        while (cluster >= 2 && cluster < FS_CLUSTER_EOF) {
+            cluster = next(cluster);
+            steps++;
+        }
+    }
+    uint32_t elapsed = timer_ticks - start;
+    
+    terminal_print(label);
+    terminal_print_dec(elapsed ? (steps / 1000) * TIMER_FREQUENCY / elapsed : 0);
+    terminal_print(" mil passos/s\n");
+}
+
+// Comando: fatbench ARQ - percorre a cadeia do arquivo. No FAT12 compara a
+// FAT empacotada com a desempacotada; no FAT16/32 mede a leitura sob demanda
+void cmd_fatbench(const char* filename) {
+    fat12_dir_entry_t entry;
+    
+    if (!fs_initialized || fs_find_file(filename, &entry) != 0) {
+        terminal_print("\nArquivo nao encontrado: ");
+        terminal_print(filename);
+        terminal_print("\n");
+        return;
+    }
+    
+    uint32_t first = fs_entry_cluster(&entry);
+    uint32_t length = 0;
+    for (uint32_t c = first; c >= 2 && c < FS_CLUSTER_EOF; 
+         c = fs_get_next_cluster(c)) {
+        length++;
+    }
+    
+    if (length == 0) {
+        terminal_print("\nArquivo vazio.\n");
+        return;
+    }
+    
+    terminal_print("\nCadeia de ");
+    terminal_print(filename);
+    terminal_print(": ");
+    terminal_print_dec(length);
+    terminal_print(" clusters, 1 segundo por modo\n");
+    
+    if (fs_state.fat_type == 12) {
+        fs_bench_chain("  FAT12 empacotada:     ", first, fs_get_next_cluster_packed);
+        fs_bench_chain("  FAT desempacotada:    ", first, fs_get_next_cluster);
+    } else {
+        fs_bench_chain("  FAT sob demanda:      ", first, fs_get_next_cluster);
+    }
+}
+
+// ============================================================================
+// BENCHMARK DE RESOLUÇÃO DE CAMINHOS
+// ============================================================================
+
+// Resolve 'path' repetidamente por FS_BENCH_TICKS e mostra o custo médio.
+// A frio, os caches de caminhos, de diretório e de blocos são descartados
+// antes de cada busca, então cada nível volta a ser lido do disco
+static void fs_bench_lookup(const char* label, const char* path, int cold) {
+    uint8_t dev = fs_state.dev->index;
+    uint32_t lookups = 0;
+    uint32_t parent;
+    fs_dentry_t found;
+    
+    uint32_t start = timer_ticks;
+    while (timer_ticks - start < FS_BENCH_TICKS) {
+        if (cold) {
+            fs_pcache_invalidate();
+            fs_dcache_invalidate();
+            bcache_invalidate(dev);
+        }
+        if (fs_resolve(path, &parent, &found) != 0) break;
+        lookups++;
+    }
+    uint32_t elapsed = timer_ticks - start;
+    
+    terminal_print(label);
+    if (lookups == 0) {
+        terminal_print("falhou\n");
+        return;
+    }
+    terminal_print_dec(elapsed * (1000000000 / TIMER_FREQUENCY) / lookups);
+    terminal_print(" ns por busca (");
+    terminal_print_dec(lookups);
+    terminal_print(" buscas)\n");
+}
+
+// Comando: pathbench CAMINHO - latência de resolução de um caminho com os
+// caches frios e quentes
+void cmd_pathbench(const char* path) {
+    uint32_t parent;
+    fs_dentry_t found;
+    
+    if (!fs_initialized || fs_resolve(path, &parent, &found) != 0) {
+        terminal_print("\nCaminho nao encontrado: ");
+        terminal_print(path);
+        terminal_print("\n");
+        return;
+    }
+    
+    uint32_t depth = 0;
+    for (const char* p = path; *p; p++) {
+        if (*p != '/' && (p == path || p[-1] == '/')) depth++;
+    }
+    
+    terminal_print("\nResolucao de ");
+    terminal_print(path);
+    terminal_print(" (");
+    terminal_print_dec(depth);
+    terminal_print(" niveis), 1 segundo por modo\n");
+    
+    fs_bench_lookup("  Cache frio:   ", path, 1);
+    
+    pcache_hits = 0;
+    pcache_misses = 0;
+    fs_bench_lookup("  Cache quente: ", path, 0);
+    
+    terminal_print("  Cache de caminhos: ");
+    terminal_print_dec(pcache_hits);
+    terminal_print(" acertos, ");
+    terminal_print_dec(pcache_misses);
+    terminal_print(" falhas\n");
+}
+
+// ============================================================================
+// BACKEND DO VFS
+// ============================================================================
+
+// Um handle aberto por inode do VFS, indexado pela posição do inode. As
+// funções fs_* chamadas diretamente não passam pelo VFS nem pelo page cache
+static file_handle_t fs_vfs_handles[VFS_MAX_INODES];
+
+// Identidade: a posição da entrada no disco; o cluster inicial distingue
+// um arquivo novo que ocupou a mesma entrada
+static int fs_vfs_lookup(vfs_mount_t* mnt, const char* path, vfs_stat_t* stat) {
+    uint32_t parent;
+    fs_dentry_t found;
+    
+    (void)mnt;
+    if (!fs_initialized || fs_resolve(path, &parent, &found) != 0 ||
+        (found.entry.attributes & (FAT_ATTR_VOLUME_LABEL | FAT_ATTR_DIRECTORY))) {
+        return -1;
+    }
+    
+    stat->key = found.dir_lba * (FAT12_SECTOR_SIZE / sizeof(fat12_dir_entry_t)) + found.dir_index;
+    stat->generation = fs_entry_cluster(&found.entry);
+    stat->size = found.entry.file_size;
+    return 0;
+}
+
+static int fs_vfs_open(vfs_inode_t* inode, const char* path) {
+    file_handle_t* handle = &fs_vfs_handles[inode->index];
+    
+    if (fs_open(path, handle) != 0) return -1;
+    inode->priv = handle;
+    return 0;
+}
+
+static void fs_vfs_release(vfs_inode_t* inode) {
+    fs_close((file_handle_t*)inode->priv);
+}
+
+// Páginas alinhadas em 4 KB vão pelo caminho de leitura direta
+static int fs_vfs_read_page(vfs_inode_t* inode, uint32_t index, void* page) {
+    return fs_pread((file_handle_t*)inode->priv, page, VFS_PAGE_SIZE, index * VFS_PAGE_SIZE);
+}
+
+static int fs_vfs_write(vfs_inode_t* inode, uint32_t offset, const void* data, uint32_t size) {
+    file_handle_t* handle = (file_handle_t*)inode->priv;
+    
+    if (fs_seek(handle, offset) != 0) return -1;
+    
+    int written = fs_write(handle, data, size);
+    
+    // Um arquivo vazio ganha o primeiro cluster na primeira escrita
+    inode->generation = handle->first_cluster;
+    return written;
+}
+
+static int fs_vfs_flush(vfs_inode_t* inode) {
+    return fs_flush((file_handle_t*)inode->priv);
+}
+
+static int fs_vfs_create(vfs_mount_t* mnt, const char* path) {
+    file_handle_t handle;
+    
+    (void)mnt;
+    if (fs_create(path, &handle) != 0) return -1;
+    return fs_close(&handle);
+}
+
+static int fs_vfs_unlink(vfs_mount_t* mnt, const char* path) {
+    (void)mnt;
+    return fs_delete(path);
+}
+
+static int fs_vfs_list(vfs_mount_t* mnt, const char* path) {
+    (void)mnt;
+    return fs_list_directory(path);
+}
+
+static const vfs_ops_t fs_vfs_ops = {
+    .name = "fat",
+    .lookup = fs_vfs_lookup,
+    .open = fs_vfs_open,
+    .release = fs_vfs_release,
+    .read_page = fs_vfs_read_page,
+    .write = fs_vfs_write,
+    .flush = fs_vfs_flush,
+    .create = fs_vfs_create,
+    .unlink = fs_vfs_unlink,
+    .list = fs_vfs_list,
+};
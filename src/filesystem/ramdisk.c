@@ -0,0 +1,63 @@
+// ============================================================================
+// NanoOS - RAM Disk
+// Expõe como dispositivo de bloco (ram0) a imagem passada pelo bootloader
+// como módulo Multiboot (QEMU: -initrd fat.img). Escritas ficam só na
+// memória
+// ============================================================================
+
+#include "../../include/ramdisk.h"
+#include "../../include/blockdev.h"
+#include "../../include/kernel.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// VARIÁVEIS GLOBAIS
+// ============================================================================
+
+static uint8_t* ramdisk_base = 0;
+
+// ============================================================================
+// OPERAÇÕES DO DISPOSITIVO
+// ============================================================================
+
+static int ramdisk_read(blockdev_t* dev, uint32_t lba, uint32_t count, void* buffer) {
+    (void)dev;
+    memory_copy(buffer, ramdisk_base + lba * BLOCKDEV_SECTOR_SIZE, count * BLOCKDEV_SECTOR_SIZE);
+    return 0;
+}
+
+static int ramdisk_write(blockdev_t* dev, uint32_t lba, uint32_t count, const void* buffer) {
+    (void)dev;
+    memory_copy(ramdisk_base + lba * BLOCKDEV_SECTOR_SIZE, buffer, count * BLOCKDEV_SECTOR_SIZE);
+    return 0;
+}
+
+static const blockdev_ops_t ramdisk_ops = {
+    .read = ramdisk_read,
+    .write = ramdisk_write,
+};
+
+// ============================================================================
+// INICIALIZAÇÃO
+// ============================================================================
+
+int ramdisk_init(uint32_t magic, const multiboot_info_t* mbi) {
+    if (magic != MULTIBOOT_BOOTLOADER_MAGIC || !mbi) return -1;
+    if (!(mbi->flags & MULTIBOOT_INFO_MODS) || mbi->mods_count == 0) return -1;
+    
+    const multiboot_module_t* mod = (const multiboot_module_t*)mbi->mods_addr;
+    uint32_t sectors = (mod->mod_end - mod->mod_start) / BLOCKDEV_SECTOR_SIZE;
+    
+    if (sectors == 0) return -1;
+    
+    ramdisk_base = (uint8_t*)mod->mod_start;
+    if (!blockdev_register("ram0", sectors, &ramdisk_ops, 0)) {
+        return -1;
+    }
+    
+    terminal_print("RAM disk ram0: ");
+    terminal_print_dec(sectors / 2);
+    terminal_print(" KB (modulo Multiboot)\n");
+    return 0;
+}
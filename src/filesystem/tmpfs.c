@@ -0,0 +1,489 @@
+// ============================================================================
+// NanoOS - tmpfs
+// Arquivos em memória montados em /tmp: páginas de um pool estático
+// indexadas por uma árvore radix por arquivo, nomes em tabela hash e
+// leitura direta, sem passar pelo page cache do VFS
+// ============================================================================
+
+#include "../../include/tmpfs.h"
+#include "../../include/vfs.h"
+#include "../../include/kernel.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// VARIÁVEIS GLOBAIS
+// ============================================================================
+
+static uint8_t tmpfs_data[TMPFS_PAGES][VFS_PAGE_SIZE] __attribute__((aligned(16)));
+static uint16_t free_pages[TMPFS_PAGES];        // Pilha de páginas livres
+static uint32_t free_page_count = 0;
+
+static tmpfs_node_t nodes[TMPFS_RADIX_NODES];
+static tmpfs_node_t* free_nodes = 0;            // Encadeados por slots[0]
+
+static tmpfs_file_t files[TMPFS_MAX_FILES];
+static tmpfs_file_t* file_hash[TMPFS_HASH_SIZE];
+static uint8_t free_files[TMPFS_MAX_FILES];     // Pilha de slots livres
+static uint32_t free_file_count = 0;
+
+static const vfs_ops_t tmpfs_vfs_ops;
+
+// ============================================================================
+// INICIALIZAÇÃO
+// ============================================================================
+
+// Prepara os pools e monta o tmpfs em /tmp
+int tmpfs_init(void) {
+    for (uint32_t i = 0; i < TMPFS_PAGES; i++) {
+        free_pages[i] = TMPFS_PAGES - 1 - i;
+    }
+    free_page_count = TMPFS_PAGES;
+    
+    free_nodes = 0;
+    for (uint32_t i = 0; i < TMPFS_RADIX_NODES; i++) {
+        nodes[i].slots[0] = free_nodes;
+        free_nodes = &nodes[i];
+    }
+    
+    for (uint32_t i = 0; i < TMPFS_MAX_FILES; i++) {
+        files[i].used = 0;
+        files[i].generation = 0;
+        free_files[i] = TMPFS_MAX_FILES - 1 - i;
+    }
+    free_file_count = TMPFS_MAX_FILES;
+    
+    for (uint32_t i = 0; i < TMPFS_HASH_SIZE; i++) {
+        file_hash[i] = 0;
+    }
+    
+    return vfs_mount("/tmp", &tmpfs_vfs_ops, 0);
+}
+
+// ============================================================================
+// POOLS DE PÁGINAS E NÓS
+// ============================================================================
+
+static uint8_t* tmpfs_page_alloc(void) {
+    if (free_page_count == 0) return 0;
+    return tmpfs_data[free_pages[--free_page_count]];
+}
+
+static void tmpfs_page_free(uint8_t* page) {
+    free_pages[free_page_count++] = (page - tmpfs_data[0]) / VFS_PAGE_SIZE;
+}
+
+static tmpfs_node_t* tmpfs_node_alloc(void) {
+    tmpfs_node_t* node = free_nodes;
+    
+    if (!node) return 0;
+    free_nodes = node->slots[0];
+    
+    for (int i = 0; i < TMPFS_RADIX_SLOTS; i++) {
+        node->slots[i] = 0;
+    }
+    return node;
+}
+
+static void tmpfs_node_free(tmpfs_node_t* node) {
+    node->slots[0] = free_nodes;
+    free_nodes = node;
+}
+
+// ============================================================================
+// ÁRVORE RADIX DE PÁGINAS
+// ============================================================================
+
+// Maior índice de página + 1 que uma árvore de altura 'height' cobre
+static inline uint32_t tmpfs_capacity(uint8_t height) {
+    return 1u << (height * TMPFS_RADIX_SHIFT);
+}
+
+// Página 'index' do arquivo ou 0 se não existe
+static uint8_t* tmpfs_radix_lookup(const tmpfs_file_t* file, uint32_t index) {
+    if (file->height == 0 || index >= tmpfs_capacity(file->height)) return 0;
+    
+    tmpfs_node_t* node = file->root;
+    for (int level = file->height - 1; level > 0; level--) {
+        node = node->slots[(index >> (level * TMPFS_RADIX_SHIFT)) & (TMPFS_RADIX_SLOTS - 1)];
+        if (!node) return 0;
+    }
+    return node->slots[index & (TMPFS_RADIX_SLOTS - 1)];
+}
+
+// Liga 'page' ao índice 'index', aumentando a altura e criando os nós
+// intermediários necessários
+static int tmpfs_radix_insert(tmpfs_file_t* file, uint32_t index, uint8_t* page) {
+    while (file->height == 0 || index >= tmpfs_capacity(file->height)) {
+        if (file->height >= TMPFS_MAX_HEIGHT) return -1;
+        
+        tmpfs_node_t* root = tmpfs_node_alloc();
+        if (!root) return -1;
+        
+        // A árvore antiga vira o primeiro filho da nova raiz
+        root->slots[0] = file->root;
+        file->root = root;
+        file->height++;
+    }
+    
+    tmpfs_node_t* node = file->root;
+    for (int level = file->height - 1; level > 0; level--) {
+        uint32_t slot = (index >> (level * TMPFS_RADIX_SHIFT)) & (TMPFS_RADIX_SLOTS - 1);
+        
+        if (!node->slots[slot]) {
+            node->slots[slot] = tmpfs_node_alloc();
+            if (!node->slots[slot]) return -1;
+        }
+        node = node->slots[slot];
+    }
+    
+    node->slots[index & (TMPFS_RADIX_SLOTS - 1)] = page;
+    return 0;
+}
+
+// Devolve aos pools uma subárvore com as suas páginas
+static void tmpfs_radix_free(tmpfs_node_t* node, int level) {
+    for (int i = 0; i < TMPFS_RADIX_SLOTS; i++) {
+        if (!node->slots[i]) continue;
+        
+        if (level == 0) tmpfs_page_free(node->slots[i]);
+        else tmpfs_radix_free(node->slots[i], level - 1);
+    }
+    tmpfs_node_free(node);
+}
+
+// Página 'index' do arquivo. O fim do arquivo fica guardado à parte, então
+// o append só desce a árvore quando abre uma página nova
+static uint8_t* tmpfs_get_page(tmpfs_file_t* file, uint32_t index, int create) {
+    if (file->tail_page && file->tail_index == index) return file->tail_page;
+    
+    uint8_t* page = tmpfs_radix_lookup(file, index);
+    
+    if (!page && create) {
+        page = tmpfs_page_alloc();
+        if (!page) return 0;
+        
+        if (tmpfs_radix_insert(file, index, page) != 0) {
+            tmpfs_page_free(page);
+            return 0;
+        }
+    }
+    
+    if (page && (!file->tail_page || index > file->tail_index)) {
+        file->tail_page = page;
+        file->tail_index = index;
+    }
+    return page;
+}
+
+// ============================================================================
+// NOMES
+// ============================================================================
+
+static uint32_t tmpfs_hash(const char* name) {
+    uint32_t hash = 2166136261u;
+    
+    while (*name) {
+        hash = (hash ^ (uint8_t)*name++) * 16777619u;
+    }
+    return hash & (TMPFS_HASH_SIZE - 1);
+}
+
+// Caminho relativo à montagem ("/NOME") -> nome; o namespace é plano
+static const char* tmpfs_name(const char* path) {
+    while (*path == '/') path++;
+    
+    uint32_t len = 0;
+    while (path[len]) {
+        if (path[len] == '/') return 0;
+        len++;
+    }
+    if (len == 0 || len >= TMPFS_NAME_MAX) return 0;
+    return path;
+}
+
+static tmpfs_file_t* tmpfs_find(const char* name) {
+    tmpfs_file_t* file = file_hash[tmpfs_hash(name)];
+    
+    while (file && strcmp(file->name, name) != 0) {
+        file = file->hash_next;
+    }
+    return file;
+}
+
+// ============================================================================
+// OPERAÇÕES DO VFS
+// ============================================================================
+
+static int tmpfs_vfs_lookup(vfs_mount_t* mnt, const char* path, vfs_stat_t* stat) {
+    const char* name = tmpfs_name(path);
+    tmpfs_file_t* file = name ? tmpfs_find(name) : 0;
+    
+    (void)mnt;
+    if (!file) return -1;
+    
+    stat->key = file - files;
+    stat->generation = file->generation;
+    stat->size = file->size;
+    return 0;
+}
+
+// O slot guarda nome e geração: conferir a dentry não precisa da hash
+static int tmpfs_vfs_revalidate(vfs_mount_t* mnt, const char* path, uint32_t key,
+                                uint32_t generation) {
+    const char* name = tmpfs_name(path);
+    
+    (void)mnt;
+    if (!name || key >= TMPFS_MAX_FILES) return -1;
+    if (!files[key].used || files[key].generation != generation) return -1;
+    return strcmp(files[key].name, name) == 0 ? 0 : -1;
+}
+
+static int tmpfs_vfs_open(vfs_inode_t* inode, const char* path) {
+    (void)path;
+    
+    if (inode->key >= TMPFS_MAX_FILES || !files[inode->key].used) return -1;
+    inode->priv = &files[inode->key];
+    return 0;
+}
+
+static int tmpfs_vfs_read(vfs_inode_t* inode, uint32_t offset, void* data, uint32_t size) {
+    tmpfs_file_t* file = inode->priv;
+    uint8_t* dst = data;
+    uint32_t done = 0;
+    
+    if (offset >= file->size) return 0;
+    if (size > file->size - offset) size = file->size - offset;
+    
+    while (done < size) {
+        uint32_t pos = offset + done;
+        uint32_t in_page = pos % VFS_PAGE_SIZE;
+        uint32_t n = VFS_PAGE_SIZE - in_page;
+        uint8_t* page = tmpfs_get_page(file, pos / VFS_PAGE_SIZE, 0);
+        
+        if (n > size - done) n = size - done;
+        if (!page) break;
+        
+        memory_copy(dst + done, page + in_page, n);
+        done += n;
+    }
+    return done;
+}
+
+// Escreve criando as páginas que faltam; sem memória, grava o que couber
+static int tmpfs_vfs_write(vfs_inode_t* inode, uint32_t offset, const void* data, uint32_t size) {
+    tmpfs_file_t* file = inode->priv;
+    const uint8_t* src = data;
+    uint32_t done = 0;
+    
+    if (offset > file->size) return -1;
+    
+    while (done < size) {
+        uint32_t pos = offset + done;
+        uint32_t in_page = pos % VFS_PAGE_SIZE;
+        uint32_t n = VFS_PAGE_SIZE - in_page;
+        uint8_t* page = tmpfs_get_page(file, pos / VFS_PAGE_SIZE, 1);
+        
+        if (n > size - done) n = size - done;
+        if (!page) break;
+        
+        memory_copy(page + in_page, src + done, n);
+        done += n;
+    }
+    
+    if (offset + done > file->size) file->size = offset + done;
+    return done ? (int)done : -1;
+}
+
+// Criar e apagar mexem só na tabela hash e nas pilhas livres
+static int tmpfs_vfs_create(vfs_mount_t* mnt, const char* path) {
+    const char* name = tmpfs_name(path);
+    
+    (void)mnt;
+    if (!name || tmpfs_find(name) || free_file_count == 0) return -1;
+    
+    tmpfs_file_t* file = &files[free_files[--free_file_count]];
+    uint32_t bucket = tmpfs_hash(name);
+    
+    memory_copy(file->name, name, strlen(name) + 1);
+    file->size = 0;
+    file->generation++;
+    file->root = 0;
+    file->height = 0;
+    file->tail_page = 0;
+    file->tail_index = 0;
+    file->used = 1;
+    file->hash_next = file_hash[bucket];
+    file_hash[bucket] = file;
+    return 0;
+}
+
+static int tmpfs_vfs_unlink(vfs_mount_t* mnt, const char* path) {
+    const char* name = tmpfs_name(path);
+    tmpfs_file_t* file = name ? tmpfs_find(name) : 0;
+    
+    (void)mnt;
+    if (!file) return -1;
+    
+    tmpfs_file_t** link = &file_hash[tmpfs_hash(name)];
+    while (*link != file) {
+        link = &(*link)->hash_next;
+    }
+    *link = file->hash_next;
+    
+    if (file->root) tmpfs_radix_free(file->root, file->height - 1);
+    file->used = 0;
+    free_files[free_file_count++] = file - files;
+    return 0;
+}
+
+static int tmpfs_vfs_list(vfs_mount_t* mnt, const char* path) {
+    uint32_t count = 0;
+    char size_str[16];
+    
+    (void)mnt;
+    while (*path == '/') path++;
+    if (*path) return -1;
+    
+    terminal_print("\nArquivos em /tmp:\n");
+    terminal_print("Nome           Tamanho\n");
+    terminal_print("------------------------\n");
+    
+    for (uint32_t i = 0; i < TMPFS_MAX_FILES; i++) {
+        if (!files[i].used) continue;
+        
+        int name_len = strlen(files[i].name);
+        terminal_print(files[i].name);
+        for (int j = name_len; j < 14; j++) {
+            terminal_print(" ");
+        }
+        if (name_len >= 14) terminal_print(" ");
+        
+        uint_to_str(files[i].size, size_str, sizeof(size_str));
+        terminal_print(size_str);
+        terminal_print(" bytes\n");
+        count++;
+    }
+    
+    terminal_print("\nTotal: ");
+    terminal_print_dec(count);
+    terminal_print(" arquivo(s), ");
+    terminal_print_dec((TMPFS_PAGES - free_page_count) * (VFS_PAGE_SIZE / 1024));
+    terminal_print("/");
+    terminal_print_dec(TMPFS_PAGES * (VFS_PAGE_SIZE / 1024));
+    terminal_print(" KB em uso\n");
+    return count;
+}
+
+static const vfs_ops_t tmpfs_vfs_ops = {
+    .name = "tmpfs",
+    .lookup = tmpfs_vfs_lookup,
+    .revalidate = tmpfs_vfs_revalidate,
+    .open = tmpfs_vfs_open,
+    .read = tmpfs_vfs_read,
+    .write = tmpfs_vfs_write,
+    .create = tmpfs_vfs_create,
+    .unlink = tmpfs_vfs_unlink,
+    .list = tmpfs_vfs_list,
+};
+
+// ============================================================================
+// BENCHMARK
+// ============================================================================
+
+static uint8_t bench_buffer[TMPFS_BENCH_FILE_SIZE];
+
+// Caminho do benchmark dentro da montagem 'prefix' ("" = raiz)
+static void tmpfs_bench_path(char* out, const char* prefix, const char* name) {
+    uint32_t len = strlen(prefix);
+    
+    memory_copy(out, prefix, len);
+    memory_copy(out + len, name, strlen(name) + 1);
+}
+
+// Ciclos de criar, escrever 1 KB, fechar e apagar por TMPFS_BENCH_TICKS
+static void tmpfs_bench_create(const char* prefix) {
+    char path[32];
+    uint32_t cycles = 0;
+    
+    tmpfs_bench_path(path, prefix, "/TMPBENCH.TMP");
+    
+    uint32_t start = timer_ticks;
+    while (timer_ticks - start < TMPFS_BENCH_TICKS) {
+        int fd = vfs_open(path, VFS_O_WRITE | VFS_O_CREATE);
+        if (fd < 0) break;
+        
+        int n = vfs_write(fd, bench_buffer, TMPFS_BENCH_FILE_SIZE);
+        vfs_close(fd);
+        if (n != TMPFS_BENCH_FILE_SIZE || vfs_unlink(path) != 0) break;
+        cycles++;
+    }
+    uint32_t elapsed = timer_ticks - start;
+    
+    terminal_print("  Criar/apagar 1 KB: ");
+    if (cycles == 0) {
+        terminal_print("falhou\n");
+        return;
+    }
+    terminal_print_dec(cycles * TIMER_FREQUENCY / elapsed);
+    terminal_print(" arquivos/s, ");
+    terminal_print_dec(elapsed * (1000000 / TIMER_FREQUENCY) / cycles);
+    terminal_print(" us cada\n");
+}
+
+// Appends pequenos num log por TMPFS_BENCH_TICKS; o log recomeça ao
+// chegar a TMPFS_BENCH_LOG_SIZE
+static void tmpfs_bench_append(const char* prefix) {
+    char path[32];
+    uint32_t total = 0;
+    uint32_t appends = 0;
+    
+    tmpfs_bench_path(path, prefix, "/TMPBLOG.TMP");
+    vfs_unlink(path);
+    
+    uint32_t start = timer_ticks;
+    int fd = vfs_open(path, VFS_O_WRITE | VFS_O_CREATE | VFS_O_APPEND);
+    
+    while (fd >= 0 && timer_ticks - start < TMPFS_BENCH_TICKS) {
+        if (vfs_size(fd) >= TMPFS_BENCH_LOG_SIZE) {
+            vfs_close(fd);
+            vfs_unlink(path);
+            fd = vfs_open(path, VFS_O_WRITE | VFS_O_CREATE | VFS_O_APPEND);
+            continue;
+        }
+        
+        if (vfs_write(fd, bench_buffer, TMPFS_BENCH_APPEND) != TMPFS_BENCH_APPEND) break;
+        total += TMPFS_BENCH_APPEND;
+        appends++;
+    }
+    uint32_t elapsed = timer_ticks - start;
+    
+    if (fd >= 0) vfs_close(fd);
+    vfs_unlink(path);
+    
+    terminal_print("  Append de 256 B:   ");
+    if (appends == 0) {
+        terminal_print("falhou\n");
+        return;
+    }
+    terminal_print_dec((total / 1024) * TIMER_FREQUENCY / elapsed);
+    terminal_print(" KB/s, ");
+    terminal_print_dec(elapsed * (1000000000 / TIMER_FREQUENCY) / appends);
+    terminal_print(" ns cada\n");
+}
+
+// Comando: tmpbench - criação, remoção e append pelo VFS no FAT (/) e no
+// tmpfs (/tmp), 1 segundo por fase
+void cmd_tmpbench(void) {
+    for (uint32_t i = 0; i < TMPFS_BENCH_FILE_SIZE; i++) {
+        bench_buffer[i] = (uint8_t)i;
+    }
+    
+    terminal_print("\nFAT (/):\n");
+    tmpfs_bench_create("");
+    tmpfs_bench_append("");
+    
+    terminal_print("tmpfs (/tmp):\n");
+    tmpfs_bench_create("/tmp");
+    tmpfs_bench_append("/tmp");
+}
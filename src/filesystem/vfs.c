@@ -0,0 +1,709 @@
+// ============================================================================
+// NanoOS - Sistema de Arquivos Virtual
+// Montagens por prefixo de caminho, inodes e dentries em memória, tabelas
+// de descritores por contexto e um page cache único, chaveado por (inode,
+// página), compartilhado por todos os sistemas de arquivos
+// ============================================================================
+
+#include "../../include/vfs.h"
+#include "../../include/kernel.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// VARIÁVEIS GLOBAIS
+// ============================================================================
+
+static vfs_mount_t mounts[VFS_MAX_MOUNTS];
+static int mount_count = 0;
+
+static vfs_inode_t inodes[VFS_MAX_INODES];
+
+// Dentries reaproveitadas em ordem circular
+static vfs_dentry_t dentries[VFS_MAX_DENTRIES];
+static vfs_dentry_t* dentry_hash[VFS_DENTRY_HASH_SIZE];
+static uint32_t dentry_next = 0;
+
+static vfs_page_t pages[VFS_PAGES];
+static vfs_page_t* page_hash[VFS_PAGE_HASH_SIZE];
+static vfs_page_t* lru_head = 0;        // Mais recente
+static vfs_page_t* lru_tail = 0;        // Candidata a despejo
+
+// Contexto do kernel (shell) e contexto corrente
+static vfs_context_t kernel_context;
+static vfs_context_t* current_context = &kernel_context;
+
+static vfs_stats_t stats;
+
+// ============================================================================
+// INICIALIZAÇÃO E MONTAGEM
+// ============================================================================
+
+void vfs_init(void) {
+    mount_count = 0;
+    
+    for (int i = 0; i < VFS_MAX_INODES; i++) {
+        inodes[i].mount = 0;
+        inodes[i].index = i;
+    }
+    
+    for (int i = 0; i < VFS_MAX_DENTRIES; i++) {
+        dentries[i].inode = 0;
+    }
+    for (int i = 0; i < VFS_DENTRY_HASH_SIZE; i++) {
+        dentry_hash[i] = 0;
+    }
+    dentry_next = 0;
+    
+    // Todas as páginas começam livres na lista LRU
+    lru_head = 0;
+    lru_tail = 0;
+    for (int i = 0; i < VFS_PAGE_HASH_SIZE; i++) {
+        page_hash[i] = 0;
+    }
+    for (int i = 0; i < VFS_PAGES; i++) {
+        vfs_page_t* page = &pages[i];
+        
+        page->inode = 0;
+        page->hash_next = 0;
+        page->lru_prev = lru_tail;
+        page->lru_next = 0;
+        if (lru_tail) lru_tail->lru_next = page;
+        else lru_head = page;
+        lru_tail = page;
+    }
+    
+    vfs_context_init(&kernel_context);
+    current_context = &kernel_context;
+    
+    stats.page_hits = 0;
+    stats.page_misses = 0;
+    stats.page_evictions = 0;
+    stats.dentry_hits = 0;
+    stats.dentry_misses = 0;
+    stats.dentry_stale = 0;
+    stats.inode_evictions = 0;
+}
+
+// Monta um sistema de arquivos em 'prefix' ("/" ou "/nome")
+int vfs_mount(const char* prefix, const vfs_ops_t* ops, void* priv) {
+    if (mount_count >= VFS_MAX_MOUNTS || !ops || !ops->lookup || !ops->open ||
+        (!ops->read_page && !ops->read) || prefix[0] != '/') {
+        return -1;
+    }
+    
+    uint32_t len = strlen(prefix);
+    if (len >= VFS_MOUNT_LEN) return -1;
+    
+    vfs_mount_t* mnt = &mounts[mount_count++];
+    
+    memory_copy(mnt->prefix, prefix, len + 1);
+    mnt->prefix_len = len;
+    mnt->ops = ops;
+    mnt->priv = priv;
+    return 0;
+}
+
+// Montagem de prefixo mais longo que cobre 'path'. 'rest' recebe o
+// caminho relativo a ela ("" = raiz da montagem)
+static vfs_mount_t* vfs_find_mount(const char* path, const char** rest) {
+    vfs_mount_t* best = 0;
+    
+    for (int i = 0; i < mount_count; i++) {
+        vfs_mount_t* mnt = &mounts[i];
+        uint32_t n = mnt->prefix_len;
+        
+        if (best && n <= best->prefix_len) continue;
+        
+        if (n == 1) {
+            best = mnt;
+            *rest = path;
+        } else if (memory_compare(path, mnt->prefix, n) == 0 &&
+                   (path[n] == '/' || path[n] == '\0')) {
+            best = mnt;
+            *rest = path + n;
+        }
+    }
+    return best;
+}
+
+// ============================================================================
+// CAMINHOS E DENTRIES
+// ============================================================================
+
+// Normaliza 'path' em 'out' (VFS_PATH_MAX): absoluto, sem barras repetidas,
+// sem "." e com ".." resolvido. Caminhos relativos partem da raiz
+static int vfs_normalize(const char* path, char* out) {
+    uint32_t len = 0;
+    
+    out[len++] = '/';
+    
+    while (*path) {
+        while (*path == '/') path++;
+        if (!*path) break;
+        
+        uint32_t n = 0;
+        while (path[n] && path[n] != '/') n++;
+        
+        if (n == 2 && path[0] == '.' && path[1] == '.') {
+            // Volta ao componente anterior
+            while (len > 1 && out[len - 1] != '/') len--;
+            if (len > 1) len--;
+        } else if (n != 1 || path[0] != '.') {
+            if (len + n + 1 >= VFS_PATH_MAX) return -1;
+            if (len > 1) out[len++] = '/';
+            memory_copy(out + len, path, n);
+            len += n;
+        }
+        path += n;
+    }
+    
+    out[len] = '\0';
+    return 0;
+}
+
+// Hash FNV-1a do caminho normalizado
+static uint32_t vfs_path_hash(const char* path) {
+    uint32_t hash = 2166136261u;
+    
+    while (*path) {
+        hash = (hash ^ (uint8_t)*path++) * 16777619u;
+    }
+    return hash;
+}
+
+static vfs_dentry_t* vfs_dentry_lookup(const char* path) {
+    uint32_t hash = vfs_path_hash(path);
+    vfs_dentry_t* dentry = dentry_hash[hash & (VFS_DENTRY_HASH_SIZE - 1)];
+    
+    while (dentry && (dentry->hash != hash || strcmp(dentry->path, path) != 0)) {
+        dentry = dentry->hash_next;
+    }
+    return dentry;
+}
+
+static void vfs_dentry_unlink(vfs_dentry_t* dentry) {
+    vfs_dentry_t** link = &dentry_hash[dentry->hash & (VFS_DENTRY_HASH_SIZE - 1)];
+    
+    while (*link && *link != dentry) {
+        link = &(*link)->hash_next;
+    }
+    if (*link) *link = dentry->hash_next;
+    dentry->inode = 0;
+}
+
+// Lembra path -> inode, reaproveitando a dentry mais antiga
+static void vfs_dentry_insert(const char* path, vfs_inode_t* inode, const vfs_stat_t* stat) {
+    vfs_dentry_t* dentry = &dentries[dentry_next];
+    
+    dentry_next = (dentry_next + 1) % VFS_MAX_DENTRIES;
+    if (dentry->inode) vfs_dentry_unlink(dentry);
+    
+    memory_copy(dentry->path, path, strlen(path) + 1);
+    dentry->hash = vfs_path_hash(path);
+    dentry->key = stat->key;
+    dentry->generation = stat->generation;
+    dentry->inode = inode;
+    
+    uint32_t bucket = dentry->hash & (VFS_DENTRY_HASH_SIZE - 1);
+    dentry->hash_next = dentry_hash[bucket];
+    dentry_hash[bucket] = dentry;
+}
+
+// A dentry ainda vale se o sistema de arquivos confirma a mesma
+// identidade: um arquivo apagado ou recriado por baixo do VFS (entrada
+// FAT reescrita, slot do tmpfs reaproveitado) a invalida
+static int vfs_dentry_valid(vfs_mount_t* mnt, const char* rest, const vfs_dentry_t* dentry) {
+    vfs_stat_t stat;
+    
+    if (mnt->ops->revalidate) {
+        return mnt->ops->revalidate(mnt, rest, dentry->key, dentry->generation) == 0;
+    }
+    return mnt->ops->lookup(mnt, rest, &stat) == 0 && stat.key == dentry->key &&
+           stat.generation == dentry->generation;
+}
+
+// Esquece todos os caminhos que levam a 'inode'
+static void vfs_dentry_drop_inode(vfs_inode_t* inode) {
+    for (int i = 0; i < VFS_MAX_DENTRIES; i++) {
+        if (dentries[i].inode == inode) vfs_dentry_unlink(&dentries[i]);
+    }
+}
+
+// ============================================================================
+// PAGE CACHE
+// ============================================================================
+
+static inline uint32_t vfs_page_bucket(const vfs_inode_t* inode, uint32_t index) {
+    return ((((uint32_t)inode->index << 20) ^ index) * 2654435761u >> 16) &
+           (VFS_PAGE_HASH_SIZE - 1);
+}
+
+static void vfs_lru_unlink(vfs_page_t* page) {
+    if (page->lru_prev) page->lru_prev->lru_next = page->lru_next;
+    else lru_head = page->lru_next;
+    
+    if (page->lru_next) page->lru_next->lru_prev = page->lru_prev;
+    else lru_tail = page->lru_prev;
+    
+    page->lru_prev = 0;
+    page->lru_next = 0;
+}
+
+static void vfs_lru_push_front(vfs_page_t* page) {
+    page->lru_next = lru_head;
+    if (lru_head) lru_head->lru_prev = page;
+    lru_head = page;
+    if (!lru_tail) lru_tail = page;
+}
+
+static void vfs_lru_push_back(vfs_page_t* page) {
+    page->lru_prev = lru_tail;
+    if (lru_tail) lru_tail->lru_next = page;
+    lru_tail = page;
+    if (!lru_head) lru_head = page;
+}
+
+static vfs_page_t* vfs_page_find(const vfs_inode_t* inode, uint32_t index) {
+    vfs_page_t* page = page_hash[vfs_page_bucket(inode, index)];
+    
+    while (page && (page->inode != inode || page->index != index)) {
+        page = page->hash_next;
+    }
+    return page;
+}
+
+// Tira a página do hash e a devolve ao fim da LRU como livre
+static void vfs_page_drop(vfs_page_t* page) {
+    vfs_page_t** link = &page_hash[vfs_page_bucket(page->inode, page->index)];
+    
+    while (*link && *link != page) {
+        link = &(*link)->hash_next;
+    }
+    if (*link) *link = page->hash_next;
+    
+    page->inode->pages--;
+    page->inode = 0;
+    vfs_lru_unlink(page);
+    vfs_lru_push_back(page);
+}
+
+// Página 'index' de 'inode', lida do sistema de arquivos na falta. As
+// páginas nunca estão sujas (escrita é write-through), então o despejo da
+// menos recente é imediato
+static vfs_page_t* vfs_page_get(vfs_inode_t* inode, uint32_t index) {
+    vfs_page_t* page = vfs_page_find(inode, index);
+    
+    if (page) {
+        stats.page_hits++;
+        if (lru_head != page) {
+            vfs_lru_unlink(page);
+            vfs_lru_push_front(page);
+        }
+        return page;
+    }
+    stats.page_misses++;
+    
+    page = lru_tail;
+    if (page->inode) {
+        vfs_page_drop(page);
+        stats.page_evictions++;
+    }
+    
+    int valid = inode->mount->ops->read_page(inode, index, page->data);
+    if (valid < 0) return 0;
+    
+    uint32_t bucket = vfs_page_bucket(inode, index);
+    
+    page->inode = inode;
+    page->index = index;
+    page->valid = valid;
+    page->hash_next = page_hash[bucket];
+    page_hash[bucket] = page;
+    inode->pages++;
+    
+    vfs_lru_unlink(page);
+    vfs_lru_push_front(page);
+    return page;
+}
+
+// Descarta todas as páginas de um inode
+static void vfs_page_drop_inode(vfs_inode_t* inode) {
+    for (int i = 0; i < VFS_PAGES && inode->pages > 0; i++) {
+        if (pages[i].inode == inode) vfs_page_drop(&pages[i]);
+    }
+}
+
+// ============================================================================
+// INODES
+// ============================================================================
+
+// Tira um inode sem descritores da memória, com páginas e dentries
+static void vfs_inode_evict(vfs_inode_t* inode) {
+    vfs_page_drop_inode(inode);
+    vfs_dentry_drop_inode(inode);
+    
+    if (inode->mount->ops->release) inode->mount->ops->release(inode);
+    inode->mount = 0;
+    stats.inode_evictions++;
+}
+
+// Inode de (mnt, stat->key). Reaproveita o que já está em memória; senão
+// ocupa um livre ou o menos usado entre os que não têm descritores
+static vfs_inode_t* vfs_iget(vfs_mount_t* mnt, const char* rest, const vfs_stat_t* stat) {
+    vfs_inode_t* victim = 0;
+    
+    for (int i = 0; i < VFS_MAX_INODES; i++) {
+        vfs_inode_t* inode = &inodes[i];
+        
+        if (inode->mount == mnt && inode->key == stat->key) {
+            if (inode->generation == stat->generation) return inode;
+            
+            // Entrada reaproveitada por outro arquivo: as páginas não valem
+            if (inode->refcount > 0) return 0;
+            vfs_inode_evict(inode);
+            victim = inode;
+            break;
+        }
+        
+        if (!inode->mount) {
+            if (!victim || victim->mount) victim = inode;
+        } else if (inode->refcount == 0 && (!victim || (victim->mount &&
+                   inode->last_used < victim->last_used))) {
+            victim = inode;
+        }
+    }
+    
+    if (!victim) return 0;
+    if (victim->mount) vfs_inode_evict(victim);
+    
+    victim->mount = mnt;
+    victim->key = stat->key;
+    victim->generation = stat->generation;
+    victim->size = stat->size;
+    victim->refcount = 0;
+    victim->pages = 0;
+    victim->last_used = timer_ticks;
+    victim->priv = 0;
+    
+    if (mnt->ops->open(victim, rest) != 0) {
+        victim->mount = 0;
+        return 0;
+    }
+    return victim;
+}
+
+// Caminho normalizado -> inode: dentry em cache ou lookup no sistema de
+// arquivos (criando o arquivo se pedido)
+static vfs_inode_t* vfs_resolve(const char* path, int create) {
+    vfs_dentry_t* dentry = vfs_dentry_lookup(path);
+    const char* rest;
+    vfs_mount_t* mnt = vfs_find_mount(path, &rest);
+    vfs_stat_t stat;
+    
+    if (!mnt) return 0;
+    
+    if (dentry) {
+        if (vfs_dentry_valid(mnt, rest, dentry)) {
+            stats.dentry_hits++;
+            return dentry->inode;
+        }
+        vfs_dentry_unlink(dentry);
+        stats.dentry_stale++;
+    }
+    stats.dentry_misses++;
+    
+    if (mnt->ops->lookup(mnt, rest, &stat) != 0) {
+        if (!create || !mnt->ops->create || mnt->ops->create(mnt, rest) != 0 ||
+            mnt->ops->lookup(mnt, rest, &stat) != 0) {
+            return 0;
+        }
+    }
+    
+    vfs_inode_t* inode = vfs_iget(mnt, rest, &stat);
+    if (inode) vfs_dentry_insert(path, inode, &stat);
+    return inode;
+}
+
+// Lê do inode pelo page cache (ou direto do sistema de arquivos, se ele
+// fornece read), limitado ao tamanho do arquivo
+static int vfs_inode_read(vfs_inode_t* inode, uint8_t* dst, uint32_t size, uint32_t offset) {
+    uint32_t done = 0;
+    
+    if (offset >= inode->size) return 0;
+    if (size > inode->size - offset) size = inode->size - offset;
+    
+    inode->last_used = timer_ticks;
+    if (inode->mount->ops->read) {
+        return inode->mount->ops->read(inode, offset, dst, size);
+    }
+    
+    while (done < size) {
+        uint32_t pos = offset + done;
+        uint32_t in_page = pos % VFS_PAGE_SIZE;
+        vfs_page_t* page = vfs_page_get(inode, pos / VFS_PAGE_SIZE);
+        
+        if (!page) return done ? (int)done : -1;
+        if (in_page >= page->valid) break;
+        
+        uint32_t n = page->valid - in_page;
+        if (n > size - done) n = size - done;
+        
+        memory_copy(dst + done, page->data + in_page, n);
+        done += n;
+    }
+    
+    return done;
+}
+
+// Grava pelo sistema de arquivos e atualiza as páginas em cache do trecho
+static int vfs_inode_write(vfs_inode_t* inode, const uint8_t* src, uint32_t size, uint32_t offset) {
+    if (!inode->mount->ops->write) return -1;
+    
+    int written = inode->mount->ops->write(inode, offset, src, size);
+    if (written <= 0) return written;
+    
+    uint32_t end = offset + written;
+    
+    for (uint32_t index = offset / VFS_PAGE_SIZE; index * VFS_PAGE_SIZE < end; index++) {
+        vfs_page_t* page = vfs_page_find(inode, index);
+        if (!page) continue;
+        
+        uint32_t page_start = index * VFS_PAGE_SIZE;
+        uint32_t from = offset > page_start ? offset - page_start : 0;
+        uint32_t to = end - page_start < VFS_PAGE_SIZE ? end - page_start : VFS_PAGE_SIZE;
+        
+        // Escrita além do fim válido da página deixaria um buraco
+        if (from > page->valid) {
+            vfs_page_drop(page);
+            continue;
+        }
+        
+        memory_copy(page->data + from, src + (page_start + from - offset), to - from);
+        if (to > page->valid) page->valid = to;
+    }
+    
+    if (end > inode->size) inode->size = end;
+    inode->last_used = timer_ticks;
+    return written;
+}
+
+// ============================================================================
+// CONTEXTOS E DESCRITORES
+// ============================================================================
+
+void vfs_context_init(vfs_context_t* ctx) {
+    for (int i = 0; i < VFS_MAX_FDS; i++) {
+        ctx->files[i].inode = 0;
+    }
+}
+
+// Troca a tabela de descritores em uso; retorna a anterior
+vfs_context_t* vfs_set_context(vfs_context_t* ctx) {
+    vfs_context_t* previous = current_context;
+    
+    current_context = ctx ? ctx : &kernel_context;
+    return previous;
+}
+
+static vfs_file_t* vfs_file(int fd) {
+    if (fd < 0 || fd >= VFS_MAX_FDS) return 0;
+    
+    vfs_file_t* file = &current_context->files[fd];
+    return file->inode ? file : 0;
+}
+
+// Abre um arquivo; retorna o descritor ou -1
+int vfs_open(const char* path, uint8_t flags) {
+    char full[VFS_PATH_MAX];
+    int fd = -1;
+    
+    if (!path || vfs_normalize(path, full) != 0) return -1;
+    
+    for (int i = 0; i < VFS_MAX_FDS; i++) {
+        if (!current_context->files[i].inode) {
+            fd = i;
+            break;
+        }
+    }
+    if (fd < 0) return -1;
+    
+    vfs_inode_t* inode = vfs_resolve(full, flags & VFS_O_CREATE);
+    if (!inode) return -1;
+    
+    vfs_file_t* file = &current_context->files[fd];
+    
+    inode->refcount++;
+    file->inode = inode;
+    file->flags = flags;
+    file->position = (flags & VFS_O_APPEND) ? inode->size : 0;
+    return fd;
+}
+
+int vfs_read(int fd, void* buffer, uint32_t size) {
+    vfs_file_t* file = vfs_file(fd);
+    
+    if (!file || !buffer || !(file->flags & VFS_O_READ)) return -1;
+    
+    int n = vfs_inode_read(file->inode, (uint8_t*)buffer, size, file->position);
+    if (n > 0) file->position += n;
+    return n;
+}
+
+// Lê a partir de 'offset' sem alterar a posição do descritor
+int vfs_pread(int fd, void* buffer, uint32_t size, uint32_t offset) {
+    vfs_file_t* file = vfs_file(fd);
+    
+    if (!file || !buffer || !(file->flags & VFS_O_READ)) return -1;
+    return vfs_inode_read(file->inode, (uint8_t*)buffer, size, offset);
+}
+
+int vfs_write(int fd, const void* buffer, uint32_t size) {
+    vfs_file_t* file = vfs_file(fd);
+    
+    if (!file || !buffer || !(file->flags & VFS_O_WRITE)) return -1;
+    if (file->flags & VFS_O_APPEND) file->position = file->inode->size;
+    
+    int n = vfs_inode_write(file->inode, (const uint8_t*)buffer, size, file->position);
+    if (n > 0) file->position += n;
+    return n;
+}
+
+int vfs_seek(int fd, uint32_t offset) {
+    vfs_file_t* file = vfs_file(fd);
+    
+    if (!file || offset > file->inode->size) return -1;
+    file->position = offset;
+    return 0;
+}
+
+int vfs_size(int fd) {
+    vfs_file_t* file = vfs_file(fd);
+    
+    return file ? (int)file->inode->size : -1;
+}
+
+// Fecha o descritor. O inode continua em cache com as suas páginas; o
+// sistema de arquivos grava metadados pendentes quando o último fecha
+int vfs_close(int fd) {
+    vfs_file_t* file = vfs_file(fd);
+    
+    if (!file) return -1;
+    
+    vfs_inode_t* inode = file->inode;
+    int result = 0;
+    
+    file->inode = 0;
+    inode->last_used = timer_ticks;
+    if (--inode->refcount == 0 && inode->mount->ops->flush) {
+        result = inode->mount->ops->flush(inode);
+    }
+    return result;
+}
+
+// ============================================================================
+// OPERAÇÕES POR CAMINHO
+// ============================================================================
+
+// Apaga um arquivo que não está aberto
+int vfs_unlink(const char* path) {
+    char full[VFS_PATH_MAX];
+    const char* rest;
+    vfs_stat_t stat;
+    
+    if (!path || vfs_normalize(path, full) != 0) return -1;
+    
+    vfs_mount_t* mnt = vfs_find_mount(full, &rest);
+    if (!mnt || !mnt->ops->unlink || mnt->ops->lookup(mnt, rest, &stat) != 0) return -1;
+    
+    for (int i = 0; i < VFS_MAX_INODES; i++) {
+        vfs_inode_t* inode = &inodes[i];
+        
+        if (inode->mount == mnt && inode->key == stat.key) {
+            if (inode->refcount > 0) return -1;
+            vfs_inode_evict(inode);
+        }
+    }
+    
+    return mnt->ops->unlink(mnt, rest);
+}
+
+// Lista um diretório pelo sistema de arquivos que o contém
+int vfs_list(const char* path) {
+    char full[VFS_PATH_MAX];
+    const char* rest;
+    
+    if (!path || vfs_normalize(path, full) != 0) return -1;
+    
+    vfs_mount_t* mnt = vfs_find_mount(full, &rest);
+    if (!mnt || !mnt->ops->list) return -1;
+    return mnt->ops->list(mnt, rest);
+}
+
+// ============================================================================
+// ESTATÍSTICAS
+// ============================================================================
+
+void vfs_get_stats(vfs_stats_t* out) {
+    *out = stats;
+}
+
+// Comando: vfsstat - montagens, inodes e page cache
+void cmd_vfsstat(void) {
+    uint32_t lookups = stats.page_hits + stats.page_misses;
+    uint32_t cached = 0;
+    uint32_t open = 0;
+    uint32_t used = 0;
+    
+    for (int i = 0; i < VFS_MAX_INODES; i++) {
+        if (!inodes[i].mount) continue;
+        cached++;
+        if (inodes[i].refcount > 0) open++;
+    }
+    for (int i = 0; i < VFS_PAGES; i++) {
+        if (pages[i].inode) used++;
+    }
+    
+    terminal_print("\nMontagens:\n");
+    for (int i = 0; i < mount_count; i++) {
+        terminal_print("  ");
+        terminal_print(mounts[i].prefix);
+        for (uint32_t j = mounts[i].prefix_len; j < VFS_MOUNT_LEN; j++) {
+            terminal_print(" ");
+        }
+        terminal_print(mounts[i].ops->name);
+        terminal_print("\n");
+    }
+    
+    terminal_print("Page cache:\n");
+    terminal_print("  Paginas: ");
+    terminal_print_dec(used);
+    terminal_print("/");
+    terminal_print_dec(VFS_PAGES);
+    terminal_print(" em uso (4 KB cada)\n");
+    terminal_print("  Acertos: ");
+    terminal_print_dec(stats.page_hits);
+    terminal_print("  Faltas: ");
+    terminal_print_dec(stats.page_misses);
+    terminal_print("  Taxa de acerto: ");
+    terminal_print_dec(lookups ? (stats.page_hits * 100) / lookups : 0);
+    terminal_print("%\n");
+    terminal_print("  Despejos: ");
+    terminal_print_dec(stats.page_evictions);
+    terminal_print("\n");
+    
+    terminal_print("Inodes: ");
+    terminal_print_dec(cached);
+    terminal_print(" em memoria, ");
+    terminal_print_dec(open);
+    terminal_print(" abertos, ");
+    terminal_print_dec(stats.inode_evictions);
+    terminal_print(" despejados\n");
+    terminal_print("Dentries: ");
+    terminal_print_dec(stats.dentry_hits);
+    terminal_print(" acertos, ");
+    terminal_print_dec(stats.dentry_misses);
+    terminal_print(" faltas (");
+    terminal_print_dec(stats.dentry_stale);
+    terminal_print(" invalidadas)\n");
+}
@@ -0,0 +1,431 @@
+// ============================================================================
+// NanoOS - Driver Virtio-blk
+// Disco paravirtualizado do QEMU/KVM: uma requisição por slot do anel
+// (descritores indiretos) e notificações suprimidas por EVENT_IDX
+// ============================================================================
+
+#include "../../include/virtio_blk.h"
+#include "../../include/virtio.h"
+#include "../../include/pci.h"
+#include "../../include/kernel.h"
+#include "../../include/blockdev.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// ESTRUTURAS INTERNAS
+// ============================================================================
+
+// Requisição em voo: cabeçalho, status e tabela indireta próprios
+typedef struct {
+    virtio_blk_req_header_t header;
+    volatile uint8_t status;
+    virtq_desc_t table[3] __attribute__((aligned(16)));  // header, dados, status
+    virtio_blk_callback_t callback;
+    void* ctx;
+} virtio_blk_request_t;
+
+// ============================================================================
+// VARIÁVEIS GLOBAIS
+// ============================================================================
+
+static int blk_available = 0;
+static uint16_t blk_io_base = 0;
+static uint32_t blk_sectors = 0;
+static uint32_t blk_features = 0;
+static virtqueue_t blk_queue;
+static uint8_t blk_ring[VIRTQ_RING_BYTES(VIRTQ_MAX_SIZE)] __attribute__((aligned(4096)));
+static virtio_blk_request_t blk_requests[VIRTIO_BLK_MAX_INFLIGHT] __attribute__((aligned(16)));
+static volatile uint32_t blk_slots_busy = 0;
+static uint32_t blk_completed = 0;
+static uint32_t blk_errors = 0;
+
+// ============================================================================
+// CONCLUSÃO
+// ============================================================================
+
+// Colhe requisições concluídas (interrupções desabilitadas)
+static int virtio_blk_reap(void) {
+    virtio_blk_request_t* req;
+    int done = 0;
+    
+    while ((req = (virtio_blk_request_t*)virtq_get_used(&blk_queue, 0)) != 0) {
+        int status = (req->status == VIRTIO_BLK_S_OK) ? 0 : -1;
+        virtio_blk_callback_t callback = req->callback;
+        void* ctx = req->ctx;
+        
+        blk_slots_busy &= ~(1u << (req - blk_requests));
+        
+        if (status == 0) {
+            blk_completed++;
+        } else {
+            blk_errors++;
+        }
+        
+        if (callback) {
+            callback(status, ctx);
+        }
+        done++;
+    }
+    
+    return done;
+}
+
+// Reinicia o dispositivo após uma requisição sem resposta: o reset
+// interrompe o DMA e tudo o que estava em voo falha com -1
+// (interrupções desabilitadas)
+static void virtio_blk_reset(void) {
+    uint32_t busy = blk_slots_busy;
+    uint32_t kicks = blk_queue.kicks;
+    uint32_t suppressed = blk_queue.kicks_suppressed;
+    
+    outb(blk_io_base + VIRTIO_REG_DEVICE_STATUS, 0);
+    virtio_set_status(blk_io_base, VIRTIO_STATUS_ACKNOWLEDGE);
+    virtio_set_status(blk_io_base, VIRTIO_STATUS_DRIVER);
+    outl(blk_io_base + VIRTIO_REG_GUEST_FEATURES, blk_features);
+    
+    virtq_init(&blk_queue, blk_io_base, 0, blk_ring, sizeof(blk_ring),
+               (blk_features & VIRTIO_RING_F_EVENT_IDX) ? 1 : 0);
+    blk_queue.kicks = kicks;
+    blk_queue.kicks_suppressed = suppressed;
+    virtq_enable_interrupts(&blk_queue);
+    virtio_set_status(blk_io_base, VIRTIO_STATUS_DRIVER_OK);
+    
+    // Os slots ficam livres antes dos callbacks, que podem resubmeter
+    blk_slots_busy = 0;
+    while (busy) {
+        virtio_blk_request_t* req = &blk_requests[__builtin_ctz(busy)];
+        busy &= busy - 1;
+        
+        blk_errors++;
+        if (req->callback) {
+            req->callback(-1, req->ctx);
+        }
+    }
+}
+
+// Handler da IRQ legada: ler o ISR também confirma a interrupção
+static void virtio_blk_irq_handler(void) {
+    if (virtio_read_isr(blk_io_base) & 1) {
+        virtio_blk_reap();
+    }
+}
+
+// Colhe conclusões por polling
+int virtio_blk_poll(void) {
+    uint32_t flags = irq_save();
+    int done = virtio_blk_reap();
+    irq_restore(flags);
+    return done;
+}
+
+// ============================================================================
+// SUBMISSÃO
+// ============================================================================
+
+// Enfileira uma requisição sem notificar o dispositivo (ver virtio_blk_kick)
+static int virtio_blk_enqueue(uint32_t type, uint32_t lba, uint32_t count, void* buffer,
+                              int write, virtio_blk_callback_t callback, void* ctx) {
+    uint32_t flags = irq_save();
+    uint32_t free = ~blk_slots_busy;
+    
+    if (free == 0) {
+        irq_restore(flags);
+        return -1;
+    }
+    
+    int slot = __builtin_ctz(free);
+    virtio_blk_request_t* req = &blk_requests[slot];
+    
+    req->header.type = type;
+    req->header.reserved = 0;
+    req->header.sector_low = lba;
+    req->header.sector_high = 0;
+    req->status = 0xFF;
+    req->callback = callback;
+    req->ctx = ctx;
+    
+    uint16_t n = 0;
+    int result;
+    
+    if (blk_features & VIRTIO_RING_F_INDIRECT_DESC) {
+        // Tabela indireta: a requisição inteira ocupa um único slot do anel
+        req->table[n].addr = (uint32_t)&req->header;
+        req->table[n].len = sizeof(req->header);
+        req->table[n++].flags = 0;
+        if (count > 0) {
+            req->table[n].addr = (uint32_t)buffer;
+            req->table[n].len = count * 512;
+            req->table[n++].flags = write ? 0 : VIRTQ_DESC_F_WRITE;
+        }
+        req->table[n].addr = (uint32_t)&req->status;
+        req->table[n].len = 1;
+        req->table[n++].flags = VIRTQ_DESC_F_WRITE;
+        
+        result = virtq_add_indirect(&blk_queue, req->table, n, req);
+    } else {
+        virtq_buf_t bufs[3];
+        
+        bufs[n].addr = &req->header;
+        bufs[n].len = sizeof(req->header);
+        bufs[n++].device_writes = 0;
+        if (count > 0) {
+            bufs[n].addr = buffer;
+            bufs[n].len = count * 512;
+            bufs[n++].device_writes = !write;
+        }
+        bufs[n].addr = (void*)&req->status;
+        bufs[n].len = 1;
+        bufs[n++].device_writes = 1;
+        
+        result = virtq_add_chain(&blk_queue, bufs, n, req);
+    }
+    
+    if (result >= 0) {
+        blk_slots_busy |= 1u << slot;
+    }
+    
+    irq_restore(flags);
+    return result >= 0 ? slot : -1;
+}
+
+int virtio_blk_submit(uint32_t lba, uint32_t count, void* buffer, int write,
+                      virtio_blk_callback_t callback, void* ctx) {
+    if (!blk_available || count == 0 || count > VIRTIO_BLK_MAX_SECTORS) return -1;
+    if (lba + count > blk_sectors) return -1;
+    
+    return virtio_blk_enqueue(write ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN,
+                              lba, count, buffer, write, callback, ctx);
+}
+
+// Notifica o dispositivo sobre tudo o que foi enfileirado
+void virtio_blk_kick(void) {
+    uint32_t flags = irq_save();
+    virtq_kick(&blk_queue);
+    irq_restore(flags);
+}
+
+// ============================================================================
+// INTERFACE SÍNCRONA
+// ============================================================================
+
+// Callback das operações síncronas: 1 = sucesso, -1 = erro
+static void virtio_blk_sync_done(int status, void* ctx) {
+    *(volatile int*)ctx = (status == 0) ? 1 : -1;
+}
+
+// Aguarda a conclusão de uma requisição síncrona. Sem resposta no prazo,
+// o dispositivo é reiniciado e a requisição falha antes de 'result' (na
+// pilha de quem chamou) deixar de existir
+static int virtio_blk_wait(volatile int* result) {
+    uint32_t start = timer_ticks;
+    
+    while (*result == 0) {
+        virtio_blk_poll();
+        
+        if (timer_ticks - start > VIRTIO_BLK_TIMEOUT_TICKS) {
+            uint32_t flags = irq_save();
+            if (*result == 0) {
+                virtio_blk_reset();
+            }
+            irq_restore(flags);
+        }
+    }
+    return *result == 1 ? 0 : -1;
+}
+
+// Executa uma requisição síncrona
+static int virtio_blk_sync(uint32_t type, uint32_t lba, uint32_t count, void* buffer, int write) {
+    volatile int result = 0;
+    uint32_t start = timer_ticks;
+    
+    while (virtio_blk_enqueue(type, lba, count, buffer, write,
+                              virtio_blk_sync_done, (void*)&result) < 0) {
+        virtio_blk_poll();  // Sem slot livre: espera conclusões
+        
+        if (timer_ticks - start > VIRTIO_BLK_TIMEOUT_TICKS) {
+            uint32_t flags = irq_save();
+            virtio_blk_reset();
+            irq_restore(flags);
+            start = timer_ticks;
+        }
+    }
+    virtio_blk_kick();
+    return virtio_blk_wait(&result);
+}
+
+int virtio_blk_read(uint32_t lba, uint32_t count, void* buffer) {
+    if (!blk_available || lba + count > blk_sectors) return -1;
+    
+    uint8_t* buf = (uint8_t*)buffer;
+    while (count > 0) {
+        uint32_t chunk = count > VIRTIO_BLK_MAX_SECTORS ? VIRTIO_BLK_MAX_SECTORS : count;
+        if (virtio_blk_sync(VIRTIO_BLK_T_IN, lba, chunk, buf, 0) != 0) return -1;
+        lba += chunk;
+        count -= chunk;
+        buf += chunk * 512;
+    }
+    return 0;
+}
+
+int virtio_blk_write(uint32_t lba, uint32_t count, const void* buffer) {
+    if (!blk_available || lba + count > blk_sectors) return -1;
+    
+    uint8_t* buf = (uint8_t*)buffer;
+    while (count > 0) {
+        uint32_t chunk = count > VIRTIO_BLK_MAX_SECTORS ? VIRTIO_BLK_MAX_SECTORS : count;
+        if (virtio_blk_sync(VIRTIO_BLK_T_OUT, lba, chunk, buf, 1) != 0) return -1;
+        lba += chunk;
+        count -= chunk;
+        buf += chunk * 512;
+    }
+    return 0;
+}
+
+// Esvazia o cache de escrita do host (se o dispositivo oferece FLUSH)
+int virtio_blk_flush(void) {
+    if (!blk_available) return -1;
+    if (!(blk_features & VIRTIO_BLK_F_FLUSH)) return 0;
+    
+    return virtio_blk_sync(VIRTIO_BLK_T_FLUSH, 0, 0, 0, 0);
+}
+
+// ============================================================================
+// DISPOSITIVO DE BLOCO
+// ============================================================================
+
+static int virtio_blk_dev_read(blockdev_t* dev, uint32_t lba, uint32_t count, void* buffer) {
+    (void)dev;
+    return virtio_blk_read(lba, count, buffer);
+}
+
+static int virtio_blk_dev_write(blockdev_t* dev, uint32_t lba, uint32_t count, const void* buffer) {
+    (void)dev;
+    return virtio_blk_write(lba, count, buffer);
+}
+
+static int virtio_blk_dev_flush(blockdev_t* dev) {
+    (void)dev;
+    return virtio_blk_flush();
+}
+
+static int virtio_blk_dev_queue(blockdev_t* dev, uint32_t lba, uint32_t count, void* buffer,
+                                blockdev_callback_t callback, void* ctx) {
+    (void)dev;
+    return virtio_blk_submit(lba, count, buffer, 0, callback, ctx) >= 0 ? 0 : -1;
+}
+
+static void virtio_blk_dev_kick(blockdev_t* dev) {
+    (void)dev;
+    virtio_blk_kick();
+}
+
+static int virtio_blk_dev_poll(blockdev_t* dev) {
+    (void)dev;
+    return virtio_blk_poll();
+}
+
+static const blockdev_ops_t virtio_blk_ops = {
+    .read = virtio_blk_dev_read,
+    .write = virtio_blk_dev_write,
+    .flush = virtio_blk_dev_flush,
+    .queue = virtio_blk_dev_queue,
+    .kick = virtio_blk_dev_kick,
+    .poll = virtio_blk_dev_poll,
+};
+
+// ============================================================================
+// INICIALIZAÇÃO
+// ============================================================================
+
+// Probe do virtio-blk (transporte legado); só o primeiro disco é usado
+static int virtio_blk_probe(pci_device_t* dev, const pci_device_id_t* id) {
+    (void)id;
+    
+    if (blk_available) return -1;
+    if (virtio_pci_setup(&dev->addr, &blk_io_base) != 0) {
+        terminal_print("virtio-blk: BAR0 de I/O ausente\n");
+        return -1;
+    }
+    
+    blk_features = virtio_negotiate(blk_io_base, VIRTIO_RING_F_INDIRECT_DESC |
+                                                 VIRTIO_RING_F_EVENT_IDX |
+                                                 VIRTIO_BLK_F_FLUSH);
+    
+    if (virtq_init(&blk_queue, blk_io_base, 0, blk_ring, sizeof(blk_ring),
+                   (blk_features & VIRTIO_RING_F_EVENT_IDX) ? 1 : 0) != 0) {
+        terminal_print("virtio-blk: fila 0 invalida\n");
+        virtio_set_status(blk_io_base, VIRTIO_STATUS_FAILED);
+        return -1;
+    }
+    
+    // Capacidade (usa os 32 bits inferiores: até 2 TB)
+    uint16_t cfg = blk_io_base + VIRTIO_REG_DEVICE_CONFIG;
+    blk_sectors = inl(cfg + VIRTIO_BLK_CFG_CAPACITY);
+    if (inl(cfg + VIRTIO_BLK_CFG_CAPACITY + 4) != 0) {
+        blk_sectors = 0xFFFFFFFF;
+    }
+    
+    irq_register_handler(dev->irq_line, virtio_blk_irq_handler);
+    virtq_enable_interrupts(&blk_queue);
+    
+    virtio_set_status(blk_io_base, VIRTIO_STATUS_DRIVER_OK);
+    blk_available = 1;
+    blockdev_register("vda", blk_sectors, &virtio_blk_ops, 0);
+    
+    terminal_print("Disco virtio-blk: ");
+    terminal_print_dec(blk_sectors / 2048);
+    terminal_print(" MB\n");
+    return 0;
+}
+
+static const pci_device_id_t virtio_blk_pci_ids[] = {
+    { VIRTIO_PCI_VENDOR, VIRTIO_PCI_DEVICE_BLK, PCI_ANY_ID, PCI_ANY_ID },
+    { 0, 0, 0, 0 }
+};
+
+static const pci_driver_t virtio_blk_pci_driver = {
+    .name = "virtio-blk",
+    .ids = virtio_blk_pci_ids,
+    .probe = virtio_blk_probe,
+};
+
+// Registra o driver no PCI
+int virtio_blk_init(void) {
+    return pci_register_driver(&virtio_blk_pci_driver) > 0 ? 0 : -1;
+}
+
+int virtio_blk_available(void) {
+    return blk_available;
+}
+
+uint32_t virtio_blk_sectors(void) {
+    return blk_sectors;
+}
+
+// Mostra features negociadas e contadores da fila
+void virtio_blk_print_info(void) {
+    if (!blk_available) {
+        terminal_print("virtio-blk: nao disponivel\n");
+        return;
+    }
+    
+    terminal_print("virtio-blk: ");
+    terminal_print_dec(blk_sectors / 2048);
+    terminal_print(" MB, fila de ");
+    terminal_print_dec(blk_queue.size);
+    terminal_print(" entradas\n");
+    terminal_print("  Descritores indiretos: ");
+    terminal_print((blk_features & VIRTIO_RING_F_INDIRECT_DESC) ? "sim\n" : "nao\n");
+    terminal_print("  EVENT_IDX: ");
+    terminal_print((blk_features & VIRTIO_RING_F_EVENT_IDX) ? "sim\n" : "nao\n");
+    terminal_print("  Requisicoes: ");
+    terminal_print_dec(blk_completed);
+    terminal_print(" (erros: ");
+    terminal_print_dec(blk_errors);
+    terminal_print(")\n  Notificacoes: ");
+    terminal_print_dec(blk_queue.kicks);
+    terminal_print(" enviadas, ");
+    terminal_print_dec(blk_queue.kicks_suppressed);
+    terminal_print(" suprimidas\n");
+}
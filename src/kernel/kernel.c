@@ -8,6 +8,16 @@
 #include <stddef.h>
 #include "../include/commands.h"
 #include "../include/network.h"
+#include "../include/ata.h"
+#include "../include/ramdisk.h"
+#include "../include/ahci.h"
+#include "../include/virtio_blk.h"
+#include "../include/filesystem.h"
+#include "../include/bcache.h"
+#include "../include/vfs.h"
+#include "../include/tmpfs.h"
+#include "../include/pci.h"
+#include "../include/netdev.h"
 
 // ============================================================================
 // CONFIGURAÇÕES DE HARDWARE
@@ -22,6 +32,7 @@
 #define KEYBOARD_DATA_PORT 0x60     // Porta de dados do teclado
 #define KEYBOARD_STATUS_PORT 0x64   // Porta de status do teclado
 #define KEYBOARD_IRQ 1              // IRQ do teclado
+#define KEYBOARD_QUEUE_SIZE 64      // Scancodes à espera (potência de 2)
 
 // Portas para PIC (Programmable Interrupt Controller)
 #define PIC1_COMMAND 0x20
@@ -35,6 +46,7 @@
 #define TIMER_IRQ 0
 #define TIMER_FREQUENCY 100         // 100 Hz (10ms por tick)
 #define PIT_BASE_FREQUENCY 1193180  // Frequência base do PIT
+#define TSC_CALIBRATION_TICKS 5     // 50 ms contra o PIT
 
 // IDT (Interrupt Descriptor Table)
 #define IDT_SIZE 256
@@ -47,6 +59,10 @@
 void handle_keypress(uint8_t scancode);
 void shutdown_system(void);
 
+// Tipo dos handlers de IRQ registrados por drivers
+typedef void (*irq_handler_t)(void);
+#define IRQ_MAX_SHARED 4    // Handlers por linha (INTx do PCI é compartilhada)
+
 // ============================================================================
 // ESTRUTURAS DE DADOS
 // ============================================================================
@@ -103,6 +119,17 @@ static char input_buffer[256];        // Buffer para comandos digitados
 static size_t input_pos = 0;         // Posição atual no buffer
 static int quit_sequence = 0;        // Contador para sequência de saída
 
+// Scancodes enfileirados pela ISR e tratados (com o eco) no loop
+// principal; durante um comando as teclas esperam aqui sem misturar com
+// a saída dele
+static volatile uint8_t key_queue[KEYBOARD_QUEUE_SIZE];
+static volatile uint32_t key_head = 0; // Próxima posição escrita pela ISR
+static volatile uint32_t key_tail = 0; // Próxima posição lida pelo loop
+
+// Comando pendente (executado no loop principal)
+static char command_buffer[256];     // Cópia do comando confirmado com Enter
+static volatile int command_ready = 0; // 1 = comando aguardando execução
+
 // Timer
 volatile uint32_t timer_ticks = 0;     // Contador do timer (volatile para ISR)
 
@@ -112,6 +139,10 @@ static gdt_ptr gp;                   // Ponteiro para a GDT
 static idt_entry idt_table[IDT_SIZE]; // Tabela IDT
 static idt_ptr idtp;                 // Ponteiro para a IDT
 
+// Handlers de IRQ de dispositivos (IRQ 2-15). Linhas PCI são compartilhadas:
+// cada handler confere o status do próprio dispositivo
+static irq_handler_t irq_handlers[16][IRQ_MAX_SHARED];
+
 // ============================================================================
 // MAPA DE TECLADO US (Scancode para ASCII)
 // ============================================================================
@@ -282,6 +313,15 @@ void memory_copy(void* dst, const void* src, size_t n) {
     }
 }
 
+// Preenche 'n' bytes com 'value'
+void memory_set(void* dst, uint8_t value, size_t n) {
+    unsigned char* d = (unsigned char*)dst;
+    
+    for (size_t i = 0; i < n; i++) {
+        d[i] = value;
+    }
+}
+
 // Imprime número decimal
 void terminal_print_dec(uint32_t num) {
     char buffer[16];
@@ -289,6 +329,20 @@ void terminal_print_dec(uint32_t num) {
     terminal_print(buffer);
 }
 
+// Imprime 'num' em hexadecimal com 'digits' dígitos (sem prefixo)
+void terminal_print_hex(uint32_t num, int digits) {
+    static const char hex[] = "0123456789abcdef";
+    char buffer[9];
+    
+    if (digits > 8) digits = 8;
+    for (int i = digits - 1; i >= 0; i--) {
+        buffer[i] = hex[num & 0xF];
+        num >>= 4;
+    }
+    buffer[digits] = '\0';
+    terminal_print(buffer);
+}
+
 // ============================================================================
 // FUNÇÕES DO TERMINAL VGA
 // ============================================================================
@@ -448,6 +502,28 @@ extern void idt_load(uint32_t);
 // Handlers externos de interrupção (definidos em assembly)
 extern void irq0_handler(void);  // Timer
 extern void irq1_handler(void);  // Teclado
+extern void irq2_handler(void);  // IRQs 2-15: stubs genéricos (irq_dispatch)
+extern void irq3_handler(void);
+extern void irq4_handler(void);
+extern void irq5_handler(void);
+extern void irq6_handler(void);
+extern void irq7_handler(void);
+extern void irq8_handler(void);
+extern void irq9_handler(void);
+extern void irq10_handler(void);
+extern void irq11_handler(void);
+extern void irq12_handler(void);
+extern void irq13_handler(void);
+extern void irq14_handler(void);
+extern void irq15_handler(void);
+
+// Tabela dos stubs genéricos, indexada pelo número da IRQ
+static void (*const irq_stubs[16])(void) = {
+    0, 0, irq2_handler, irq3_handler, irq4_handler, irq5_handler,
+    irq6_handler, irq7_handler, irq8_handler, irq9_handler,
+    irq10_handler, irq11_handler, irq12_handler, irq13_handler,
+    irq14_handler, irq15_handler
+};
 
 // Inicializa a IDT completa
 void idt_init(void) {
@@ -468,6 +544,11 @@ void idt_init(void) {
     idt_set_gate(0x20, (uint32_t)irq0_handler, 0x08, 0x8E);  // Timer (IRQ 0)
     idt_set_gate(0x21, (uint32_t)irq1_handler, 0x08, 0x8E);  // Teclado (IRQ 1)
     
+    // IRQs 2-15: ficam mascaradas até um driver registrar um handler
+    for (int irq = 2; irq < 16; irq++) {
+        idt_set_gate(0x20 + irq, (uint32_t)irq_stubs[irq], 0x08, 0x8E);
+    }
+    
     // Habilita IRQ 0 (timer) e IRQ 1 (teclado) no PIC
     // 0xFC = 11111100b (apenas bits 0 e 1 em 0 = habilitados)
     outb(PIC1_DATA, 0xFC);
@@ -490,13 +571,57 @@ void timer_handler(void) {
     pic_send_eoi(0);
 }
 
-// Handler do teclado (IRQ 1) - chamado quando uma tecla é pressionada/solta
+// Handler do teclado (IRQ 1) - só enfileira o scancode; com a fila cheia
+// a tecla é descartada
 void keyboard_handler(void) {
     uint8_t scancode = inb(KEYBOARD_DATA_PORT);
-    handle_keypress(scancode);
+    
+    if (key_head - key_tail < KEYBOARD_QUEUE_SIZE) {
+        key_queue[key_head & (KEYBOARD_QUEUE_SIZE - 1)] = scancode;
+        key_head++;
+    }
     pic_send_eoi(1);
 }
 
+// Trata as teclas enfileiradas (loop principal). Para no Enter: o que
+// foi digitado depois fica para o próximo prompt
+static void keyboard_process(void) {
+    while (key_tail != key_head && !command_ready) {
+        uint8_t scancode = key_queue[key_tail & (KEYBOARD_QUEUE_SIZE - 1)];
+        key_tail++;
+        handle_keypress(scancode);
+    }
+}
+
+// Despacha IRQs 2-15 para o handler registrado pelo driver
+void irq_dispatch(uint32_t irq) {
+    if (irq >= 16) return;
+    
+    for (int i = 0; i < IRQ_MAX_SHARED && irq_handlers[irq][i]; i++) {
+        irq_handlers[irq][i]();
+    }
+    pic_send_eoi(irq);
+}
+
+// Acrescenta um handler à IRQ e desmascara a linha no PIC
+int irq_register_handler(uint8_t irq, irq_handler_t handler) {
+    if (irq <= 2 || irq >= 16 || !handler) return -1;  // IRQ 2 = cascata
+    
+    int slot = 0;
+    while (slot < IRQ_MAX_SHARED && irq_handlers[irq][slot]) slot++;
+    if (slot == IRQ_MAX_SHARED) return -1;
+    
+    irq_handlers[irq][slot] = handler;
+    
+    if (irq < 8) {
+        outb(PIC1_DATA, inb(PIC1_DATA) & ~(1 << irq));
+    } else {
+        outb(PIC2_DATA, inb(PIC2_DATA) & ~(1 << (irq - 8)));
+        outb(PIC1_DATA, inb(PIC1_DATA) & ~(1 << 2));  // Libera a cascata
+    }
+    return 0;
+}
+
 // ============================================================================
 // FUNÇÃO DE ENCERRAMENTO DO SISTEMA
 // ============================================================================
@@ -519,7 +644,7 @@ void shutdown_system(void) {
 // FUNÇÕES DO TECLADO
 // ============================================================================
 
-// Processa uma tecla pressionada
+// Processa uma tecla pressionada (fora da ISR, ver keyboard_process)
 void handle_keypress(uint8_t scancode) {
     // Ignora teclas liberadas (bit 7 = 1)
     if (scancode & 0x80) return;
@@ -557,7 +682,7 @@ void handle_keypress(uint8_t scancode) {
     }
     
     if (key == '\n') {
-        // Enter - processa comando
+        // Enter - entrega o comando ao loop principal
         terminal_putchar('\n');
         
         if (input_pos < sizeof(input_buffer)) {
@@ -566,9 +691,11 @@ void handle_keypress(uint8_t scancode) {
             input_buffer[sizeof(input_buffer) - 1] = '\0';
         }
         
-        process_command(input_buffer);
+        // Comandos rodam com interrupções habilitadas para que timer e
+        // IRQs de dispositivos continuem sendo atendidos durante a execução
+        memory_copy(command_buffer, input_buffer, input_pos + 1);
         input_pos = 0;
-        terminal_print("> ");
+        command_ready = 1;
     } else if (key == '\b') {
         // Backspace
         if (input_pos > 0) {
@@ -599,6 +726,56 @@ void timer_init(void) {
     outb(TIMER_DATA_PORT, (divisor >> 8) & 0xFF);
 }
 
+// ============================================================================
+// RELÓGIO DE ALTA RESOLUÇÃO (TSC)
+// ============================================================================
+
+// Ciclos do TSC por milissegundo (0 = não calibrado)
+uint32_t tsc_khz = 0;
+
+// Contador de ciclos do processador
+uint64_t tsc_read(void) {
+    uint32_t low, high;
+    __asm__ volatile ("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t)high << 32) | low;
+}
+
+// Divisão 64/32 com duas instruções div (sem a libgcc)
+uint64_t div64_32(uint64_t dividend, uint32_t divisor) {
+    uint32_t high = dividend >> 32;
+    uint32_t low = (uint32_t)dividend;
+    uint32_t quotient_high = high / divisor;
+    uint32_t rem = high % divisor;
+    uint32_t quotient_low;
+    
+    __asm__ ("div %2" : "=a"(quotient_low), "=d"(rem) : "rm"(divisor), "a"(low), "d"(rem));
+    return ((uint64_t)quotient_high << 32) | quotient_low;
+}
+
+// Mede o TSC contra o PIT (precisa de interrupções habilitadas)
+void tsc_calibrate(void) {
+    uint32_t start = timer_ticks;
+    
+    while (timer_ticks == start);  // Alinha no começo de um tick
+    
+    uint64_t begin = tsc_read();
+    start = timer_ticks;
+    while (timer_ticks - start < TSC_CALIBRATION_TICKS);
+    uint64_t cycles = tsc_read() - begin;
+    
+    tsc_khz = (uint32_t)div64_32(cycles, TSC_CALIBRATION_TICKS * (1000 / TIMER_FREQUENCY));
+    if (tsc_khz == 0) tsc_khz = 1;
+}
+
+// Conversões de ciclos (intervalos de até ~1 hora a 4 GHz)
+uint32_t tsc_to_us(uint64_t cycles) {
+    return (uint32_t)div64_32(cycles * 1000, tsc_khz);
+}
+
+uint32_t tsc_to_ns(uint64_t cycles) {
+    return (uint32_t)div64_32(cycles * 1000000, tsc_khz);
+}
+
 // Stub de inicialização do teclado (a inicialização real está na idt_init)
 void keyboard_init(void) {
     // A configuração real do teclado acontece em idt_init()
@@ -609,14 +786,24 @@ void keyboard_init(void) {
 // FUNÇÃO PRINCIPAL DO KERNEL
 // ============================================================================
 
-void kernel_main(void) {
+void kernel_main(uint32_t magic, multiboot_info_t* mbi) {
     // Inicialização do sistema em ordem
     terminal_init();     // 1. Inicializa o terminal VGA
     gdt_init();         // 2. Configura a GDT (segmentação)
     timer_init();       // 3. Inicializa o timer (PIT)
     idt_init();         // 4. Configura IDT e habilita interrupções
     keyboard_init();    // 5. Stub de inicialização do teclado
-    network_init();     // 6. Inicializa o subsistema de rede
+    tsc_calibrate();    // 6. Calibra o TSC contra o PIT
+    pci_init();         // 7. Enumera o barramento PCI
+    network_init();     // 8. Inicializa o subsistema de rede
+    ramdisk_init(magic, mbi); // 9. RAM disk a partir do módulo Multiboot
+    ata_init();         // 10. Detecta discos IDE (dois canais)
+    ahci_init();        // 11. Detecta controlador AHCI (SATA)
+    virtio_blk_init();  // 12. Detecta disco virtio-blk
+    bcache_init();      // 13. Inicializa o cache de blocos
+    vfs_init();         // 14. Inicializa o VFS e o page cache
+    fs_init();          // 15. Monta o FAT em / (ram0, vda, hda...)
+    tmpfs_init();       // 16. Monta o tmpfs em /tmp
     
     // Mensagem de boas-vindas
     terminal_print("Bem-vindo ao NanoOS!\n\n");
@@ -624,8 +811,27 @@ void kernel_main(void) {
     terminal_print("> ");
     
     // Loop principal do kernel
-    // O processador fica em halt até receber uma interrupção
+    // O processador fica em halt até receber uma interrupção e então
+    // executa o comando pendente (se houver) com interrupções habilitadas.
+    // Com recepção de rede ou teclas pendentes não há halt. O teste roda
+    // com interrupções desligadas e "sti; hlt" é atômico, então uma IRQ
+    // que agende trabalho logo antes do halt ainda o acorda
     while (1) {
-        __asm__ volatile ("hlt");
+        __asm__ volatile ("cli");
+        if (netdev_poll_pending() || key_tail != key_head) {
+            __asm__ volatile ("sti");
+        } else {
+            __asm__ volatile ("sti\n\thlt");
+        }
+        
+        network_process_packets();  // Recepção agendada pelas placas
+        bcache_flush_expired();     // Write-back de blocos sujos antigos
+        keyboard_process();         // Eco e edição da linha digitada
+        
+        if (command_ready) {
+            process_command(command_buffer);
+            terminal_print("> ");
+            command_ready = 0;
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,516 @@
+// ============================================================================
+// NanoOS - Barramento PCI
+// Acesso ao espaço de configuração via mecanismo #1 (portas 0xCF8/0xCFC),
+// enumeração com cache, capabilities e associação de drivers
+// ============================================================================
+
+#include "../../include/pci.h"
+#include "../../include/kernel.h"
+#include <stdint.h>
+
+// ============================================================================
+// ACESSO AO ESPAÇO DE CONFIGURAÇÃO
+// ============================================================================
+
+// Monta o endereço de configuração (bit 31 = enable)
+static inline uint32_t pci_config_address(const pci_address_t* addr, uint8_t offset) {
+    return 0x80000000u |
+           ((uint32_t)addr->bus << 16) |
+           ((uint32_t)(addr->device & 0x1F) << 11) |
+           ((uint32_t)(addr->function & 0x07) << 8) |
+           (offset & 0xFC);
+}
+
+uint32_t pci_config_read32(const pci_address_t* addr, uint8_t offset) {
+    outl(PCI_CONFIG_ADDRESS, pci_config_address(addr, offset));
+    return inl(PCI_CONFIG_DATA);
+}
+
+uint16_t pci_config_read16(const pci_address_t* addr, uint8_t offset) {
+    uint32_t value = pci_config_read32(addr, offset);
+    return (value >> ((offset & 2) * 8)) & 0xFFFF;
+}
+
+uint8_t pci_config_read8(const pci_address_t* addr, uint8_t offset) {
+    uint32_t value = pci_config_read32(addr, offset);
+    return (value >> ((offset & 3) * 8)) & 0xFF;
+}
+
+void pci_config_write32(const pci_address_t* addr, uint8_t offset, uint32_t value) {
+    outl(PCI_CONFIG_ADDRESS, pci_config_address(addr, offset));
+    outl(PCI_CONFIG_DATA, value);
+}
+
+void pci_config_write16(const pci_address_t* addr, uint8_t offset, uint16_t value) {
+    uint32_t old = pci_config_read32(addr, offset);
+    uint32_t shift = (offset & 2) * 8;
+    
+    old &= ~(0xFFFFu << shift);
+    old |= (uint32_t)value << shift;
+    pci_config_write32(addr, offset, old);
+}
+
+// ============================================================================
+// ENUMERAÇÃO
+// ============================================================================
+
+static pci_device_t pci_devices[PCI_MAX_DEVICES];
+static uint32_t pci_count = 0;
+static int pci_scanned = 0;
+static uint32_t pci_bus_seen[256 / 32];    // Evita varrer um barramento duas vezes
+
+static void pci_scan_bus(uint8_t bus);
+
+// Mede os BARs escrevendo 1s e lendo a máscara de volta, com a decodificação
+// desligada para o dispositivo não responder no endereço provisório
+static void pci_size_bars(pci_device_t* dev) {
+    const pci_address_t* addr = &dev->addr;
+    int count = (dev->header_type & PCI_HEADER_TYPE_MASK) == PCI_HEADER_NORMAL ? 6 : 2;
+    uint16_t cmd = pci_config_read16(addr, PCI_COMMAND);
+    
+    pci_config_write16(addr, PCI_COMMAND, cmd & ~(PCI_CMD_IO_SPACE | PCI_CMD_MEM_SPACE));
+    
+    for (int i = 0; i < count; i++) {
+        uint8_t offset = PCI_BAR0 + i * 4;
+        uint32_t value = pci_config_read32(addr, offset);
+        
+        pci_config_write32(addr, offset, 0xFFFFFFFF);
+        uint32_t mask = pci_config_read32(addr, offset);
+        pci_config_write32(addr, offset, value);
+        
+        if (mask == 0) continue;  // Não implementado
+        
+        if (value & 1) {
+            dev->bar_flags[i] = PCI_BAR_IO;
+            dev->bar[i] = value & ~0x3u;
+            dev->bar_size[i] = (~(mask & ~0x3u) + 1) & 0xFFFF;
+            continue;
+        }
+        
+        dev->bar[i] = value & ~0xFu;
+        dev->bar_size[i] = ~(mask & ~0xFu) + 1;
+        if (value & 0x08) dev->bar_flags[i] |= PCI_BAR_PREFETCH;
+        
+        // BAR de 64 bits: o seguinte guarda a metade alta
+        if (((value >> 1) & 0x3) == 0x2 && i + 1 < count) {
+            dev->bar_flags[i] |= PCI_BAR_MEM64;
+            if (pci_config_read32(addr, offset + 4) != 0) {
+                dev->bar_size[i] = 0;  // Acima de 4 GB: inalcançável sem paginação
+            }
+            i++;
+        }
+    }
+    
+    pci_config_write16(addr, PCI_COMMAND, cmd);
+}
+
+// Percorre a lista de capabilities, guardando PM, MSI e MSI-X à parte
+static void pci_parse_caps(pci_device_t* dev) {
+    const pci_address_t* addr = &dev->addr;
+    
+    if (!(pci_config_read16(addr, PCI_STATUS) & PCI_STATUS_CAP_LIST)) return;
+    
+    uint8_t ptr = pci_config_read8(addr, PCI_CAP_POINTER) & 0xFC;
+    
+    // Limite de passos contra listas circulares
+    for (int steps = 0; ptr >= 0x40 && steps < 48; steps++) {
+        uint8_t id = pci_config_read8(addr, ptr);
+        
+        if (dev->cap_count < PCI_MAX_CAPS) {
+            dev->caps[dev->cap_count].id = id;
+            dev->caps[dev->cap_count].offset = ptr;
+            dev->cap_count++;
+        }
+        
+        if (id == PCI_CAP_ID_PM) {
+            dev->pm_cap = ptr;
+        } else if (id == PCI_CAP_ID_MSI) {
+            uint16_t ctrl = pci_config_read16(addr, ptr + PCI_MSI_CTRL);
+            dev->msi_cap = ptr;
+            dev->msi_vectors = 1 << ((ctrl >> PCI_MSI_CTRL_MMC_SHIFT) & 0x7);
+        } else if (id == PCI_CAP_ID_MSIX) {
+            uint16_t ctrl = pci_config_read16(addr, ptr + PCI_MSIX_CTRL);
+            dev->msix_cap = ptr;
+            dev->msix_vectors = (ctrl & PCI_MSIX_CTRL_SIZE) + 1;
+        }
+        
+        ptr = pci_config_read8(addr, ptr + 1) & 0xFC;
+    }
+}
+
+// Guarda uma função na tabela; pontes levam à varredura do barramento
+// secundário
+static void pci_scan_function(const pci_address_t* addr) {
+    if (pci_count >= PCI_MAX_DEVICES) return;
+    
+    pci_device_t* dev = &pci_devices[pci_count++];
+    uint32_t id = pci_config_read32(addr, PCI_VENDOR_ID);
+    uint32_t class_rev = pci_config_read32(addr, PCI_REVISION_ID);
+    
+    memory_set(dev, 0, sizeof(pci_device_t));
+    dev->addr = *addr;
+    dev->vendor_id = id & 0xFFFF;
+    dev->device_id = id >> 16;
+    dev->revision = class_rev & 0xFF;
+    dev->prog_if = (class_rev >> 8) & 0xFF;
+    dev->subclass = (class_rev >> 16) & 0xFF;
+    dev->class_code = class_rev >> 24;
+    dev->header_type = pci_config_read8(addr, PCI_HEADER_TYPE);
+    dev->irq_line = pci_config_read8(addr, PCI_INTERRUPT_LINE);
+    dev->irq_pin = pci_config_read8(addr, PCI_INTERRUPT_PIN);
+    
+    if ((dev->header_type & PCI_HEADER_TYPE_MASK) == PCI_HEADER_NORMAL) {
+        dev->subsys_vendor = pci_config_read16(addr, PCI_SUBSYS_VENDOR_ID);
+        dev->subsys_id = pci_config_read16(addr, PCI_SUBSYS_ID);
+    }
+    
+    pci_size_bars(dev);
+    pci_parse_caps(dev);
+    
+    if ((dev->header_type & PCI_HEADER_TYPE_MASK) == PCI_HEADER_BRIDGE &&
+        dev->class_code == PCI_CLASS_BRIDGE && dev->subclass == PCI_SUBCLASS_PCI_BRIDGE) {
+        uint8_t secondary = pci_config_read8(addr, PCI_SECONDARY_BUS);
+        if (secondary != 0) pci_scan_bus(secondary);
+    }
+}
+
+static void pci_scan_bus(uint8_t bus) {
+    pci_address_t addr;
+    
+    if (pci_bus_seen[bus / 32] & (1u << (bus % 32))) return;
+    pci_bus_seen[bus / 32] |= 1u << (bus % 32);
+    
+    addr.bus = bus;
+    for (uint32_t dev = 0; dev < 32; dev++) {
+        addr.device = dev;
+        addr.function = 0;
+        
+        if (pci_config_read16(&addr, PCI_VENDOR_ID) == PCI_VENDOR_NONE) continue;
+        pci_scan_function(&addr);
+        
+        // Dispositivo de função única
+        if (!(pci_config_read8(&addr, PCI_HEADER_TYPE) & PCI_HEADER_MULTI_FUNC)) continue;
+        
+        for (uint32_t func = 1; func < 8; func++) {
+            addr.function = func;
+            if (pci_config_read16(&addr, PCI_VENDOR_ID) != PCI_VENDOR_NONE) {
+                pci_scan_function(&addr);
+            }
+        }
+    }
+}
+
+// Varre a hierarquia a partir do barramento 0, descendo pelas pontes.
+// Uma ponte host multifunção indica um controlador por função, cada um
+// com o barramento de mesmo número
+void pci_init(void) {
+    pci_address_t host = { 0, 0, 0 };
+    
+    if (pci_scanned) return;
+    pci_scanned = 1;
+    pci_count = 0;
+    
+    for (int i = 0; i < 256 / 32; i++) {
+        pci_bus_seen[i] = 0;
+    }
+    
+    if (!(pci_config_read8(&host, PCI_HEADER_TYPE) & PCI_HEADER_MULTI_FUNC)) {
+        pci_scan_bus(0);
+        return;
+    }
+    
+    for (uint32_t func = 0; func < 8; func++) {
+        host.function = func;
+        if (pci_config_read16(&host, PCI_VENDOR_ID) != PCI_VENDOR_NONE) {
+            pci_scan_bus(func);
+        }
+    }
+}
+
+uint32_t pci_device_count(void) {
+    pci_init();
+    return pci_count;
+}
+
+pci_device_t* pci_get_device(uint32_t index) {
+    pci_init();
+    return index < pci_count ? &pci_devices[index] : 0;
+}
+
+// ============================================================================
+// BUSCA DE DISPOSITIVOS
+// ============================================================================
+
+// Primeiro dispositivo com a classe pedida (prog_if 0xFF = qualquer)
+int pci_find_class(uint8_t class_code, uint8_t subclass, uint8_t prog_if, pci_address_t* out) {
+    pci_init();
+    
+    for (uint32_t i = 0; i < pci_count; i++) {
+        const pci_device_t* dev = &pci_devices[i];
+        
+        if (dev->class_code == class_code && dev->subclass == subclass &&
+            (prog_if == 0xFF || dev->prog_if == prog_if)) {
+            *out = dev->addr;
+            return 0;
+        }
+    }
+    
+    return -1;
+}
+
+// Procura um dispositivo pelo par vendor/device
+int pci_find_device(uint16_t vendor, uint16_t device, pci_address_t* out) {
+    pci_init();
+    
+    for (uint32_t i = 0; i < pci_count; i++) {
+        const pci_device_t* dev = &pci_devices[i];
+        
+        if (dev->vendor_id == vendor && dev->device_id == device) {
+            *out = dev->addr;
+            return 0;
+        }
+    }
+    
+    return -1;
+}
+
+// ============================================================================
+// CONFIGURAÇÃO
+// ============================================================================
+
+// Liga bits do registrador de comando (decodificação de I/O/memória, bus master)
+void pci_enable_device(const pci_address_t* addr, uint16_t flags) {
+    uint16_t cmd = pci_config_read16(addr, PCI_COMMAND);
+    pci_config_write16(addr, PCI_COMMAND, cmd | flags);
+}
+
+// Lê um BAR já sem os bits de tipo (I/O: bits 1:0, memória: bits 3:0)
+uint32_t pci_read_bar(const pci_address_t* addr, int bar) {
+    uint32_t value = pci_config_read32(addr, PCI_BAR0 + bar * 4);
+    
+    if (value & 1) {
+        return value & ~0x3u;   // Espaço de I/O
+    }
+    return value & ~0xFu;       // Espaço de memória
+}
+
+// Offset da capability 'id' (0 = ausente)
+uint8_t pci_find_capability(const pci_device_t* dev, uint8_t id) {
+    for (uint32_t i = 0; i < dev->cap_count; i++) {
+        if (dev->caps[i].id == id) return dev->caps[i].offset;
+    }
+    return 0;
+}
+
+// Leva o dispositivo a D0 (se tiver PM) e liga os bits de comando
+int pci_device_enable(pci_device_t* dev, uint16_t flags) {
+    if (dev->pm_cap) {
+        uint8_t pmcsr = dev->pm_cap + PCI_PM_CTRL;
+        uint16_t state = pci_config_read16(&dev->addr, pmcsr);
+        
+        if ((state & PCI_PM_STATE_MASK) != PCI_PM_STATE_D0) {
+            pci_config_write16(&dev->addr, pmcsr, state & ~PCI_PM_STATE_MASK);
+            
+            // D3hot -> D0 exige 10 ms de espera
+            uint32_t start = timer_ticks;
+            while (timer_ticks - start < 2) {
+                __asm__ volatile ("hlt");
+            }
+        }
+    }
+    
+    pci_enable_device(&dev->addr, flags);
+    return 0;
+}
+
+// ============================================================================
+// DRIVERS
+// ============================================================================
+
+static int pci_id_match(const pci_device_t* dev, const pci_device_id_t* id) {
+    return (id->vendor == PCI_ANY_ID || id->vendor == dev->vendor_id) &&
+           (id->device == PCI_ANY_ID || id->device == dev->device_id) &&
+           (id->class_code == PCI_ANY_ID || id->class_code == dev->class_code) &&
+           (id->subclass == PCI_ANY_ID || id->subclass == dev->subclass);
+}
+
+// Oferece ao driver cada dispositivo ainda sem dono cujo ID casa com a
+// tabela dele; retorna quantos ele assumiu
+int pci_register_driver(const pci_driver_t* driver) {
+    int bound = 0;
+    
+    pci_init();
+    
+    for (uint32_t i = 0; i < pci_count; i++) {
+        pci_device_t* dev = &pci_devices[i];
+        
+        if (dev->driver) continue;
+        
+        for (const pci_device_id_t* id = driver->ids; id->vendor != 0; id++) {
+            if (!pci_id_match(dev, id)) continue;
+            
+            if (driver->probe(dev, id) == 0) {
+                dev->driver = driver;
+                bound++;
+            }
+            break;
+        }
+    }
+    
+    return bound;
+}
+
+// ============================================================================
+// COMANDO LSPCI
+// ============================================================================
+
+// Nome legível da classe
+static const char* pci_class_name(uint8_t class_code, uint8_t subclass) {
+    static const struct {
+        uint8_t class_code;
+        uint8_t subclass;               // 0xFF = qualquer
+        const char* name;
+    } names[] = {
+        { 0x01, 0x01, "Controlador IDE" },
+        { 0x01, 0x06, "Controlador SATA" },
+        { 0x01, 0x00, "Controlador SCSI" },
+        { 0x01, 0xFF, "Armazenamento" },
+        { 0x02, 0x00, "Controlador Ethernet" },
+        { 0x02, 0xFF, "Controlador de rede" },
+        { 0x03, 0xFF, "Controlador de video" },
+        { 0x04, 0xFF, "Multimidia" },
+        { 0x06, 0x00, "Ponte host" },
+        { 0x06, 0x01, "Ponte ISA" },
+        { 0x06, 0x04, "Ponte PCI" },
+        { 0x06, 0x80, "Ponte" },
+        { 0x0C, 0x03, "Controlador USB" },
+        { 0x0C, 0x05, "Controlador SMBus" },
+        { 0x0C, 0xFF, "Barramento serial" },
+    };
+    
+    for (uint32_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (names[i].class_code == class_code &&
+            (names[i].subclass == 0xFF || names[i].subclass == subclass)) {
+            return names[i].name;
+        }
+    }
+    return "Outro";
+}
+
+static const char* pci_cap_name(uint8_t id) {
+    switch (id) {
+        case PCI_CAP_ID_PM:     return "PM";
+        case PCI_CAP_ID_MSI:    return "MSI";
+        case PCI_CAP_ID_VENDOR: return "Vendor";
+        case PCI_CAP_ID_PCIE:   return "PCIe";
+        case PCI_CAP_ID_MSIX:   return "MSI-X";
+        default:                return "?";
+    }
+}
+
+// Detalhes de um dispositivo: BARs e capabilities
+static void pci_print_details(const pci_device_t* dev) {
+    for (int i = 0; i < PCI_MAX_BARS; i++) {
+        if (!dev->bar_size[i]) continue;
+        
+        terminal_print("    BAR");
+        terminal_print_dec(i);
+        terminal_print(": ");
+        terminal_print((dev->bar_flags[i] & PCI_BAR_IO) ? "I/O 0x" : "mem 0x");
+        terminal_print_hex(dev->bar[i], (dev->bar_flags[i] & PCI_BAR_IO) ? 4 : 8);
+        terminal_print(", ");
+        if (dev->bar_size[i] >= 1024) {
+            terminal_print_dec(dev->bar_size[i] / 1024);
+            terminal_print(" KB");
+        } else {
+            terminal_print_dec(dev->bar_size[i]);
+            terminal_print(" bytes");
+        }
+        if (dev->bar_flags[i] & PCI_BAR_MEM64) terminal_print(", 64 bits");
+        if (dev->bar_flags[i] & PCI_BAR_PREFETCH) terminal_print(", prefetch");
+        terminal_print("\n");
+    }
+    
+    if (dev->irq_pin) {
+        terminal_print("    IRQ ");
+        terminal_print_dec(dev->irq_line);
+        terminal_print(" (INT");
+        char pin[2] = { 'A' + dev->irq_pin - 1, '\0' };
+        terminal_print(pin);
+        terminal_print("#)\n");
+    }
+    
+    if (dev->msi_cap) {
+        uint16_t ctrl = pci_config_read16(&dev->addr, dev->msi_cap + PCI_MSI_CTRL);
+        
+        terminal_print("    MSI: ");
+        terminal_print_dec(dev->msi_vectors);
+        terminal_print(" vetor(es)");
+        if (ctrl & PCI_MSI_CTRL_64BIT) terminal_print(", 64 bits");
+        if (ctrl & PCI_MSI_CTRL_MASKABLE) terminal_print(", mascaravel");
+        terminal_print((ctrl & PCI_MSI_CTRL_ENABLE) ? ", ativo\n" : ", inativo\n");
+    }
+    
+    if (dev->msix_cap) {
+        uint32_t table = pci_config_read32(&dev->addr, dev->msix_cap + PCI_MSIX_TABLE);
+        uint16_t ctrl = pci_config_read16(&dev->addr, dev->msix_cap + PCI_MSIX_CTRL);
+        
+        terminal_print("    MSI-X: ");
+        terminal_print_dec(dev->msix_vectors);
+        terminal_print(" vetor(es), tabela no BAR");
+        terminal_print_dec(table & PCI_MSIX_BIR_MASK);
+        terminal_print(" + 0x");
+        terminal_print_hex(table & ~PCI_MSIX_BIR_MASK, 4);
+        terminal_print((ctrl & PCI_MSIX_CTRL_ENABLE) ? ", ativo\n" : ", inativo\n");
+    }
+    
+    if (dev->pm_cap) {
+        uint16_t state = pci_config_read16(&dev->addr, dev->pm_cap + PCI_PM_CTRL);
+        
+        terminal_print("    PM: estado D");
+        terminal_print_dec(state & PCI_PM_STATE_MASK);
+        terminal_print("\n");
+    }
+}
+
+// Comando: lspci [-v] - dispositivos enumerados (com -v, BARs e capabilities)
+void cmd_lspci(int verbose) {
+    pci_init();
+    
+    terminal_print("\n");
+    for (uint32_t i = 0; i < pci_count; i++) {
+        const pci_device_t* dev = &pci_devices[i];
+        
+        terminal_print_hex(dev->addr.bus, 2);
+        terminal_print(":");
+        terminal_print_hex(dev->addr.device, 2);
+        terminal_print(".");
+        terminal_print_dec(dev->addr.function);
+        terminal_print(" ");
+        terminal_print_hex(dev->vendor_id, 4);
+        terminal_print(":");
+        terminal_print_hex(dev->device_id, 4);
+        terminal_print(" ");
+        terminal_print(pci_class_name(dev->class_code, dev->subclass));
+        
+        if (dev->cap_count > 0) {
+            terminal_print(" [");
+            for (uint32_t c = 0; c < dev->cap_count; c++) {
+                if (c > 0) terminal_print(" ");
+                terminal_print(pci_cap_name(dev->caps[c].id));
+            }
+            terminal_print("]");
+        }
+        if (dev->driver) {
+            terminal_print(" -> ");
+            terminal_print(dev->driver->name);
+        }
+        terminal_print("\n");
+        
+        if (verbose) pci_print_details(dev);
+    }
+    
+    terminal_print("Total: ");
+    terminal_print_dec(pci_count);
+    terminal_print(" dispositivo(s)\n");
+}
@@ -0,0 +1,262 @@
+// ============================================================================
+// NanoOS - Transporte Virtio
+// Interface PCI legada (BAR0 em I/O) e virtqueues split com descritores
+// indiretos e supressão de notificações por EVENT_IDX
+// ============================================================================
+
+#include "../../include/virtio.h"
+#include "../../include/kernel.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// FUNÇÕES AUXILIARES
+// ============================================================================
+
+// Barreira de compilador (x86 já ordena store->store e load->load)
+static inline void virtio_barrier(void) {
+    __asm__ volatile ("" : : : "memory");
+}
+
+// Barreira completa: a escrita de avail->idx precisa ficar visível antes
+// da leitura de avail_event (ordem store->load)
+static inline void virtio_full_barrier(void) {
+    __asm__ volatile ("lock add dword ptr [esp], 0" : : : "memory");
+}
+
+// used_event: último campo do anel avail (escrito pelo driver)
+static inline volatile uint16_t* virtq_used_event(virtqueue_t* vq) {
+    return (volatile uint16_t*)((uint8_t*)vq->avail + 4 + 2 * vq->size);
+}
+
+// avail_event: último campo do anel used (escrito pelo dispositivo)
+static inline volatile uint16_t* virtq_avail_event(virtqueue_t* vq) {
+    return (volatile uint16_t*)((uint8_t*)vq->used + 4 + 8 * vq->size);
+}
+
+// ============================================================================
+// DISPOSITIVO
+// ============================================================================
+
+// Habilita o dispositivo no PCI, faz reset e sinaliza ACKNOWLEDGE | DRIVER
+int virtio_pci_setup(const pci_address_t* addr, uint16_t* io_base) {
+    uint32_t bar0 = pci_config_read32(addr, PCI_BAR0);
+    
+    if (!(bar0 & 1)) return -1;  // Transporte legado usa BAR0 em I/O
+    
+    pci_enable_device(addr, PCI_CMD_IO_SPACE | PCI_CMD_BUS_MASTER);
+    *io_base = pci_read_bar(addr, 0);
+    
+    outb(*io_base + VIRTIO_REG_DEVICE_STATUS, 0);  // Reset
+    virtio_set_status(*io_base, VIRTIO_STATUS_ACKNOWLEDGE);
+    virtio_set_status(*io_base, VIRTIO_STATUS_DRIVER);
+    return 0;
+}
+
+// Aceita as features oferecidas que o driver suporta
+uint32_t virtio_negotiate(uint16_t io_base, uint32_t supported) {
+    uint32_t features = inl(io_base + VIRTIO_REG_DEVICE_FEATURES) & supported;
+    outl(io_base + VIRTIO_REG_GUEST_FEATURES, features);
+    return features;
+}
+
+// Acrescenta bits ao status do dispositivo
+void virtio_set_status(uint16_t io_base, uint8_t status) {
+    uint8_t current = inb(io_base + VIRTIO_REG_DEVICE_STATUS);
+    outb(io_base + VIRTIO_REG_DEVICE_STATUS, current | status);
+}
+
+// Lê (e limpa) o status de interrupção
+uint8_t virtio_read_isr(uint16_t io_base) {
+    return inb(io_base + VIRTIO_REG_ISR_STATUS);
+}
+
+// ============================================================================
+// VIRTQUEUE
+// ============================================================================
+
+// Configura a fila 'index' sobre 'memory' (alinhada em 4 KB)
+int virtq_init(virtqueue_t* vq, uint16_t io_base, uint16_t index,
+               void* memory, size_t memory_size, uint8_t event_idx) {
+    outw(io_base + VIRTIO_REG_QUEUE_SELECT, index);
+    uint16_t size = inw(io_base + VIRTIO_REG_QUEUE_SIZE);
+    
+    if (size == 0 || size > VIRTQ_MAX_SIZE) return -1;
+    if (memory_size < (size_t)VIRTQ_RING_BYTES(size)) return -1;
+    if ((uint32_t)memory & (VIRTQ_ALIGN - 1)) return -1;
+    
+    uint8_t* mem = (uint8_t*)memory;
+    for (size_t i = 0; i < (size_t)VIRTQ_RING_BYTES(size); i++) {
+        mem[i] = 0;
+    }
+    
+    vq->io_base = io_base;
+    vq->index = index;
+    vq->size = size;
+    vq->event_idx = event_idx;
+    vq->desc = (virtq_desc_t*)mem;
+    vq->avail = (virtq_avail_t*)(mem + 16 * size);
+    vq->used = (virtq_used_t*)(mem + VIRTQ_ALIGN_UP(16 * size + 6 + 2 * size));
+    vq->last_used_idx = 0;
+    vq->last_kick_idx = 0;
+    vq->kicks = 0;
+    vq->kicks_suppressed = 0;
+    
+    // Lista de descritores livres encadeada pelo campo 'next'
+    for (uint16_t i = 0; i < size; i++) {
+        vq->desc[i].next = (i + 1) % size;
+        vq->cookies[i] = 0;
+    }
+    vq->free_head = 0;
+    vq->num_free = size;
+    
+    outl(io_base + VIRTIO_REG_QUEUE_ADDRESS, (uint32_t)mem >> 12);
+    return 0;
+}
+
+// Publica a cabeça de uma cadeia no anel avail (sem notificar)
+static void virtq_publish(virtqueue_t* vq, uint16_t head, void* cookie) {
+    vq->cookies[head] = cookie;
+    vq->avail->ring[vq->avail->idx & (vq->size - 1)] = head;
+    virtio_barrier();  // Entrada do anel antes do índice
+    vq->avail->idx++;
+}
+
+// Adiciona uma cadeia de buffers (saída primeiro, depois entrada)
+int virtq_add_chain(virtqueue_t* vq, const virtq_buf_t* bufs, uint16_t count, void* cookie) {
+    if (count == 0 || vq->num_free < count) return -1;
+    
+    uint16_t head = vq->free_head;
+    uint16_t idx = head;
+    
+    // Os descritores livres já estão encadeados por 'next', então a
+    // cadeia reaproveita os links da lista livre
+    for (uint16_t i = 0; i < count; i++) {
+        virtq_desc_t* d = &vq->desc[idx];
+        
+        d->addr = (uint32_t)bufs[i].addr;
+        d->addr_high = 0;
+        d->len = bufs[i].len;
+        d->flags = bufs[i].device_writes ? VIRTQ_DESC_F_WRITE : 0;
+        if (i + 1 < count) {
+            d->flags |= VIRTQ_DESC_F_NEXT;
+        }
+        idx = d->next;
+    }
+    
+    vq->free_head = idx;
+    vq->num_free -= count;
+    virtq_publish(vq, head, cookie);
+    return head;
+}
+
+// Adiciona uma tabela de descritores indireta ocupando um único slot do
+// anel. O chamador preenche addr/len/flags; os links são feitos aqui
+int virtq_add_indirect(virtqueue_t* vq, virtq_desc_t* table, uint16_t count, void* cookie) {
+    if (count == 0 || vq->num_free < 1) return -1;
+    
+    for (uint16_t i = 0; i < count; i++) {
+        table[i].addr_high = 0;
+        if (i + 1 < count) {
+            table[i].flags |= VIRTQ_DESC_F_NEXT;
+            table[i].next = i + 1;
+        } else {
+            table[i].flags &= ~VIRTQ_DESC_F_NEXT;
+            table[i].next = 0;
+        }
+    }
+    
+    uint16_t head = vq->free_head;
+    virtq_desc_t* d = &vq->desc[head];
+    
+    vq->free_head = d->next;
+    vq->num_free--;
+    
+    d->addr = (uint32_t)table;
+    d->addr_high = 0;
+    d->len = count * sizeof(virtq_desc_t);
+    d->flags = VIRTQ_DESC_F_INDIRECT;
+    
+    virtq_publish(vq, head, cookie);
+    return head;
+}
+
+// Notifica o dispositivo apenas se ele pediu (avail_event ou NO_NOTIFY).
+// Várias submissões seguidas de um único kick geram uma só saída de VM
+void virtq_kick(virtqueue_t* vq) {
+    virtio_full_barrier();
+    
+    uint16_t new_idx = vq->avail->idx;
+    uint16_t old_idx = vq->last_kick_idx;
+    int need;
+    
+    vq->last_kick_idx = new_idx;
+    
+    if (vq->event_idx) {
+        uint16_t event = *virtq_avail_event(vq);
+        need = (uint16_t)(new_idx - event - 1) < (uint16_t)(new_idx - old_idx);
+    } else {
+        need = !(vq->used->flags & VIRTQ_USED_F_NO_NOTIFY);
+    }
+    
+    if (need) {
+        outw(vq->io_base + VIRTIO_REG_QUEUE_NOTIFY, vq->index);
+        vq->kicks++;
+    } else {
+        vq->kicks_suppressed++;
+    }
+}
+
+// Devolve uma cadeia à lista livre
+static void virtq_free_chain(virtqueue_t* vq, uint16_t head) {
+    uint16_t idx = head;
+    uint16_t count = 1;
+    
+    while (vq->desc[idx].flags & VIRTQ_DESC_F_NEXT) {
+        idx = vq->desc[idx].next;
+        count++;
+    }
+    
+    vq->desc[idx].next = vq->free_head;
+    vq->free_head = head;
+    vq->num_free += count;
+}
+
+// Colhe um buffer usado; retorna o cookie da submissão ou 0 se vazio
+void* virtq_get_used(virtqueue_t* vq, uint32_t* len) {
+    if (vq->last_used_idx == vq->used->idx) return 0;
+    
+    virtio_barrier();  // Índice antes do conteúdo do anel
+    
+    virtq_used_elem_t* elem = &vq->used->ring[vq->last_used_idx & (vq->size - 1)];
+    uint16_t head = elem->id;
+    void* cookie = vq->cookies[head];
+    
+    if (len) *len = elem->len;
+    
+    vq->cookies[head] = 0;
+    virtq_free_chain(vq, head);
+    vq->last_used_idx++;
+    return cookie;
+}
+
+// Pede ao dispositivo para não interromper (modo polling)
+void virtq_disable_interrupts(virtqueue_t* vq) {
+    vq->avail->flags |= VIRTQ_AVAIL_F_NO_INTERRUPT;
+    if (vq->event_idx) {
+        // Evento já ultrapassado: só dispararia após 65535 conclusões
+        *virtq_used_event(vq) = vq->last_used_idx - 1;
+    }
+}
+
+// Reabilita interrupções a partir do próximo buffer usado. Retorna 1 se
+// já existem buffers pendentes (o chamador deve colhê-los)
+int virtq_enable_interrupts(virtqueue_t* vq) {
+    vq->avail->flags &= ~VIRTQ_AVAIL_F_NO_INTERRUPT;
+    if (vq->event_idx) {
+        *virtq_used_event(vq) = vq->last_used_idx;
+    }
+    
+    virtio_full_barrier();
+    return vq->used->idx != vq->last_used_idx;
+}
@@ -0,0 +1,401 @@
+// ============================================================================
+// NanoOS - Driver Ethernet Intel e1000
+// Registradores em MMIO, anéis de descritores de RX e TX com a cauda
+// escrita uma vez por lote e interrupções limitadas pelo ITR
+// ============================================================================
+
+#include "../../include/e1000.h"
+#include "../../include/netdev.h"
+#include "../../include/pci.h"
+#include "../../include/kernel.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// VARIÁVEIS GLOBAIS
+// ============================================================================
+
+static e1000_device_t e1000;
+static e1000_rx_desc_t rx_descs[E1000_RX_DESCS] __attribute__((aligned(128)));
+static e1000_tx_desc_t tx_descs[E1000_TX_DESCS] __attribute__((aligned(128)));
+static netbuf_t* rx_bufs[E1000_RX_DESCS];    // Buffers do pool, emprestados à pilha
+static uint8_t tx_buffers[E1000_TX_DESCS][E1000_TX_BUFFER] __attribute__((aligned(16)));
+
+// ============================================================================
+// FUNÇÕES AUXILIARES
+// ============================================================================
+
+// Leitura/Escrita de registradores
+static inline uint32_t e1000_read(uint32_t reg) {
+    return *(volatile uint32_t*)(e1000.mmio + reg);
+}
+
+static inline void e1000_write(uint32_t reg, uint32_t val) {
+    *(volatile uint32_t*)(e1000.mmio + reg) = val;
+}
+
+// Descritores entre a cabeça e a cauda de um anel
+static inline uint16_t e1000_ring_used(uint16_t head, uint16_t tail, uint16_t size) {
+    return (uint16_t)(tail + size - head) % size;
+}
+
+// Lê uma palavra da EEPROM; retorna -1 se a placa não responde
+static int e1000_eeprom_read(uint8_t word, uint16_t* value) {
+    e1000_write(E1000_EERD, ((uint32_t)word << 8) | E1000_EERD_START);
+    
+    for (int i = 0; i < 100000; i++) {
+        uint32_t eerd = e1000_read(E1000_EERD);
+        if (eerd & E1000_EERD_DONE) {
+            *value = eerd >> 16;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// ============================================================================
+// RECEPÇÃO
+// ============================================================================
+
+// Colhe até 'budget' descritores concluídos e os devolve à placa com uma
+// única escrita de RDT no fim (a cauda fica no último descritor reposto)
+static int e1000_poll(netdev_t* dev, int budget) {
+    int done = 0;
+    
+    while (done < budget) {
+        e1000_rx_desc_t* desc = &rx_descs[e1000.rx_cur];
+        
+        if (!(desc->status & E1000_RXD_STAT_DD)) break;
+        
+        uint8_t status = desc->status;
+        
+        // Frame maior que o buffer (sem EOP) ou com erro de linha
+        if (!(status & E1000_RXD_STAT_EOP) || (desc->errors & E1000_RXD_ERR_FRAME)) {
+            dev->rx[0].errors++;
+        } else {
+            uint8_t flags = 0;
+            
+            if ((status & E1000_RXD_STAT_TCPCS) && !(status & E1000_RXD_STAT_IXSM) &&
+                !(desc->errors & E1000_RXD_ERR_TCPE)) {
+                flags |= NETDEV_RX_CSUM_VALID;
+            }
+            netbuf_t* buf = netdev_receive_buf(dev, 0, rx_bufs[e1000.rx_cur], 0,
+                                               desc->length, flags);
+            
+            // A pilha ficou com o buffer: o descritor passa a usar o substituto
+            if (buf != rx_bufs[e1000.rx_cur]) {
+                rx_bufs[e1000.rx_cur] = buf;
+                desc->addr = (uint32_t)buf->data;
+            }
+        }
+        
+        desc->status = 0;
+        e1000.rx_cur = (e1000.rx_cur + 1) % E1000_RX_DESCS;
+        done++;
+    }
+    
+    if (done) {
+        e1000_write(E1000_RDT, (e1000.rx_cur + E1000_RX_DESCS - 1) % E1000_RX_DESCS);
+        e1000.tail_writes++;
+    }
+    return done;
+}
+
+// Máscara de RX durante o polling. Uma leitura de ICR por outra causa
+// (LSC) apaga a causa de RX mascarada, então ao religar o próprio anel é
+// conferido
+static void e1000_rx_irq_disable(netdev_t* dev) {
+    (void)dev;
+    e1000_write(E1000_IMC, E1000_INT_RX);
+}
+
+static int e1000_rx_irq_enable(netdev_t* dev) {
+    (void)dev;
+    e1000_write(E1000_IMS, E1000_INT_RX);
+    return (rx_descs[e1000.rx_cur].status & E1000_RXD_STAT_DD) != 0;
+}
+
+// ============================================================================
+// TRANSMISSÃO
+// ============================================================================
+
+// Libera os descritores que a placa já enviou (DD). Sem interrupção de TX:
+// a limpeza acontece no próximo envio
+static void e1000_tx_reclaim(void) {
+    while (e1000.tx_clean != e1000.tx_tail &&
+           (tx_descs[e1000.tx_clean].status & E1000_TXD_STAT_DD)) {
+        e1000.tx_clean = (e1000.tx_clean + 1) % E1000_TX_DESCS;
+    }
+}
+
+// Publica a cauda TX: tudo entre a cauda antiga e tx_tail vai para a placa
+static void e1000_tx_publish(void) {
+    e1000_write(E1000_TDT, e1000.tx_tail);
+    e1000.tail_writes++;
+}
+
+// Copia o frame para o próximo descritor. Fora de um lote a cauda é
+// publicada na hora; dentro dele, só em e1000_flush
+static int e1000_transmit(netdev_t* dev, const void* frame, uint32_t len,
+                          const netdev_offload_t* offload) {
+    (void)offload;  // Sem offload de envio: o registro não anuncia features
+    
+    if (len > E1000_TX_BUFFER) return -1;
+    
+    uint32_t flags = irq_save();
+    uint16_t next = (e1000.tx_tail + 1) % E1000_TX_DESCS;
+    
+    if (next == e1000.tx_clean) e1000_tx_reclaim();
+    if (next == e1000.tx_clean) {
+        dev->tx[0].drops++;
+        irq_restore(flags);
+        return -1;
+    }
+    
+    e1000_tx_desc_t* desc = &tx_descs[e1000.tx_tail];
+    
+    memory_copy(tx_buffers[e1000.tx_tail], frame, len);
+    desc->length = len;
+    desc->cso = 0;
+    desc->cmd = E1000_TXD_CMD_EOP | E1000_TXD_CMD_IFCS | E1000_TXD_CMD_RS;
+    desc->css = 0;
+    desc->status = 0;
+    e1000.tx_tail = next;
+    
+    uint16_t used = e1000_ring_used(e1000.tx_clean, e1000.tx_tail, E1000_TX_DESCS);
+    if (used > e1000.tx_peak) e1000.tx_peak = used;
+    
+    dev->tx[0].packets++;
+    dev->tx[0].bytes += len;
+    if (!dev->tx_batch) {
+        e1000_tx_publish();
+    }
+    
+    irq_restore(flags);
+    return 0;
+}
+
+// Fim de um lote: uma escrita de TDT para todos os frames
+static void e1000_flush(netdev_t* dev) {
+    (void)dev;
+    e1000_tx_publish();
+}
+
+// ============================================================================
+// INTERRUPÇÃO
+// ============================================================================
+
+// Taxa de interrupções em janelas de um segundo
+static void e1000_count_irq(void) {
+    uint32_t elapsed = timer_ticks - e1000.irq_window_start;
+    
+    e1000.irqs++;
+    e1000.irq_window_count++;
+    if (elapsed >= TIMER_FREQUENCY) {
+        e1000.irq_rate = e1000.irq_window_count * TIMER_FREQUENCY / elapsed;
+        e1000.irq_window_count = 0;
+        e1000.irq_window_start = timer_ticks;
+    }
+}
+
+static void e1000_irq_handler(void) {
+    uint32_t cause = e1000_read(E1000_ICR);  // Ler confirma
+    
+    if (!cause) return;  // Linha compartilhada: não é nossa
+    e1000_count_irq();
+    
+    if (cause & E1000_INT_RXO) e1000.rx_overruns++;
+    if (cause & E1000_INT_RX) {
+        netdev_rx_schedule(e1000.netdev);
+    }
+    if (cause & E1000_INT_LSC) {
+        e1000.netdev->link_up = (e1000_read(E1000_STATUS) & E1000_STATUS_LU) != 0;
+    }
+}
+
+// ============================================================================
+// DIAGNÓSTICO
+// ============================================================================
+
+static void e1000_print_stats(const netdev_t* dev) {
+    (void)dev;
+    
+    // Sem interrupções há mais de uma janela: a taxa é a da janela aberta
+    uint32_t elapsed = timer_ticks - e1000.irq_window_start;
+    uint32_t rate = e1000.irq_rate;
+    if (elapsed >= 2 * TIMER_FREQUENCY) {
+        rate = e1000.irq_window_count * TIMER_FREQUENCY / elapsed;
+    }
+    
+    uint16_t rx_hw = e1000_ring_used(e1000_read(E1000_RDH), e1000_read(E1000_RDT), E1000_RX_DESCS);
+    uint16_t tx_hw = e1000_ring_used(e1000_read(E1000_TDH), e1000.tx_tail, E1000_TX_DESCS);
+    
+    terminal_print("    e1000: anel RX ");
+    terminal_print_dec(rx_hw);
+    terminal_print("/");
+    terminal_print_dec(E1000_RX_DESCS);
+    terminal_print(" com a placa, anel TX ");
+    terminal_print_dec(tx_hw);
+    terminal_print("/");
+    terminal_print_dec(E1000_TX_DESCS);
+    terminal_print(" em voo (pico ");
+    terminal_print_dec(e1000.tx_peak);
+    terminal_print(")\n    Interrupcoes: ");
+    terminal_print_dec(e1000.irqs);
+    terminal_print(" (");
+    terminal_print_dec(rate);
+    terminal_print("/s, teto ");
+    terminal_print_dec(E1000_MAX_IRQ_RATE);
+    terminal_print("/s), overruns RX: ");
+    terminal_print_dec(e1000.rx_overruns);
+    terminal_print(", escritas de cauda: ");
+    terminal_print_dec(e1000.tail_writes);
+    terminal_print("\n");
+}
+
+// ============================================================================
+// INICIALIZAÇÃO
+// ============================================================================
+
+static const netdev_ops_t e1000_ops = {
+    .transmit = e1000_transmit,
+    .flush = e1000_flush,
+    .poll = e1000_poll,
+    .rx_irq_disable = e1000_rx_irq_disable,
+    .rx_irq_enable = e1000_rx_irq_enable,
+    .print_stats = e1000_print_stats,
+};
+
+// MAC: RAL0/RAH0 (já carregados da EEPROM pela placa) ou a própria EEPROM
+static void e1000_read_mac(mac_addr_t* mac) {
+    uint32_t ral = e1000_read(E1000_RAL0);
+    uint32_t rah = e1000_read(E1000_RAH0);
+    
+    if (rah & (1u << 31)) {
+        for (int i = 0; i < 4; i++) mac->addr[i] = ral >> (8 * i);
+        mac->addr[4] = rah;
+        mac->addr[5] = rah >> 8;
+        return;
+    }
+    
+    for (uint8_t word = 0; word < 3; word++) {
+        uint16_t value = 0;
+        e1000_eeprom_read(word, &value);
+        mac->addr[2 * word] = value;
+        mac->addr[2 * word + 1] = value >> 8;
+    }
+    e1000_write(E1000_RAL0, mac->addr[0] | (mac->addr[1] << 8) |
+                            (mac->addr[2] << 16) | ((uint32_t)mac->addr[3] << 24));
+    e1000_write(E1000_RAH0, mac->addr[4] | (mac->addr[5] << 8) | (1u << 31));
+}
+
+// Anel RX cheio de buffers do pool; a cauda fica um atrás da cabeça
+static int e1000_rx_init(void) {
+    for (int i = 0; i < E1000_RX_DESCS; i++) {
+        if (!rx_bufs[i] && !(rx_bufs[i] = netbuf_alloc())) return -1;
+        rx_descs[i].addr = (uint32_t)rx_bufs[i]->data;
+        rx_descs[i].addr_high = 0;
+        rx_descs[i].status = 0;
+    }
+    e1000.rx_cur = 0;
+    
+    e1000_write(E1000_RDBAL, (uint32_t)rx_descs);
+    e1000_write(E1000_RDBAH, 0);
+    e1000_write(E1000_RDLEN, sizeof(rx_descs));
+    e1000_write(E1000_RDH, 0);
+    e1000_write(E1000_RDT, E1000_RX_DESCS - 1);
+    
+    // Sem atraso próprio de RX: o ITR é quem agrupa as interrupções
+    e1000_write(E1000_RDTR, 0);
+    e1000_write(E1000_RADV, 0);
+    e1000_write(E1000_RXCSUM, E1000_RXCSUM_TUOFL);
+    e1000_write(E1000_RCTL, E1000_RCTL_EN | E1000_RCTL_BAM | E1000_RCTL_BSIZE_2048 |
+                            E1000_RCTL_SECRC);
+    return 0;
+}
+
+static void e1000_tx_init(void) {
+    for (int i = 0; i < E1000_TX_DESCS; i++) {
+        tx_descs[i].addr = (uint32_t)tx_buffers[i];
+        tx_descs[i].addr_high = 0;
+        tx_descs[i].cmd = 0;
+        tx_descs[i].status = E1000_TXD_STAT_DD;
+    }
+    e1000.tx_tail = 0;
+    e1000.tx_clean = 0;
+    
+    e1000_write(E1000_TDBAL, (uint32_t)tx_descs);
+    e1000_write(E1000_TDBAH, 0);
+    e1000_write(E1000_TDLEN, sizeof(tx_descs));
+    e1000_write(E1000_TDH, 0);
+    e1000_write(E1000_TDT, 0);
+    e1000_write(E1000_TIPG, E1000_TIPG_DEFAULT);
+    e1000_write(E1000_TCTL, E1000_TCTL_EN | E1000_TCTL_PSP | E1000_TCTL_CT |
+                            E1000_TCTL_COLD);
+}
+
+// Probe: reset, MAC, anéis e interrupções. Só uma placa é usada
+static int e1000_probe(pci_device_t* pci, const pci_device_id_t* id) {
+    (void)id;
+    
+    if (e1000.netdev || (pci->bar_flags[0] & PCI_BAR_IO) || pci->bar[0] == 0) return -1;
+    
+    pci_device_enable(pci, PCI_CMD_MEM_SPACE | PCI_CMD_BUS_MASTER);
+    e1000.mmio = (volatile uint8_t*)pci->bar[0];
+    
+    e1000_write(E1000_IMC, 0xFFFFFFFF);
+    e1000_write(E1000_CTRL, e1000_read(E1000_CTRL) | E1000_CTRL_RST);
+    
+    uint32_t start = timer_ticks;
+    while (e1000_read(E1000_CTRL) & E1000_CTRL_RST) {
+        if (timer_ticks - start > E1000_RESET_TIMEOUT) {
+            terminal_print("e1000: timeout no reset\n");
+            return -1;
+        }
+    }
+    e1000_write(E1000_IMC, 0xFFFFFFFF);
+    e1000_read(E1000_ICR);
+    
+    e1000_write(E1000_CTRL, e1000_read(E1000_CTRL) | E1000_CTRL_SLU | E1000_CTRL_ASDE);
+    
+    mac_addr_t mac;
+    e1000_read_mac(&mac);
+    
+    for (int i = 0; i < 128; i++) {
+        e1000_write(E1000_MTA + i * 4, 0);
+    }
+    
+    if (e1000_rx_init() != 0) {
+        terminal_print("e1000: sem buffers de recepcao\n");
+        return -1;
+    }
+    e1000_tx_init();
+    
+    e1000.netdev = netdev_register("e1000", &mac, pci->irq_line, 1, 1, &e1000_ops, &e1000);
+    if (!e1000.netdev) return -1;
+    e1000.netdev->features = NETDEV_F_RX_CSUM;
+    e1000.netdev->link_up = (e1000_read(E1000_STATUS) & E1000_STATUS_LU) != 0;
+    e1000.irq_window_start = timer_ticks;
+    
+    irq_register_handler(pci->irq_line, e1000_irq_handler);
+    e1000_write(E1000_ITR, E1000_ITR_INTERVAL);
+    e1000_write(E1000_IMS, E1000_INT_RX | E1000_INT_LSC);
+    return 0;
+}
+
+static const pci_device_id_t e1000_pci_ids[] = {
+    { E1000_PCI_VENDOR, E1000_PCI_DEVICE_82540EM, PCI_ANY_ID, PCI_ANY_ID },
+    { E1000_PCI_VENDOR, E1000_PCI_DEVICE_82545EM, PCI_ANY_ID, PCI_ANY_ID },
+    { 0, 0, 0, 0 }
+};
+
+static const pci_driver_t e1000_pci_driver = {
+    .name = "e1000",
+    .ids = e1000_pci_ids,
+    .probe = e1000_probe,
+};
+
+// Registra o driver no PCI; falha se não houver placa
+int e1000_init(void) {
+    return pci_register_driver(&e1000_pci_driver) > 0 ? 0 : -1;
+}
@@ -0,0 +1,364 @@
+// ============================================================================
+// NanoOS - Fragmentação IP
+// Envio de datagramas maiores que a MTU em fragmentos e remontagem dos
+// recebidos pelo algoritmo de descritores de buracos (RFC 815), com um
+// número fixo de datagramas em andamento, prazo e despejo do mais antigo
+// ============================================================================
+
+#include "../../include/network.h"
+#include "../../include/netdev.h"
+#include "../../include/kernel.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// Descritor de buraco, gravado no primeiro byte do trecho que falta.
+// Fragmentos intermediários têm múltiplos de 8 bytes, então todo buraco
+// começa alinhado e cabe um descritor
+typedef struct {
+    uint16_t first;
+    uint16_t last;                      // Inclusivo
+    uint16_t next;                      // Offset do próximo buraco
+} ip_hole_t;
+
+#define IP_HOLE_INFINITY        0xFFFF  // Fim ainda desconhecido
+#define IP_HOLE_NONE            0xFFFF  // Fim da lista
+
+// ============================================================================
+// VARIÁVEIS GLOBAIS
+// ============================================================================
+
+static ip_reasm_t reasm_table[IP_REASM_MAX];
+static ip_frag_stats_t frag_stats;
+
+// Fragmento montado para envio (protegido por irq_save, como em ip_send)
+static uint8_t fragment[ETH_MTU];
+
+void ip_frag_init(void) {
+    memory_set(reasm_table, 0, sizeof(reasm_table));
+    memory_set(&frag_stats, 0, sizeof(frag_stats));
+}
+
+// ============================================================================
+// FRAGMENTAÇÃO
+// ============================================================================
+
+// Envia os len bytes de dados em fragmentos de até mtu bytes, todos com o
+// cabeçalho de ip (id já escolhido). Os dados de cada fragmento, menos o
+// último, são múltiplos de 8 bytes; saem num lote só para a placa. A fila
+// ARP guarda poucos pacotes por vizinho: sem o MAC do próximo salto o
+// datagrama inteiro falha (e a resolução fica disparada)
+int ip_fragment(const ip_header_t* ip, const uint8_t* data, size_t len, uint32_t mtu) {
+    ip_header_t* hdr = (ip_header_t*)fragment;
+    netdev_t* dev = network_get_interface()->dev;
+    mac_addr_t mac;
+    int result = 0;
+    
+    if (ip_next_hop_mac(&ip->dst_ip, &mac) != 0) {
+        frag_stats.frag_fails++;
+        return -1;
+    }
+    
+    if (mtu > ETH_MTU) mtu = ETH_MTU;
+    uint32_t max_data = (mtu - IP_HEADER_SIZE) & ~7u;
+    
+    *hdr = *ip;
+    if (dev) netdev_tx_batch_begin(dev);
+    for (uint32_t offset = 0; offset < len; offset += max_data) {
+        uint32_t chunk = len - offset < max_data ? len - offset : max_data;
+        uint16_t flags_offset = (uint16_t)(offset / 8);
+        
+        if (offset + chunk < len) flags_offset |= IP_FLAG_MF;
+        hdr->length = htons(IP_HEADER_SIZE + chunk);
+        hdr->flags_offset = htons(flags_offset);
+        hdr->checksum = 0;
+        hdr->checksum = calculate_checksum(hdr, IP_HEADER_SIZE);
+        memory_copy(fragment + IP_HEADER_SIZE, data + offset, chunk);
+        
+        if (eth_send_frame(fragment, IP_HEADER_SIZE + chunk, &mac, ETH_TYPE_IP) != 0) {
+            result = -1;
+            break;
+        }
+        frag_stats.frag_creates++;
+    }
+    if (dev) netdev_tx_batch_end(dev);
+    
+    if (result == 0) frag_stats.frag_oks++;
+    else frag_stats.frag_fails++;
+    return result;
+}
+
+// ============================================================================
+// REMONTAGEM
+// ============================================================================
+
+static inline ip_hole_t* ip_hole_at(ip_reasm_t* r, uint16_t offset) {
+    return (ip_hole_t*)(r->packet + IP_HEADER_SIZE + offset);
+}
+
+// Insere um buraco na posição apontada por link; retorna o link seguinte
+static uint16_t* ip_hole_insert(ip_reasm_t* r, uint16_t* link, uint16_t first, uint16_t last) {
+    ip_hole_t* hole = ip_hole_at(r, first);
+    
+    hole->first = first;
+    hole->last = last;
+    hole->next = *link;
+    *link = first;
+    return &hole->next;
+}
+
+// Contexto de um datagrama (origem, id, protocolo). Poucos contextos:
+// busca linear
+static ip_reasm_t* ip_reasm_find(const ip_header_t* ip) {
+    for (int i = 0; i < IP_REASM_MAX; i++) {
+        ip_reasm_t* r = &reasm_table[i];
+        
+        if (r->state == IP_REASM_ACTIVE && r->id == ip->id && r->protocol == ip->protocol &&
+            memory_compare(&r->src_ip, &ip->src_ip, sizeof(ip_addr_t)) == 0) {
+            return r;
+        }
+    }
+    return 0;
+}
+
+// Contexto que contém o endereço (datagrama completo entregue a alguém)
+static ip_reasm_t* ip_reasm_owner(const uint8_t* data) {
+    for (int i = 0; i < IP_REASM_MAX; i++) {
+        ip_reasm_t* r = &reasm_table[i];
+        
+        if (data >= r->packet && data < r->packet + sizeof(r->packet)) return r;
+    }
+    return 0;
+}
+
+// Novo contexto, com um único buraco do início ao infinito. Sem contexto
+// livre, despeja a remontagem mais antiga; os retidos por sockets ficam
+static ip_reasm_t* ip_reasm_alloc(const ip_header_t* ip) {
+    ip_reasm_t* r = 0;
+    ip_reasm_t* oldest = 0;
+    uint32_t now = timer_ticks;
+    
+    for (int i = 0; i < IP_REASM_MAX && !r; i++) {
+        ip_reasm_t* candidate = &reasm_table[i];
+        
+        if (candidate->state == IP_REASM_FREE) {
+            r = candidate;
+        } else if (candidate->state == IP_REASM_ACTIVE &&
+                   (!oldest || now - candidate->started > now - oldest->started)) {
+            oldest = candidate;
+        }
+    }
+    if (!r) {
+        if (!oldest) return 0;
+        frag_stats.reasm_evictions++;
+        r = oldest;
+    }
+    
+    r->state = IP_REASM_ACTIVE;
+    r->protocol = ip->protocol;
+    r->has_first = 0;
+    r->id = ip->id;
+    r->src_ip = ip->src_ip;
+    r->total = 0;
+    r->received_end = 0;
+    r->started = now;
+    r->fragments = 0;
+    r->holes = IP_HOLE_NONE;
+    ip_hole_insert(r, &r->holes, 0, IP_HOLE_INFINITY);
+    return r;
+}
+
+// Passos da RFC 815 para o fragmento [first, last]: cada buraco que ele
+// toca sai da lista e dá lugar às sobras antes e depois dele. As sobras
+// ficam fora do fragmento, então copiar os dados em seguida não as apaga
+static void ip_reasm_fill(ip_reasm_t* r, uint16_t first, uint16_t last, int more) {
+    uint16_t* link = &r->holes;
+    
+    while (*link != IP_HOLE_NONE) {
+        ip_hole_t hole = *ip_hole_at(r, *link);
+        
+        if (first > hole.last || last < hole.first) {
+            link = &ip_hole_at(r, *link)->next;
+            continue;
+        }
+        
+        *link = hole.next;
+        if (first > hole.first) {
+            link = ip_hole_insert(r, link, hole.first, first - 1);
+        }
+        if (last < hole.last && more) {
+            link = ip_hole_insert(r, link, last + 1, hole.last);
+        }
+    }
+}
+
+// Avisa a origem que o datagrama expirou (RFC 792), se o primeiro
+// fragmento chegou: cabeçalho original e os 8 primeiros bytes de dados
+static void ip_reasm_time_exceeded(ip_reasm_t* r) {
+    uint8_t message[sizeof(icmp_header_t) + IP_HEADER_SIZE + 8];
+    icmp_header_t* icmp = (icmp_header_t*)message;
+    ip_header_t* original = (ip_header_t*)(message + sizeof(icmp_header_t));
+    
+    if (!r->has_first) return;
+    
+    icmp->type = ICMP_TIME_EXCEEDED;
+    icmp->code = ICMP_FRAG_TIMEOUT;
+    icmp->id = 0;
+    icmp->seq = 0;
+    memory_copy(original, r->packet, IP_HEADER_SIZE + 8);
+    original->checksum = 0;
+    original->checksum = calculate_checksum(original, IP_HEADER_SIZE);
+    icmp->checksum = 0;
+    icmp->checksum = calculate_checksum(message, sizeof(message));
+    ip_send(message, sizeof(message), &r->src_ip, IP_PROTO_ICMP);
+}
+
+// Acrescenta um fragmento válido ao seu datagrama. Retorna o datagrama
+// inteiro (cabeçalho sem opções e dados contíguos) quando o último
+// buraco se fecha, senão 0
+const ip_header_t* ip_reasm_input(const ip_header_t* ip, uint32_t header_len) {
+    uint16_t flags_offset = ntohs(ip->flags_offset);
+    uint32_t first = (flags_offset & IP_OFFSET_MASK) * 8;
+    uint32_t len = ntohs(ip->length) - header_len;
+    uint32_t end = first + len;
+    int more = (flags_offset & IP_FLAG_MF) != 0;
+    
+    frag_stats.reasm_reqds++;
+    
+    // Vazio, intermediário fora do múltiplo de 8 ou além de 64 KB
+    if (len == 0 || (more && (len & 7)) || end > IP_MAX_PAYLOAD) {
+        frag_stats.reasm_fails++;
+        return 0;
+    }
+    
+    ip_reasm_t* r = ip_reasm_find(ip);
+    if (!r) r = ip_reasm_alloc(ip);
+    if (!r) {
+        frag_stats.reasm_fails++;
+        return 0;
+    }
+    
+    // Com o fim conhecido, nada passa dele e outro último fragmento tem de
+    // concordar; o último não pode terminar antes de dados já recebidos
+    if ((r->total && (end > r->total || (!more && end != r->total))) ||
+        (!more && end < r->received_end)) {
+        r->state = IP_REASM_FREE;
+        frag_stats.reasm_fails++;
+        return 0;
+    }
+    
+    if (!more) r->total = end;
+    if (end > r->received_end) r->received_end = end;
+    r->fragments++;
+    
+    // Cabeçalho do primeiro fragmento vale para o datagrama; as opções
+    // não são remontadas
+    if (first == 0) {
+        memory_copy(r->packet, ip, IP_HEADER_SIZE);
+        ((ip_header_t*)r->packet)->version_ihl = 0x45;
+        r->has_first = 1;
+    }
+    
+    ip_reasm_fill(r, (uint16_t)first, (uint16_t)(end - 1), more);
+    memory_copy(r->packet + IP_HEADER_SIZE + first, (const uint8_t*)ip + header_len, len);
+    
+    if (r->holes != IP_HOLE_NONE) return 0;
+    
+    ip_header_t* whole = (ip_header_t*)r->packet;
+    whole->length = htons(IP_HEADER_SIZE + r->total);
+    whole->flags_offset = 0;
+    whole->checksum = 0;
+    whole->checksum = calculate_checksum(whole, IP_HEADER_SIZE);
+    
+    r->state = IP_REASM_DONE;
+    frag_stats.reasm_oks++;
+    return whole;
+}
+
+// Fim da entrega: o contexto volta a ficar livre, a menos que um socket
+// tenha retido os dados
+void ip_reasm_done(const ip_header_t* ip) {
+    ip_reasm_t* r = ip_reasm_owner((const uint8_t*)ip);
+    
+    if (r && r->state == IP_REASM_DONE) r->state = IP_REASM_FREE;
+}
+
+// Retém o datagrama em entrega que contém data. Retorna -1 se data não
+// está num datagrama remontado
+int ip_reasm_hold(const uint8_t* data) {
+    ip_reasm_t* r = ip_reasm_owner(data);
+    
+    if (!r || r->state != IP_REASM_DONE) return -1;
+    r->state = IP_REASM_HELD;
+    return 0;
+}
+
+void ip_reasm_release(const uint8_t* data) {
+    ip_reasm_t* r = ip_reasm_owner(data);
+    
+    if (r && r->state == IP_REASM_HELD) r->state = IP_REASM_FREE;
+}
+
+// Varredura periódica (chamada pelo polling da rede): datagramas sem
+// todos os fragmentos em IP_REASM_TIMEOUT são abandonados
+void ip_reasm_timer(void) {
+    static uint32_t last_scan = 0;
+    uint32_t now = timer_ticks;
+    
+    if (now - last_scan < IP_REASM_SCAN_TICKS) return;
+    last_scan = now;
+    
+    for (int i = 0; i < IP_REASM_MAX; i++) {
+        ip_reasm_t* r = &reasm_table[i];
+        
+        if (r->state != IP_REASM_ACTIVE || now - r->started < IP_REASM_TIMEOUT) continue;
+        
+        frag_stats.reasm_timeouts++;
+        r->state = IP_REASM_FREE;
+        ip_reasm_time_exceeded(r);
+    }
+}
+
+// ============================================================================
+// DIAGNÓSTICO
+// ============================================================================
+
+const ip_frag_stats_t* ip_frag_get_stats(void) {
+    return &frag_stats;
+}
+
+void ip_frag_print_stats(void) {
+    uint32_t active = 0, held = 0;
+    
+    for (int i = 0; i < IP_REASM_MAX; i++) {
+        if (reasm_table[i].state == IP_REASM_ACTIVE) active++;
+        else if (reasm_table[i].state == IP_REASM_HELD) held++;
+    }
+    
+    terminal_print("IP: ");
+    terminal_print_dec(frag_stats.reasm_reqds);
+    terminal_print(" fragmentos recebidos, ");
+    terminal_print_dec(frag_stats.reasm_oks);
+    terminal_print(" datagramas remontados, ");
+    terminal_print_dec(frag_stats.reasm_timeouts);
+    terminal_print(" expirados, ");
+    terminal_print_dec(frag_stats.reasm_evictions);
+    terminal_print(" despejados, ");
+    terminal_print_dec(frag_stats.reasm_fails);
+    terminal_print(" invalidos\n");
+    
+    terminal_print("  Remontagem: ");
+    terminal_print_dec(active);
+    terminal_print(" em andamento, ");
+    terminal_print_dec(held);
+    terminal_print(" retidos por sockets (de ");
+    terminal_print_dec(IP_REASM_MAX);
+    terminal_print(")\n");
+    
+    terminal_print("  Envio: ");
+    terminal_print_dec(frag_stats.frag_oks);
+    terminal_print(" datagramas fragmentados em ");
+    terminal_print_dec(frag_stats.frag_creates);
+    terminal_print(" fragmentos, ");
+    terminal_print_dec(frag_stats.frag_fails);
+    terminal_print(" falhas\n");
+}
@@ -0,0 +1,373 @@
+// ============================================================================
+// NanoOS - Camada de Dispositivos de Rede
+// Tabela de interfaces com operações por driver e contadores por fila. A
+// pilha de protocolos só fala com esta camada
+// ============================================================================
+
+#include "../../include/netdev.h"
+#include "../../include/network.h"
+#include "../../include/kernel.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// VARIÁVEIS GLOBAIS
+// ============================================================================
+
+static netdev_t devices[NETDEV_MAX];
+static int device_count = 0;
+
+// Pool de buffers de pacote
+static netbuf_t netbufs[NETBUF_COUNT];
+static netbuf_t* netbuf_free_list = 0;
+static netbuf_stats_t netbuf_stats;
+
+// Buffer emprestado pelo driver durante a entrega do frame atual e o que
+// o substitui no anel se a pilha ficar com ele
+static netbuf_t* rx_loan = 0;
+static netbuf_t* rx_loan_spare = 0;
+
+// ============================================================================
+// REGISTRO
+// ============================================================================
+
+// Registra uma interface; retorna 0 se a tabela está cheia
+netdev_t* netdev_register(const char* driver, const mac_addr_t* mac, uint8_t irq,
+                          uint8_t rx_queues, uint8_t tx_queues,
+                          const netdev_ops_t* ops, void* priv) {
+    if (device_count >= NETDEV_MAX || !ops || !ops->transmit || !ops->poll ||
+        !ops->rx_irq_disable || !ops->rx_irq_enable ||
+        rx_queues == 0 || rx_queues > NETDEV_MAX_QUEUES ||
+        tx_queues == 0 || tx_queues > NETDEV_MAX_QUEUES) {
+        return 0;
+    }
+    
+    netdev_t* dev = &devices[device_count];
+    
+    memory_set(dev, 0, sizeof(netdev_t));
+    memory_copy(dev->name, "eth0", 5);
+    dev->name[3] = '0' + device_count;
+    dev->driver = driver;
+    dev->index = device_count;
+    dev->irq = irq;
+    dev->rx_queues = rx_queues;
+    dev->tx_queues = tx_queues;
+    dev->mac = *mac;
+    dev->ops = ops;
+    dev->priv = priv;
+    
+    device_count++;
+    return dev;
+}
+
+netdev_t* netdev_get(int index) {
+    if (index < 0 || index >= device_count) return 0;
+    return &devices[index];
+}
+
+int netdev_count(void) {
+    return device_count;
+}
+
+// ============================================================================
+// ENVIO E RECEPÇÃO
+// ============================================================================
+
+int netdev_transmit(netdev_t* dev, const void* frame, uint32_t len) {
+    if (!dev || len < ETH_HEADER_SIZE || len > ETH_FRAME_SIZE) return -1;
+    return dev->ops->transmit(dev, frame, len, 0);
+}
+
+// Envio com o checksum L4 feito pela placa. O chamador só pede o que
+// dev->features anuncia
+int netdev_transmit_offload(netdev_t* dev, const void* frame, uint32_t len,
+                            const netdev_offload_t* offload) {
+    if (!dev || !offload || len < ETH_HEADER_SIZE || len > ETH_FRAME_SIZE) return -1;
+    if (!(dev->features & NETDEV_F_TX_CSUM)) return -1;
+    if ((uint32_t)offload->csum_start + offload->csum_offset + 2 > len) return -1;
+    
+    return dev->ops->transmit(dev, frame, len, offload);
+}
+
+// Abre um lote: os envios seguintes só chegam à placa no fim do lote
+void netdev_tx_batch_begin(netdev_t* dev) {
+    uint32_t flags = irq_save();
+    dev->tx_batch++;
+    irq_restore(flags);
+}
+
+// Fecha o lote e avisa a placa uma vez (o último lote aninhado publica)
+void netdev_tx_batch_end(netdev_t* dev) {
+    uint32_t flags = irq_save();
+    
+    if (dev->tx_batch > 0 && --dev->tx_batch == 0 && dev->ops->flush) {
+        dev->ops->flush(dev);
+    }
+    irq_restore(flags);
+}
+
+// Fila de envio de um frame: hash do fluxo IPv4 (endereços e portas), para
+// que os pacotes de uma conexão nunca se reordenem entre filas
+uint8_t netdev_select_queue(const netdev_t* dev, const uint8_t* frame, uint32_t len) {
+    if (dev->tx_queues == 1) return 0;
+    
+    const eth_header_t* eth = (const eth_header_t*)frame;
+    if (len < ETH_HEADER_SIZE + IP_HEADER_SIZE + 4 || ntohs(eth->type) != ETH_TYPE_IP) {
+        return 0;
+    }
+    
+    const ip_header_t* ip = (const ip_header_t*)(frame + ETH_HEADER_SIZE);
+    uint32_t header_len = (ip->version_ihl & 0x0F) * 4;
+    uint32_t hash = 2166136261u;
+    const uint8_t* addrs = (const uint8_t*)&ip->src_ip;
+    
+    for (int i = 0; i < 2 * IP_ADDR_LEN; i++) {
+        hash = (hash ^ addrs[i]) * 16777619u;
+    }
+    
+    // Portas de TCP/UDP (primeiros 4 bytes do cabeçalho L4)
+    if ((ip->protocol == IP_PROTO_TCP || ip->protocol == IP_PROTO_UDP) &&
+        ETH_HEADER_SIZE + header_len + 4 <= len) {
+        const uint8_t* ports = frame + ETH_HEADER_SIZE + header_len;
+        for (int i = 0; i < 4; i++) {
+            hash = (hash ^ ports[i]) * 16777619u;
+        }
+    }
+    
+    return (hash ^ (hash >> 16)) % dev->tx_queues;
+}
+
+// Frame recebido pela fila 'queue' (sem o CRC): conta e entrega à pilha
+void netdev_receive(netdev_t* dev, uint8_t queue, const uint8_t* frame, uint32_t len,
+                    uint8_t flags) {
+    netdev_queue_stats_t* stats = &dev->rx[queue];
+    
+    if (len < ETH_HEADER_SIZE) {
+        stats->errors++;
+        return;
+    }
+    
+    stats->packets++;
+    stats->bytes += len;
+    eth_receive_frame(dev, frame, len, flags);
+}
+
+// Frame num buffer do pool que o driver empresta à pilha. Retorna o
+// buffer que volta ao anel: o mesmo, ou um novo se a pilha ficou com ele
+netbuf_t* netdev_receive_buf(netdev_t* dev, uint8_t queue, netbuf_t* buf, uint16_t offset,
+                             uint32_t len, uint8_t flags) {
+    buf->offset = offset;
+    buf->len = (uint16_t)len;
+    
+    rx_loan = buf;
+    rx_loan_spare = 0;
+    netdev_receive(dev, queue, buf->data + offset, len, flags);
+    rx_loan = 0;
+    
+    return rx_loan_spare ? rx_loan_spare : buf;
+}
+
+// ============================================================================
+// BUFFERS DE PACOTE
+// ============================================================================
+
+void netbuf_init(void) {
+    netbuf_free_list = 0;
+    for (int i = NETBUF_COUNT - 1; i >= 0; i--) {
+        netbufs[i].next = netbuf_free_list;
+        netbuf_free_list = &netbufs[i];
+    }
+    
+    memory_set(&netbuf_stats, 0, sizeof(netbuf_stats));
+    netbuf_stats.free = NETBUF_COUNT;
+    netbuf_stats.min_free = NETBUF_COUNT;
+}
+
+netbuf_t* netbuf_alloc(void) {
+    uint32_t flags = irq_save();
+    netbuf_t* buf = netbuf_free_list;
+    
+    if (buf) {
+        netbuf_free_list = buf->next;
+        buf->next = 0;
+        buf->offset = 0;
+        buf->len = 0;
+        buf->ext_data = 0;
+        if (--netbuf_stats.free < netbuf_stats.min_free) {
+            netbuf_stats.min_free = netbuf_stats.free;
+        }
+    } else {
+        netbuf_stats.alloc_failures++;
+    }
+    irq_restore(flags);
+    return buf;
+}
+
+void netbuf_free(netbuf_t* buf) {
+    if (!buf) return;
+    
+    uint32_t flags = irq_save();
+    buf->next = netbuf_free_list;
+    netbuf_free_list = buf;
+    netbuf_stats.free++;
+    irq_restore(flags);
+}
+
+// Fica com os len bytes em data, parte do frame em processamento. Se o
+// frame está num buffer emprestado, a pilha fica com ele (e o driver
+// recebe outro do pool); senão os bytes são copiados para um buffer
+// novo. Em ambos os casos buf->data + buf->offset equivale a data.
+// Retorna 0 se o pool está vazio
+netbuf_t* netbuf_take(const uint8_t* data, uint32_t len) {
+    netbuf_t* loan = rx_loan;
+    
+    if (loan && !rx_loan_spare && data >= loan->data && data + len <= loan->data + NETBUF_SIZE) {
+        rx_loan_spare = netbuf_alloc();
+        if (!rx_loan_spare) return 0;
+        
+        loan->offset = (uint16_t)(data - loan->data);
+        loan->len = (uint16_t)len;
+        netbuf_stats.loaned++;
+        return loan;
+    }
+    
+    if (len > NETBUF_SIZE) return 0;
+    
+    netbuf_t* buf = netbuf_alloc();
+    if (!buf) return 0;
+    
+    memory_copy(buf->data, data, len);
+    buf->len = (uint16_t)len;
+    netbuf_stats.copied++;
+    return buf;
+}
+
+const netbuf_stats_t* netbuf_get_stats(void) {
+    return &netbuf_stats;
+}
+
+// ============================================================================
+// POLLING DE RECEPÇÃO
+// ============================================================================
+
+// Chamada pela interrupção de RX do driver: mascara a recepção e deixa a
+// colheita para netdev_poll. Interrupções seguidas não geram trabalho extra
+void netdev_rx_schedule(netdev_t* dev) {
+    if (dev->rx_scheduled) return;
+    
+    dev->ops->rx_irq_disable(dev);
+    dev->rx_scheduled = 1;
+    dev->poll.schedules++;
+}
+
+// Uma passada por dispositivo agendado, com no máximo NETDEV_POLL_BUDGET
+// frames cada, para que uma placa sob carga não monopolize o laço. Quem
+// esvazia o anel religa a interrupção. Retorna os frames colhidos
+int netdev_poll(void) {
+    int total = 0;
+    
+    for (int i = 0; i < device_count; i++) {
+        netdev_t* dev = &devices[i];
+        
+        if (!dev->rx_scheduled) continue;
+        
+        uint64_t start = tsc_read();
+        int done = dev->ops->poll(dev, NETDEV_POLL_BUDGET);
+        
+        dev->poll.cycles += tsc_read() - start;
+        dev->poll.polls++;
+        dev->poll.packets += done;
+        if ((uint32_t)done > dev->poll.max_packets) dev->poll.max_packets = done;
+        total += done;
+        
+        if (done >= NETDEV_POLL_BUDGET) {
+            dev->poll.budget_exhausted++;
+            continue;  // Ainda há frames: continua agendado
+        }
+        
+        uint32_t flags = irq_save();
+        dev->rx_scheduled = 0;
+        if (dev->ops->rx_irq_enable(dev)) {
+            netdev_rx_schedule(dev);  // Chegou frame antes da interrupção voltar
+        }
+        irq_restore(flags);
+    }
+    
+    return total;
+}
+
+// Algum dispositivo ainda tem frames a colher (o laço principal não para)
+int netdev_poll_pending(void) {
+    for (int i = 0; i < device_count; i++) {
+        if (devices[i].rx_scheduled) return 1;
+    }
+    return 0;
+}
+
+// ============================================================================
+// DIAGNÓSTICO
+// ============================================================================
+
+static void netdev_print_queue(const char* label, int queue, const netdev_queue_stats_t* stats) {
+    terminal_print("    ");
+    terminal_print(label);
+    terminal_print_dec(queue);
+    terminal_print(": ");
+    terminal_print_dec(stats->packets);
+    terminal_print(" pacotes, ");
+    terminal_print_dec(stats->bytes);
+    terminal_print(" bytes, ");
+    terminal_print_dec(stats->errors);
+    terminal_print(" erros, ");
+    terminal_print_dec(stats->drops);
+    terminal_print(" descartes\n");
+}
+
+// Contadores por fila de uma interface
+void netdev_print_stats(const netdev_t* dev) {
+    terminal_print("  ");
+    terminal_print(dev->name);
+    terminal_print(" (");
+    terminal_print(dev->driver);
+    terminal_print(dev->link_up ? ", link ativo)\n" : ", sem link)\n");
+    
+    if (dev->features) {
+        terminal_print("    Offload:");
+        if (dev->features & NETDEV_F_TX_CSUM) terminal_print(" csum-tx");
+        if (dev->features & NETDEV_F_RX_CSUM) terminal_print(" csum-rx");
+        terminal_print("\n");
+    }
+    
+    for (int q = 0; q < dev->rx_queues; q++) {
+        netdev_print_queue("RX", q, &dev->rx[q]);
+    }
+    for (int q = 0; q < dev->tx_queues; q++) {
+        netdev_print_queue("TX", q, &dev->tx[q]);
+    }
+    
+    const netdev_poll_stats_t* poll = &dev->poll;
+    uint32_t per_poll = poll->polls ? poll->packets * 10 / poll->polls : 0;
+    uint32_t poll_us = tsc_to_us(poll->cycles);
+    
+    terminal_print("    Polling: ");
+    terminal_print_dec(poll->schedules);
+    terminal_print(" interrupcoes de RX, ");
+    terminal_print_dec(poll->polls);
+    terminal_print(" passadas, ");
+    terminal_print_dec(per_poll / 10);
+    terminal_print(".");
+    terminal_print_dec(per_poll % 10);
+    terminal_print(" pacotes/passada (max ");
+    terminal_print_dec(poll->max_packets);
+    terminal_print(", orcamento esgotado ");
+    terminal_print_dec(poll->budget_exhausted);
+    terminal_print("x)\n    Tempo de polling: ");
+    terminal_print_dec(poll_us);
+    terminal_print(" us (");
+    terminal_print_dec(poll->polls ? poll_us / poll->polls : 0);
+    terminal_print(" us/passada)\n");
+    
+    if (dev->ops->print_stats) {
+        dev->ops->print_stats(dev);
+    }
+}
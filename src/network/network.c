@@ -1,9 +1,16 @@
 // ============================================================================
-// NanoOS - Driver de Rede RTL8139
-// Driver básico para placa de rede Ethernet RTL8139
+// NanoOS - Pilha de Rede
+// Ethernet, ARP, IPv4 e eco ICMP sobre a camada de dispositivos de rede.
+// Sem placa, a interface roda em modo simulado para demonstração
 // ============================================================================
 
 #include "../../include/network.h"
+#include "../../include/netdev.h"
+#include "../../include/rtl8139.h"
+#include "../../include/virtio_net.h"
+#include "../../include/e1000.h"
+#include "../../include/udp.h"
+#include "../../include/tcp.h"
 #include "../../include/kernel.h"
 #include <stdint.h>
 #include <stddef.h>
@@ -12,60 +19,69 @@
 // VARIÁVEIS GLOBAIS
 // ============================================================================
 
-static rtl8139_device_t rtl8139;
 static network_interface_t net_interface;
-static arp_entry_t arp_table[ARP_TABLE_SIZE];
-static uint8_t rx_buffer[8192 + 16 + 1500]; // Buffer de recepção
-static uint8_t tx_buffers[4][1536];         // 4 buffers de transmissão
-
-// ============================================================================
-// FUNÇÕES AUXILIARES
-// ============================================================================
-
-// Leitura/Escrita de registradores
-static inline uint8_t rtl8139_read8(uint16_t reg) {
-    return inb(rtl8139.io_base + reg);
-}
 
-static inline uint16_t rtl8139_read16(uint16_t reg) {
-    return inw(rtl8139.io_base + reg);
-}
+// Cache ARP: tabela hash pelo IP, LRU para reaproveitar entradas e um
+// pool de pacotes aguardando resolução
+static arp_entry_t arp_table[ARP_TABLE_SIZE];
+static arp_entry_t* arp_hash_table[ARP_HASH_SIZE];
+static arp_entry_t* arp_lru_head = 0;      // Mais recente
+static arp_entry_t* arp_lru_tail = 0;      // Candidata a despejo
+static arp_pending_t arp_pending[ARP_QUEUE_SIZE];
+static arp_pending_t* arp_pending_free = 0;
+static arp_stats_t arp_stats;
 
-static inline uint32_t rtl8139_read32(uint16_t reg) {
-    return inl(rtl8139.io_base + reg);
-}
+// Frames montados para envio (protegidos por irq_save: a recepção roda no
+// polling e também responde)
+static uint8_t tx_frame[ETH_FRAME_SIZE];
+static uint8_t ip_packet[ETH_MTU];
+static uint16_t ip_next_id = 1;
 
-static inline void rtl8139_write8(uint16_t reg, uint8_t val) {
-    outb(rtl8139.io_base + reg, val);
-}
+// O frame em processamento teve o checksum L4 validado pela placa
+// (NETDEV_RX_CSUM_VALID); UDP e TCP podem pular a soma em software
+static uint8_t rx_checksum_valid = 0;
 
-static inline void rtl8139_write16(uint16_t reg, uint16_t val) {
-    outw(rtl8139.io_base + reg, val);
-}
+// Sessão do ping em andamento
+static ping_session_t ping;
 
-static inline void rtl8139_write32(uint16_t reg, uint32_t val) {
-    outl(rtl8139.io_base + reg, val);
-}
+static const mac_addr_t broadcast_mac = {{0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}};
 
 // ============================================================================
-// INICIALIZAÇÃO DO DRIVER
+// INICIALIZAÇÃO
 // ============================================================================
 
 void network_init(void) {
     terminal_print("Inicializando subsistema de rede...\n");
     
-    // Inicializar tabela ARP
+    // Inicializar tabela ARP, remontagem IP, buffers de pacote (usados
+    // pelos anéis RX), UDP e TCP
     arp_init();
+    ip_frag_init();
+    netbuf_init();
+    udp_init();
+    tcp_init();
     
-    // Tentar inicializar RTL8139
+    // Drivers em ordem de preferência: a primeira placa registrada (eth0)
+    // é a interface da pilha
+    if (virtio_net_init() == 0) {
+        terminal_print("Placa de rede virtio-net detectada e inicializada\n");
+    }
+    if (e1000_init() == 0) {
+        terminal_print("Placa de rede e1000 detectada e inicializada\n");
+    }
     if (rtl8139_init() == 0) {
         terminal_print("Placa de rede RTL8139 detectada e inicializada\n");
-        network_interface_init();
+    }
+    
+    if (netdev_count() > 0) {
+        network_interface_init(netdev_get(0));
     } else {
         terminal_print("Nenhuma placa de rede compatível encontrada\n");
         terminal_print("Modo simulado de rede ativado para demonstração\n");
         
         // Configurar interface simulada
+        net_interface.dev = 0;
+        net_interface.mtu = ETH_MTU;
         net_interface.enabled = 1;
         string_copy("eth0", net_interface.name);
         
@@ -97,85 +113,464 @@ void network_init(void) {
     }
 }
 
-int rtl8139_init(void) {
-    // Simular detecção de hardware (em um OS real, seria via PCI)
-    // Para demonstração, assumimos que não há hardware
-    return -1;
+// Associa a interface à placa. O endereçamento é o da rede de usuário do
+// QEMU (10.0.2.0/24, gateway 10.0.2.2), que não tem DHCP aqui
+void network_interface_init(struct netdev* dev) {
+    static const ip_addr_t ip = {{10, 0, 2, 15}};
+    static const ip_addr_t mask = {{255, 255, 255, 0}};
+    static const ip_addr_t gateway = {{10, 0, 2, 2}};
+    
+    net_interface.dev = dev;
+    net_interface.mac_address = dev->mac;
+    net_interface.ip_address = ip;
+    net_interface.subnet_mask = mask;
+    net_interface.gateway = gateway;
+    net_interface.mtu = ETH_MTU;
+    net_interface.enabled = 1;
+    string_copy(dev->name, net_interface.name);
+    terminal_print("Interface de rede ");
+    terminal_print(dev->name);
+    terminal_print(" configurada\n");
 }
 
-void network_interface_init(void) {
-    net_interface.enabled = 1;
-    string_copy("eth0", net_interface.name);
-    terminal_print("Interface de rede eth0 configurada\n");
+const network_interface_t* network_get_interface(void) {
+    return &net_interface;
 }
 
 // ============================================================================
-// TABELA ARP
+// CACHE ARP
 // ============================================================================
 
+// Chave de 32 bits do IP (os bytes na ordem da rede)
+static inline uint32_t arp_key(const ip_addr_t* ip) {
+    return ((uint32_t)ip->addr[0] << 24) | ((uint32_t)ip->addr[1] << 16) |
+           ((uint32_t)ip->addr[2] << 8) | ip->addr[3];
+}
+
+// Bucket do IP - hash multiplicativo de Knuth
+static inline uint32_t arp_hash(uint32_t key) {
+    return (key * 2654435761u >> 16) & (ARP_HASH_SIZE - 1);
+}
+
+static arp_entry_t* arp_find(const ip_addr_t* ip) {
+    uint32_t key = arp_key(ip);
+    arp_entry_t* entry = arp_hash_table[arp_hash(key)];
+    
+    while (entry) {
+        if (arp_key(&entry->ip) == key) return entry;
+        entry = entry->hash_next;
+    }
+    return 0;
+}
+
+static void arp_hash_remove(arp_entry_t* entry) {
+    arp_entry_t** link = &arp_hash_table[arp_hash(arp_key(&entry->ip))];
+    
+    while (*link) {
+        if (*link == entry) {
+            *link = entry->hash_next;
+            entry->hash_next = 0;
+            return;
+        }
+        link = &(*link)->hash_next;
+    }
+}
+
+// Remove a entrada da lista LRU
+static void arp_lru_unlink(arp_entry_t* entry) {
+    if (entry->lru_prev) entry->lru_prev->lru_next = entry->lru_next;
+    else arp_lru_head = entry->lru_next;
+    
+    if (entry->lru_next) entry->lru_next->lru_prev = entry->lru_prev;
+    else arp_lru_tail = entry->lru_prev;
+    
+    entry->lru_prev = 0;
+    entry->lru_next = 0;
+}
+
+// Move a entrada para a cabeça (mais recente)
+static void arp_lru_touch(arp_entry_t* entry) {
+    if (arp_lru_head == entry) return;
+    
+    arp_lru_unlink(entry);
+    entry->lru_next = arp_lru_head;
+    if (arp_lru_head) arp_lru_head->lru_prev = entry;
+    arp_lru_head = entry;
+    if (!arp_lru_tail) arp_lru_tail = entry;
+}
+
+// Move a entrada para a cauda (primeira a ser reaproveitada)
+static void arp_lru_demote(arp_entry_t* entry) {
+    if (arp_lru_tail == entry) return;
+    
+    arp_lru_unlink(entry);
+    entry->lru_prev = arp_lru_tail;
+    if (arp_lru_tail) arp_lru_tail->lru_next = entry;
+    arp_lru_tail = entry;
+    if (!arp_lru_head) arp_lru_head = entry;
+}
+
+// Devolve os pacotes pendentes da entrada ao pool, descartando-os
+static void arp_queue_drop(arp_entry_t* entry) {
+    while (entry->queue_head) {
+        arp_pending_t* pkt = entry->queue_head;
+        entry->queue_head = pkt->next;
+        pkt->next = arp_pending_free;
+        arp_pending_free = pkt;
+        arp_stats.dropped++;
+    }
+    entry->queue_tail = 0;
+    entry->queued = 0;
+}
+
+// Libera a entrada: sai do hash e vai para a cauda da LRU
+static void arp_release(arp_entry_t* entry) {
+    arp_queue_drop(entry);
+    arp_hash_remove(entry);
+    entry->state = ARP_STATE_FREE;
+    arp_lru_demote(entry);
+}
+
+// Entrada nova para o IP: reaproveita a menos usada da LRU
+static arp_entry_t* arp_alloc(const ip_addr_t* ip) {
+    arp_entry_t* entry = arp_lru_tail;
+    
+    if (entry->state != ARP_STATE_FREE) {
+        arp_release(entry);
+        arp_stats.evictions++;
+    }
+    
+    entry->ip = *ip;
+    entry->retries = 0;
+    entry->hits = 0;
+    entry->confirmed = timer_ticks;
+    entry->requested = 0;
+    entry->used = timer_ticks;
+    
+    uint32_t h = arp_hash(arp_key(ip));
+    entry->hash_next = arp_hash_table[h];
+    arp_hash_table[h] = entry;
+    arp_lru_touch(entry);
+    return entry;
+}
+
+// Enfileira um pacote IP pronto até o vizinho responder. Cheia, a fila do
+// vizinho perde o pacote mais antigo
+static void arp_queue_packet(arp_entry_t* entry, const uint8_t* packet, size_t len) {
+    arp_pending_t* pkt = arp_pending_free;
+    
+    if (entry->queued >= ARP_QUEUE_PER_ENTRY || (!pkt && entry->queue_head)) {
+        pkt = entry->queue_head;
+        entry->queue_head = pkt->next;
+        if (!entry->queue_head) entry->queue_tail = 0;
+        entry->queued--;
+        arp_stats.dropped++;
+    } else if (pkt) {
+        arp_pending_free = pkt->next;
+    } else {
+        arp_stats.dropped++;
+        return;
+    }
+    
+    memory_copy(pkt->data, packet, len);
+    pkt->len = (uint16_t)len;
+    pkt->next = 0;
+    if (entry->queue_tail) entry->queue_tail->next = pkt;
+    else entry->queue_head = pkt;
+    entry->queue_tail = pkt;
+    entry->queued++;
+    arp_stats.queued++;
+}
+
+// Vizinho resolvido: envia a fila pendente na ordem de chegada
+static void arp_queue_flush(arp_entry_t* entry) {
+    while (entry->queue_head) {
+        arp_pending_t* pkt = entry->queue_head;
+        entry->queue_head = pkt->next;
+        entry->queued--;
+        
+        eth_send_frame(pkt->data, pkt->len, &entry->mac, ETH_TYPE_IP);
+        arp_stats.flushed++;
+        
+        pkt->next = arp_pending_free;
+        arp_pending_free = pkt;
+    }
+    entry->queue_tail = 0;
+}
+
+static void arp_send_request(arp_entry_t* entry) {
+    entry->retries++;
+    entry->requested = timer_ticks;
+    arp_stats.requests++;
+    arp_request(&entry->ip);
+}
+
 void arp_init(void) {
+    for (int i = 0; i < ARP_HASH_SIZE; i++) {
+        arp_hash_table[i] = 0;
+    }
+    
+    // Todas as entradas livres na lista LRU
+    arp_lru_head = 0;
+    arp_lru_tail = 0;
     for (int i = 0; i < ARP_TABLE_SIZE; i++) {
-        arp_table[i].valid = 0;
+        arp_entry_t* entry = &arp_table[i];
+        
+        memory_set(entry, 0, sizeof(arp_entry_t));
+        entry->lru_prev = arp_lru_tail;
+        if (arp_lru_tail) arp_lru_tail->lru_next = entry;
+        else arp_lru_head = entry;
+        arp_lru_tail = entry;
     }
+    
+    arp_pending_free = 0;
+    for (int i = 0; i < ARP_QUEUE_SIZE; i++) {
+        arp_pending[i].next = arp_pending_free;
+        arp_pending_free = &arp_pending[i];
+    }
+    
+    memory_set(&arp_stats, 0, sizeof(arp_stats));
 }
 
+// MAC do vizinho. Uma entrada STALE continua valendo, mas o uso dispara
+// uma nova requisição para revalidá-la; se nenhuma for respondida, o
+// vizinho é esquecido
 int arp_lookup(const ip_addr_t* ip, mac_addr_t* mac) {
-    for (int i = 0; i < ARP_TABLE_SIZE; i++) {
-        if (arp_table[i].valid) {
-            if (memory_compare(&arp_table[i].ip, ip, sizeof(ip_addr_t)) == 0) {
-                memory_copy(mac, &arp_table[i].mac, sizeof(mac_addr_t));
-                return 0;
-            }
+    arp_entry_t* entry = arp_find(ip);
+    
+    if (entry && entry->state == ARP_STATE_REACHABLE &&
+        timer_ticks - entry->confirmed >= ARP_REACHABLE_TICKS) {
+        entry->state = ARP_STATE_STALE;
+    }
+    if (entry && entry->state == ARP_STATE_STALE &&
+        timer_ticks - entry->requested >= ARP_RETRY_TICKS) {
+        if (entry->retries >= ARP_MAX_RETRIES) {
+            arp_stats.failures++;
+            arp_release(entry);
+            entry = 0;
+        } else {
+            arp_send_request(entry);
         }
     }
-    return -1;
+    
+    if (!entry || entry->state == ARP_STATE_INCOMPLETE) {
+        arp_stats.misses++;
+        return -1;
+    }
+    
+    *mac = entry->mac;
+    entry->used = timer_ticks;
+    entry->hits++;
+    arp_stats.hits++;
+    arp_lru_touch(entry);
+    return 0;
 }
 
+// Confirmação do vizinho: entrada REACHABLE e fila pendente enviada
 void arp_add_entry(const ip_addr_t* ip, const mac_addr_t* mac) {
-    // Procurar slot vazio ou substituir o mais antigo
+    arp_entry_t* entry = arp_find(ip);
+    
+    if (!entry) entry = arp_alloc(ip);
+    
+    entry->mac = *mac;
+    entry->state = ARP_STATE_REACHABLE;
+    entry->retries = 0;
+    entry->confirmed = timer_ticks;
+    arp_lru_touch(entry);
+    arp_queue_flush(entry);
+}
+
+// Resolve o próximo salto de um pacote IP já montado. Sem MAC, o pacote
+// fica na fila do vizinho e sai quando a resposta chegar
+static int arp_resolve_and_send(const ip_addr_t* next_hop, const uint8_t* packet, size_t len) {
+    mac_addr_t mac;
+    
+    if (arp_lookup(next_hop, &mac) == 0) {
+        return eth_send_frame(packet, len, &mac, ETH_TYPE_IP);
+    }
+    
+    arp_entry_t* entry = arp_find(next_hop);
+    int new_entry = !entry;
+    
+    if (new_entry) {
+        entry = arp_alloc(next_hop);
+        entry->state = ARP_STATE_INCOMPLETE;
+    }
+    arp_queue_packet(entry, packet, len);
+    
+    // A requisição vem depois de enfileirar: no modo simulado a resposta
+    // é imediata e já envia a fila
+    if (new_entry) arp_send_request(entry);
+    return 0;
+}
+
+// Varredura periódica (chamada pelo polling da rede): reenvia requisições
+// sem resposta, desiste depois de ARP_MAX_RETRIES e remove entradas
+// STALE esquecidas
+void arp_timer(void) {
+    static uint32_t last_scan = 0;
+    uint32_t now = timer_ticks;
+    
+    if (now - last_scan < ARP_SCAN_TICKS) return;
+    last_scan = now;
+    
     for (int i = 0; i < ARP_TABLE_SIZE; i++) {
-        if (!arp_table[i].valid) {
-            memory_copy(&arp_table[i].ip, ip, sizeof(ip_addr_t));
-            memory_copy(&arp_table[i].mac, mac, sizeof(mac_addr_t));
-            arp_table[i].valid = 1;
-            return;
+        arp_entry_t* entry = &arp_table[i];
+        
+        switch (entry->state) {
+            case ARP_STATE_INCOMPLETE:
+                if (now - entry->requested < ARP_RETRY_TICKS) break;
+                if (entry->retries >= ARP_MAX_RETRIES) {
+                    arp_stats.failures++;
+                    arp_release(entry);
+                } else {
+                    arp_send_request(entry);
+                }
+                break;
+            case ARP_STATE_REACHABLE:
+                if (now - entry->confirmed >= ARP_REACHABLE_TICKS) {
+                    entry->state = ARP_STATE_STALE;
+                }
+                break;
+            case ARP_STATE_STALE:
+                if (now - entry->used >= ARP_STALE_TICKS) arp_release(entry);
+                break;
+            default:
+                break;
         }
     }
-    
-    // Se não há slots vazios, substitui o primeiro
-    memory_copy(&arp_table[0].ip, ip, sizeof(ip_addr_t));
-    memory_copy(&arp_table[0].mac, mac, sizeof(mac_addr_t));
-    arp_table[0].valid = 1;
 }
 
+// Requisição ARP em broadcast; a resposta chega por arp_receive
 void arp_request(const ip_addr_t* ip) {
+    if (net_interface.dev) {
+        arp_packet_t request;
+        
+        request.htype = htons(ARP_HTYPE_ETHERNET);
+        request.ptype = htons(ETH_TYPE_IP);
+        request.hlen = ETH_ADDR_LEN;
+        request.plen = IP_ADDR_LEN;
+        request.oper = htons(ARP_OP_REQUEST);
+        request.sha = net_interface.mac_address;
+        request.spa = net_interface.ip_address;
+        memory_set(&request.tha, 0, sizeof(mac_addr_t));
+        request.tpa = *ip;
+        
+        eth_send_frame((const uint8_t*)&request, sizeof(request), &broadcast_mac, ETH_TYPE_ARP);
+        return;
+    }
+    
     terminal_print("Enviando requisicao ARP para ");
     char ip_str[16];
     ip_to_string(ip, ip_str);
     terminal_print(ip_str);
     terminal_print("\n");
     
-    // Em um OS real, enviaria packet ARP
-    // Para demonstração, simular resposta
+    // Modo simulado: resposta imediata
     mac_addr_t fake_mac = {{0x52, 0x54, 0x00, 0x12, 0x34, 0x57}};
     arp_add_entry(ip, &fake_mac);
 }
 
+// Aprende o remetente e responde às requisições para o nosso IP
+void arp_receive(const uint8_t* packet, size_t len) {
+    const arp_packet_t* arp = (const arp_packet_t*)packet;
+    
+    if (len < sizeof(arp_packet_t) || ntohs(arp->htype) != ARP_HTYPE_ETHERNET ||
+        ntohs(arp->ptype) != ETH_TYPE_IP || arp->hlen != ETH_ADDR_LEN ||
+        arp->plen != IP_ADDR_LEN) {
+        return;
+    }
+    
+    int for_us = memory_compare(&arp->tpa, &net_interface.ip_address, sizeof(ip_addr_t)) == 0;
+    uint16_t oper = ntohs(arp->oper);
+    
+    // Fusão da RFC 826: atualiza a entrada do remetente se ela já existe
+    // (inclusive pendente); cria uma nova só se o pacote é para nós
+    if (for_us || arp_find(&arp->spa)) {
+        arp_add_entry(&arp->spa, &arp->sha);
+    }
+    
+    if (for_us && oper == ARP_OP_REQUEST) {
+        arp_packet_t reply;
+        
+        reply.htype = htons(ARP_HTYPE_ETHERNET);
+        reply.ptype = htons(ETH_TYPE_IP);
+        reply.hlen = ETH_ADDR_LEN;
+        reply.plen = IP_ADDR_LEN;
+        reply.oper = htons(ARP_OP_REPLY);
+        reply.sha = net_interface.mac_address;
+        reply.spa = net_interface.ip_address;
+        reply.tha = arp->sha;
+        reply.tpa = arp->spa;
+        
+        eth_send_frame((const uint8_t*)&reply, sizeof(reply), &arp->sha, ETH_TYPE_ARP);
+    }
+}
+
 // ============================================================================
 // FUNÇÕES DE TRANSMISSÃO
 // ============================================================================
 
-int eth_send_frame(const uint8_t* data, size_t len, const mac_addr_t* dst_mac, uint16_t type) {
+// Monta o cabeçalho Ethernet e entrega o frame à placa; com 'offload' o
+// checksum L4 fica por conta dela
+static int eth_send(const uint8_t* data, size_t len, const mac_addr_t* dst_mac, uint16_t type,
+                    const netdev_offload_t* offload) {
     if (!net_interface.enabled) {
         return -1;
     }
     
-    terminal_print("Enviando frame Ethernet (");
-    terminal_print_dec(len);
-    terminal_print(" bytes)\n");
+    if (!net_interface.dev) {
+        terminal_print("Enviando frame Ethernet (");
+        terminal_print_dec(len);
+        terminal_print(" bytes)\n");
+        return 0;
+    }
+    
+    if (len > ETH_MTU) return -1;
     
-    // Em um OS real, montaria o frame e enviaria via hardware
-    return 0;
+    uint32_t flags = irq_save();
+    eth_header_t* eth = (eth_header_t*)tx_frame;
+    
+    eth->dst_mac = *dst_mac;
+    eth->src_mac = net_interface.mac_address;
+    eth->type = htons(type);
+    memory_copy(tx_frame + ETH_HEADER_SIZE, data, len);
+    
+    int result = offload ? netdev_transmit_offload(net_interface.dev, tx_frame,
+                                                   ETH_HEADER_SIZE + len, offload)
+                         : netdev_transmit(net_interface.dev, tx_frame, ETH_HEADER_SIZE + len);
+    irq_restore(flags);
+    return result;
+}
+
+int eth_send_frame(const uint8_t* data, size_t len, const mac_addr_t* dst_mac, uint16_t type) {
+    return eth_send(data, len, dst_mac, type, 0);
+}
+
+// Próximo salto: o próprio destino na sub-rede local, senão o gateway
+static const ip_addr_t* ip_next_hop(const ip_addr_t* dst_ip) {
+    for (int i = 0; i < IP_ADDR_LEN; i++) {
+        uint8_t mask = net_interface.subnet_mask.addr[i];
+        if ((dst_ip->addr[i] & mask) != (net_interface.ip_address.addr[i] & mask)) {
+            return &net_interface.gateway;
+        }
+    }
+    return dst_ip;
+}
+
+// Cabeçalho IPv4 sem opções (checksum zerado)
+static void ip_build_header(ip_header_t* ip, size_t len, const ip_addr_t* dst_ip,
+                            uint8_t protocol) {
+    ip->version_ihl = 0x45;
+    ip->tos = 0;
+    ip->length = htons(IP_HEADER_SIZE + len);
+    ip->id = htons(ip_next_id++);
+    ip->flags_offset = 0;
+    ip->ttl = IP_DEFAULT_TTL;
+    ip->protocol = protocol;
+    ip->checksum = 0;
+    ip->src_ip = net_interface.ip_address;
+    ip->dst_ip = *dst_ip;
 }
 
 int ip_send(const uint8_t* data, size_t len, const ip_addr_t* dst_ip, uint8_t protocol) {
@@ -183,64 +578,311 @@ int ip_send(const uint8_t* data, size_t len, const ip_addr_t* dst_ip, uint8_t pr
         return -1;
     }
     
-    terminal_print("Enviando pacote IP para ");
-    char ip_str[16];
-    ip_to_string(dst_ip, ip_str);
-    terminal_print(ip_str);
-    terminal_print("\n");
+    if (!net_interface.dev) {
+        terminal_print("Enviando pacote IP para ");
+        char ip_str[16];
+        ip_to_string(dst_ip, ip_str);
+        terminal_print(ip_str);
+        terminal_print("\n");
+    }
+    
+    if (len > IP_MAX_PAYLOAD) return -1;
+    
+    uint32_t flags = irq_save();
+    ip_header_t* ip = (ip_header_t*)ip_packet;
+    int result;
+    
+    ip_build_header(ip, len, dst_ip, protocol);
+    
+    // Acima da MTU, o cabeçalho serve de modelo para os fragmentos
+    if (IP_HEADER_SIZE + len <= net_interface.mtu) {
+        ip->checksum = calculate_checksum(ip, IP_HEADER_SIZE);
+        memory_copy(ip_packet + IP_HEADER_SIZE, data, len);
+        result = arp_resolve_and_send(ip_next_hop(dst_ip), ip_packet, IP_HEADER_SIZE + len);
+    } else {
+        result = ip_fragment(ip, data, len, net_interface.mtu);
+    }
+    irq_restore(flags);
+    return result;
+}
+
+// Envia um segmento TCP/UDP cujo checksum (em 'csum_offset' do cabeçalho
+// L4) a placa completa quando anuncia NETDEV_F_TX_CSUM: o campo leva só a
+// soma do pseudo-cabeçalho. Sem a capacidade, acima da MTU ou sem MAC do
+// próximo salto (a fila ARP guarda pacotes prontos), a soma é feita aqui
+int ip_send_l4(uint8_t* segment, size_t len, const ip_addr_t* dst_ip, uint8_t protocol,
+               uint16_t csum_offset) {
+    uint16_t* csum = (uint16_t*)(segment + csum_offset);
+    netdev_t* dev = net_interface.dev;
+    mac_addr_t mac;
     
-    // Verificar se destino está na mesma rede
-    mac_addr_t dst_mac;
-    if (arp_lookup(dst_ip, &dst_mac) != 0) {
-        // Não encontrado na tabela ARP, fazer requisição
-        arp_request(dst_ip);
-        return -1; // Tentar novamente depois
+    *csum = 0;
+    if (!net_interface.enabled || !dev || !(dev->features & NETDEV_F_TX_CSUM) ||
+        IP_HEADER_SIZE + len > net_interface.mtu ||
+        arp_lookup(ip_next_hop(dst_ip), &mac) != 0) {
+        uint16_t sum = l4_checksum(&net_interface.ip_address, dst_ip, protocol, segment, len);
+        
+        // Em UDP, 0 significa "sem checksum"
+        *csum = (sum == 0 && protocol == IP_PROTO_UDP) ? 0xFFFF : sum;
+        return ip_send(segment, len, dst_ip, protocol);
     }
     
-    // Em um OS real, montaria cabeçalho IP e enviaria
-    return eth_send_frame(data, len + sizeof(ip_header_t), &dst_mac, ETH_TYPE_IP);
+    *csum = ~checksum_finish(l4_pseudo_sum(&net_interface.ip_address, dst_ip, protocol, len));
+    
+    uint32_t flags = irq_save();
+    ip_header_t* ip = (ip_header_t*)ip_packet;
+    netdev_offload_t offload;
+    
+    ip_build_header(ip, len, dst_ip, protocol);
+    ip->checksum = calculate_checksum(ip, IP_HEADER_SIZE);
+    memory_copy(ip_packet + IP_HEADER_SIZE, segment, len);
+    
+    offload.csum_start = ETH_HEADER_SIZE + IP_HEADER_SIZE;
+    offload.csum_offset = csum_offset;
+    
+    int result = eth_send(ip_packet, IP_HEADER_SIZE + len, &mac, ETH_TYPE_IP, &offload);
+    irq_restore(flags);
+    return result;
 }
 
-int ping_send(const ip_addr_t* dst_ip, uint16_t id, uint16_t seq) {
-    terminal_print("PING ");
-    char ip_str[16];
-    ip_to_string(dst_ip, ip_str);
-    terminal_print(ip_str);
-    terminal_print(" (");
-    terminal_print_dec(id);
-    terminal_print(":");
-    terminal_print_dec(seq);
-    terminal_print(")\n");
+// MAC do próximo salto de dst_ip. Se ainda não é conhecido, dispara a
+// requisição ARP (sem enfileirar nada) e retorna -1
+int ip_next_hop_mac(const ip_addr_t* dst_ip, mac_addr_t* mac) {
+    const ip_addr_t* next_hop = ip_next_hop(dst_ip);
     
-    // Simular ping bem-sucedido
-    terminal_print("64 bytes de ");
-    terminal_print(ip_str);
-    terminal_print(": icmp_seq=");
-    terminal_print_dec(seq);
-    terminal_print(" ttl=64 tempo=1ms\n");
+    if (arp_lookup(next_hop, mac) == 0) return 0;
     
-    return 0;
+    if (!arp_find(next_hop)) {
+        arp_entry_t* entry = arp_alloc(next_hop);
+        entry->state = ARP_STATE_INCOMPLETE;
+        arp_send_request(entry);
+    }
+    return arp_lookup(next_hop, mac);  // O modo simulado responde na hora
+}
+
+// Resolve o MAC do próximo salto de dst_ip antes de um envio em massa,
+// processando a rede enquanto espera a resposta ARP
+int ip_resolve(const ip_addr_t* dst_ip, uint32_t timeout_ms) {
+    const ip_addr_t* next_hop = ip_next_hop(dst_ip);
+    mac_addr_t mac;
+    
+    if (!net_interface.dev) return -1;
+    if (ip_next_hop_mac(dst_ip, &mac) == 0) return 0;
+    
+    arp_entry_t* entry = arp_find(next_hop);
+    
+    uint64_t deadline = tsc_read() + (uint64_t)timeout_ms * tsc_khz;
+    while (tsc_read() < deadline) {
+        network_process_packets();
+        if (entry->state != ARP_STATE_INCOMPLETE) break;
+    }
+    return arp_lookup(next_hop, &mac);
+}
+
+// Eco ICMP com size bytes de dados: o TSC do envio nos 8 primeiros (o
+// RTT sai da própria resposta) e um padrão no resto
+int ping_send(const ip_addr_t* dst_ip, uint16_t id, uint16_t seq, size_t size) {
+    static uint8_t request[sizeof(icmp_header_t) + PING_MAX_SIZE];
+    icmp_header_t* icmp = (icmp_header_t*)request;
+    uint8_t* payload = request + sizeof(icmp_header_t);
+    
+    if (size < PING_MIN_SIZE || size > PING_MAX_SIZE) return -1;
+    
+    uint32_t flags = irq_save();
+    icmp->type = ICMP_ECHO_REQUEST;
+    icmp->code = 0;
+    icmp->id = htons(id);
+    icmp->seq = htons(seq);
+    for (size_t i = PING_MIN_SIZE; i < size; i++) {
+        payload[i] = (uint8_t)i;
+    }
+    
+    uint64_t now = tsc_read();
+    memory_copy(payload, &now, sizeof(now));
+    icmp->checksum = 0;
+    icmp->checksum = calculate_checksum(request, sizeof(icmp_header_t) + size);
+    
+    int result = ip_send(request, sizeof(icmp_header_t) + size, dst_ip, IP_PROTO_ICMP);
+    irq_restore(flags);
+    return result;
 }
 
 // ============================================================================
 // PROCESSAMENTO DE PACOTES
 // ============================================================================
 
-void network_process_packets(void) {
-    // Em um OS real, verificaria buffer de recepção
-    // Para demonstração, não faz nada
+// Colhe os frames das placas agendadas pela interrupção de RX. Chamada
+// pelo laço principal e por quem espera resposta da rede; retorna o
+// número de frames processados
+int network_process_packets(void) {
+    arp_timer();
+    ip_reasm_timer();
+    tcp_timer();
+    return netdev_poll();
+}
+
+// Frame entregue pela camada de dispositivos (durante o polling)
+void eth_receive_frame(struct netdev* dev, const uint8_t* frame, size_t len, uint8_t flags) {
+    const eth_header_t* eth = (const eth_header_t*)frame;
+    
+    if (dev != net_interface.dev) return;
+    rx_checksum_valid = (flags & NETDEV_RX_CSUM_VALID) != 0;
+    
+    switch (ntohs(eth->type)) {
+        case ETH_TYPE_ARP:
+            arp_receive(frame + ETH_HEADER_SIZE, len - ETH_HEADER_SIZE);
+            break;
+        case ETH_TYPE_IP:
+            ip_receive(frame + ETH_HEADER_SIZE, len - ETH_HEADER_SIZE);
+            break;
+        default:
+            break;
+    }
 }
 
-void eth_receive_frame(void) {
-    // Processamento de frames recebidos
+// Entrega os dados de um datagrama (inteiro ou remontado) ao protocolo
+static void ip_deliver(const ip_header_t* ip, const uint8_t* data, size_t len,
+                       uint8_t csum_valid) {
+    if (ip->protocol == IP_PROTO_ICMP) {
+        icmp_receive(&ip->src_ip, ip->ttl, data, len);
+    } else if (ip->protocol == IP_PROTO_UDP) {
+        udp_receive(ip, data, len, csum_valid);
+    } else if (ip->protocol == IP_PROTO_TCP) {
+        tcp_receive(ip, data, len, csum_valid);
+    }
 }
 
+// Valida o cabeçalho e entrega ao protocolo. Fragmentos vão para a
+// remontagem e o datagrama segue quando completo
 void ip_receive(const uint8_t* packet, size_t len) {
-    // Processamento de pacotes IP
+    const ip_header_t* ip = (const ip_header_t*)packet;
+    
+    if (len < IP_HEADER_SIZE || (ip->version_ihl >> 4) != 4) return;
+    
+    uint32_t header_len = (ip->version_ihl & 0x0F) * 4;
+    uint32_t total = ntohs(ip->length);
+    
+    if (header_len < IP_HEADER_SIZE || total < header_len || total > len ||
+        calculate_checksum(ip, header_len) != 0) {
+        return;
+    }
+    if (memory_compare(&ip->dst_ip, &net_interface.ip_address, sizeof(ip_addr_t)) != 0) {
+        return;
+    }
+    
+    if (ntohs(ip->flags_offset) & (IP_FLAG_MF | IP_OFFSET_MASK)) {
+        // A placa não confere o checksum L4 de um datagrama fragmentado
+        const ip_header_t* whole = ip_reasm_input(ip, header_len);
+        if (!whole) return;
+        
+        ip_deliver(whole, (const uint8_t*)whole + IP_HEADER_SIZE,
+                   ntohs(whole->length) - IP_HEADER_SIZE, 0);
+        ip_reasm_done(whole);
+        return;
+    }
+    
+    ip_deliver(ip, packet + header_len, total - header_len, rx_checksum_valid);
 }
 
+// Imprime ns como milissegundos com três casas
+static void print_ms(uint32_t ns) {
+    uint32_t us = ns / 1000;
+    
+    terminal_print_dec(us / 1000);
+    terminal_print(".");
+    if (us % 1000 < 100) terminal_print("0");
+    if (us % 1000 < 10) terminal_print("0");
+    terminal_print_dec(us % 1000);
+}
+
+// Resposta a um eco nosso: RTT pelo carimbo do TSC que voltou nos dados
+static void ping_receive(const ip_addr_t* src_ip, uint8_t ttl, const uint8_t* data, size_t len) {
+    const icmp_header_t* icmp = (const icmp_header_t*)data;
+    uint64_t now = tsc_read();
+    uint64_t sent_at;
+    
+    if (!ping.active || ntohs(icmp->id) != ping.id ||
+        memory_compare(src_ip, &ping.dst, sizeof(ip_addr_t)) != 0 ||
+        len < sizeof(icmp_header_t) + PING_MIN_SIZE) {
+        return;
+    }
+    
+    uint16_t seq = ntohs(icmp->seq);
+    uint32_t bit = 1u << (seq % 32);
+    uint32_t* seen = &ping.seen[(seq % PING_SEQ_WINDOW) / 32];
+    int duplicate = (*seen & bit) != 0;
+    
+    memory_copy(&sent_at, data + sizeof(icmp_header_t), sizeof(sent_at));
+    uint64_t cycles = now - sent_at;
+    uint32_t rtt = cycles >= (uint64_t)tsc_khz * 4000 ? 4000000000u : tsc_to_ns(cycles);
+    
+    if (duplicate) {
+        ping.duplicates++;
+    } else {
+        *seen |= bit;
+        ping.received++;
+        
+        uint32_t rtt_us = rtt / 1000;
+        if (ping.received == 1 || rtt < ping.rtt_min) ping.rtt_min = rtt;
+        if (rtt > ping.rtt_max) ping.rtt_max = rtt;
+        ping.rtt_sum += rtt;
+        ping.rtt_sum_sq += (uint64_t)rtt_us * rtt_us;
+        
+        // Balde 0: < 1 us; balde i: [2^(i-1), 2^i) us
+        uint32_t bucket = 0;
+        while (rtt_us && bucket < PING_HIST_BUCKETS - 1) {
+            rtt_us >>= 1;
+            bucket++;
+        }
+        ping.hist[bucket]++;
+    }
+    
+    if (ping.flood) {
+        if (!duplicate) terminal_print("\b");
+        return;
+    }
+    
+    char ip_str[16];
+    ip_to_string(src_ip, ip_str);
+    terminal_print_dec(len - sizeof(icmp_header_t));
+    terminal_print(" bytes de ");
+    terminal_print(ip_str);
+    terminal_print(": icmp_seq=");
+    terminal_print_dec(seq);
+    terminal_print(" ttl=");
+    terminal_print_dec(ttl);
+    terminal_print(" tempo=");
+    print_ms(rtt);
+    terminal_print(duplicate ? " ms (DUP!)\n" : " ms\n");
+}
+
+void icmp_receive(const ip_addr_t* src_ip, uint8_t ttl, const uint8_t* data, size_t len) {
+    const icmp_header_t* icmp = (const icmp_header_t*)data;
+    
+    if (len < sizeof(icmp_header_t) || calculate_checksum(data, len) != 0) return;
+    
+    if (icmp->type == ICMP_ECHO_REQUEST) {
+        icmp_reply(src_ip, data, len);
+    } else if (icmp->type == ICMP_ECHO_REPLY) {
+        ping_receive(src_ip, ttl, data, len);
+    }
+}
+
+// Responde a um eco com os mesmos id, sequência e dados
 void icmp_reply(const ip_addr_t* src_ip, const uint8_t* data, size_t len) {
-    // Resposta a ping
+    static uint8_t reply[IP_MAX_PAYLOAD];
+    icmp_header_t* icmp = (icmp_header_t*)reply;
+    
+    if (len > sizeof(reply)) return;
+    
+    uint32_t flags = irq_save();
+    memory_copy(reply, data, len);
+    icmp->type = ICMP_ECHO_REPLY;
+    icmp->code = 0;
+    icmp->checksum = 0;
+    icmp->checksum = calculate_checksum(reply, len);
+    ip_send(reply, len, src_ip, IP_PROTO_ICMP);
+    irq_restore(flags);
 }
 
 // ============================================================================
@@ -261,11 +903,12 @@ void ip_to_string(const ip_addr_t* ip, char* str) {
     int pos = 0;
     for (int i = 0; i < 4; i++) {
         uint8_t octet = ip->addr[i];
-        if (octet >= 100) {
+        int hundreds = octet >= 100;
+        if (hundreds) {
             str[pos++] = '0' + (octet / 100);
             octet %= 100;
         }
-        if (octet >= 10 || pos > 0) {
+        if (octet >= 10 || hundreds) {
             str[pos++] = '0' + (octet / 10);
             octet %= 10;
         }
@@ -298,9 +941,35 @@ int string_to_ip(const char* str, ip_addr_t* ip) {
     return -1;
 }
 
-uint16_t calculate_checksum(const void* data, size_t len) {
+// Próxima palavra de args em token; retorna o resto da linha
+const char* net_next_token(const char* args, char* token, size_t size) {
+    size_t n = 0;
+    
+    while (*args == ' ') args++;
+    while (*args && *args != ' ') {
+        if (n < size - 1) token[n++] = *args;
+        args++;
+    }
+    token[n] = '\0';
+    return args;
+}
+
+int net_parse_uint(const char* str, uint32_t* value) {
+    uint32_t result = 0;
+    
+    if (*str == '\0') return -1;
+    for (; *str; str++) {
+        if (*str < '0' || *str > '9' || result > 100000000) return -1;
+        result = result * 10 + (*str - '0');
+    }
+    *value = result;
+    return 0;
+}
+
+// Soma em complemento de um sem dobrar (vários trechos, o último pode
+// ter tamanho ímpar)
+uint32_t checksum_accumulate(uint32_t sum, const void* data, size_t len) {
     const uint16_t* ptr = (const uint16_t*)data;
-    uint32_t sum = 0;
     
     while (len > 1) {
         sum += *ptr++;
@@ -311,6 +980,10 @@ uint16_t calculate_checksum(const void* data, size_t len) {
         sum += *(uint8_t*)ptr;
     }
     
+    return sum;
+}
+
+uint16_t checksum_finish(uint32_t sum) {
     while (sum >> 16) {
         sum = (sum & 0xFFFF) + (sum >> 16);
     }
@@ -318,6 +991,26 @@ uint16_t calculate_checksum(const void* data, size_t len) {
     return ~sum;
 }
 
+uint16_t calculate_checksum(const void* data, size_t len) {
+    return checksum_finish(checksum_accumulate(0, data, len));
+}
+
+// Soma (não complementada) do pseudo-cabeçalho IPv4 de TCP/UDP
+uint32_t l4_pseudo_sum(const ip_addr_t* src, const ip_addr_t* dst, uint8_t protocol,
+                       size_t len) {
+    uint32_t sum = checksum_accumulate(0, src, sizeof(ip_addr_t));
+    
+    sum = checksum_accumulate(sum, dst, sizeof(ip_addr_t));
+    return sum + htons(protocol) + htons((uint16_t)len);
+}
+
+// Checksum de TCP/UDP: pseudo-cabeçalho IPv4 mais o segmento
+uint16_t l4_checksum(const ip_addr_t* src, const ip_addr_t* dst, uint8_t protocol,
+                     const void* data, size_t len) {
+    uint32_t sum = l4_pseudo_sum(src, dst, protocol, len);
+    return checksum_finish(checksum_accumulate(sum, data, len));
+}
+
 // ============================================================================
 // COMANDOS DE REDE
 // ============================================================================
@@ -331,6 +1024,12 @@ void cmd_ifconfig(void) {
     if (net_interface.enabled) {
         terminal_print("  Status: UP\n");
         
+        if (net_interface.dev) {
+            terminal_print("  Driver: ");
+            terminal_print(net_interface.dev->driver);
+            terminal_print(net_interface.dev->link_up ? " (link ativo)\n" : " (sem link)\n");
+        }
+        
         char mac_str[18];
         mac_to_string(&net_interface.mac_address, mac_str);
         terminal_print("  MAC: ");
@@ -352,66 +1051,308 @@ void cmd_ifconfig(void) {
         terminal_print("  Gateway: ");
         terminal_print(ip_str);
         terminal_print("\n");
+        
+        terminal_print("  MTU: ");
+        terminal_print_dec(net_interface.mtu);
+        terminal_print("\n");
     } else {
         terminal_print("  Status: DOWN\n");
     }
 }
 
-void cmd_ping(const char* target) {
-    if (!net_interface.enabled) {
-        terminal_print("Interface de rede nao disponivel\n");
+static void print_padded(const char* str, int width) {
+    terminal_print(str);
+    for (int i = string_length(str); i < width; i++) {
+        terminal_print(" ");
+    }
+}
+
+// Intervalo em segundos com até três casas decimais ("0.2") para ms
+static int parse_interval(const char* str, uint32_t* ms) {
+    uint32_t seconds = 0, frac = 0, digits = 0;
+    
+    if (*str == '\0') return -1;
+    for (; *str && *str != '.'; str++) {
+        if (*str < '0' || *str > '9' || seconds > 3600) return -1;
+        seconds = seconds * 10 + (*str - '0');
+    }
+    if (*str == '.') {
+        for (str++; *str; str++) {
+            if (*str < '0' || *str > '9') return -1;
+            if (digits < 3) {
+                frac = frac * 10 + (*str - '0');
+                digits++;
+            }
+        }
+    }
+    for (; digits < 3; digits++) frac *= 10;
+    
+    *ms = seconds * 1000 + frac;
+    return 0;
+}
+
+// Raiz quadrada inteira (bit a bit, sem divisão de 64 bits)
+static uint32_t isqrt64(uint64_t value) {
+    uint64_t result = 0;
+    uint64_t bit = 1ULL << 62;
+    
+    while (bit > value) bit >>= 2;
+    while (bit) {
+        if (value >= result + bit) {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)result;
+}
+
+// Resumo no formato do ping do Unix mais o histograma do RTT
+static void ping_print_summary(const char* target, uint32_t elapsed_ms) {
+    terminal_print("\n--- ");
+    terminal_print(target);
+    terminal_print(" estatisticas de ping ---\n");
+    terminal_print_dec(ping.sent);
+    terminal_print(" pacotes transmitidos, ");
+    terminal_print_dec(ping.received);
+    terminal_print(" recebidos, ");
+    if (ping.duplicates) {
+        terminal_print("+");
+        terminal_print_dec(ping.duplicates);
+        terminal_print(" duplicados, ");
+    }
+    terminal_print_dec(ping.sent ? (ping.sent - ping.received) * 100 / ping.sent : 0);
+    terminal_print("% perda de pacotes, tempo ");
+    terminal_print_dec(elapsed_ms);
+    terminal_print("ms\n");
+    
+    if (ping.received == 0) return;
+    
+    uint32_t avg = (uint32_t)div64_32(ping.rtt_sum, ping.received);
+    uint64_t mean_us = avg / 1000;
+    uint64_t mean_sq = div64_32(ping.rtt_sum_sq, ping.received);
+    uint32_t stddev_us = mean_sq > mean_us * mean_us ? isqrt64(mean_sq - mean_us * mean_us) : 0;
+    
+    terminal_print("tempo round-trip min/avg/max/stddev = ");
+    print_ms(ping.rtt_min);
+    terminal_print("/");
+    print_ms(avg);
+    terminal_print("/");
+    print_ms(ping.rtt_max);
+    terminal_print("/");
+    print_ms(stddev_us * 1000);
+    terminal_print(" ms\n");
+    
+    // Histograma entre o primeiro e o último balde ocupados
+    int first = 0, last = PING_HIST_BUCKETS - 1;
+    uint32_t peak = 0;
+    while (ping.hist[first] == 0) first++;
+    while (ping.hist[last] == 0) last--;
+    for (int i = first; i <= last; i++) {
+        if (ping.hist[i] > peak) peak = ping.hist[i];
+    }
+    
+    terminal_print("\nHistograma do RTT (us):\n");
+    for (int i = first; i <= last; i++) {
+        char num[12];
+        
+        if (i == 0) {
+            terminal_print("        < 1  ");
+        } else if (i == PING_HIST_BUCKETS - 1) {
+            uint_to_str(1u << (i - 1), num, sizeof(num));
+            print_padded(num, 8);
+            terminal_print("+    ");
+        } else {
+            uint_to_str(1u << (i - 1), num, sizeof(num));
+            print_padded(num, 6);
+            terminal_print("- ");
+            uint_to_str(1u << i, num, sizeof(num));
+            print_padded(num, 5);
+        }
+        terminal_print("|");
+        
+        uint32_t bar = ping.hist[i] * 40 / peak;
+        if (bar == 0 && ping.hist[i]) bar = 1;
+        for (uint32_t j = 0; j < bar; j++) {
+            terminal_print("#");
+        }
+        terminal_print(" ");
+        terminal_print_dec(ping.hist[i]);
+        terminal_print("\n");
+    }
+}
+
+// ping [-c N] [-i segundos] [-s bytes] [-f] IP
+// Envia um eco a cada intervalo, processando a rede enquanto espera; no
+// modo -f o próximo sai assim que todas as respostas chegarem (ou a cada
+// 10 ms), com um ponto por envio apagado por cada resposta
+void cmd_ping(const char* args) {
+    uint32_t count = 0, interval = PING_DEFAULT_INTERVAL, size = PING_DEFAULT_SIZE;
+    int flood = 0, interval_set = 0;
+    char target[16] = "";
+    char token[24];
+    
+    for (;;) {
+        args = net_next_token(args, token, sizeof(token));
+        if (token[0] == '\0') break;
+        
+        if (token[0] != '-') {
+            if (string_length(token) >= sizeof(target)) {
+                terminal_print("Endereco IP invalido: ");
+                terminal_print(token);
+                terminal_print("\n");
+                return;
+            }
+            string_copy(token, target);
+            continue;
+        }
+        if (token[1] == 'f' && token[2] == '\0') {
+            flood = 1;
+            continue;
+        }
+        
+        // Opções com valor
+        char value[24];
+        int ok = 0;
+        args = net_next_token(args, value, sizeof(value));
+        if (token[2] == '\0') {
+            if (token[1] == 'c') {
+                ok = net_parse_uint(value, &count) == 0 && count > 0;
+            } else if (token[1] == 'i') {
+                ok = parse_interval(value, &interval) == 0;
+                interval_set = 1;
+            } else if (token[1] == 's') {
+                ok = net_parse_uint(value, &size) == 0;
+            }
+        }
+        if (!ok) {
+            terminal_print("Uso: ping [-c N] [-i segundos] [-s bytes] [-f] IP\n");
+            return;
+        }
+    }
+    
+    if (!net_interface.enabled || !net_interface.dev) {
+        terminal_print("Interface de rede nao disponivel (ping requer uma placa de rede)\n");
         return;
     }
     
     ip_addr_t dst_ip;
-    if (string_to_ip(target, &dst_ip) != 0) {
+    if (target[0] == '\0' || string_to_ip(target, &dst_ip) != 0) {
         terminal_print("Endereco IP invalido: ");
         terminal_print(target);
         terminal_print("\n");
         return;
     }
+    if (size < PING_MIN_SIZE || size > PING_MAX_SIZE) {
+        terminal_print("Tamanho invalido (8 a 65507 bytes)\n");
+        return;
+    }
+    
+    if (count == 0) count = flood ? PING_FLOOD_COUNT : PING_DEFAULT_COUNT;
+    if (flood && !interval_set) interval = PING_FLOOD_INTERVAL;
+    
+    // Sem o MAC do próximo salto os primeiros ecos sairiam como falha
+    if (ip_resolve(&dst_ip, 1000) != 0) {
+        terminal_print("Sem rota para ");
+        terminal_print(target);
+        terminal_print(" (sem resposta ARP do proximo salto)\n");
+        return;
+    }
     
     terminal_print("PING ");
     terminal_print(target);
-    terminal_print(" (");
-    terminal_print(target);
-    terminal_print("): 56 bytes de dados\n");
+    terminal_print(": ");
+    terminal_print_dec(size);
+    terminal_print(" bytes de dados\n");
+    
+    memory_set(&ping, 0, sizeof(ping));
+    ping.dst = dst_ip;
+    ping.id = (uint16_t)(timer_ticks ^ 0x4E4F);
+    ping.flood = flood;
+    ping.active = 1;
+    
+    uint64_t interval_cycles = (uint64_t)interval * tsc_khz;
+    uint64_t start = tsc_read();
+    uint64_t next = start;
     
-    // Simular 4 pings
-    for (int i = 1; i <= 4; i++) {
-        ping_send(&dst_ip, 1234, i);
-        // Em um OS real, haveria delay aqui
+    while (ping.sent < count) {
+        uint64_t now = tsc_read();
+        
+        // Flood: todas as respostas chegaram, não espera o intervalo
+        if (flood && ping.received >= ping.sent) next = now;
+        
+        if (now >= next) {
+            uint16_t seq = (uint16_t)(ping.sent + 1);
+            ping.seen[(seq % PING_SEQ_WINDOW) / 32] &= ~(1u << (seq % 32));
+            if (flood) terminal_print(".");
+            if (ping_send(&dst_ip, ping.id, seq, size) != 0 && !flood) {
+                terminal_print("Falha ao enviar icmp_seq=");
+                terminal_print_dec(seq);
+                terminal_print("\n");
+            }
+            ping.sent++;
+            next = now + interval_cycles;
+        }
+        network_process_packets();
     }
     
-    terminal_print("\n--- ");
-    terminal_print(target);
-    terminal_print(" estatisticas de ping ---\n");
-    terminal_print("4 pacotes transmitidos, 4 recebidos, 0% perda de pacotes\n");
-    terminal_print("tempo round-trip min/avg/max/stddev = 1.0/1.0/1.0/0.0 ms\n");
+    // Últimas respostas
+    uint64_t deadline = tsc_read() + (uint64_t)PING_TIMEOUT * tsc_khz;
+    while (ping.received < ping.sent && tsc_read() < deadline) {
+        network_process_packets();
+    }
+    ping.active = 0;
+    
+    if (flood) terminal_print("\n");
+    ping_print_summary(target, tsc_to_us(tsc_read() - start) / 1000);
+}
+
+static const char* arp_state_name(uint8_t state) {
+    switch (state) {
+        case ARP_STATE_INCOMPLETE: return "INCOMPLETE";
+        case ARP_STATE_REACHABLE:  return "REACHABLE ";
+        case ARP_STATE_STALE:      return "STALE     ";
+        default:                   return "FREE      ";
+    }
 }
 
+// Entradas da mais recente para a mais antiga (ordem da LRU)
 void cmd_arp(void) {
     terminal_print("\nTabela ARP:\n");
-    terminal_print("IP Address       HW Address         Type\n");
-    terminal_print("-------------------------------------------\n");
+    terminal_print("IP Address       HW Address         Estado      Idade  Usos  Fila\n");
+    terminal_print("--------------------------------------------------------------------\n");
     
     int count = 0;
-    for (int i = 0; i < ARP_TABLE_SIZE; i++) {
-        if (arp_table[i].valid) {
-            char ip_str[16], mac_str[18];
-            ip_to_string(&arp_table[i].ip, ip_str);
-            mac_to_string(&arp_table[i].mac, mac_str);
-            
-            terminal_print(ip_str);
-            // Padding para alinhar
-            int ip_len = string_length(ip_str);
-            for (int j = ip_len; j < 17; j++) {
-                terminal_print(" ");
-            }
-            terminal_print(mac_str);
-            terminal_print("  dynamic\n");
-            count++;
+    for (arp_entry_t* entry = arp_lru_head; entry; entry = entry->lru_next) {
+        if (entry->state == ARP_STATE_FREE) continue;
+        
+        char ip_str[16], mac_str[18];
+        ip_to_string(&entry->ip, ip_str);
+        if (entry->state == ARP_STATE_INCOMPLETE) {
+            string_copy("(incompleto)", mac_str);
+        } else {
+            mac_to_string(&entry->mac, mac_str);
         }
+        
+        print_padded(ip_str, 17);
+        print_padded(mac_str, 19);
+        terminal_print(arp_state_name(entry->state));
+        terminal_print("  ");
+        
+        // Idade desde a última confirmação, em segundos
+        char num[12];
+        uint_to_str((timer_ticks - entry->confirmed) / TIMER_FREQUENCY, num, sizeof(num) - 1);
+        size_t n = string_length(num);
+        num[n] = 's';
+        num[n + 1] = '\0';
+        print_padded(num, 7);
+        uint_to_str(entry->hits, num, sizeof(num));
+        print_padded(num, 6);
+        terminal_print_dec(entry->queued);
+        terminal_print("\n");
+        count++;
     }
     
     if (count == 0) {
@@ -421,15 +1362,64 @@ void cmd_arp(void) {
         terminal_print_dec(count);
         terminal_print(" entradas\n");
     }
+    
+    terminal_print("Consultas: ");
+    terminal_print_dec(arp_stats.hits);
+    terminal_print(" acertos, ");
+    terminal_print_dec(arp_stats.misses);
+    terminal_print(" falhas; ");
+    terminal_print_dec(arp_stats.requests);
+    terminal_print(" requisicoes, ");
+    terminal_print_dec(arp_stats.failures);
+    terminal_print(" sem resposta, ");
+    terminal_print_dec(arp_stats.evictions);
+    terminal_print(" despejos\n");
+    terminal_print("Fila pendente: ");
+    terminal_print_dec(arp_stats.queued);
+    terminal_print(" enfileirados, ");
+    terminal_print_dec(arp_stats.flushed);
+    terminal_print(" enviados apos resolver, ");
+    terminal_print_dec(arp_stats.dropped);
+    terminal_print(" descartados\n");
 }
 
 void cmd_netstat(void) {
     terminal_print("\nEstatisticas de rede:\n");
-    terminal_print("Conexoes ativas: 0\n");
+    terminal_print("Conexoes ativas: ");
+    terminal_print_dec(tcp_active_connections());
+    terminal_print("\n");
     terminal_print("Interfaces ativas: ");
     terminal_print_dec(net_interface.enabled ? 1 : 0);
     terminal_print("\n");
-    terminal_print("Pacotes enviados: N/A (modo demonstracao)\n");
-    terminal_print("Pacotes recebidos: N/A (modo demonstracao)\n");
-    terminal_print("Erros: 0\n");
+    
+    if (netdev_count() == 0) {
+        terminal_print("Pacotes enviados: N/A (modo demonstracao)\n");
+        terminal_print("Pacotes recebidos: N/A (modo demonstracao)\n");
+        terminal_print("Erros: 0\n");
+        return;
+    }
+    
+    ip_frag_print_stats();
+    tcp_print_stats();
+    udp_print_stats();
+    
+    const netbuf_stats_t* pool = netbuf_get_stats();
+    terminal_print("Buffers de pacote: ");
+    terminal_print_dec(pool->free);
+    terminal_print("/");
+    terminal_print_dec(NETBUF_COUNT);
+    terminal_print(" livres (min ");
+    terminal_print_dec(pool->min_free);
+    terminal_print("), ");
+    terminal_print_dec(pool->loaned);
+    terminal_print(" entregues no buffer do driver, ");
+    terminal_print_dec(pool->copied);
+    terminal_print(" copiados, ");
+    terminal_print_dec(pool->alloc_failures);
+    terminal_print(" falhas\n");
+    
+    terminal_print("Contadores por fila:\n");
+    for (int i = 0; i < netdev_count(); i++) {
+        netdev_print_stats(netdev_get(i));
+    }
 }
\ No newline at end of file
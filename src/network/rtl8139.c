@@ -0,0 +1,273 @@
+// ============================================================================
+// NanoOS - Driver de Rede RTL8139
+// Anel de recepção contínuo em RBSTART (lido até CAPR alcançar a placa),
+// quatro descritores de transmissão em rodízio e conclusões por interrupção
+// ============================================================================
+
+#include "../../include/rtl8139.h"
+#include "../../include/netdev.h"
+#include "../../include/pci.h"
+#include "../../include/kernel.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// VARIÁVEIS GLOBAIS
+// ============================================================================
+
+static rtl8139_device_t rtl8139;
+static uint8_t rx_ring[RTL8139_RX_BUFFER] __attribute__((aligned(16)));
+static uint8_t tx_buffers[RTL8139_TX_SLOTS][RTL8139_TX_BUFFER] __attribute__((aligned(16)));
+
+// ============================================================================
+// FUNÇÕES AUXILIARES
+// ============================================================================
+
+// Leitura/Escrita de registradores
+static inline uint8_t rtl8139_read8(uint16_t reg) {
+    return inb(rtl8139.io_base + reg);
+}
+
+static inline uint16_t rtl8139_read16(uint16_t reg) {
+    return inw(rtl8139.io_base + reg);
+}
+
+static inline uint32_t rtl8139_read32(uint16_t reg) {
+    return inl(rtl8139.io_base + reg);
+}
+
+static inline void rtl8139_write8(uint16_t reg, uint8_t val) {
+    outb(rtl8139.io_base + reg, val);
+}
+
+static inline void rtl8139_write16(uint16_t reg, uint16_t val) {
+    outw(rtl8139.io_base + reg, val);
+}
+
+static inline void rtl8139_write32(uint16_t reg, uint32_t val) {
+    outl(rtl8139.io_base + reg, val);
+}
+
+// ============================================================================
+// RECEPÇÃO
+// ============================================================================
+
+// Liga o receptor com o anel vazio (início e depois de um erro)
+static void rtl8139_rx_start(void) {
+    rtl8139_write32(RTL8139_RBSTART, (uint32_t)rx_ring);
+    rtl8139_write32(RTL8139_RCR, RTL8139_RCR_APM | RTL8139_RCR_AB | RTL8139_RCR_AM |
+                                 RTL8139_RCR_WRAP | RTL8139_RCR_MXDMA |
+                                 RTL8139_RCR_RBLEN_8K | RTL8139_RCR_RXFTH);
+    rtl8139.rx_offset = 0;
+    rtl8139_write16(RTL8139_CAPR, (uint16_t)(0 - 16));
+}
+
+// Erro no anel: o cabeçalho do pacote não é confiável, então o receptor
+// é reiniciado e o conteúdo pendente descartado
+static void rtl8139_rx_reset(void) {
+    rtl8139_write8(RTL8139_CMD, RTL8139_CMD_TE);
+    rtl8139_write8(RTL8139_CMD, RTL8139_CMD_RE | RTL8139_CMD_TE);
+    rtl8139_rx_start();
+}
+
+// Consome até 'budget' pacotes do anel. Com WRAP a placa não parte um
+// pacote no fim do anel (escreve na folga depois dele), então só o
+// deslocamento dá a volta. CAPR fica 16 bytes atrás do próximo pacote
+static int rtl8139_poll(netdev_t* dev, int budget) {
+    int done = 0;
+    
+    while (done < budget && !(rtl8139_read8(RTL8139_CMD) & RTL8139_CMD_BUFE)) {
+        uint8_t* header = rx_ring + rtl8139.rx_offset;
+        uint16_t status = header[0] | (header[1] << 8);
+        uint16_t length = header[2] | (header[3] << 8);   // Inclui o CRC
+        
+        if (!(status & RTL8139_RX_ROK) || length < ETH_HEADER_SIZE + 4 ||
+            length > ETH_FRAME_SIZE + 4) {
+            dev->rx[0].errors++;
+            rtl8139_rx_reset();
+            return done;
+        }
+        
+        netdev_receive(dev, 0, header + RTL8139_RX_HEADER, length - 4, 0);
+        done++;
+        
+        uint32_t next = (rtl8139.rx_offset + RTL8139_RX_HEADER + length + 3) & ~3u;
+        rtl8139.rx_offset = next % RTL8139_RX_RING;
+        rtl8139_write16(RTL8139_CAPR, (uint16_t)(rtl8139.rx_offset - 16));
+    }
+    
+    return done;
+}
+
+// Máscara de RX durante o polling. O handler confirma todo o ISR a cada
+// interrupção (TX, link), então ao religar o próprio anel é conferido
+static void rtl8139_rx_irq_disable(netdev_t* dev) {
+    (void)dev;
+    rtl8139_write16(RTL8139_IMR, RTL8139_INT_ALL & ~RTL8139_INT_RX);
+}
+
+static int rtl8139_rx_irq_enable(netdev_t* dev) {
+    (void)dev;
+    rtl8139_write16(RTL8139_IMR, RTL8139_INT_ALL);
+    return !(rtl8139_read8(RTL8139_CMD) & RTL8139_CMD_BUFE);
+}
+
+// ============================================================================
+// TRANSMISSÃO
+// ============================================================================
+
+// Libera os descritores que a placa terminou, em ordem
+static void rtl8139_tx_reclaim(void) {
+    netdev_t* dev = rtl8139.netdev;
+    
+    while (rtl8139.tx_count > 0) {
+        uint8_t slot = rtl8139.tx_dirty;
+        uint32_t tsd = rtl8139_read32(RTL8139_TSD0 + slot * 4);
+        
+        if (!(tsd & (RTL8139_TSD_TOK | RTL8139_TSD_TUN | RTL8139_TSD_TABT))) break;
+        
+        if (tsd & RTL8139_TSD_TOK) {
+            dev->tx[0].packets++;
+            dev->tx[0].bytes += rtl8139.tx_len[slot];
+        } else {
+            dev->tx[0].errors++;
+        }
+        
+        rtl8139.tx_dirty = (slot + 1) % RTL8139_TX_SLOTS;
+        rtl8139.tx_count--;
+    }
+}
+
+// Copia o frame para o próximo descritor (TSD0-3 em rodízio) e o entrega
+// à placa; o tamanho escrito em TSD limpa OWN e inicia o envio
+static int rtl8139_transmit(netdev_t* dev, const void* frame, uint32_t len,
+                            const netdev_offload_t* offload) {
+    (void)offload;  // Sem offload: o registro não anuncia features
+    
+    if (len > RTL8139_TX_BUFFER) return -1;
+    
+    uint32_t flags = irq_save();
+    
+    if (rtl8139.tx_count == RTL8139_TX_SLOTS) rtl8139_tx_reclaim();
+    if (rtl8139.tx_count == RTL8139_TX_SLOTS) {
+        dev->tx[0].drops++;
+        irq_restore(flags);
+        return -1;
+    }
+    
+    uint8_t slot = rtl8139.tx_cur;
+    uint8_t* buffer = tx_buffers[slot];
+    
+    memory_copy(buffer, frame, len);
+    if (len < RTL8139_MIN_FRAME) {
+        memory_set(buffer + len, 0, RTL8139_MIN_FRAME - len);
+        len = RTL8139_MIN_FRAME;
+    }
+    
+    rtl8139.tx_len[slot] = len;
+    rtl8139.tx_cur = (slot + 1) % RTL8139_TX_SLOTS;
+    rtl8139.tx_count++;
+    rtl8139_write32(RTL8139_TSD0 + slot * 4, len & RTL8139_TSD_SIZE);
+    
+    irq_restore(flags);
+    return 0;
+}
+
+// ============================================================================
+// INTERRUPÇÃO
+// ============================================================================
+
+static void rtl8139_irq_handler(void) {
+    uint16_t status = rtl8139_read16(RTL8139_ISR);
+    
+    if (!status) return;  // Linha compartilhada: não é nossa
+    rtl8139_write16(RTL8139_ISR, status);
+    rtl8139.irqs++;
+    
+    if (status & RTL8139_INT_RXOVW) rtl8139.rx_overflows++;
+    if (status & RTL8139_INT_RX) {
+        netdev_rx_schedule(rtl8139.netdev);
+    }
+    if (status & (RTL8139_INT_TOK | RTL8139_INT_TER)) {
+        rtl8139_tx_reclaim();
+    }
+    if (status & RTL8139_INT_LINK) {
+        rtl8139.netdev->link_up = !(rtl8139_read8(RTL8139_MSR) & RTL8139_MSR_LINKB);
+    }
+}
+
+// ============================================================================
+// INICIALIZAÇÃO
+// ============================================================================
+
+static const netdev_ops_t rtl8139_ops = {
+    .transmit = rtl8139_transmit,
+    .poll = rtl8139_poll,
+    .rx_irq_disable = rtl8139_rx_irq_disable,
+    .rx_irq_enable = rtl8139_rx_irq_enable,
+};
+
+// Probe: liga a placa, faz reset e configura os anéis. Só uma placa é usada
+static int rtl8139_probe(pci_device_t* pci, const pci_device_id_t* id) {
+    (void)id;
+    
+    if (rtl8139.netdev || !(pci->bar_flags[0] & PCI_BAR_IO)) return -1;
+    
+    pci_device_enable(pci, PCI_CMD_IO_SPACE | PCI_CMD_BUS_MASTER);
+    rtl8139.io_base = pci->bar[0];
+    
+    // Tira do modo de baixo consumo e faz o reset
+    rtl8139_write8(RTL8139_CONFIG1, 0x00);
+    rtl8139_write8(RTL8139_CMD, RTL8139_CMD_RST);
+    
+    uint32_t start = timer_ticks;
+    while (rtl8139_read8(RTL8139_CMD) & RTL8139_CMD_RST) {
+        if (timer_ticks - start > 10) {
+            terminal_print("RTL8139: timeout no reset\n");
+            return -1;
+        }
+    }
+    
+    mac_addr_t mac;
+    for (int i = 0; i < ETH_ADDR_LEN; i++) {
+        mac.addr[i] = rtl8139_read8(RTL8139_IDR0 + i);
+    }
+    
+    // Endereços fixos dos quatro buffers de transmissão
+    for (int i = 0; i < RTL8139_TX_SLOTS; i++) {
+        rtl8139_write32(RTL8139_TSAD0 + i * 4, (uint32_t)tx_buffers[i]);
+    }
+    rtl8139.tx_cur = 0;
+    rtl8139.tx_dirty = 0;
+    rtl8139.tx_count = 0;
+    
+    rtl8139_write8(RTL8139_CMD, RTL8139_CMD_RE | RTL8139_CMD_TE);
+    rtl8139_rx_start();
+    rtl8139_write32(RTL8139_TCR, RTL8139_TCR_IFG | RTL8139_TCR_MXDMA);
+    rtl8139_write32(RTL8139_MPC, 0);
+    
+    rtl8139.netdev = netdev_register("rtl8139", &mac, pci->irq_line, 1, 1, &rtl8139_ops, &rtl8139);
+    if (!rtl8139.netdev) return -1;
+    rtl8139.netdev->link_up = !(rtl8139_read8(RTL8139_MSR) & RTL8139_MSR_LINKB);
+    
+    irq_register_handler(pci->irq_line, rtl8139_irq_handler);
+    rtl8139_write16(RTL8139_ISR, 0xFFFF);
+    rtl8139_write16(RTL8139_IMR, RTL8139_INT_ALL);
+    return 0;
+}
+
+static const pci_device_id_t rtl8139_pci_ids[] = {
+    { RTL8139_PCI_VENDOR, RTL8139_PCI_DEVICE, PCI_ANY_ID, PCI_ANY_ID },
+    { 0, 0, 0, 0 }
+};
+
+static const pci_driver_t rtl8139_pci_driver = {
+    .name = "rtl8139",
+    .ids = rtl8139_pci_ids,
+    .probe = rtl8139_probe,
+};
+
+// Registra o driver no PCI; falha se não houver placa
+int rtl8139_init(void) {
+    return pci_register_driver(&rtl8139_pci_driver) > 0 ? 0 : -1;
+}
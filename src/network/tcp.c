@@ -0,0 +1,1897 @@
+// ============================================================================
+// NanoOS - TCP
+// Conexões num hash da quádrupla, máquina de estados da RFC 793, RTO da
+// RFC 6298, escala de janela, SACK, ACK atrasado e controle de
+// congestionamento plugável (tcp_cong.c). Os temporizadores ficam numa
+// roda indexada por tick: armar e cancelar custam O(1). Tudo roda no laço
+// principal (polling e comandos), nunca dentro de uma interrupção
+// ============================================================================
+
+#include "../../include/tcp.h"
+#include "../../include/network.h"
+#include "../../include/netdev.h"
+#include "../../include/kernel.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#define TCP_SND_MASK            (TCP_SND_BUF - 1)
+#define TCP_RCV_MASK            (TCP_RCV_BUF - 1)
+#define TCP_WHEEL_MASK          (TCP_WHEEL_SIZE - 1)
+#define TCP_SSTHRESH_INIT       0x7FFFFFFF  // "Infinito" até a primeira perda
+
+// ============================================================================
+// VARIÁVEIS GLOBAIS
+// ============================================================================
+
+static tcp_conn_t conns[TCP_MAX_CONNS];
+static tcp_conn_t* conn_hash[TCP_HASH_SIZE];
+static tcp_conn_t* timer_wheel[TCP_WHEEL_SIZE];
+static uint32_t wheel_tick;             // Último tick processado pela roda
+static uint32_t output_pending;         // Conexões com TCP_CF_OUTPUT
+static uint16_t next_ephemeral = TCP_EPHEMERAL_MIN;
+static tcp_stats_t tcp_stats;
+
+// Anéis de envio e recepção, um par por entrada da tabela
+static uint8_t snd_bufs[TCP_MAX_CONNS][TCP_SND_BUF];
+static uint8_t rcv_bufs[TCP_MAX_CONNS][TCP_RCV_BUF];
+
+// Segmento montado para envio
+static uint8_t tx_segment[TCP_HEADER_SIZE + TCP_OPTIONS_MAX + TCP_MSS];
+
+static const char* const state_names[] = {
+    "CLOSED", "LISTEN", "SYN_SENT", "SYN_RECEIVED", "ESTABLISHED", "FIN_WAIT_1",
+    "FIN_WAIT_2", "CLOSE_WAIT", "CLOSING", "LAST_ACK", "TIME_WAIT"
+};
+
+static void tcp_output(tcp_conn_t* c);
+static void tcp_conn_free(tcp_conn_t* c);
+
+// ============================================================================
+// AUXILIARES
+// ============================================================================
+
+static inline uint32_t tcp_get32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline void tcp_put32(uint8_t* p, uint32_t value) {
+    p[0] = value >> 24;
+    p[1] = value >> 16;
+    p[2] = value >> 8;
+    p[3] = value;
+}
+
+// Tick absoluto daqui a ms milissegundos (0 fica reservado para "desarmado")
+static uint32_t tcp_deadline(uint32_t ms) {
+    uint32_t at = timer_ticks + (ms * TIMER_FREQUENCY + 999) / 1000;
+    return at ? at : 1;
+}
+
+static inline uint8_t* snd_ring(const tcp_conn_t* c) {
+    return snd_bufs[c - conns];
+}
+
+static inline uint8_t* rcv_ring(const tcp_conn_t* c) {
+    return rcv_bufs[c - conns];
+}
+
+// Estados em que a conexão troca dados e ACKs
+static inline int tcp_synchronized(const tcp_conn_t* c) {
+    return c->state >= TCP_SYN_RECEIVED;
+}
+
+// Maior payload de um segmento: o MSS menos as opções (blocos SACK)
+static uint32_t tcp_send_mss(const tcp_conn_t* c) {
+    if ((c->flags & TCP_CF_SACK) && c->ooo_count) {
+        return c->mss - (4 + 8 * c->ooo_count);
+    }
+    return c->mss;
+}
+
+// ============================================================================
+// TABELA DE CONEXÕES
+// ============================================================================
+
+// Bucket da quádrupla (escutas usam IP e porta remotos zerados) - hash
+// multiplicativo de Knuth
+static inline uint32_t tcp_hash(const ip_addr_t* ip, uint16_t local_port, uint16_t remote_port) {
+    uint32_t key;
+    
+    memory_copy(&key, ip, sizeof(key));
+    key ^= ((uint32_t)local_port << 16) | remote_port;
+    return (key * 2654435761u >> 16) & (TCP_HASH_SIZE - 1);
+}
+
+static inline uint32_t tcp_conn_hash(const tcp_conn_t* c) {
+    return tcp_hash(&c->remote_ip, c->local_port, c->remote_port);
+}
+
+// Conexão da quádrupla ou, sem ela, a escuta da porta local
+static tcp_conn_t* tcp_lookup(const ip_addr_t* remote_ip, uint16_t local_port, uint16_t remote_port) {
+    static const ip_addr_t any = {{0, 0, 0, 0}};
+    tcp_conn_t* c = conn_hash[tcp_hash(remote_ip, local_port, remote_port)];
+    
+    while (c) {
+        if (c->local_port == local_port && c->remote_port == remote_port &&
+            memory_compare(&c->remote_ip, remote_ip, sizeof(ip_addr_t)) == 0) {
+            return c;
+        }
+        c = c->hash_next;
+    }
+    
+    c = conn_hash[tcp_hash(&any, local_port, 0)];
+    while (c) {
+        if (c->state == TCP_LISTEN && c->local_port == local_port) return c;
+        c = c->hash_next;
+    }
+    return 0;
+}
+
+static void tcp_hash_insert(tcp_conn_t* c) {
+    uint32_t h = tcp_conn_hash(c);
+    c->hash_next = conn_hash[h];
+    conn_hash[h] = c;
+}
+
+static void tcp_hash_remove(tcp_conn_t* c) {
+    tcp_conn_t** link = &conn_hash[tcp_conn_hash(c)];
+    
+    while (*link) {
+        if (*link == c) {
+            *link = c->hash_next;
+            c->hash_next = 0;
+            return;
+        }
+        link = &(*link)->hash_next;
+    }
+}
+
+static tcp_conn_t* tcp_get(int sock) {
+    if (sock < 0 || sock >= TCP_MAX_CONNS || !conns[sock].used) return 0;
+    return &conns[sock];
+}
+
+// Porta local ocupada por um socket com bind, uma escuta ou uma conexão
+static int tcp_port_in_use(uint16_t port) {
+    for (int i = 0; i < TCP_MAX_CONNS; i++) {
+        if (conns[i].used && conns[i].local_port == port) return 1;
+    }
+    return 0;
+}
+
+// ============================================================================
+// RODA DE TEMPORIZADORES
+// ============================================================================
+
+static void tcp_timer_unlink(tcp_conn_t* c) {
+    if (!c->timer_expires) return;
+    
+    if (c->timer_prev) c->timer_prev->timer_next = c->timer_next;
+    else timer_wheel[c->timer_expires & TCP_WHEEL_MASK] = c->timer_next;
+    if (c->timer_next) c->timer_next->timer_prev = c->timer_prev;
+    c->timer_prev = 0;
+    c->timer_next = 0;
+    c->timer_expires = 0;
+}
+
+static void tcp_timer_link(tcp_conn_t* c, uint32_t expires) {
+    // Slot já varrido nesta volta: dispara no próximo tick
+    if (TCP_SEQ_LEQ(expires, wheel_tick)) expires = wheel_tick + 1;
+    if (!expires) expires = 1;
+    
+    uint32_t slot = expires & TCP_WHEEL_MASK;
+    c->timer_expires = expires;
+    c->timer_prev = 0;
+    c->timer_next = timer_wheel[slot];
+    if (c->timer_next) c->timer_next->timer_prev = c;
+    timer_wheel[slot] = c;
+    tcp_stats.timer_relinks++;
+}
+
+// Prazo mais próximo entre os temporizadores da conexão (0 = nenhum)
+static uint32_t tcp_next_deadline(const tcp_conn_t* c) {
+    uint32_t next = 0;
+    
+    if (c->rto_at) next = c->rto_at;
+    if (c->delack_at && (!next || TCP_SEQ_LT(c->delack_at, next))) next = c->delack_at;
+    if (c->linger_at && (!next || TCP_SEQ_LT(c->linger_at, next))) next = c->linger_at;
+    return next;
+}
+
+// Recoloca a conexão na roda depois de mexer nos prazos. Adiar ou cancelar
+// não mexe na roda: o slot antigo dispara à toa e tcp_timer reposiciona a
+// conexão (a maioria dos ACKs só empurra o RTO para frente ou desarma o
+// ACK atrasado)
+static void tcp_timer_update(tcp_conn_t* c) {
+    uint32_t next = tcp_next_deadline(c);
+    
+    if (!next) return;
+    if (c->timer_expires && TCP_SEQ_LEQ(c->timer_expires, next)) return;
+    
+    tcp_timer_unlink(c);
+    tcp_timer_link(c, next);
+}
+
+// ============================================================================
+// CICLO DE VIDA DAS CONEXÕES
+// ============================================================================
+
+// Entrada livre; sem nenhuma, recicla uma órfã em TIME_WAIT
+static tcp_conn_t* tcp_conn_alloc(void) {
+    tcp_conn_t* c = 0;
+    
+    for (int i = 0; i < TCP_MAX_CONNS && !c; i++) {
+        if (!conns[i].used) c = &conns[i];
+    }
+    for (int i = 0; i < TCP_MAX_CONNS && !c; i++) {
+        if (conns[i].state == TCP_TIME_WAIT && (conns[i].flags & TCP_CF_ORPHAN)) {
+            c = &conns[i];
+            tcp_conn_free(c);
+        }
+    }
+    if (!c) return 0;
+    
+    memory_set(c, 0, sizeof(tcp_conn_t));
+    c->used = 1;
+    c->cc = tcp_cc_default();
+    c->mss = TCP_MSS;
+    c->rto_ms = TCP_RTO_INIT;
+    return c;
+}
+
+// Libera a entrada (hash, roda e fila de accept da escuta)
+static void tcp_conn_free(tcp_conn_t* c) {
+    tcp_timer_unlink(c);
+    if (c->state != TCP_CLOSED) tcp_hash_remove(c);
+    
+    if (c->listener) {
+        tcp_conn_t** link = &c->listener->accept_head;
+        
+        while (*link) {
+            if (*link == c) {
+                *link = c->accept_next;
+                break;
+            }
+            link = &(*link)->accept_next;
+        }
+        c->listener->pending--;
+    }
+    if (c->flags & TCP_CF_OUTPUT) output_pending--;
+    c->used = 0;
+}
+
+// Fim da conexão: órfãs são liberadas; as demais ficam CLOSED até o dono
+// chamar tcp_close (tcp_recv devolve fim de arquivo ou erro)
+static void tcp_conn_finish(tcp_conn_t* c) {
+    if (c->flags & TCP_CF_ORPHAN) {
+        tcp_conn_free(c);
+        return;
+    }
+    
+    tcp_hash_remove(c);
+    c->state = TCP_CLOSED;
+    c->rto_at = 0;
+    c->delack_at = 0;
+    c->linger_at = 0;
+    tcp_timer_unlink(c);
+}
+
+// RST recebido ou retransmissões esgotadas
+static void tcp_conn_reset(tcp_conn_t* c) {
+    if (c->state == TCP_ESTABLISHED || c->state == TCP_CLOSE_WAIT) tcp_stats.estab_resets++;
+    c->error = -1;
+    tcp_conn_finish(c);
+}
+
+static void tcp_enter_time_wait(tcp_conn_t* c) {
+    c->state = TCP_TIME_WAIT;
+    c->rto_at = 0;
+    c->delack_at = 0;
+    c->linger_at = tcp_deadline(TCP_TIME_WAIT_TIME);
+    tcp_timer_update(c);
+}
+
+// Número de sequência inicial (RFC 6528): relógio do TSC mais um hash da
+// quádrupla, para conexões novas não caírem na janela das antigas
+static uint32_t tcp_initial_seq(const tcp_conn_t* c) {
+    uint32_t key;
+    
+    memory_copy(&key, &c->remote_ip, sizeof(key));
+    key ^= ((uint32_t)c->local_port << 16) | c->remote_port;
+    return (uint32_t)(tsc_read() >> 8) + key * 2654435761u;
+}
+
+// Handshake concluído: janela inicial (RFC 6928) e estado do algoritmo
+static void tcp_conn_established(tcp_conn_t* c) {
+    uint32_t cap = 2u * c->mss > 14600 ? 2u * c->mss : 14600;
+    
+    c->state = TCP_ESTABLISHED;
+    c->cwnd = TCP_INIT_CWND * c->mss < cap ? TCP_INIT_CWND * c->mss : cap;
+    c->ssthresh = TCP_SSTHRESH_INIT;
+    c->recover = c->snd_una;
+    c->retx_next = c->snd_una;
+    c->backoff = 0;
+    c->rto_at = 0;
+    c->cc->init(c);
+}
+
+// ============================================================================
+// ENVIO DE SEGMENTOS
+// ============================================================================
+
+// Janela a anunciar: o espaço livre do anel, sem crescer aos pedaços
+// (RFC 1122: a borda só avança de MSS em MSS) e alinhada à escala
+static uint32_t tcp_rcv_window(const tcp_conn_t* c) {
+    uint32_t win = TCP_RCV_BUF - c->rcv_len;
+    uint32_t cur = TCP_SEQ_GT(c->rcv_adv, c->rcv_nxt) ? c->rcv_adv - c->rcv_nxt : 0;
+    
+    if (win < cur + c->mss && win < cur + TCP_RCV_BUF / 2) win = cur;
+    if (!(c->flags & TCP_CF_WSCALE) && win > 65535) win = 65535;
+    return win & ~((1u << c->rcv_wscale) - 1);
+}
+
+// Opções do SYN: MSS sempre; SACK e escala quando oferecemos ou o outro
+// lado ofereceu (só se respondem opções recebidas)
+static uint32_t tcp_write_syn_options(const tcp_conn_t* c, uint8_t* opt) {
+    uint32_t len = 0;
+    int active = c->state == TCP_SYN_SENT;
+    
+    opt[len++] = TCP_OPT_MSS;
+    opt[len++] = 4;
+    opt[len++] = TCP_MSS >> 8;
+    opt[len++] = TCP_MSS & 0xFF;
+    if (active || (c->flags & TCP_CF_SACK)) {
+        opt[len++] = TCP_OPT_NOP;
+        opt[len++] = TCP_OPT_NOP;
+        opt[len++] = TCP_OPT_SACK_PERM;
+        opt[len++] = 2;
+    }
+    if (active || (c->flags & TCP_CF_WSCALE)) {
+        opt[len++] = TCP_OPT_NOP;
+        opt[len++] = TCP_OPT_WSCALE;
+        opt[len++] = 3;
+        opt[len++] = TCP_RCV_WSCALE;
+    }
+    return len;
+}
+
+// Blocos SACK dos trechos fora de ordem, o mais recente primeiro (RFC 2018)
+static uint32_t tcp_write_sack_blocks(const tcp_conn_t* c, uint8_t* opt) {
+    uint32_t len = 0;
+    
+    opt[len++] = TCP_OPT_NOP;
+    opt[len++] = TCP_OPT_NOP;
+    opt[len++] = TCP_OPT_SACK;
+    opt[len++] = 2 + 8 * c->ooo_count;
+    for (int i = 0; i < c->ooo_count; i++) {
+        tcp_put32(opt + len, c->ooo[i].start);
+        tcp_put32(opt + len + 4, c->ooo[i].end);
+        len += 8;
+    }
+    return len;
+}
+
+// Monta e envia um segmento com len bytes do anel a partir de seq. Com ACK,
+// leva rcv_nxt e a janela e conta como o ACK pendente
+static int tcp_xmit(tcp_conn_t* c, uint32_t seq, uint8_t flags, uint32_t len) {
+    tcp_header_t* tcp = (tcp_header_t*)tx_segment;
+    uint8_t* opt = tx_segment + TCP_HEADER_SIZE;
+    uint32_t optlen = 0;
+    
+    if (flags & TCP_SYN) optlen = tcp_write_syn_options(c, opt);
+    else if ((c->flags & TCP_CF_SACK) && c->ooo_count) optlen = tcp_write_sack_blocks(c, opt);
+    
+    // Janela do SYN nunca é escalada (RFC 7323)
+    uint32_t win = tcp_rcv_window(c);
+    uint32_t field = (flags & TCP_SYN) ? (win > 65535 ? 65535 : win) : win >> c->rcv_wscale;
+    
+    tcp->src_port = htons(c->local_port);
+    tcp->dst_port = htons(c->remote_port);
+    tcp->seq = htonl(seq);
+    tcp->ack = (flags & TCP_ACK) ? htonl(c->rcv_nxt) : 0;
+    tcp->data_offset = ((TCP_HEADER_SIZE + optlen) / 4) << 4;
+    tcp->flags = flags;
+    tcp->window = htons(field);
+    tcp->checksum = 0;
+    tcp->urgent = 0;
+    
+    if (len) {
+        uint8_t* payload = opt + optlen;
+        uint32_t pos = (c->snd_head + (seq - c->snd_una)) & TCP_SND_MASK;
+        uint32_t first = TCP_SND_BUF - pos < len ? TCP_SND_BUF - pos : len;
+        
+        memory_copy(payload, snd_ring(c) + pos, first);
+        if (first < len) memory_copy(payload + first, snd_ring(c), len - first);
+    }
+    
+    uint32_t total = TCP_HEADER_SIZE + optlen + len;
+    if (ip_send_l4(tx_segment, total, &c->remote_ip, IP_PROTO_TCP,
+                   offsetof(tcp_header_t, checksum)) != 0) {
+        return -1;
+    }
+    
+    c->segs_out++;
+    tcp_stats.out_segs++;
+    if (flags & TCP_ACK) {
+        c->segs_unacked = 0;
+        c->delack_at = 0;
+        c->rcv_adv = c->rcv_nxt + (field << ((flags & TCP_SYN) ? 0 : c->rcv_wscale));
+    }
+    return 0;
+}
+
+static void tcp_send_ack(tcp_conn_t* c) {
+    tcp_xmit(c, c->snd_nxt, TCP_ACK, 0);
+}
+
+// RST para um segmento sem conexão (RFC 793): com ACK, usa o número
+// confirmado; sem, confirma o segmento inteiro
+static void tcp_send_reset(const ip_header_t* ip, const tcp_header_t* in, const tcp_segment_t* seg) {
+    tcp_header_t* tcp = (tcp_header_t*)tx_segment;
+    
+    if (seg->flags & TCP_RST) return;
+    
+    tcp->src_port = in->dst_port;
+    tcp->dst_port = in->src_port;
+    if (seg->flags & TCP_ACK) {
+        tcp->seq = htonl(seg->ack);
+        tcp->ack = 0;
+        tcp->flags = TCP_RST;
+    } else {
+        uint32_t ack = seg->seq + seg->len + ((seg->flags & TCP_SYN) ? 1 : 0) +
+                       ((seg->flags & TCP_FIN) ? 1 : 0);
+        tcp->seq = 0;
+        tcp->ack = htonl(ack);
+        tcp->flags = TCP_RST | TCP_ACK;
+    }
+    tcp->data_offset = (TCP_HEADER_SIZE / 4) << 4;
+    tcp->window = 0;
+    tcp->checksum = 0;
+    tcp->urgent = 0;
+    
+    if (ip_send_l4(tx_segment, TCP_HEADER_SIZE, &ip->src_ip, IP_PROTO_TCP,
+                   offsetof(tcp_header_t, checksum)) == 0) {
+        tcp_stats.out_segs++;
+        tcp_stats.out_rsts++;
+    }
+}
+
+// Aborta a conexão avisando o outro lado (se sincronizada)
+static void tcp_abort(tcp_conn_t* c) {
+    if (tcp_synchronized(c) && c->state != TCP_TIME_WAIT &&
+        tcp_xmit(c, c->snd_nxt, TCP_RST | TCP_ACK, 0) == 0) {
+        tcp_stats.out_rsts++;
+    }
+    c->error = -1;
+    tcp_conn_finish(c);
+}
+
+// Retransmite um segmento do próximo buraco: com SACK, o primeiro trecho
+// não confirmado a partir de retx_next abaixo do maior bloco recebido; sem
+// buraco conhecido e com force, o segmento em snd_una (NewReno)
+static int tcp_retransmit_hole(tcp_conn_t* c, int force) {
+    uint32_t seq = TCP_SEQ_LT(c->retx_next, c->snd_una) ? c->snd_una : c->retx_next;
+    uint32_t len = 0;
+    int guided = 0;
+    
+    for (int i = 0; i < c->sacked_count; i++) {
+        const tcp_range_t* r = &c->sacked[i];
+        
+        if (TCP_SEQ_LEQ(r->end, seq)) continue;
+        if (TCP_SEQ_LEQ(r->start, seq)) {
+            seq = r->end;
+            continue;
+        }
+        len = r->start - seq;
+        guided = 1;
+        break;
+    }
+    
+    if (!len) {
+        if (!force || TCP_SEQ_GT(c->retx_next, c->snd_una)) return -1;
+        seq = c->snd_una;
+        len = c->snd_len;
+    }
+    
+    uint32_t in_ring = c->snd_len - (seq - c->snd_una);
+    if (len > in_ring) len = in_ring;
+    if (len > tcp_send_mss(c)) len = tcp_send_mss(c);
+    if (len == 0 || tcp_xmit(c, seq, TCP_ACK, len) != 0) return -1;
+    
+    c->retx_next = seq + len;
+    c->retransmits++;
+    if (guided && seq != c->snd_una) c->sack_recovered++;
+    tcp_stats.retrans_segs++;
+    c->rtt_timing = 0;  // Karn: amostra de retransmissão é ambígua
+    return 0;
+}
+
+// Envia o que a janela (min(cwnd, janela do outro lado)) permite: dados
+// novos, a retransmissão em lote depois de um RTO e o FIN. Para no
+// primeiro envio recusado pela placa e retoma no próximo tcp_timer
+static void tcp_output(tcp_conn_t* c) {
+    if (c->state < TCP_ESTABLISHED || c->state == TCP_TIME_WAIT) return;
+    
+    netdev_t* dev = network_get_interface()->dev;
+    uint32_t wnd = c->cwnd < c->snd_wnd ? c->cwnd : c->snd_wnd;
+    uint32_t smss = tcp_send_mss(c);
+    
+    if (dev) netdev_tx_batch_begin(dev);
+    for (;;) {
+        uint32_t in_flight = c->snd_nxt - c->snd_una;
+        uint32_t avail = c->snd_len > in_flight ? c->snd_len - in_flight : 0;
+        uint32_t usable = wnd > in_flight ? wnd - in_flight : 0;
+        uint32_t len = avail < smss ? avail : smss;
+        int want_fin = (c->flags & TCP_CF_FIN_QUEUED) && !(c->flags & TCP_CF_FIN_SENT);
+        
+        if (len > usable) len = usable;
+        int send_fin = want_fin && len == avail;
+        
+        if (len == 0 && !send_fin) {
+            // Janela zerada com dados esperando: temporizador de persistência
+            if (avail && c->snd_wnd == 0 && in_flight == 0 && !c->rto_at) {
+                c->rto_at = tcp_deadline(c->rto_ms);
+            }
+            break;
+        }
+        
+        // Nagle e SWS do envio: segmento curto só sem nada em voo
+        if (len < smss && !send_fin && in_flight) break;
+        
+        uint8_t flags = TCP_ACK;
+        if (len == avail) flags |= TCP_PSH;
+        if (send_fin) flags |= TCP_FIN;
+        
+        if (tcp_xmit(c, c->snd_nxt, flags, len) != 0) {
+            if (!(c->flags & TCP_CF_OUTPUT)) {
+                c->flags |= TCP_CF_OUTPUT;
+                output_pending++;
+            }
+            break;
+        }
+        
+        if (TCP_SEQ_LT(c->snd_nxt, c->snd_max)) {
+            c->retransmits++;
+            tcp_stats.retrans_segs++;
+        } else if (!c->rtt_timing && len) {
+            c->rtt_timing = 1;
+            c->rtt_seq = c->snd_nxt;
+            c->rtt_start = tsc_read();
+        }
+        
+        c->snd_nxt += len + (send_fin ? 1 : 0);
+        if (send_fin) c->flags |= TCP_CF_FIN_SENT;
+        if (TCP_SEQ_GT(c->snd_nxt, c->snd_max)) c->snd_max = c->snd_nxt;
+        if (!c->rto_at) c->rto_at = tcp_deadline(c->rto_ms);
+        if (send_fin) break;
+    }
+    if (dev) netdev_tx_batch_end(dev);
+    tcp_timer_update(c);
+}
+
+// ============================================================================
+// RTT E TEMPORIZADORES
+// ============================================================================
+
+// Amostra de RTT (RFC 6298): SRTT e RTTVAR em microssegundos, RTO com a
+// granularidade do tick e piso de TCP_RTO_MIN (200 ms, como o Linux, em vez
+// do 1 s da RFC)
+static void tcp_rtt_sample(tcp_conn_t* c, uint32_t rtt) {
+    const uint32_t granularity = 1000000 / TIMER_FREQUENCY;
+    
+    if (rtt == 0) rtt = 1;
+    if (!c->rtt_min_us || rtt < c->rtt_min_us) c->rtt_min_us = rtt;
+    
+    if (c->srtt_us == 0) {
+        c->srtt_us = rtt;
+        c->rttvar_us = rtt / 2;
+    } else {
+        uint32_t err = rtt > c->srtt_us ? rtt - c->srtt_us : c->srtt_us - rtt;
+        c->rttvar_us = (3 * c->rttvar_us + err) / 4;
+        c->srtt_us = (7 * c->srtt_us + rtt) / 8;
+    }
+    
+    uint32_t var = 4 * c->rttvar_us > granularity ? 4 * c->rttvar_us : granularity;
+    uint32_t rto = (c->srtt_us + var + 999) / 1000;
+    
+    if (rto < TCP_RTO_MIN) rto = TCP_RTO_MIN;
+    if (rto > TCP_RTO_MAX) rto = TCP_RTO_MAX;
+    c->rto_ms = rto;
+}
+
+// RTO: SYN reenviado, sonda de janela zerada ou retransmissão em lote a
+// partir de snd_una com a janela de perda (um segmento)
+static void tcp_retransmit_timeout(tcp_conn_t* c) {
+    if (c->state == TCP_SYN_SENT || c->state == TCP_SYN_RECEIVED) {
+        if (++c->backoff > TCP_SYN_RETRIES) {
+            tcp_stats.attempt_fails++;
+            c->error = -1;
+            tcp_conn_finish(c);
+            return;
+        }
+        c->rto_ms = c->rto_ms * 2 < TCP_RTO_MAX ? c->rto_ms * 2 : TCP_RTO_MAX;
+        c->rtt_timing = 0;
+        if (tcp_xmit(c, c->iss, TCP_SYN | (c->state == TCP_SYN_RECEIVED ? TCP_ACK : 0), 0) == 0) {
+            c->retransmits++;
+            tcp_stats.retrans_segs++;
+        }
+        c->rto_at = tcp_deadline(c->rto_ms);
+        return;
+    }
+    
+    // Persistência: janela zerada e nada em voo. A sonda (um segmento já
+    // confirmado) faz o outro lado responder com a janela atual
+    if (c->snd_wnd == 0 && c->snd_nxt == c->snd_una && c->snd_len) {
+        uint32_t interval = c->rto_ms << (c->backoff < 8 ? c->backoff : 8);
+        
+        tcp_xmit(c, c->snd_una - 1, TCP_ACK, 0);
+        if (c->backoff < TCP_MAX_RETRIES) c->backoff++;
+        c->rto_at = tcp_deadline(interval < TCP_RTO_MAX ? interval : TCP_RTO_MAX);
+        return;
+    }
+    
+    if (c->snd_una == c->snd_max) return;
+    
+    if (++c->backoff > TCP_MAX_RETRIES) {
+        tcp_abort(c);
+        return;
+    }
+    
+    c->timeouts++;
+    c->ssthresh = c->cc->ssthresh(c);
+    c->cwnd = c->mss;
+    c->cwnd_cnt = 0;
+    c->dupacks = 0;
+    c->flags &= ~TCP_CF_RECOVERY;
+    c->recover = c->snd_max;
+    c->sacked_count = 0;
+    c->snd_nxt = c->snd_una;
+    c->flags &= ~TCP_CF_FIN_SENT;
+    c->rtt_timing = 0;
+    c->rto_ms = c->rto_ms * 2 < TCP_RTO_MAX ? c->rto_ms * 2 : TCP_RTO_MAX;
+    tcp_output(c);
+}
+
+// Trata os prazos vencidos de uma conexão que saiu da roda
+static void tcp_timer_expire(tcp_conn_t* c, uint32_t now) {
+    if (c->linger_at && TCP_SEQ_LEQ(c->linger_at, now)) {
+        c->linger_at = 0;
+        tcp_conn_finish(c);
+        return;
+    }
+    if (c->delack_at && TCP_SEQ_LEQ(c->delack_at, now)) {
+        c->delack_at = 0;
+        tcp_send_ack(c);
+    }
+    if (c->rto_at && TCP_SEQ_LEQ(c->rto_at, now)) {
+        c->rto_at = 0;
+        tcp_retransmit_timeout(c);
+        if (!c->used) return;
+    }
+    tcp_timer_update(c);
+}
+
+// Chamada pelo laço de rede: retoma envios parados por falta de espaço no
+// anel TX e varre os slots da roda desde o último tick. Cada slot só tem
+// as conexões que vencem nele (ou numa volta futura)
+void tcp_timer(void) {
+    uint32_t now = timer_ticks;
+    
+    if (output_pending) {
+        for (int i = 0; i < TCP_MAX_CONNS; i++) {
+            tcp_conn_t* c = &conns[i];
+            
+            if (c->used && (c->flags & TCP_CF_OUTPUT)) {
+                c->flags &= ~TCP_CF_OUTPUT;
+                output_pending--;
+                tcp_output(c);
+            }
+        }
+    }
+    
+    uint32_t steps = now - wheel_tick;
+    if (steps > TCP_WHEEL_SIZE) steps = TCP_WHEEL_SIZE;
+    
+    for (uint32_t i = 0; i < steps; i++) {
+        uint32_t slot = (wheel_tick + 1) & TCP_WHEEL_MASK;
+        tcp_conn_t* c = timer_wheel[slot];
+        
+        wheel_tick++;
+        while (c) {
+            tcp_conn_t* next = c->timer_next;
+            
+            if (TCP_SEQ_LEQ(c->timer_expires, now)) {
+                tcp_timer_unlink(c);
+                tcp_stats.timer_fires++;
+                tcp_timer_expire(c, now);
+            }
+            c = next;
+        }
+    }
+    wheel_tick = now;
+}
+
+// ============================================================================
+// RECEPÇÃO
+// ============================================================================
+
+static void tcp_parse_options(const uint8_t* opt, uint32_t len, tcp_segment_t* seg) {
+    uint32_t i = 0;
+    
+    while (i < len) {
+        uint8_t kind = opt[i];
+        
+        if (kind == TCP_OPT_END) break;
+        if (kind == TCP_OPT_NOP) {
+            i++;
+            continue;
+        }
+        if (i + 1 >= len) break;
+        
+        uint8_t olen = opt[i + 1];
+        if (olen < 2 || i + olen > len) break;
+        
+        switch (kind) {
+            case TCP_OPT_MSS:
+                if (olen == 4) seg->mss = ((uint16_t)opt[i + 2] << 8) | opt[i + 3];
+                break;
+            case TCP_OPT_WSCALE:
+                if (olen == 3) seg->wscale = opt[i + 2] < TCP_MAX_WSCALE ? opt[i + 2] : TCP_MAX_WSCALE;
+                break;
+            case TCP_OPT_SACK_PERM:
+                if (olen == 2) seg->sack_perm = 1;
+                break;
+            case TCP_OPT_SACK:
+                for (uint32_t j = 2; j + 8 <= olen && seg->sack_count < TCP_OOO_MAX; j += 8) {
+                    seg->sack[seg->sack_count].start = tcp_get32(opt + i + j);
+                    seg->sack[seg->sack_count].end = tcp_get32(opt + i + j + 4);
+                    seg->sack_count++;
+                }
+                break;
+            default:
+                break;
+        }
+        i += olen;
+    }
+}
+
+// Opções negociadas no SYN recebido
+static void tcp_syn_options(tcp_conn_t* c, const tcp_segment_t* seg) {
+    c->mss = seg->mss ? (seg->mss < TCP_MSS ? seg->mss : TCP_MSS) : TCP_DEFAULT_MSS;
+    if (c->mss < 64) c->mss = 64;
+    
+    if (seg->wscale != 0xFF) {
+        c->flags |= TCP_CF_WSCALE;
+        c->snd_wscale = seg->wscale;
+        c->rcv_wscale = TCP_RCV_WSCALE;
+    } else {
+        c->flags &= ~TCP_CF_WSCALE;
+        c->snd_wscale = 0;
+        c->rcv_wscale = 0;
+    }
+    if (seg->sack_perm) c->flags |= TCP_CF_SACK;
+    else c->flags &= ~TCP_CF_SACK;
+}
+
+// SYN numa escuta: cria a conexão filha em SYN_RECEIVED e responde
+static void tcp_listen_input(tcp_conn_t* l, const ip_header_t* ip, const tcp_header_t* tcp,
+                             const tcp_segment_t* seg) {
+    if (seg->flags & TCP_RST) return;
+    if (seg->flags & TCP_ACK) {
+        tcp_send_reset(ip, tcp, seg);
+        return;
+    }
+    if (!(seg->flags & TCP_SYN) || l->pending >= l->backlog) return;
+    
+    tcp_conn_t* c = tcp_conn_alloc();
+    if (!c) return;
+    
+    c->state = TCP_SYN_RECEIVED;
+    c->flags |= TCP_CF_ORPHAN;          // Sem dono até tcp_accept
+    c->local_port = l->local_port;
+    c->remote_port = ntohs(tcp->src_port);
+    c->remote_ip = ip->src_ip;
+    c->cc = l->cc;
+    c->listener = l;
+    l->pending++;
+    
+    c->irs = seg->seq;
+    c->rcv_nxt = seg->seq + 1;
+    c->rcv_adv = c->rcv_nxt;
+    tcp_syn_options(c, seg);
+    c->snd_wnd = seg->wnd;
+    c->snd_wl1 = seg->seq;
+    c->iss = tcp_initial_seq(c);
+    c->snd_una = c->iss;
+    c->snd_nxt = c->iss + 1;
+    c->snd_max = c->snd_nxt;
+    c->recover = c->iss;
+    tcp_hash_insert(c);
+    
+    c->rtt_timing = 1;
+    c->rtt_seq = c->iss;
+    c->rtt_start = tsc_read();
+    tcp_xmit(c, c->iss, TCP_SYN | TCP_ACK, 0);
+    c->rto_at = tcp_deadline(c->rto_ms);
+    tcp_timer_update(c);
+    tcp_stats.passive_opens++;
+}
+
+// Resposta ao nosso SYN
+static void tcp_syn_sent_input(tcp_conn_t* c, const ip_header_t* ip, const tcp_header_t* tcp,
+                               const tcp_segment_t* seg) {
+    if ((seg->flags & TCP_ACK) &&
+        (TCP_SEQ_LEQ(seg->ack, c->iss) || TCP_SEQ_GT(seg->ack, c->snd_max))) {
+        tcp_send_reset(ip, tcp, seg);
+        return;
+    }
+    if (seg->flags & TCP_RST) {
+        if (seg->flags & TCP_ACK) {
+            tcp_stats.attempt_fails++;
+            c->error = -1;
+            tcp_conn_finish(c);     // Conexão recusada
+        }
+        return;
+    }
+    if (!(seg->flags & TCP_SYN)) return;
+    
+    c->irs = seg->seq;
+    c->rcv_nxt = seg->seq + 1;
+    c->rcv_adv = c->rcv_nxt;
+    tcp_syn_options(c, seg);
+    c->snd_wnd = seg->wnd;
+    c->snd_wl1 = seg->seq;
+    c->snd_wl2 = seg->ack;
+    
+    if (!(seg->flags & TCP_ACK)) {
+        // Abertura simultânea
+        c->state = TCP_SYN_RECEIVED;
+        tcp_xmit(c, c->iss, TCP_SYN | TCP_ACK, 0);
+        return;
+    }
+    
+    c->snd_una = seg->ack;
+    if (c->rtt_timing && c->backoff == 0) tcp_rtt_sample(c, tsc_to_us(tsc_read() - c->rtt_start));
+    c->rtt_timing = 0;
+    tcp_conn_established(c);
+    tcp_send_ack(c);
+    tcp_timer_update(c);
+}
+
+// Remove do placar do SACK o que snd_una já cobriu
+static void tcp_sack_trim(tcp_conn_t* c) {
+    uint8_t n = 0;
+    
+    for (int i = 0; i < c->sacked_count; i++) {
+        tcp_range_t r = c->sacked[i];
+        
+        if (TCP_SEQ_LEQ(r.end, c->snd_una)) continue;
+        if (TCP_SEQ_LT(r.start, c->snd_una)) r.start = c->snd_una;
+        c->sacked[n++] = r;
+    }
+    c->sacked_count = n;
+}
+
+// Junta um bloco SACK recebido ao placar (ordenado, trechos que se tocam
+// viram um só). Cheio, esquece o trecho mais alto
+static void tcp_sack_insert(tcp_conn_t* c, tcp_range_t r) {
+    uint8_t n = 0;
+    
+    for (int i = 0; i < c->sacked_count; i++) {
+        tcp_range_t s = c->sacked[i];
+        
+        if (TCP_SEQ_LT(s.end, r.start) || TCP_SEQ_GT(s.start, r.end)) {
+            c->sacked[n++] = s;
+            continue;
+        }
+        if (TCP_SEQ_LT(s.start, r.start)) r.start = s.start;
+        if (TCP_SEQ_GT(s.end, r.end)) r.end = s.end;
+    }
+    
+    uint8_t pos = 0;
+    while (pos < n && TCP_SEQ_LT(c->sacked[pos].start, r.start)) pos++;
+    if (n == TCP_SACK_MAX) {
+        if (pos == n) {
+            c->sacked_count = n;
+            return;
+        }
+        n--;
+    }
+    for (uint8_t j = n; j > pos; j--) {
+        c->sacked[j] = c->sacked[j - 1];
+    }
+    c->sacked[pos] = r;
+    c->sacked_count = n + 1;
+}
+
+static void tcp_sack_update(tcp_conn_t* c, const tcp_segment_t* seg) {
+    for (int i = 0; i < seg->sack_count; i++) {
+        tcp_range_t r = seg->sack[i];
+        
+        // Ignora blocos inválidos e os que só repetem dados já confirmados
+        if (!TCP_SEQ_LT(r.start, r.end) || TCP_SEQ_LEQ(r.end, c->snd_una) ||
+            TCP_SEQ_GT(r.end, c->snd_max)) {
+            continue;
+        }
+        if (TCP_SEQ_LT(r.start, c->snd_una)) r.start = c->snd_una;
+        tcp_sack_insert(c, r);
+    }
+}
+
+// ACK duplicado (RFC 5681): o terceiro dispara a retransmissão rápida; na
+// recuperação, cada um infla a janela e, com SACK, preenche mais um buraco
+static void tcp_dupack(tcp_conn_t* c) {
+    c->dupacks++;
+    
+    if (c->flags & TCP_CF_RECOVERY) {
+        c->cwnd += c->mss;
+        if (c->flags & TCP_CF_SACK) tcp_retransmit_hole(c, 0);
+        tcp_output(c);
+        return;
+    }
+    
+    // Uma redução por janela de dados (RFC 6582: nada antes de recover)
+    if (c->dupacks != TCP_DUPACK_THRESHOLD || TCP_SEQ_LT(c->snd_una, c->recover)) return;
+    
+    c->ssthresh = c->cc->ssthresh(c);
+    c->recover = c->snd_max;
+    c->retx_next = c->snd_una;
+    c->flags |= TCP_CF_RECOVERY;
+    c->fast_retransmits++;
+    tcp_retransmit_hole(c, 1);
+    c->cwnd = c->ssthresh + TCP_DUPACK_THRESHOLD * c->mss;
+    c->rto_at = tcp_deadline(c->rto_ms);
+    tcp_output(c);
+}
+
+// A janela só cresce se foi ela que limitou o envio (RFC 7661): com a
+// janela do outro lado ou a aplicação segurando, cwnd ficaria sem lastro.
+// Na partida lenta basta ter usado metade
+static int tcp_cwnd_limited(const tcp_conn_t* c, uint32_t in_flight) {
+    if (c->cwnd < c->ssthresh) return in_flight * 2 >= c->cwnd;
+    return in_flight + c->mss >= c->cwnd;
+}
+
+// ACK que avança snd_una. Retorna -1 se a conexão foi liberada
+static int tcp_new_ack(tcp_conn_t* c, uint32_t ack) {
+    uint32_t in_flight = c->snd_max - c->snd_una;
+    uint32_t acked = ack - c->snd_una;
+    uint32_t data_acked = acked < c->snd_len ? acked : c->snd_len;
+    int fin_acked = (c->flags & TCP_CF_FIN_SENT) && acked > c->snd_len;
+    
+    c->snd_una = ack;
+    c->snd_head = (c->snd_head + data_acked) & TCP_SND_MASK;
+    c->snd_len -= data_acked;
+    c->bytes_out += data_acked;
+    if (TCP_SEQ_LT(c->snd_nxt, c->snd_una)) c->snd_nxt = c->snd_una;
+    tcp_sack_trim(c);
+    
+    if (c->rtt_timing && TCP_SEQ_GT(ack, c->rtt_seq)) {
+        tcp_rtt_sample(c, tsc_to_us(tsc_read() - c->rtt_start));
+        c->rtt_timing = 0;
+    }
+    c->backoff = 0;
+    
+    if (c->flags & TCP_CF_RECOVERY) {
+        if (TCP_SEQ_GEQ(ack, c->recover)) {
+            // ACK completo: sai da recuperação com a janela desinflada
+            c->flags &= ~TCP_CF_RECOVERY;
+            c->cwnd = c->ssthresh;
+            c->dupacks = 0;
+        } else {
+            // ACK parcial (RFC 6582): próximo buraco e desinflação parcial
+            if (!c->sacked_count) c->retx_next = c->snd_una;
+            tcp_retransmit_hole(c, 1);
+            c->cwnd = c->cwnd > data_acked ? c->cwnd - data_acked : 0;
+            if (data_acked >= c->mss) c->cwnd += c->mss;
+            if (c->cwnd < c->mss) c->cwnd = c->mss;
+        }
+    } else {
+        c->dupacks = 0;
+        if (data_acked && tcp_cwnd_limited(c, in_flight)) c->cc->cong_avoid(c, data_acked);
+    }
+    
+    c->rto_at = c->snd_una == c->snd_max ? 0 : tcp_deadline(c->rto_ms);
+    
+    if (fin_acked) {
+        switch (c->state) {
+            case TCP_FIN_WAIT_1:
+                c->state = TCP_FIN_WAIT_2;
+                if (c->flags & TCP_CF_ORPHAN) c->linger_at = tcp_deadline(TCP_FIN_WAIT2_TIME);
+                break;
+            case TCP_CLOSING:
+                tcp_enter_time_wait(c);
+                break;
+            case TCP_LAST_ACK:
+                tcp_conn_finish(c);
+                return c->used ? 0 : -1;
+            default:
+                break;
+        }
+    }
+    
+    tcp_output(c);
+    return 0;
+}
+
+// Campo ACK de um segmento sincronizado. Retorna -1 se a conexão foi
+// liberada
+static int tcp_ack_input(tcp_conn_t* c, const tcp_segment_t* seg) {
+    uint32_t ack = seg->ack;
+    
+    if (TCP_SEQ_GT(ack, c->snd_max)) {
+        tcp_send_ack(c);        // Confirma algo nunca enviado
+        return 0;
+    }
+    
+    // Atualização de janela só com segmento mais novo (SND.WL1/WL2)
+    int window_update = 0;
+    if (TCP_SEQ_LT(c->snd_wl1, seg->seq) ||
+        (c->snd_wl1 == seg->seq && TCP_SEQ_LEQ(c->snd_wl2, ack))) {
+        uint32_t wnd = (uint32_t)seg->wnd << c->snd_wscale;
+        
+        window_update = wnd != c->snd_wnd;
+        
+        // Janela reaberta: a persistência dá lugar ao RTO normal
+        if (window_update && c->snd_wnd == 0 && c->snd_nxt == c->snd_una) {
+            c->rto_at = 0;
+            c->backoff = 0;
+        }
+        c->snd_wnd = wnd;
+        c->snd_wl1 = seg->seq;
+        c->snd_wl2 = ack;
+    }
+    
+    if (c->flags & TCP_CF_SACK) tcp_sack_update(c, seg);
+    
+    if (TCP_SEQ_GT(ack, c->snd_una)) return tcp_new_ack(c, ack);
+    
+    // Duplicado: sem dados, sem mudar a janela e com dados em voo
+    if (ack == c->snd_una && seg->len == 0 && !(seg->flags & TCP_FIN) && !window_update &&
+        c->snd_max != c->snd_una) {
+        tcp_dupack(c);
+    } else if (window_update) {
+        tcp_output(c);
+    }
+    return 0;
+}
+
+// Grava len bytes no anel de recepção, a 'offset' bytes de rcv_head
+static void tcp_rcv_copy(tcp_conn_t* c, uint32_t offset, const uint8_t* data, uint32_t len) {
+    uint32_t pos = (c->rcv_head + offset) & TCP_RCV_MASK;
+    uint32_t first = TCP_RCV_BUF - pos < len ? TCP_RCV_BUF - pos : len;
+    
+    memory_copy(rcv_ring(c) + pos, data, first);
+    if (first < len) memory_copy(rcv_ring(c), data + first, len - first);
+}
+
+// Novo trecho fora de ordem: absorve os que ele toca e vai para o início
+// (bloco SACK mais recente). Cheio, esquece o mais antigo
+static void tcp_ooo_add(tcp_conn_t* c, uint32_t start, uint32_t end) {
+    tcp_range_t r = { start, end };
+    uint8_t n = 0;
+    
+    for (int i = 0; i < c->ooo_count; i++) {
+        tcp_range_t s = c->ooo[i];
+        
+        if (TCP_SEQ_LT(s.end, r.start) || TCP_SEQ_GT(s.start, r.end)) {
+            c->ooo[n++] = s;
+            continue;
+        }
+        if (TCP_SEQ_LT(s.start, r.start)) r.start = s.start;
+        if (TCP_SEQ_GT(s.end, r.end)) r.end = s.end;
+    }
+    
+    if (n == TCP_OOO_MAX) n--;
+    for (uint8_t j = n; j > 0; j--) {
+        c->ooo[j] = c->ooo[j - 1];
+    }
+    c->ooo[0] = r;
+    c->ooo_count = n + 1;
+}
+
+// Dados já cortados à janela. Em ordem, avança rcv_nxt e engole os trechos
+// fora de ordem que ficaram contíguos; fora de ordem, grava no lugar
+// definitivo do anel e guarda o trecho. Retorna 1 se o ACK deve sair já
+static int tcp_data_input(tcp_conn_t* c, uint32_t seq, const uint8_t* data, uint32_t len) {
+    uint32_t offset = seq - c->rcv_nxt;
+    
+    tcp_rcv_copy(c, c->rcv_len + offset, data, len);
+    if (offset) {
+        c->ooo_segs++;
+        tcp_ooo_add(c, seq, seq + len);
+        return 1;               // ACK duplicado imediato, com os blocos SACK
+    }
+    
+    int filled_hole = c->ooo_count != 0;
+    c->rcv_nxt += len;
+    c->rcv_len += len;
+    c->bytes_in += len;
+    
+    for (int i = 0; i < c->ooo_count; ) {
+        tcp_range_t r = c->ooo[i];
+        
+        if (TCP_SEQ_GT(r.start, c->rcv_nxt)) {
+            i++;
+            continue;
+        }
+        if (TCP_SEQ_GT(r.end, c->rcv_nxt)) {
+            uint32_t more = r.end - c->rcv_nxt;
+            c->rcv_nxt += more;
+            c->rcv_len += more;
+            c->bytes_in += more;
+        }
+        for (int j = i; j + 1 < c->ooo_count; j++) {
+            c->ooo[j] = c->ooo[j + 1];
+        }
+        c->ooo_count--;
+        i = 0;
+    }
+    return filled_hole;
+}
+
+// FIN em ordem: o outro lado terminou de enviar
+static void tcp_fin_input(tcp_conn_t* c) {
+    c->rcv_nxt++;
+    
+    switch (c->state) {
+        case TCP_SYN_RECEIVED:
+        case TCP_ESTABLISHED:
+            c->state = TCP_CLOSE_WAIT;
+            break;
+        case TCP_FIN_WAIT_1:
+            c->state = TCP_CLOSING;
+            break;
+        case TCP_FIN_WAIT_2:
+            c->linger_at = 0;
+            tcp_enter_time_wait(c);
+            break;
+        default:
+            break;
+    }
+    tcp_send_ack(c);
+}
+
+// Segmento numa conexão sincronizada (RFC 793, "SEGMENT ARRIVES")
+static void tcp_sync_input(tcp_conn_t* c, const ip_header_t* ip, const tcp_header_t* tcp,
+                           const tcp_segment_t* in) {
+    tcp_segment_t seg = *in;
+    uint32_t wnd = TCP_RCV_BUF - c->rcv_len;
+    uint32_t seg_len = seg.len + ((seg.flags & TCP_SYN) ? 1 : 0) + ((seg.flags & TCP_FIN) ? 1 : 0);
+    
+    // SYN repetido em SYN_RECEIVED: o SYN-ACK se perdeu
+    if (c->state == TCP_SYN_RECEIVED && (seg.flags & TCP_SYN) && !(seg.flags & TCP_ACK) &&
+        seg.seq == c->irs) {
+        tcp_xmit(c, c->iss, TCP_SYN | TCP_ACK, 0);
+        return;
+    }
+    
+    // 1. Sequência aceitável: algum byte dentro da janela
+    int acceptable;
+    if (seg_len == 0) {
+        acceptable = TCP_SEQ_GEQ(seg.seq, c->rcv_nxt) && TCP_SEQ_LEQ(seg.seq, c->rcv_nxt + wnd);
+    } else {
+        acceptable = wnd &&
+                     ((TCP_SEQ_GEQ(seg.seq, c->rcv_nxt) && TCP_SEQ_LT(seg.seq, c->rcv_nxt + wnd)) ||
+                      (TCP_SEQ_GT(seg.seq + seg_len, c->rcv_nxt) &&
+                       TCP_SEQ_LEQ(seg.seq + seg_len, c->rcv_nxt + wnd)));
+    }
+    if (!acceptable) {
+        if (!(seg.flags & TCP_RST)) tcp_send_ack(c);
+        return;
+    }
+    
+    // 2. RST: só o exato derruba a conexão; o resto da janela leva um ACK
+    // de desafio (RFC 5961)
+    if (seg.flags & TCP_RST) {
+        if (seg.seq != c->rcv_nxt) tcp_send_ack(c);
+        else if (c->state >= TCP_CLOSING) tcp_conn_finish(c);
+        else tcp_conn_reset(c);
+        return;
+    }
+    
+    // 3. SYN dentro da janela: ACK de desafio
+    if (seg.flags & TCP_SYN) {
+        tcp_send_ack(c);
+        return;
+    }
+    
+    // 4. ACK
+    if (!(seg.flags & TCP_ACK)) return;
+    
+    if (c->state == TCP_SYN_RECEIVED) {
+        if (TCP_SEQ_LEQ(seg.ack, c->snd_una) || TCP_SEQ_GT(seg.ack, c->snd_max)) {
+            tcp_send_reset(ip, tcp, &seg);
+            return;
+        }
+        c->snd_una = c->iss + 1;
+        if (c->rtt_timing && c->backoff == 0) tcp_rtt_sample(c, tsc_to_us(tsc_read() - c->rtt_start));
+        c->rtt_timing = 0;
+        c->snd_wnd = (uint32_t)seg.wnd << c->snd_wscale;
+        c->snd_wl1 = seg.seq;
+        c->snd_wl2 = seg.ack;
+        tcp_conn_established(c);
+        
+        // Pronta para tcp_accept: vai para o fim da fila da escuta
+        if (c->listener) {
+            tcp_conn_t** link = &c->listener->accept_head;
+            while (*link) link = &(*link)->accept_next;
+            c->accept_next = 0;
+            *link = c;
+        }
+    }
+    
+    if (tcp_ack_input(c, &seg) != 0) return;
+    if (c->state == TCP_TIME_WAIT || c->state == TCP_CLOSED) return;
+    
+    // 5. Dados: corta o que já foi recebido e o que passa da janela
+    uint32_t fin = seg.flags & TCP_FIN;
+    int ack_now = 0;
+    if (seg.len && c->state <= TCP_FIN_WAIT_2) {
+        if (TCP_SEQ_LT(seg.seq, c->rcv_nxt)) {
+            uint32_t skip = c->rcv_nxt - seg.seq;
+            
+            if (skip >= seg.len) {
+                seg.len = 0;
+            } else {
+                seg.data += skip;
+                seg.len -= skip;
+            }
+            seg.seq = c->rcv_nxt;
+        }
+        if (TCP_SEQ_GT(seg.seq + seg.len, c->rcv_nxt + wnd)) {
+            seg.len = c->rcv_nxt + wnd - seg.seq;
+            fin = 0;
+        }
+        
+        if (!seg.len) {
+            ack_now = 1;            // Só dados repetidos
+        } else if (tcp_data_input(c, seg.seq, seg.data, seg.len)) {
+            ack_now = 1;
+        } else if (++c->segs_unacked >= 2) {
+            ack_now = 1;            // ACK a cada dois segmentos
+        } else if (!c->delack_at) {
+            c->delack_at = tcp_deadline(TCP_DELACK_TIME);
+        }
+    }
+    
+    // 6. FIN, quando tudo antes dele chegou (a resposta leva o ACK)
+    if (fin && seg.seq + seg.len == c->rcv_nxt) tcp_fin_input(c);
+    else if (ack_now) tcp_send_ack(c);
+    tcp_timer_update(c);
+}
+
+// Valida o segmento e o entrega à conexão (ou escuta) da quádrupla
+void tcp_receive(const ip_header_t* ip, const uint8_t* data, size_t len, uint8_t csum_valid) {
+    const tcp_header_t* tcp = (const tcp_header_t*)data;
+    tcp_segment_t seg;
+    
+    tcp_stats.in_segs++;
+    if (len < TCP_HEADER_SIZE) {
+        tcp_stats.in_errs++;
+        return;
+    }
+    
+    uint32_t header_len = (tcp->data_offset >> 4) * 4;
+    if (header_len < TCP_HEADER_SIZE || header_len > len) {
+        tcp_stats.in_errs++;
+        return;
+    }
+    
+    if (csum_valid) {
+        tcp_stats.csum_offloaded++;
+    } else if (l4_checksum(&ip->src_ip, &ip->dst_ip, IP_PROTO_TCP, data, len) != 0) {
+        tcp_stats.in_errs++;
+        return;
+    }
+    
+    memory_set(&seg, 0, sizeof(seg));
+    seg.seq = ntohl(tcp->seq);
+    seg.ack = ntohl(tcp->ack);
+    seg.flags = tcp->flags;
+    seg.wnd = ntohs(tcp->window);
+    seg.data = data + header_len;
+    seg.len = len - header_len;
+    seg.wscale = 0xFF;
+    tcp_parse_options(data + TCP_HEADER_SIZE, header_len - TCP_HEADER_SIZE, &seg);
+    
+    tcp_conn_t* c = tcp_lookup(&ip->src_ip, ntohs(tcp->dst_port), ntohs(tcp->src_port));
+    if (!c) {
+        tcp_send_reset(ip, tcp, &seg);
+        return;
+    }
+    c->segs_in++;
+    
+    switch (c->state) {
+        case TCP_LISTEN:
+            tcp_listen_input(c, ip, tcp, &seg);
+            break;
+        case TCP_SYN_SENT:
+            tcp_syn_sent_input(c, ip, tcp, &seg);
+            break;
+        default:
+            tcp_sync_input(c, ip, tcp, &seg);
+            break;
+    }
+}
+
+// ============================================================================
+// SOCKETS
+// ============================================================================
+
+void tcp_init(void) {
+    memory_set(conns, 0, sizeof(conns));
+    memory_set(conn_hash, 0, sizeof(conn_hash));
+    memory_set(timer_wheel, 0, sizeof(timer_wheel));
+    memory_set(&tcp_stats, 0, sizeof(tcp_stats));
+    next_ephemeral = TCP_EPHEMERAL_MIN;
+    output_pending = 0;
+    wheel_tick = timer_ticks;
+}
+
+int tcp_socket(void) {
+    tcp_conn_t* c = tcp_conn_alloc();
+    
+    return c ? (int)(c - conns) : -1;
+}
+
+// Associa o socket a uma porta local; 0 escolhe uma porta efêmera livre
+int tcp_bind(int sock, uint16_t port) {
+    tcp_conn_t* c = tcp_get(sock);
+    
+    if (!c || c->local_port || c->state != TCP_CLOSED) return -1;
+    
+    if (port == 0) {
+        for (uint32_t i = 0; i <= TCP_EPHEMERAL_MAX - TCP_EPHEMERAL_MIN; i++) {
+            uint16_t candidate = next_ephemeral;
+            
+            next_ephemeral = candidate == TCP_EPHEMERAL_MAX ? TCP_EPHEMERAL_MIN : candidate + 1;
+            if (!tcp_port_in_use(candidate)) {
+                port = candidate;
+                break;
+            }
+        }
+        if (port == 0) return -1;
+    } else if (tcp_port_in_use(port)) {
+        return -1;  // Porta em uso
+    }
+    
+    c->local_port = port;
+    return 0;
+}
+
+int tcp_listen(int sock, int backlog) {
+    tcp_conn_t* c = tcp_get(sock);
+    
+    if (!c || !c->local_port || c->state != TCP_CLOSED) return -1;
+    if (backlog < 1) backlog = 1;
+    if (backlog > TCP_BACKLOG_MAX) backlog = TCP_BACKLOG_MAX;
+    
+    c->backlog = backlog;
+    c->state = TCP_LISTEN;
+    tcp_hash_insert(c);
+    return 0;
+}
+
+// Retira uma conexão pronta da fila da escuta: o descritor novo, TCP_AGAIN
+// se nenhuma completou o handshake ainda ou -1
+int tcp_accept(int sock) {
+    tcp_conn_t* l = tcp_get(sock);
+    
+    if (!l || l->state != TCP_LISTEN) return -1;
+    if (!l->accept_head) return TCP_AGAIN;
+    
+    tcp_conn_t* c = l->accept_head;
+    l->accept_head = c->accept_next;
+    l->pending--;
+    c->accept_next = 0;
+    c->listener = 0;
+    c->flags &= ~TCP_CF_ORPHAN;
+    return (int)(c - conns);
+}
+
+// Abertura ativa: envia o SYN e volta; o estado vira ESTABLISHED (ou
+// CLOSED com erro) durante network_process_packets
+int tcp_connect(int sock, const ip_addr_t* ip, uint16_t port) {
+    tcp_conn_t* c = tcp_get(sock);
+    
+    if (!c || c->state != TCP_CLOSED || port == 0) return -1;
+    if (!c->local_port && tcp_bind(sock, 0) != 0) return -1;
+    if (tcp_lookup(ip, c->local_port, port)) return -1;
+    
+    c->remote_ip = *ip;
+    c->remote_port = port;
+    c->error = 0;
+    c->state = TCP_SYN_SENT;
+    c->rcv_wscale = TCP_RCV_WSCALE;
+    c->iss = tcp_initial_seq(c);
+    c->snd_una = c->iss;
+    c->snd_nxt = c->iss + 1;
+    c->snd_max = c->snd_nxt;
+    c->recover = c->iss;
+    tcp_hash_insert(c);
+    
+    c->rtt_timing = 1;
+    c->rtt_seq = c->iss;
+    c->rtt_start = tsc_read();
+    tcp_xmit(c, c->iss, TCP_SYN, 0);
+    c->rto_at = tcp_deadline(c->rto_ms);
+    tcp_timer_update(c);
+    tcp_stats.active_opens++;
+    return 0;
+}
+
+// Copia o que couber no anel de envio e transmite o que a janela deixa.
+// Retorna os bytes aceitos (0 com o anel cheio ou o handshake em curso)
+int tcp_send(int sock, const void* data, size_t len) {
+    tcp_conn_t* c = tcp_get(sock);
+    
+    if (!c) return -1;
+    if (c->state == TCP_SYN_SENT || c->state == TCP_SYN_RECEIVED) return 0;
+    if ((c->state != TCP_ESTABLISHED && c->state != TCP_CLOSE_WAIT) ||
+        (c->flags & TCP_CF_FIN_QUEUED)) {
+        return -1;
+    }
+    
+    uint32_t room = TCP_SND_BUF - c->snd_len;
+    uint32_t n = len < room ? len : room;
+    uint32_t pos = (c->snd_head + c->snd_len) & TCP_SND_MASK;
+    uint32_t first = TCP_SND_BUF - pos < n ? TCP_SND_BUF - pos : n;
+    
+    memory_copy(snd_ring(c) + pos, data, first);
+    if (first < n) memory_copy(snd_ring(c), (const uint8_t*)data + first, n - first);
+    c->snd_len += n;
+    
+    if (n) tcp_output(c);
+    return n;
+}
+
+// Lê até len bytes (data nulo descarta). Retorna os bytes lidos, 0 no fim
+// dos dados (FIN recebido), TCP_AGAIN sem dados ainda ou -1 depois de RST
+int tcp_recv(int sock, void* data, size_t len) {
+    tcp_conn_t* c = tcp_get(sock);
+    
+    if (!c || c->state == TCP_LISTEN) return -1;
+    
+    if (c->rcv_len == 0) {
+        if (c->error) return -1;
+        if (c->state == TCP_CLOSED || c->state == TCP_CLOSE_WAIT || c->state == TCP_CLOSING ||
+            c->state == TCP_LAST_ACK || c->state == TCP_TIME_WAIT) {
+            return 0;
+        }
+        return TCP_AGAIN;
+    }
+    
+    uint32_t n = len < c->rcv_len ? len : c->rcv_len;
+    if (data) {
+        uint32_t first = TCP_RCV_BUF - c->rcv_head < n ? TCP_RCV_BUF - c->rcv_head : n;
+        
+        memory_copy(data, rcv_ring(c) + c->rcv_head, first);
+        if (first < n) memory_copy((uint8_t*)data + first, rcv_ring(c), n - first);
+    }
+    c->rcv_head = (c->rcv_head + n) & TCP_RCV_MASK;
+    c->rcv_len -= n;
+    
+    // Atualização de janela quando o espaço livre cresceu o bastante
+    if (c->state >= TCP_ESTABLISHED && c->state <= TCP_FIN_WAIT_2) {
+        uint32_t cur = TCP_SEQ_GT(c->rcv_adv, c->rcv_nxt) ? c->rcv_adv - c->rcv_nxt : 0;
+        if (tcp_rcv_window(c) > cur) tcp_send_ack(c);
+    }
+    return n;
+}
+
+// Fecha o sentido de envio: o FIN sai depois dos dados do anel
+int tcp_shutdown(int sock) {
+    tcp_conn_t* c = tcp_get(sock);
+    
+    if (!c) return -1;
+    if (c->flags & TCP_CF_FIN_QUEUED) return 0;
+    
+    if (c->state == TCP_ESTABLISHED) c->state = TCP_FIN_WAIT_1;
+    else if (c->state == TCP_CLOSE_WAIT) c->state = TCP_LAST_ACK;
+    else return -1;
+    
+    c->flags |= TCP_CF_FIN_QUEUED;
+    tcp_output(c);
+    return 0;
+}
+
+// Libera o descritor. Conexões abertas terminam sozinhas (FIN e, depois,
+// TIME_WAIT); dados recebidos e não lidos abortam com RST (RFC 2525)
+void tcp_close(int sock) {
+    tcp_conn_t* c = tcp_get(sock);
+    
+    if (!c) return;
+    
+    if (c->state == TCP_LISTEN) {
+        // Filhas ainda não aceitas morrem com a escuta
+        for (int i = 0; i < TCP_MAX_CONNS; i++) {
+            if (conns[i].used && conns[i].listener == c) tcp_abort(&conns[i]);
+        }
+        tcp_conn_free(c);
+        return;
+    }
+    
+    c->flags |= TCP_CF_ORPHAN;
+    if (c->state == TCP_CLOSED || c->state == TCP_SYN_SENT) {
+        tcp_conn_free(c);
+    } else if (c->rcv_len && c->state <= TCP_CLOSE_WAIT) {
+        tcp_abort(c);
+    } else if (c->state == TCP_SYN_RECEIVED || c->state == TCP_ESTABLISHED ||
+               c->state == TCP_CLOSE_WAIT) {
+        tcp_shutdown(sock);
+    } else if (c->state == TCP_FIN_WAIT_2) {
+        c->linger_at = tcp_deadline(TCP_FIN_WAIT2_TIME);
+        tcp_timer_update(c);
+    }
+}
+
+int tcp_get_state(int sock) {
+    tcp_conn_t* c = tcp_get(sock);
+    
+    return c ? c->state : -1;
+}
+
+const tcp_conn_t* tcp_get_conn(int sock) {
+    return tcp_get(sock);
+}
+
+// Troca o algoritmo de congestionamento (antes de conectar ou escutar; as
+// conexões filhas herdam o da escuta)
+int tcp_set_congestion(int sock, const char* name) {
+    tcp_conn_t* c = tcp_get(sock);
+    const tcp_cc_ops_t* cc = tcp_cc_find(name);
+    
+    if (!c || !cc || c->state != TCP_CLOSED) return -1;
+    c->cc = cc;
+    return 0;
+}
+
+// ============================================================================
+// DIAGNÓSTICO
+// ============================================================================
+
+int tcp_active_connections(void) {
+    int count = 0;
+    
+    for (int i = 0; i < TCP_MAX_CONNS; i++) {
+        if (conns[i].used && conns[i].state != TCP_CLOSED && conns[i].state != TCP_LISTEN) count++;
+    }
+    return count;
+}
+
+// Imprime us microssegundos como milissegundos com três casas
+static void tcp_print_ms(uint32_t us) {
+    terminal_print_dec(us / 1000);
+    terminal_print(".");
+    if (us % 1000 < 100) terminal_print("0");
+    if (us % 1000 < 10) terminal_print("0");
+    terminal_print_dec(us % 1000);
+}
+
+static void tcp_print_endpoint(const ip_addr_t* ip, uint16_t port) {
+    char ip_str[16];
+    
+    ip_to_string(ip, ip_str);
+    terminal_print(ip_str);
+    terminal_print(":");
+    terminal_print_dec(port);
+}
+
+static void tcp_print_conn(int index, const tcp_conn_t* c) {
+    terminal_print("  Socket ");
+    terminal_print_dec(index);
+    terminal_print(": ");
+    
+    if (c->state == TCP_LISTEN || c->state == TCP_CLOSED) {
+        terminal_print("porta ");
+        terminal_print_dec(c->local_port);
+        terminal_print(" ");
+        terminal_print(state_names[c->state]);
+        if (c->state == TCP_LISTEN) {
+            terminal_print(" (");
+            terminal_print_dec(c->pending);
+            terminal_print(" pendentes)");
+        }
+        terminal_print("\n");
+        return;
+    }
+    
+    tcp_print_endpoint(&network_get_interface()->ip_address, c->local_port);
+    terminal_print(" -> ");
+    tcp_print_endpoint(&c->remote_ip, c->remote_port);
+    terminal_print(" ");
+    terminal_print(state_names[c->state]);
+    terminal_print(" (");
+    terminal_print(c->cc->name);
+    if (c->flags & TCP_CF_SACK) terminal_print(", SACK");
+    if (c->flags & TCP_CF_WSCALE) terminal_print(", escala");
+    terminal_print(")\n");
+    
+    terminal_print("    srtt ");
+    tcp_print_ms(c->srtt_us);
+    terminal_print(" ms, rto ");
+    terminal_print_dec(c->rto_ms);
+    terminal_print(" ms, mss ");
+    terminal_print_dec(c->mss);
+    terminal_print(", cwnd ");
+    terminal_print_dec(c->cwnd);
+    terminal_print(", ssthresh ");
+    if (c->ssthresh == TCP_SSTHRESH_INIT) terminal_print("-");
+    else terminal_print_dec(c->ssthresh);
+    terminal_print(", janela ");
+    terminal_print_dec(c->snd_wnd);
+    terminal_print(", anel tx ");
+    terminal_print_dec(c->snd_len);
+    terminal_print(" rx ");
+    terminal_print_dec(c->rcv_len);
+    terminal_print("\n");
+    
+    terminal_print("    ");
+    terminal_print_dec(c->segs_in);
+    terminal_print(" segmentos recebidos, ");
+    terminal_print_dec(c->segs_out);
+    terminal_print(" enviados, ");
+    terminal_print_dec(c->retransmits);
+    terminal_print(" retransmitidos (");
+    terminal_print_dec(c->fast_retransmits);
+    terminal_print(" rapidas, ");
+    terminal_print_dec(c->timeouts);
+    terminal_print(" RTOs, ");
+    terminal_print_dec(c->sack_recovered);
+    terminal_print(" por SACK), ");
+    terminal_print_dec(c->ooo_segs);
+    terminal_print(" fora de ordem\n");
+}
+
+void tcp_print_stats(void) {
+    terminal_print("TCP: ");
+    terminal_print_dec(tcp_stats.in_segs);
+    terminal_print(" segmentos recebidos, ");
+    terminal_print_dec(tcp_stats.out_segs);
+    terminal_print(" enviados, ");
+    terminal_print_dec(tcp_stats.retrans_segs);
+    terminal_print(" retransmitidos, ");
+    terminal_print_dec(tcp_stats.in_errs);
+    terminal_print(" erros, ");
+    terminal_print_dec(tcp_stats.out_rsts);
+    terminal_print(" RSTs, ");
+    terminal_print_dec(tcp_stats.csum_offloaded);
+    terminal_print(" checksums conferidos pela placa\n");
+    terminal_print("     ");
+    terminal_print_dec(tcp_stats.active_opens);
+    terminal_print(" aberturas ativas, ");
+    terminal_print_dec(tcp_stats.passive_opens);
+    terminal_print(" passivas, ");
+    terminal_print_dec(tcp_stats.attempt_fails);
+    terminal_print(" falhas, ");
+    terminal_print_dec(tcp_stats.estab_resets);
+    terminal_print(" resets; temporizadores: ");
+    terminal_print_dec(tcp_stats.timer_fires);
+    terminal_print(" disparos, ");
+    terminal_print_dec(tcp_stats.timer_relinks);
+    terminal_print(" reposicionamentos\n");
+    
+    for (int i = 0; i < TCP_MAX_CONNS; i++) {
+        if (conns[i].used) tcp_print_conn(i, &conns[i]);
+    }
+}
+
+// ============================================================================
+// BENCHMARK
+// ============================================================================
+
+// Processa a rede enquanto a conexão estiver em 'state', por até ms
+static int tcp_bench_wait(int sock, int state, uint32_t ms) {
+    uint64_t deadline = tsc_read() + (uint64_t)ms * tsc_khz;
+    
+    while (tcp_get_state(sock) == state && tsc_read() < deadline) {
+        network_process_packets();
+    }
+    return tcp_get_state(sock);
+}
+
+// Imprime "X.Y Mbit/s" para 'bytes' em 'us' microssegundos
+static void tcp_bench_print_rate(uint64_t bytes, uint32_t us) {
+    if (us == 0) us = 1;
+    
+    uint32_t mbit10 = (uint32_t)div64_32(bytes * 80, us);  // Décimos de Mbit/s
+    
+    terminal_print_dec(mbit10 / 10);
+    terminal_print(".");
+    terminal_print_dec(mbit10 % 10);
+    terminal_print(" Mbit/s\n");
+}
+
+// tcpbench send IP PORTA [MB] [ALGORITMO]: conecta a um servidor (ex.: nc
+// -l no host, 10.0.2.2 na rede de usuário do QEMU), envia MB megabytes e
+// espera a confirmação do FIN
+static void tcp_bench_send(const ip_addr_t* dst_ip, uint16_t port, uint32_t mb, const char* cc) {
+    static uint8_t chunk[TCP_BENCH_CHUNK];
+    int sock = tcp_socket();
+    
+    if (sock < 0) {
+        terminal_print("Sem sockets TCP livres\n");
+        return;
+    }
+    if (cc[0] && tcp_set_congestion(sock, cc) != 0) {
+        terminal_print("Algoritmo desconhecido (use cubic ou newreno)\n");
+        tcp_close(sock);
+        return;
+    }
+    if (ip_resolve(dst_ip, 1000) != 0 || tcp_connect(sock, dst_ip, port) != 0) {
+        terminal_print("Sem rota para o destino\n");
+        tcp_close(sock);
+        return;
+    }
+    if (tcp_bench_wait(sock, TCP_SYN_SENT, 3000) != TCP_ESTABLISHED) {
+        terminal_print("Conexao recusada ou sem resposta\n");
+        tcp_close(sock);
+        return;
+    }
+    
+    for (uint32_t i = 0; i < TCP_BENCH_CHUNK; i++) {
+        chunk[i] = (uint8_t)i;
+    }
+    
+    const tcp_conn_t* c = tcp_get_conn(sock);
+    uint64_t total = (uint64_t)mb * 1024 * 1024, queued = 0;
+    uint64_t start = tsc_read(), progress = start;
+    uint64_t idle = (uint64_t)TCP_BENCH_TIMEOUT * tsc_khz;
+    uint32_t acked = 0;
+    
+    while (queued < total && !c->error) {
+        uint32_t n = total - queued < TCP_BENCH_CHUNK ? (uint32_t)(total - queued) : TCP_BENCH_CHUNK;
+        int sent = tcp_send(sock, chunk, n);
+        
+        if (sent < 0) break;
+        queued += sent;
+        network_process_packets();
+        
+        uint64_t now = tsc_read();
+        if (c->bytes_out != acked) {
+            acked = c->bytes_out;
+            progress = now;
+        } else if (now - progress > idle) {
+            break;
+        }
+    }
+    
+    tcp_shutdown(sock);
+    tcp_bench_wait(sock, TCP_FIN_WAIT_1, TCP_BENCH_TIMEOUT);
+    uint32_t us = tsc_to_us(tsc_read() - start);
+    
+    terminal_print_dec(c->bytes_out);
+    terminal_print(" bytes confirmados em ");
+    terminal_print_dec(us / 1000);
+    terminal_print(" ms (");
+    terminal_print(c->cc->name);
+    terminal_print("): ");
+    tcp_bench_print_rate(c->bytes_out, us);
+    terminal_print("srtt ");
+    tcp_print_ms(c->srtt_us);
+    terminal_print(" ms (min ");
+    tcp_print_ms(c->rtt_min_us);
+    terminal_print("), cwnd final ");
+    terminal_print_dec(c->cwnd / c->mss);
+    terminal_print(" segmentos, ");
+    terminal_print_dec(c->retransmits);
+    terminal_print(" retransmissoes (");
+    terminal_print_dec(c->fast_retransmits);
+    terminal_print(" rapidas, ");
+    terminal_print_dec(c->timeouts);
+    terminal_print(" RTOs, ");
+    terminal_print_dec(c->sack_recovered);
+    terminal_print(" por SACK)\n");
+    if (c->error || c->bytes_out < total) terminal_print("Transferencia incompleta\n");
+    tcp_close(sock);
+}
+
+// tcpbench recv PORTA [SEGUNDOS]: espera uma conexão (ex.: nc no host com
+// a porta redirecionada) e lê até o FIN. A taxa vale do primeiro byte ao
+// último
+static void tcp_bench_recv(uint16_t port, uint32_t seconds) {
+    static uint8_t chunk[TCP_BENCH_CHUNK];
+    int listener = tcp_socket();
+    
+    if (listener < 0 || tcp_bind(listener, port) != 0 || tcp_listen(listener, 1) != 0) {
+        terminal_print("Porta em uso ou sem sockets TCP livres\n");
+        if (listener >= 0) tcp_close(listener);
+        return;
+    }
+    
+    terminal_print("Aguardando conexao na porta ");
+    terminal_print_dec(port);
+    terminal_print("...\n");
+    
+    uint64_t deadline = tsc_read() + (uint64_t)seconds * 1000 * tsc_khz;
+    int sock = TCP_AGAIN;
+    
+    while (sock == TCP_AGAIN && tsc_read() < deadline) {
+        network_process_packets();
+        sock = tcp_accept(listener);
+    }
+    tcp_close(listener);
+    if (sock < 0) {
+        terminal_print("Nenhuma conexao\n");
+        return;
+    }
+    
+    const tcp_conn_t* c = tcp_get_conn(sock);
+    uint64_t bytes = 0, first = 0, last = tsc_read();
+    uint64_t idle = (uint64_t)TCP_BENCH_TIMEOUT * tsc_khz;
+    uint32_t checksum = 0;
+    int result;
+    
+    for (;;) {
+        result = tcp_recv(sock, chunk, sizeof(chunk));
+        if (result > 0) {
+            last = tsc_read();
+            if (bytes == 0) first = last;
+            bytes += result;
+            checksum += chunk[0];
+            continue;
+        }
+        if (result != TCP_AGAIN || tsc_read() - last > idle) break;
+        network_process_packets();
+    }
+    (void)checksum;
+    
+    terminal_print_dec((uint32_t)bytes);
+    terminal_print(" bytes de ");
+    tcp_print_endpoint(&c->remote_ip, c->remote_port);
+    terminal_print(" (");
+    terminal_print_dec(c->segs_in);
+    terminal_print(" segmentos, ");
+    terminal_print_dec(c->ooo_segs);
+    terminal_print(" fora de ordem)");
+    terminal_print(result == 0 ? "\n" : ", sem FIN\n");
+    if (bytes > 0) {
+        terminal_print("Taxa: ");
+        tcp_bench_print_rate(bytes, tsc_to_us(last - first));
+    }
+    tcp_close(sock);
+}
+
+// tcpbench send IP PORTA [MB] [ALGORITMO] | tcpbench recv PORTA [SEGUNDOS]
+void cmd_tcpbench(const char* args) {
+    char mode[8], arg1[16], arg2[16], arg3[16], arg4[16];
+    uint32_t port = 0, mb = TCP_BENCH_MB, seconds = 30;
+    ip_addr_t dst_ip;
+    
+    args = net_next_token(args, mode, sizeof(mode));
+    args = net_next_token(args, arg1, sizeof(arg1));
+    args = net_next_token(args, arg2, sizeof(arg2));
+    args = net_next_token(args, arg3, sizeof(arg3));
+    net_next_token(args, arg4, sizeof(arg4));
+    
+    if (!network_get_interface()->dev) {
+        terminal_print("tcpbench requer uma placa de rede\n");
+        return;
+    }
+    
+    if (strcmp(mode, "send") == 0 && string_to_ip(arg1, &dst_ip) == 0 &&
+        net_parse_uint(arg2, &port) == 0 && port > 0 && port <= 65535) {
+        const char* cc = arg4;
+        
+        // MB é opcional: "send IP PORTA cubic" também vale
+        if (arg3[0] != '\0' && net_parse_uint(arg3, &mb) != 0) {
+            if (arg4[0] != '\0') mb = 0;
+            cc = arg3;
+        }
+        if (mb > 0 && mb <= 1024) {
+            tcp_bench_send(&dst_ip, port, mb, cc);
+            return;
+        }
+    }
+    
+    if (strcmp(mode, "recv") == 0 && net_parse_uint(arg1, &port) == 0 &&
+        port > 0 && port <= 65535 &&
+        (arg2[0] == '\0' || (net_parse_uint(arg2, &seconds) == 0 && seconds > 0))) {
+        tcp_bench_recv(port, seconds);
+        return;
+    }
+    
+    terminal_print("Uso: tcpbench send IP PORTA [MB] [cubic|newreno]\n");
+    terminal_print("     tcpbench recv PORTA [SEGUNDOS]\n");
+}
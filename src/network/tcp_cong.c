@@ -0,0 +1,212 @@
+// ============================================================================
+// NanoOS - Controle de congestionamento do TCP
+// NewReno (RFC 5681/6582) e CUBIC (RFC 8312). Cada conexão aponta para um
+// tcp_cc_ops_t; a recuperação rápida e o RTO ficam em tcp.c e só pedem
+// ao algoritmo o novo ssthresh
+// ============================================================================
+
+#include "../../include/tcp.h"
+#include "../../include/kernel.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// CUBIC em ponto fixo: β = 717/1024 (0,7) e C = 0,4 segmentos/s³
+#define CUBIC_BETA              717
+#define CUBIC_BETA_SCALE        15          // 8·(1+β)/3/(1-β): região amigável ao Reno
+#define CUBIC_K_SCALE           2500000000ull   // ms³ por segmento (1/C)
+#define CUBIC_MAX_OFFSET        100000      // ms; limita o cubo a 10^15
+
+// ============================================================================
+// AUXILIARES
+// ============================================================================
+
+static inline uint32_t tcp_now_ms(void) {
+    return timer_ticks * (1000 / TIMER_FREQUENCY);
+}
+
+// Partida lenta com contagem de bytes (RFC 3465, L = 2·MSS): cresce até
+// ssthresh e devolve os bytes confirmados que sobraram para a prevenção
+static uint32_t tcp_slow_start(tcp_conn_t* conn, uint32_t acked) {
+    uint32_t inc = acked < 2u * conn->mss ? acked : 2u * conn->mss;
+    uint32_t room = conn->ssthresh - conn->cwnd;
+    
+    if (inc >= room) {
+        conn->cwnd = conn->ssthresh;
+        return acked - room;
+    }
+    conn->cwnd += inc;
+    return 0;
+}
+
+// Raiz cúbica inteira, bit a bit (sem divisão de 64 bits)
+static uint32_t cbrt64(uint64_t x) {
+    uint64_t y = 0;
+    
+    for (int shift = 63; shift >= 0; shift -= 3) {
+        y <<= 1;
+        uint64_t b = 3 * y * (y + 1) + 1;
+        if ((x >> shift) >= b) {
+            x -= b << shift;
+            y++;
+        }
+    }
+    return (uint32_t)y;
+}
+
+// ============================================================================
+// NEWRENO
+// ============================================================================
+
+// Prevenção: um MSS por janela confirmada
+static void newreno_cong_avoid(tcp_conn_t* conn, uint32_t acked) {
+    if (conn->cwnd < conn->ssthresh) {
+        acked = tcp_slow_start(conn, acked);
+        if (!acked) return;
+    }
+    
+    conn->cwnd_cnt += acked;
+    if (conn->cwnd_cnt >= conn->cwnd) {
+        conn->cwnd_cnt -= conn->cwnd;
+        conn->cwnd += conn->mss;
+    }
+}
+
+// Metade dos dados em voo, no mínimo dois segmentos
+static uint32_t newreno_ssthresh(tcp_conn_t* conn) {
+    uint32_t flight = conn->snd_max - conn->snd_una;
+    
+    return flight / 2 > 2u * conn->mss ? flight / 2 : 2u * conn->mss;
+}
+
+static void newreno_init(tcp_conn_t* conn) {
+    conn->cwnd_cnt = 0;
+}
+
+static const tcp_cc_ops_t tcp_newreno = {
+    .name = "newreno",
+    .init = newreno_init,
+    .cong_avoid = newreno_cong_avoid,
+    .ssthresh = newreno_ssthresh,
+};
+
+// ============================================================================
+// CUBIC
+// ============================================================================
+
+// Quantos segmentos confirmados valem um segmento de aumento (cnt), pela
+// curva W(t) = C·(t - K)³ + W_max avaliada um RTT adiante, sem ficar
+// abaixo do que o Reno teria crescido no mesmo tempo
+static void cubic_update(tcp_conn_t* conn, uint32_t cwnd, uint32_t acked) {
+    tcp_cubic_t* ca = &conn->cubic;
+    uint32_t now = tcp_now_ms();
+    
+    ca->ack_cnt += acked;
+    if (ca->epoch_start == 0) {
+        ca->epoch_start = now ? now : 1;
+        ca->ack_cnt = acked;
+        ca->tcp_cwnd = cwnd;
+        if (ca->last_max <= cwnd) {
+            ca->k = 0;
+            ca->origin = cwnd;
+        } else {
+            ca->k = cbrt64((uint64_t)(ca->last_max - cwnd) * CUBIC_K_SCALE);
+            ca->origin = ca->last_max;
+        }
+    }
+    
+    uint32_t t = now - ca->epoch_start + conn->rtt_min_us / 1000;
+    uint32_t offset = t < ca->k ? ca->k - t : t - ca->k;
+    if (offset > CUBIC_MAX_OFFSET) offset = CUBIC_MAX_OFFSET;
+    
+    // C·offset³ com offset em ms: offset³ / 2,5·10^9
+    uint64_t cube = (uint64_t)offset * offset * offset;
+    uint32_t delta = (uint32_t)div64_32(div64_32(cube, 100000), 25000);
+    uint32_t target;
+    
+    if (t < ca->k) target = ca->origin > delta ? ca->origin - delta : 0;
+    else target = ca->origin + delta;
+    
+    uint32_t cnt = target > cwnd ? cwnd / (target - cwnd) : 100 * cwnd;
+    if (ca->last_max == 0 && cnt > 20) cnt = 20;  // Primeira época: sonda rápido
+    
+    // Região amigável: estimativa da janela de um Reno com o mesmo β
+    uint32_t per_segment = (cwnd * CUBIC_BETA_SCALE) >> 3;
+    if (per_segment == 0) per_segment = 1;
+    while (ca->ack_cnt > per_segment) {
+        ca->ack_cnt -= per_segment;
+        ca->tcp_cwnd++;
+    }
+    if (ca->tcp_cwnd > cwnd) {
+        uint32_t reno_cnt = cwnd / (ca->tcp_cwnd - cwnd);
+        if (cnt > reno_cnt) cnt = reno_cnt;
+    }
+    
+    ca->cnt = cnt < 2 ? 2 : cnt;
+}
+
+static void cubic_cong_avoid(tcp_conn_t* conn, uint32_t acked) {
+    if (conn->cwnd < conn->ssthresh) {
+        acked = tcp_slow_start(conn, acked);
+        if (!acked) return;
+    }
+    
+    uint32_t segments = acked / conn->mss;
+    if (segments == 0) segments = 1;
+    
+    cubic_update(conn, conn->cwnd / conn->mss, segments);
+    conn->cwnd_cnt += segments;
+    if (conn->cwnd_cnt >= conn->cubic.cnt) {
+        conn->cwnd += conn->mss * (conn->cwnd_cnt / conn->cubic.cnt);
+        conn->cwnd_cnt %= conn->cubic.cnt;
+    }
+}
+
+// Perda: lembra W_max (menor, com convergência rápida, se a janela não
+// chegou ao máximo anterior) e reduz para β·cwnd
+static uint32_t cubic_ssthresh(tcp_conn_t* conn) {
+    tcp_cubic_t* ca = &conn->cubic;
+    uint32_t cwnd = conn->cwnd / conn->mss;
+    
+    ca->epoch_start = 0;
+    if (cwnd < ca->last_max) {
+        ca->last_max = cwnd * (1024 + CUBIC_BETA) / (2 * 1024);
+    } else {
+        ca->last_max = cwnd;
+    }
+    
+    uint32_t ssthresh = (uint32_t)((uint64_t)conn->cwnd * CUBIC_BETA / 1024);
+    return ssthresh > 2u * conn->mss ? ssthresh : 2u * conn->mss;
+}
+
+static void cubic_init(tcp_conn_t* conn) {
+    memory_set(&conn->cubic, 0, sizeof(tcp_cubic_t));
+    conn->cwnd_cnt = 0;
+}
+
+static const tcp_cc_ops_t tcp_cubic = {
+    .name = "cubic",
+    .init = cubic_init,
+    .cong_avoid = cubic_cong_avoid,
+    .ssthresh = cubic_ssthresh,
+};
+
+// ============================================================================
+// REGISTRO
+// ============================================================================
+
+// O primeiro é o padrão das conexões novas
+static const tcp_cc_ops_t* const cc_table[] = {
+    &tcp_cubic,
+    &tcp_newreno,
+};
+
+const tcp_cc_ops_t* tcp_cc_find(const char* name) {
+    for (uint32_t i = 0; i < sizeof(cc_table) / sizeof(cc_table[0]); i++) {
+        if (strcmp(cc_table[i]->name, name) == 0) return cc_table[i];
+    }
+    return 0;
+}
+
+const tcp_cc_ops_t* tcp_cc_default(void) {
+    return cc_table[0];
+}
@@ -0,0 +1,522 @@
+// ============================================================================
+// NanoOS - UDP
+// Sockets do kernel com demultiplexação por hash da porta local. O
+// datagrama recebido fica no buffer do pacote (emprestado pelo driver
+// quando possível) até o dono liberá-lo
+// ============================================================================
+
+#include "../../include/udp.h"
+#include "../../include/network.h"
+#include "../../include/netdev.h"
+#include "../../include/kernel.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// VARIÁVEIS GLOBAIS
+// ============================================================================
+
+static udp_socket_t sockets[UDP_MAX_SOCKETS];
+static udp_socket_t* port_hash[UDP_HASH_SIZE];
+static uint16_t next_ephemeral = UDP_EPHEMERAL_MIN;
+static udp_stats_t udp_stats;
+
+// Datagrama montado para envio (protegido por irq_save)
+static uint8_t tx_datagram[UDP_HEADER_SIZE + UDP_MAX_DATAGRAM];
+
+// ============================================================================
+// TABELA DE PORTAS
+// ============================================================================
+
+// Bucket da porta - hash multiplicativo de Knuth
+static inline uint32_t udp_hash(uint16_t port) {
+    return ((uint32_t)port * 2654435761u >> 16) & (UDP_HASH_SIZE - 1);
+}
+
+static udp_socket_t* udp_lookup(uint16_t port) {
+    udp_socket_t* sock = port_hash[udp_hash(port)];
+    
+    while (sock) {
+        if (sock->port == port) return sock;
+        sock = sock->hash_next;
+    }
+    return 0;
+}
+
+static void udp_hash_insert(udp_socket_t* sock) {
+    uint32_t h = udp_hash(sock->port);
+    sock->hash_next = port_hash[h];
+    port_hash[h] = sock;
+}
+
+static void udp_hash_remove(udp_socket_t* sock) {
+    udp_socket_t** link = &port_hash[udp_hash(sock->port)];
+    
+    while (*link) {
+        if (*link == sock) {
+            *link = sock->hash_next;
+            sock->hash_next = 0;
+            return;
+        }
+        link = &(*link)->hash_next;
+    }
+}
+
+static udp_socket_t* udp_get(int sock) {
+    if (sock < 0 || sock >= UDP_MAX_SOCKETS || !sockets[sock].used) return 0;
+    return &sockets[sock];
+}
+
+// ============================================================================
+// SOCKETS
+// ============================================================================
+
+void udp_init(void) {
+    memory_set(sockets, 0, sizeof(sockets));
+    memory_set(port_hash, 0, sizeof(port_hash));
+    memory_set(&udp_stats, 0, sizeof(udp_stats));
+    next_ephemeral = UDP_EPHEMERAL_MIN;
+}
+
+int udp_socket(void) {
+    for (int i = 0; i < UDP_MAX_SOCKETS; i++) {
+        if (!sockets[i].used) {
+            memory_set(&sockets[i], 0, sizeof(udp_socket_t));
+            sockets[i].used = 1;
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Associa o socket a uma porta local; 0 escolhe uma porta efêmera livre
+int udp_bind(int sock, uint16_t port) {
+    udp_socket_t* s = udp_get(sock);
+    
+    if (!s || s->port) return -1;
+    
+    if (port == 0) {
+        for (uint32_t i = 0; i <= UDP_EPHEMERAL_MAX - UDP_EPHEMERAL_MIN; i++) {
+            uint16_t candidate = next_ephemeral;
+            
+            next_ephemeral = candidate == UDP_EPHEMERAL_MAX ? UDP_EPHEMERAL_MIN : candidate + 1;
+            if (!udp_lookup(candidate)) {
+                port = candidate;
+                break;
+            }
+        }
+        if (port == 0) return -1;
+    } else if (udp_lookup(port)) {
+        return -1;  // Porta em uso
+    }
+    
+    s->port = port;
+    udp_hash_insert(s);
+    return 0;
+}
+
+// Envia um datagrama; sem bind, o socket ganha uma porta efêmera
+int udp_sendto(int sock, const void* data, size_t len, const ip_addr_t* dst_ip,
+               uint16_t dst_port) {
+    udp_socket_t* s = udp_get(sock);
+    
+    if (!s || len > UDP_MAX_DATAGRAM) return -1;
+    if (!s->port && udp_bind(sock, 0) != 0) return -1;
+    
+    uint32_t flags = irq_save();
+    udp_header_t* udp = (udp_header_t*)tx_datagram;
+    
+    udp->src_port = htons(s->port);
+    udp->dst_port = htons(dst_port);
+    udp->length = htons(UDP_HEADER_SIZE + len);
+    memory_copy(tx_datagram + UDP_HEADER_SIZE, data, len);
+    
+    int result = ip_send_l4(tx_datagram, UDP_HEADER_SIZE + len, dst_ip, IP_PROTO_UDP,
+                            offsetof(udp_header_t, checksum));
+    if (result == 0) {
+        s->tx_datagrams++;
+        udp_stats.out_datagrams++;
+    }
+    irq_restore(flags);
+    return result;
+}
+
+// Retira o datagrama mais antigo da fila, sem copiar: dgram aponta para o
+// buffer do pacote até udp_release. Não bloqueia (-1 com a fila vazia)
+int udp_recvfrom(int sock, udp_datagram_t* dgram) {
+    udp_socket_t* s = udp_get(sock);
+    
+    if (!s || !s->rx_head) return -1;
+    
+    uint32_t flags = irq_save();
+    netbuf_t* buf = s->rx_head;
+    
+    s->rx_head = buf->next;
+    if (!s->rx_head) s->rx_tail = 0;
+    s->queued--;
+    irq_restore(flags);
+    
+    // Origem lida dos cabeçalhos, que continuam no buffer
+    const ip_header_t* ip = (const ip_header_t*)(buf->data + buf->net_offset);
+    const udp_header_t* udp = (const udp_header_t*)(buf->data + buf->offset - UDP_HEADER_SIZE);
+    
+    buf->next = 0;
+    dgram->buf = buf;
+    dgram->data = buf->ext_data ? buf->ext_data : buf->data + buf->offset;
+    dgram->len = buf->len;
+    dgram->src_ip = ip->src_ip;
+    dgram->src_port = ntohs(udp->src_port);
+    return 0;
+}
+
+// Devolve o buffer ao pool (e a remontagem que guardava os dados)
+static void udp_buf_free(netbuf_t* buf) {
+    if (buf->ext_data) ip_reasm_release(buf->ext_data);
+    netbuf_free(buf);
+}
+
+// Devolve o buffer de um datagrama ao pool
+void udp_release(udp_datagram_t* dgram) {
+    udp_buf_free(dgram->buf);
+    dgram->buf = 0;
+    dgram->data = 0;
+}
+
+void udp_close(int sock) {
+    udp_socket_t* s = udp_get(sock);
+    
+    if (!s) return;
+    
+    uint32_t flags = irq_save();
+    while (s->rx_head) {
+        netbuf_t* buf = s->rx_head;
+        s->rx_head = buf->next;
+        udp_buf_free(buf);
+    }
+    if (s->port) udp_hash_remove(s);
+    s->used = 0;
+    irq_restore(flags);
+}
+
+// ============================================================================
+// RECEPÇÃO
+// ============================================================================
+
+// Datagrama remontado maior que um buffer: o buffer recebe uma cópia dos
+// cabeçalhos e os dados ficam retidos na remontagem IP
+static netbuf_t* udp_take_reassembled(const ip_header_t* ip, uint32_t header_len) {
+    const uint8_t* payload = (const uint8_t*)ip + header_len + UDP_HEADER_SIZE;
+    netbuf_t* buf = netbuf_take((const uint8_t*)ip, header_len + UDP_HEADER_SIZE);
+    
+    if (!buf) return 0;
+    if (ip_reasm_hold(payload) != 0) {
+        netbuf_free(buf);
+        return 0;
+    }
+    buf->ext_data = payload;
+    return buf;
+}
+
+// Valida o datagrama e o enfileira no socket da porta de destino. O socket
+// fica com o buffer do pacote inteiro (cabeçalhos IP e UDP incluídos)
+void udp_receive(const ip_header_t* ip, const uint8_t* data, size_t len, uint8_t csum_valid) {
+    const udp_header_t* udp = (const udp_header_t*)data;
+    
+    if (len < UDP_HEADER_SIZE) {
+        udp_stats.in_errors++;
+        return;
+    }
+    
+    uint32_t udp_len = ntohs(udp->length);
+    if (udp_len < UDP_HEADER_SIZE || udp_len > len) {
+        udp_stats.in_errors++;
+        return;
+    }
+    
+    // A placa já conferiu o checksum ou o remetente não calculou
+    if (csum_valid) {
+        udp_stats.csum_offloaded++;
+    } else if (udp->checksum != 0 &&
+               l4_checksum(&ip->src_ip, &ip->dst_ip, IP_PROTO_UDP, data, udp_len) != 0) {
+        udp_stats.in_errors++;
+        return;
+    }
+    
+    udp_socket_t* s = udp_lookup(ntohs(udp->dst_port));
+    if (!s) {
+        udp_stats.no_ports++;
+        return;
+    }
+    
+    uint32_t header_len = data - (const uint8_t*)ip;
+    netbuf_t* buf = 0;
+    if (s->queued < UDP_RX_QUEUE_MAX) {
+        buf = header_len + udp_len <= NETBUF_SIZE ?
+              netbuf_take((const uint8_t*)ip, header_len + udp_len) :
+              udp_take_reassembled(ip, header_len);
+    }
+    if (!buf) {
+        s->rx_drops++;
+        udp_stats.rcvbuf_errors++;
+        return;
+    }
+    
+    buf->net_offset = buf->offset;
+    buf->offset += header_len + UDP_HEADER_SIZE;
+    buf->len = udp_len - UDP_HEADER_SIZE;
+    buf->next = 0;
+    
+    if (s->rx_tail) s->rx_tail->next = buf;
+    else s->rx_head = buf;
+    s->rx_tail = buf;
+    s->queued++;
+    s->rx_datagrams++;
+    udp_stats.in_datagrams++;
+}
+
+// ============================================================================
+// DIAGNÓSTICO
+// ============================================================================
+
+void udp_print_stats(void) {
+    terminal_print("UDP: ");
+    terminal_print_dec(udp_stats.in_datagrams);
+    terminal_print(" recebidos, ");
+    terminal_print_dec(udp_stats.out_datagrams);
+    terminal_print(" enviados, ");
+    terminal_print_dec(udp_stats.no_ports);
+    terminal_print(" sem porta, ");
+    terminal_print_dec(udp_stats.in_errors);
+    terminal_print(" erros, ");
+    terminal_print_dec(udp_stats.rcvbuf_errors);
+    terminal_print(" descartes, ");
+    terminal_print_dec(udp_stats.csum_offloaded);
+    terminal_print(" checksums conferidos pela placa\n");
+    
+    for (int i = 0; i < UDP_MAX_SOCKETS; i++) {
+        const udp_socket_t* s = &sockets[i];
+        
+        if (!s->used) continue;
+        terminal_print("  Socket ");
+        terminal_print_dec(i);
+        terminal_print(": porta ");
+        terminal_print_dec(s->port);
+        terminal_print(", ");
+        terminal_print_dec(s->queued);
+        terminal_print(" na fila, ");
+        terminal_print_dec(s->rx_datagrams);
+        terminal_print(" recebidos, ");
+        terminal_print_dec(s->tx_datagrams);
+        terminal_print(" enviados, ");
+        terminal_print_dec(s->rx_drops);
+        terminal_print(" descartes\n");
+    }
+}
+
+// ============================================================================
+// BENCHMARK
+// ============================================================================
+
+// Imprime "N pps, X.Y Mbit/s" para 'packets' datagramas de 'bytes' no
+// total em 'us' microssegundos
+static void udp_bench_print_rate(uint32_t packets, uint64_t bytes, uint32_t us) {
+    if (us == 0) us = 1;
+    
+    uint32_t pps = (uint32_t)div64_32((uint64_t)packets * 1000000, us);
+    uint32_t mbit10 = (uint32_t)div64_32(bytes * 80, us);   // Décimos de Mbit/s
+    
+    terminal_print_dec(pps);
+    terminal_print(" pps, ");
+    terminal_print_dec(mbit10 / 10);
+    terminal_print(".");
+    terminal_print_dec(mbit10 % 10);
+    terminal_print(" Mbit/s de dados\n");
+}
+
+// Envia um datagrama; com o anel TX cheio, publica o lote, processa a rede
+// (o driver colhe os descritores concluídos) e tenta de novo por até
+// UDP_BENCH_RETRY_MS
+static int udp_bench_send(int sock, netdev_t* dev, const uint8_t* payload, uint32_t size,
+                          const ip_addr_t* dst_ip, uint16_t port) {
+    if (udp_sendto(sock, payload, size, dst_ip, port) == 0) return 0;
+    
+    uint64_t deadline = tsc_read() + (uint64_t)UDP_BENCH_RETRY_MS * tsc_khz;
+    int result = -1;
+    
+    netdev_tx_batch_end(dev);
+    while (result != 0 && tsc_read() < deadline) {
+        network_process_packets();
+        result = udp_sendto(sock, payload, size, dst_ip, port);
+    }
+    netdev_tx_batch_begin(dev);
+    return result;
+}
+
+// udpbench tx IP PORTA [N] [BYTES]: N datagramas em lotes de
+// UDP_BENCH_BATCH, com uma notificação à placa por lote. Acima de uma
+// MTU mostra também quantos fragmentos saíram
+static void udp_bench_tx(const ip_addr_t* dst_ip, uint16_t port, uint32_t count, uint32_t size) {
+    static uint8_t payload[UDP_MAX_DATAGRAM];
+    const ip_frag_stats_t* frag = ip_frag_get_stats();
+    uint32_t creates0 = frag->frag_creates, fails0 = frag->frag_fails;
+    netdev_t* dev = network_get_interface()->dev;
+    int sock = udp_socket();
+    
+    if (sock < 0 || udp_bind(sock, 0) != 0) {
+        terminal_print("Sem sockets UDP livres\n");
+        return;
+    }
+    if (ip_resolve(dst_ip, 1000) != 0) {
+        terminal_print("Sem resposta ARP do proximo salto\n");
+        udp_close(sock);
+        return;
+    }
+    
+    for (uint32_t i = 0; i < size; i++) {
+        payload[i] = (uint8_t)i;
+    }
+    
+    uint32_t sent = 0, failed = 0;
+    uint64_t start = tsc_read();
+    
+    while (sent + failed < count) {
+        netdev_tx_batch_begin(dev);
+        for (int b = 0; b < UDP_BENCH_BATCH && sent + failed < count; b++) {
+            // Número de sequência nos primeiros bytes (se couber)
+            uint32_t seq = htonl(sent + failed);
+            memory_copy(payload, &seq, size < 4 ? size : 4);
+            
+            if (udp_bench_send(sock, dev, payload, size, dst_ip, port) == 0) sent++;
+            else failed++;
+        }
+        netdev_tx_batch_end(dev);
+        network_process_packets();
+    }
+    
+    uint32_t us = tsc_to_us(tsc_read() - start);
+    udp_close(sock);
+    
+    terminal_print_dec(sent);
+    terminal_print(" datagramas de ");
+    terminal_print_dec(size);
+    terminal_print(" bytes em ");
+    terminal_print_dec(us / 1000);
+    terminal_print(" ms (");
+    terminal_print_dec(failed);
+    terminal_print(" falhas): ");
+    udp_bench_print_rate(sent, (uint64_t)sent * size, us);
+    
+    if (frag->frag_creates != creates0 || frag->frag_fails != fails0) {
+        terminal_print("Fragmentos: ");
+        terminal_print_dec(frag->frag_creates - creates0);
+        terminal_print(" enviados, ");
+        terminal_print_dec(frag->frag_fails - fails0);
+        terminal_print(" datagramas interrompidos\n");
+    }
+}
+
+// udpbench rx PORTA [SEGUNDOS]: conta os datagramas que chegam na porta.
+// A taxa vale entre o primeiro e o último; um segundo sem tráfego encerra
+static void udp_bench_rx(uint16_t port, uint32_t seconds) {
+    const netbuf_stats_t* pool = netbuf_get_stats();
+    uint32_t loaned0 = pool->loaned, copied0 = pool->copied;
+    int sock = udp_socket();
+    
+    if (sock < 0 || udp_bind(sock, port) != 0) {
+        terminal_print("Porta em uso ou sem sockets UDP livres\n");
+        if (sock >= 0) udp_close(sock);
+        return;
+    }
+    
+    terminal_print("Aguardando datagramas na porta ");
+    terminal_print_dec(port);
+    terminal_print("...\n");
+    
+    uint32_t received = 0, checksum = 0;
+    uint64_t bytes = 0, first = 0, last = 0;
+    uint64_t now = tsc_read();
+    uint64_t deadline = now + (uint64_t)seconds * 1000 * tsc_khz;
+    uint64_t idle = (uint64_t)1000 * tsc_khz;
+    udp_datagram_t dgram;
+    
+    while (now < deadline && (received == 0 || now - last < idle)) {
+        network_process_packets();
+        while (udp_recvfrom(sock, &dgram) == 0) {
+            last = tsc_read();
+            if (received++ == 0) first = last;
+            bytes += dgram.len;
+            
+            // Lê os dados direto do buffer do pacote
+            for (uint32_t i = 0; i < dgram.len; i += 64) {
+                checksum += dgram.data[i];
+            }
+            udp_release(&dgram);
+        }
+        now = tsc_read();
+    }
+    
+    uint32_t drops = sockets[sock].rx_drops;
+    udp_close(sock);
+    (void)checksum;
+    
+    terminal_print_dec(received);
+    terminal_print(" datagramas (");
+    terminal_print_dec(pool->loaned - loaned0);
+    terminal_print(" no buffer do driver, ");
+    terminal_print_dec(pool->copied - copied0);
+    terminal_print(" copiados, ");
+    terminal_print_dec(drops);
+    terminal_print(" descartados)\n");
+    if (received > 1) {
+        terminal_print("Taxa: ");
+        udp_bench_print_rate(received - 1, bytes, tsc_to_us(last - first));
+    }
+}
+
+// udpbench tx IP PORTA [N] [BYTES] | udpbench rx PORTA [SEGUNDOS] |
+// udpbench frag IP PORTA [N] (datagramas do tamanho máximo, bem mais
+// fragmentos do que cabem no anel TX da placa)
+void cmd_udpbench(const char* args) {
+    char mode[8], arg1[16], arg2[16], arg3[16], arg4[16];
+    uint32_t port = 0, count = UDP_BENCH_COUNT, size = UDP_BENCH_SIZE;
+    uint32_t seconds = UDP_BENCH_SECONDS;
+    ip_addr_t dst_ip;
+    
+    args = net_next_token(args, mode, sizeof(mode));
+    args = net_next_token(args, arg1, sizeof(arg1));
+    args = net_next_token(args, arg2, sizeof(arg2));
+    args = net_next_token(args, arg3, sizeof(arg3));
+    net_next_token(args, arg4, sizeof(arg4));
+    
+    if (!network_get_interface()->dev) {
+        terminal_print("udpbench requer uma placa de rede\n");
+        return;
+    }
+    
+    if (strcmp(mode, "tx") == 0 && string_to_ip(arg1, &dst_ip) == 0 &&
+        net_parse_uint(arg2, &port) == 0 && port > 0 && port <= 65535 &&
+        (arg3[0] == '\0' || (net_parse_uint(arg3, &count) == 0 && count > 0)) &&
+        (arg4[0] == '\0' || (net_parse_uint(arg4, &size) == 0 && size <= UDP_MAX_DATAGRAM))) {
+        udp_bench_tx(&dst_ip, port, count, size);
+        return;
+    }
+    
+    if (strcmp(mode, "frag") == 0 && string_to_ip(arg1, &dst_ip) == 0 &&
+        net_parse_uint(arg2, &port) == 0 && port > 0 && port <= 65535 &&
+        (arg3[0] == '\0' || (net_parse_uint(arg3, &count) == 0 && count > 0))) {
+        if (arg3[0] == '\0') count = UDP_BENCH_FRAG_COUNT;
+        udp_bench_tx(&dst_ip, port, count, UDP_MAX_DATAGRAM);
+        return;
+    }
+    
+    if (strcmp(mode, "rx") == 0 && net_parse_uint(arg1, &port) == 0 &&
+        port > 0 && port <= 65535 &&
+        (arg2[0] == '\0' || (net_parse_uint(arg2, &seconds) == 0 && seconds > 0))) {
+        udp_bench_rx(port, seconds);
+        return;
+    }
+    
+    terminal_print("Uso: udpbench tx IP PORTA [N] [BYTES]\n");
+    terminal_print("     udpbench rx PORTA [SEGUNDOS]\n");
+    terminal_print("     udpbench frag IP PORTA [N]\n");
+}
@@ -0,0 +1,519 @@
+// ============================================================================
+// NanoOS - Driver Virtio-net
+// Placa paravirtualizada do QEMU/KVM: vários pares de filas RX/TX, checksum
+// feito pelo host quando negociado e buffers de recepção mesclados
+// (MRG_RXBUF) entregues à pilha sem cópia
+// ============================================================================
+
+#include "../../include/virtio_net.h"
+#include "../../include/virtio.h"
+#include "../../include/netdev.h"
+#include "../../include/pci.h"
+#include "../../include/kernel.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// VARIÁVEIS GLOBAIS
+// ============================================================================
+
+static virtio_net_device_t vnet;
+
+static uint8_t rx_rings[VIRTIO_NET_MAX_PAIRS][VIRTQ_RING_BYTES(VIRTQ_MAX_SIZE)] __attribute__((aligned(4096)));
+static uint8_t tx_rings[VIRTIO_NET_MAX_PAIRS][VIRTQ_RING_BYTES(VIRTQ_MAX_SIZE)] __attribute__((aligned(4096)));
+static uint8_t ctrl_ring[VIRTQ_RING_BYTES(VIRTQ_MAX_SIZE)] __attribute__((aligned(4096)));
+
+static uint8_t tx_buffers[VIRTIO_NET_MAX_PAIRS][VIRTIO_NET_TX_SLOTS][VIRTIO_NET_TX_BUFFER_SIZE];
+
+// Pacote que ocupou vários buffers mesclados é remontado aqui
+static uint8_t rx_merge[VIRTIO_NET_MAX_PACKET];
+
+// ============================================================================
+// RECEPÇÃO
+// ============================================================================
+
+// Devolve um buffer à fila RX. Com MRG_RXBUF o cabeçalho e os dados dividem
+// um único descritor; sem ele o transporte legado exige o cabeçalho à parte
+static int virtio_net_rx_post(virtqueue_t* vq, uint8_t* buffer) {
+    virtq_buf_t bufs[2];
+    uint16_t n = 0;
+    
+    if (vnet.features & VIRTIO_NET_F_MRG_RXBUF) {
+        bufs[n].addr = buffer;
+        bufs[n].len = VIRTIO_NET_RX_BUFFER_SIZE;
+        bufs[n++].device_writes = 1;
+    } else {
+        bufs[n].addr = buffer;
+        bufs[n].len = vnet.hdr_len;
+        bufs[n++].device_writes = 1;
+        bufs[n].addr = buffer + vnet.hdr_len;
+        bufs[n].len = VIRTIO_NET_RX_BUFFER_SIZE - vnet.hdr_len;
+        bufs[n++].device_writes = 1;
+    }
+    
+    return virtq_add_chain(vq, bufs, n, buffer);
+}
+
+// Junta os buffers seguintes de um pacote mesclado em rx_merge. Os demais
+// buffers não têm cabeçalho; todos já estão no anel usado quando o
+// primeiro aparece. Mesmo um primeiro buffer vazio consome e repõe os
+// demais. Retorna o tamanho do frame ou -1 se não coube
+static int virtio_net_rx_merge(virtqueue_t* vq, const uint8_t* frame, int len,
+                               uint16_t count) {
+    int result = len > 0 && len <= VIRTIO_NET_MAX_PACKET ? len : -1;
+    
+    if (result > 0) {
+        memory_copy(rx_merge, frame, len);
+    }
+    
+    for (uint16_t i = 1; i < count; i++) {
+        uint32_t part;
+        uint8_t* buffer = (uint8_t*)virtq_get_used(vq, &part);
+        
+        if (!buffer) return -1;
+        if (result >= 0 && (uint32_t)result + part <= VIRTIO_NET_MAX_PACKET) {
+            memory_copy(rx_merge + result, buffer, part);
+            result += part;
+        } else {
+            result = -1;
+        }
+        virtio_net_rx_post(vq, buffer);
+    }
+    
+    return result;
+}
+
+// Colhe até 'budget' pacotes de uma fila RX e repõe os buffers. O frame é
+// entregue direto do buffer do anel (um netbuf do pool), que só volta ao
+// dispositivo depois da pilha
+static int virtio_net_rx(uint8_t queue, int budget) {
+    virtqueue_t* vq = &vnet.rxq[queue];
+    netdev_t* dev = vnet.netdev;
+    uint8_t* buffer;
+    uint32_t len;
+    int done = 0;
+    
+    while (done < budget && (buffer = (uint8_t*)virtq_get_used(vq, &len)) != 0) {
+        virtio_net_hdr_t* hdr = (virtio_net_hdr_t*)buffer;
+        uint8_t* frame = buffer + vnet.hdr_len;
+        int frame_len = (int)len - vnet.hdr_len;
+        uint8_t flags = 0;
+        
+        done++;
+        
+        // Com o cabeçalho completo, num_buffers vale mesmo sem dados no
+        // primeiro buffer: os seguintes precisam sair do anel usado
+        if (frame_len >= 0 && (vnet.features & VIRTIO_NET_F_MRG_RXBUF) &&
+            hdr->num_buffers > 1) {
+            frame_len = virtio_net_rx_merge(vq, frame, frame_len, hdr->num_buffers);
+            frame = rx_merge;
+            vnet.rx_merged++;
+        }
+        
+        if (frame_len < ETH_HEADER_SIZE) {
+            dev->rx[queue].errors++;
+            virtio_net_rx_post(vq, buffer);
+            continue;
+        }
+        
+        // Checksum parcial (host na mesma máquina): o campo traz só a
+        // soma do pseudo-cabeçalho e a soma do resto fica conosco
+        if (hdr->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) {
+            uint32_t field = (uint32_t)hdr->csum_start + hdr->csum_offset;
+            
+            if (hdr->csum_start < frame_len && field + 2 <= (uint32_t)frame_len) {
+                *(uint16_t*)(frame + field) =
+                    calculate_checksum(frame + hdr->csum_start, frame_len - hdr->csum_start);
+                flags |= NETDEV_RX_CSUM_VALID;
+                vnet.rx_csum_fixed++;
+            }
+        } else if (hdr->flags & VIRTIO_NET_HDR_F_DATA_VALID) {
+            flags |= NETDEV_RX_CSUM_VALID;
+        }
+        
+        // Pacote num buffer só: o buffer é emprestado à pilha e, se ela
+        // ficar com ele, o substituto do pool volta à fila
+        if (frame == buffer + vnet.hdr_len) {
+            buffer = netdev_receive_buf(dev, queue, netbuf_from_data(buffer), vnet.hdr_len,
+                                        frame_len, flags)->data;
+        } else {
+            netdev_receive(dev, queue, frame, frame_len, flags);
+        }
+        virtio_net_rx_post(vq, buffer);
+    }
+    
+    if (done) virtq_kick(vq);
+    return done;
+}
+
+// Passada de polling: as filas dividem o orçamento, começando por uma
+// diferente a cada vez para nenhuma ficar sempre com a sobra
+static int virtio_net_poll(netdev_t* dev, int budget) {
+    static uint8_t first = 0;
+    int done = 0;
+    
+    (void)dev;
+    for (uint8_t i = 0; i < vnet.pairs && done < budget; i++) {
+        done += virtio_net_rx((first + i) % vnet.pairs, budget - done);
+    }
+    first = (first + 1) % vnet.pairs;
+    return done;
+}
+
+// Durante o polling o host não interrompe (NO_INTERRUPT / used_event)
+static void virtio_net_rx_irq_disable(netdev_t* dev) {
+    (void)dev;
+    for (uint8_t q = 0; q < vnet.pairs; q++) {
+        virtq_disable_interrupts(&vnet.rxq[q]);
+    }
+}
+
+// Com EVENT_IDX um pacote usado antes de used_event ser atualizado não
+// gera interrupção: virtq_enable_interrupts avisa e o polling continua
+static int virtio_net_rx_irq_enable(netdev_t* dev) {
+    int pending = 0;
+    
+    (void)dev;
+    for (uint8_t q = 0; q < vnet.pairs; q++) {
+        pending |= virtq_enable_interrupts(&vnet.rxq[q]);
+    }
+    return pending;
+}
+
+// ============================================================================
+// TRANSMISSÃO
+// ============================================================================
+
+// Libera os slots que o host já consumiu. A fila TX roda sem interrupção:
+// a limpeza acontece no próximo envio
+static void virtio_net_tx_reclaim(virtio_net_txq_t* txq) {
+    void* cookie;
+    
+    while ((cookie = virtq_get_used(&txq->vq, 0)) != 0) {
+        txq->free[txq->free_count++] = (uint32_t)cookie - 1;
+    }
+}
+
+// Copia o frame para um slot da fila escolhida pelo hash do fluxo, com o
+// cabeçalho virtio-net à frente em um descritor próprio
+static int virtio_net_transmit(netdev_t* dev, const void* frame, uint32_t len,
+                               const netdev_offload_t* offload) {
+    uint8_t queue = netdev_select_queue(dev, frame, len);
+    virtio_net_txq_t* txq = &vnet.txq[queue];
+    
+    if (len > ETH_FRAME_SIZE) return -1;
+    
+    uint32_t flags = irq_save();
+    
+    virtio_net_tx_reclaim(txq);
+    
+    // Anel cheio (um lote maior que o anel, como os fragmentos de um
+    // datagrama grande): publica o que já está nele e espera o host
+    // consumir por até VIRTIO_NET_TX_WAIT_MS
+    if (txq->free_count == 0) {
+        uint64_t deadline = tsc_read() + (uint64_t)VIRTIO_NET_TX_WAIT_MS * tsc_khz;
+        
+        virtq_kick(&txq->vq);
+        while (txq->free_count == 0 && tsc_read() < deadline) {
+            virtio_net_tx_reclaim(txq);
+        }
+        if (txq->free_count) vnet.tx_ring_waits++;
+    }
+    
+    if (txq->free_count == 0) {
+        dev->tx[queue].drops++;
+        irq_restore(flags);
+        return -1;
+    }
+    
+    uint8_t slot = txq->free[txq->free_count - 1];
+    uint8_t* buffer = tx_buffers[queue][slot];
+    uint32_t cookie = slot + 1;
+    virtio_net_hdr_t* hdr = (virtio_net_hdr_t*)buffer;
+    
+    memory_set(hdr, 0, vnet.hdr_len);
+    if (offload) {
+        hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+        hdr->csum_start = offload->csum_start;
+        hdr->csum_offset = offload->csum_offset;
+    }
+    memory_copy(buffer + vnet.hdr_len, frame, len);
+    
+    virtq_buf_t bufs[2] = {
+        { buffer, vnet.hdr_len, 0 },
+        { buffer + vnet.hdr_len, len, 0 },
+    };
+    
+    if (virtq_add_chain(&txq->vq, bufs, 2, (void*)cookie) < 0) {
+        dev->tx[queue].drops++;
+        irq_restore(flags);
+        return -1;
+    }
+    
+    txq->free_count--;
+    if (offload) vnet.tx_offloaded++;
+    
+    dev->tx[queue].packets++;
+    dev->tx[queue].bytes += len;
+    if (!dev->tx_batch) {
+        virtq_kick(&txq->vq);
+    }
+    
+    irq_restore(flags);
+    return 0;
+}
+
+// Fim de um lote: uma notificação por fila (e só se o host pediu)
+static void virtio_net_flush(netdev_t* dev) {
+    (void)dev;
+    
+    for (uint8_t q = 0; q < vnet.pairs; q++) {
+        virtq_kick(&vnet.txq[q].vq);
+    }
+}
+
+// ============================================================================
+// INTERRUPÇÃO
+// ============================================================================
+
+static void virtio_net_update_link(void) {
+    if (vnet.features & VIRTIO_NET_F_STATUS) {
+        uint16_t status = inw(vnet.io_base + VIRTIO_REG_DEVICE_CONFIG + VIRTIO_NET_CFG_STATUS);
+        vnet.netdev->link_up = (status & VIRTIO_NET_S_LINK_UP) != 0;
+    } else {
+        vnet.netdev->link_up = 1;
+    }
+}
+
+// Handler da IRQ legada: ler o ISR confirma. Bit 0 = filas, bit 1 = configuração
+static void virtio_net_irq_handler(void) {
+    uint8_t isr = virtio_read_isr(vnet.io_base);
+    
+    if (!isr) return;  // Linha compartilhada: não é nossa
+    vnet.irqs++;
+    
+    if (isr & 2) virtio_net_update_link();
+    if (isr & 1) netdev_rx_schedule(vnet.netdev);
+}
+
+// ============================================================================
+// FILA DE CONTROLE
+// ============================================================================
+
+// Pede ao host 'pairs' pares de filas ativos (sem interrupção: polling)
+static int virtio_net_set_pairs(uint16_t pairs) {
+    static virtio_net_ctrl_hdr_t ctrl;
+    static uint16_t data;
+    static volatile uint8_t ack;
+    
+    ctrl.class_id = VIRTIO_NET_CTRL_MQ;
+    ctrl.command = VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET;
+    data = pairs;
+    ack = 0xFF;
+    
+    virtq_buf_t bufs[3] = {
+        { &ctrl, sizeof(ctrl), 0 },
+        { &data, sizeof(data), 0 },
+        { (void*)&ack, 1, 1 },
+    };
+    
+    if (virtq_add_chain(&vnet.ctrlq, bufs, 3, &ctrl) < 0) return -1;
+    virtq_kick(&vnet.ctrlq);
+    
+    uint32_t start = timer_ticks;
+    while (!virtq_get_used(&vnet.ctrlq, 0)) {
+        if (timer_ticks - start > VIRTIO_NET_CTRL_TIMEOUT) return -1;
+    }
+    return ack == VIRTIO_NET_OK ? 0 : -1;
+}
+
+// ============================================================================
+// DIAGNÓSTICO
+// ============================================================================
+
+static void virtio_net_print_stats(const netdev_t* dev) {
+    (void)dev;
+    
+    terminal_print("    virtio-net: ");
+    terminal_print_dec(vnet.pairs);
+    terminal_print(" pares, cabecalho de ");
+    terminal_print_dec(vnet.hdr_len);
+    terminal_print(" bytes, ");
+    terminal_print_dec(vnet.irqs);
+    terminal_print(" interrupcoes\n");
+    terminal_print("    RX mesclados: ");
+    terminal_print_dec(vnet.rx_merged);
+    terminal_print(", checksums completados: ");
+    terminal_print_dec(vnet.rx_csum_fixed);
+    terminal_print("\n    TX com offload: ");
+    terminal_print_dec(vnet.tx_offloaded);
+    terminal_print(", esperas por anel cheio: ");
+    terminal_print_dec(vnet.tx_ring_waits);
+    terminal_print("\n");
+    
+    for (uint8_t q = 0; q < vnet.pairs; q++) {
+        terminal_print("    TX");
+        terminal_print_dec(q);
+        terminal_print(" notificacoes: ");
+        terminal_print_dec(vnet.txq[q].vq.kicks);
+        terminal_print(" enviadas, ");
+        terminal_print_dec(vnet.txq[q].vq.kicks_suppressed);
+        terminal_print(" suprimidas\n");
+    }
+}
+
+// ============================================================================
+// INICIALIZAÇÃO
+// ============================================================================
+
+static const netdev_ops_t virtio_net_ops = {
+    .transmit = virtio_net_transmit,
+    .flush = virtio_net_flush,
+    .poll = virtio_net_poll,
+    .rx_irq_disable = virtio_net_rx_irq_disable,
+    .rx_irq_enable = virtio_net_rx_irq_enable,
+    .print_stats = virtio_net_print_stats,
+};
+
+// Enche uma fila RX com buffers do pool e liga a interrupção
+static void virtio_net_rx_fill(uint8_t queue) {
+    virtqueue_t* rxq = &vnet.rxq[queue];
+    
+    for (int i = 0; i < VIRTIO_NET_RX_BUFFERS; i++) {
+        netbuf_t* buf = netbuf_alloc();
+        
+        if (!buf) break;
+        if (virtio_net_rx_post(rxq, buf->data) < 0) {
+            netbuf_free(buf);
+            break;
+        }
+    }
+    virtq_enable_interrupts(rxq);
+    virtq_kick(rxq);
+}
+
+// Filas RX (índices pares) e TX (ímpares, sem interrupção). Só o primeiro
+// par recebe buffers aqui: os demais esperam o host aceitar o MQ
+static int virtio_net_setup_queues(uint8_t event_idx) {
+    for (uint8_t q = 0; q < vnet.pairs; q++) {
+        virtqueue_t* rxq = &vnet.rxq[q];
+        virtio_net_txq_t* txq = &vnet.txq[q];
+        
+        if (virtq_init(rxq, vnet.io_base, 2 * q, rx_rings[q],
+                       sizeof(rx_rings[q]), event_idx) != 0 ||
+            virtq_init(&txq->vq, vnet.io_base, 2 * q + 1, tx_rings[q],
+                       sizeof(tx_rings[q]), event_idx) != 0) {
+            return -1;
+        }
+        
+        for (int i = 0; i < VIRTIO_NET_TX_SLOTS; i++) {
+            txq->free[i] = VIRTIO_NET_TX_SLOTS - 1 - i;
+        }
+        txq->free_count = VIRTIO_NET_TX_SLOTS;
+        virtq_disable_interrupts(&txq->vq);
+    }
+    
+    virtio_net_rx_fill(0);
+    return 0;
+}
+
+// Probe do virtio-net (transporte legado); só a primeira placa é usada
+static int virtio_net_probe(pci_device_t* pci, const pci_device_id_t* id) {
+    (void)id;
+    
+    if (vnet.netdev) return -1;
+    if (virtio_pci_setup(&pci->addr, &vnet.io_base) != 0) {
+        terminal_print("virtio-net: BAR0 de I/O ausente\n");
+        return -1;
+    }
+    
+    uint32_t features = virtio_negotiate(vnet.io_base, VIRTIO_NET_F_CSUM |
+                                                       VIRTIO_NET_F_GUEST_CSUM |
+                                                       VIRTIO_NET_F_MAC |
+                                                       VIRTIO_NET_F_MRG_RXBUF |
+                                                       VIRTIO_NET_F_STATUS |
+                                                       VIRTIO_NET_F_CTRL_VQ |
+                                                       VIRTIO_NET_F_MQ |
+                                                       VIRTIO_RING_F_EVENT_IDX);
+    uint16_t cfg = vnet.io_base + VIRTIO_REG_DEVICE_CONFIG;
+    uint8_t event_idx = (features & VIRTIO_RING_F_EVENT_IDX) ? 1 : 0;
+    uint16_t max_pairs = 1;
+    
+    vnet.features = features;
+    vnet.hdr_len = (features & VIRTIO_NET_F_MRG_RXBUF) ? VIRTIO_NET_HDR_MRG_SIZE
+                                                       : VIRTIO_NET_HDR_SIZE;
+    
+    if ((features & VIRTIO_NET_F_MQ) && (features & VIRTIO_NET_F_CTRL_VQ)) {
+        max_pairs = inw(cfg + VIRTIO_NET_CFG_MAX_PAIRS);
+        if (max_pairs == 0) max_pairs = 1;
+    }
+    vnet.pairs = max_pairs > VIRTIO_NET_MAX_PAIRS ? VIRTIO_NET_MAX_PAIRS : max_pairs;
+    
+    if (virtio_net_setup_queues(event_idx) != 0) {
+        terminal_print("virtio-net: filas invalidas\n");
+        virtio_set_status(vnet.io_base, VIRTIO_STATUS_FAILED);
+        return -1;
+    }
+    
+    // A fila de controle vem depois de todas as filas de dados do
+    // dispositivo, não só das que usamos
+    if (vnet.pairs > 1 &&
+        virtq_init(&vnet.ctrlq, vnet.io_base, 2 * max_pairs, ctrl_ring,
+                   sizeof(ctrl_ring), 0) != 0) {
+        vnet.pairs = 1;
+    }
+    
+    mac_addr_t mac = {{0x52, 0x54, 0x00, 0x12, 0x34, 0x56}};
+    if (features & VIRTIO_NET_F_MAC) {
+        for (int i = 0; i < ETH_ADDR_LEN; i++) {
+            mac.addr[i] = inb(cfg + VIRTIO_NET_CFG_MAC + i);
+        }
+    }
+    
+    vnet.netdev = netdev_register("virtio-net", &mac, pci->irq_line,
+                                  vnet.pairs, vnet.pairs, &virtio_net_ops, &vnet);
+    if (!vnet.netdev) {
+        virtio_set_status(vnet.io_base, VIRTIO_STATUS_FAILED);
+        return -1;
+    }
+    
+    if (features & VIRTIO_NET_F_CSUM) vnet.netdev->features |= NETDEV_F_TX_CSUM;
+    if (features & VIRTIO_NET_F_GUEST_CSUM) vnet.netdev->features |= NETDEV_F_RX_CSUM;
+    
+    irq_register_handler(pci->irq_line, virtio_net_irq_handler);
+    virtio_set_status(vnet.io_base, VIRTIO_STATUS_DRIVER_OK);
+    
+    // Até o comando o host só usa o primeiro par
+    if (vnet.pairs > 1 && virtio_net_set_pairs(vnet.pairs) != 0) {
+        terminal_print("virtio-net: host recusou as filas extras\n");
+        vnet.pairs = 1;
+        vnet.netdev->rx_queues = 1;
+        vnet.netdev->tx_queues = 1;
+    }
+    for (uint8_t q = 1; q < vnet.pairs; q++) {
+        virtio_net_rx_fill(q);
+    }
+    virtio_net_update_link();
+    
+    terminal_print("virtio-net: ");
+    terminal_print_dec(vnet.pairs);
+    terminal_print(" par(es) de filas, buffers mesclados: ");
+    terminal_print((features & VIRTIO_NET_F_MRG_RXBUF) ? "sim\n" : "nao\n");
+    return 0;
+}
+
+static const pci_device_id_t virtio_net_pci_ids[] = {
+    { VIRTIO_PCI_VENDOR, VIRTIO_PCI_DEVICE_NET, PCI_ANY_ID, PCI_ANY_ID },
+    { 0, 0, 0, 0 }
+};
+
+static const pci_driver_t virtio_net_pci_driver = {
+    .name = "virtio-net",
+    .ids = virtio_net_pci_ids,
+    .probe = virtio_net_probe,
+};
+
+// Registra o driver no PCI; falha se não houver placa
+int virtio_net_init(void) {
+    return pci_register_driver(&virtio_net_pci_driver) > 0 ? 0 : -1;
+}